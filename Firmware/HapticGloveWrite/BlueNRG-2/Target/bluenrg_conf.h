@@ -29,6 +29,26 @@ extern "C" {
 #include "stm32l4xx_hal.h"
 #include <string.h>
 
+/*---------- HCI transport to the BlueNRG-2 -----------*/
+#define HCI_TL_TRANSPORT_SPI      0   /* SPI, default BlueNRG-2 stack firmware */
+#define HCI_TL_TRANSPORT_UART     1   /* H4 over USART3, UART network coprocessor firmware */
+#ifndef HCI_TL_TRANSPORT
+#define HCI_TL_TRANSPORT      HCI_TL_TRANSPORT_SPI
+#endif
+/*---------- Baud rate of the UART network coprocessor firmware -----------*/
+#define HCI_TL_UART_BAUDRATE      115200U
+/*---------- Size of the UART circular reception buffer (power of two) -----------*/
+#define HCI_TL_UART_RX_RING_SIZE  512U
+/*---------- btsnoop capture of the HCI traffic over LPUART1 (takes over printf) -----------*/
+#ifndef HCI_CAPTURE_ENABLED
+#define HCI_CAPTURE_ENABLED       0
+#endif
+/*---------- Baud rate of LPUART1 while capturing -----------*/
+#define HCI_CAPTURE_BAUDRATE      921600U
+/*---------- Size of the capture ring (power of two) -----------*/
+#define HCI_CAPTURE_RING_SIZE     4096U
+/*---------- Bytes of each packet kept in the capture -----------*/
+#define HCI_CAPTURE_SNAPLEN       255U
 /*---------- Print messages from BLE2 files at user level -----------*/
 #define BLE2_DEBUG      1
 /*---------- Print the data travelling over the SPI in the .csv format compatible with the ST BlueNRG GUI -----------*/
@@ -39,8 +59,13 @@ extern "C" {
 #define HCI_READ_PACKET_SIZE      128
 /*---------- Number of Bytes reserved for HCI Max Payload -----------*/
 #define HCI_MAX_PAYLOAD_SIZE      128
-/*---------- Number of incoming packets added to the list of packets to read -----------*/
-#define HCI_READ_PACKET_NUM_MAX      10
+/*---------- Number of incoming packets the ring of packets to read can hold (power of two) -----------*/
+#define HCI_READ_PACKET_NUM_MAX      16
+/*---------- Read packets reserved for command answers, and for attribute writes on top of them -----------*/
+#define HCI_READ_PACKET_RSV_CMD      2
+#define HCI_READ_PACKET_RSV_PRIO     4
+/*---------- Number of asynchronous HCI commands queued or waiting for their answer -----------*/
+#define HCI_PENDING_CMD_NUM_MAX      4
 /*---------- Scan Interval: time interval from when the Controller started its last scan until it begins the subsequent scan (for a number N, Time = N x 0.625 msec) -----------*/
 #define SCAN_P      16384
 /*---------- Scan Window: amount of time for the duration of the LE scan (for a number N, Time = N x 0.625 msec) -----------*/
@@ -0,0 +1,290 @@
+/*
+ * hci_capture.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Capture of the HCI traffic in btsnoop format, streamed over LPUART1 by
+// DMA. Tools/btsnoop_capture.py turns the stream into a .btsnoop file
+// Wireshark can open.
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "hci_capture.h"
+
+#if (HCI_CAPTURE_ENABLED == 1)
+
+/* Defines -------------------------------------------------------------------*/
+
+#define RING_MASK         (HCI_CAPTURE_RING_SIZE - 1U)
+
+#if ((HCI_CAPTURE_RING_SIZE & RING_MASK) != 0)
+#error "HCI_CAPTURE_RING_SIZE must be a power of two"
+#endif
+
+#define SYNC_SIZE         4U
+#define RECORD_HDR_SIZE   24U /* btsnoop record header */
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief Byte ring shared by the btsnoop records and the console output.
+ *        The producers append with interrupts masked, the LPUART1 interrupt
+ *        streams [tail, head) out and frees the part it has sent.
+ */
+typedef struct
+{
+  uint32_t          head;  /**< Bytes appended, free running */
+  uint32_t          tail;  /**< Bytes sent, free running */
+  uint32_t          chunk; /**< Length of the DMA in progress, 0 if none */
+  tHciCaptureStats  stats;
+  uint8_t           ring[HCI_CAPTURE_RING_SIZE];
+} tHciCapture;
+
+/* Private variables ---------------------------------------------------------*/
+DMA_HandleTypeDef hdma_lpuart1_tx;
+
+static tHciCapture hciCapture;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Copies bytes at the head of the ring, wrapping if needed.
+ *         Called with interrupts masked, after checking the room left.
+ *
+ * @param  data Bytes to append
+ * @param  len  Number of bytes
+ * @retval None
+ */
+static void put_bytes(const uint8_t *data, uint32_t len)
+{
+  uint32_t off = hciCapture.head & RING_MASK;
+  uint32_t first = HCI_CAPTURE_RING_SIZE - off;
+
+  if (first > len)
+  {
+    first = len;
+  }
+  BLUENRG_memcpy(&hciCapture.ring[off], data, first);
+  BLUENRG_memcpy(hciCapture.ring, data + first, len - first);
+  hciCapture.head += len;
+}
+
+/**
+ * @brief  Stores a big endian 32-bit value.
+ */
+static void put_be32(uint8_t *dst, uint32_t val)
+{
+  dst[0] = (uint8_t)(val >> 24);
+  dst[1] = (uint8_t)(val >> 16);
+  dst[2] = (uint8_t)(val >> 8);
+  dst[3] = (uint8_t)val;
+}
+
+/**
+ * @brief  Microseconds since reset, from the HAL tick and the SysTick counter.
+ *         Called with interrupts masked, so a SysTick wrap that has not been
+ *         serviced yet shows as a pending SysTick exception.
+ *
+ * @param  None
+ * @retval uint64_t time stamp
+ */
+static uint64_t time_us(void)
+{
+  uint32_t load = SysTick->LOAD + 1U;
+  uint32_t tick = HAL_GetTick();
+  uint32_t val = SysTick->VAL;
+
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0)
+  {
+    tick++;
+    val = SysTick->VAL;
+  }
+
+  return ((uint64_t)tick * 1000U) + (((uint64_t)(load - 1U - val) * 1000U) / load);
+}
+
+/**
+ * @brief  Requests the LPUART1 interrupt, which streams the ring out.
+ */
+static void kick(void)
+{
+  HAL_NVIC_SetPendingIRQ(LPUART1_IRQn);
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void hci_capture_init(void)
+{
+  hlpuart1.Init.BaudRate = HCI_CAPTURE_BAUDRATE;
+  if (HAL_UART_Init(&hlpuart1) != HAL_OK)
+  {
+    return;
+  }
+
+  /* LPUART1_TX on DMA2 Channel6 */
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  hdma_lpuart1_tx.Instance = DMA2_Channel6;
+  hdma_lpuart1_tx.Init.Request = DMA_REQUEST_4;
+  hdma_lpuart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_lpuart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_lpuart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_lpuart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_lpuart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_lpuart1_tx.Init.Mode = DMA_NORMAL;
+  hdma_lpuart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+  if (HAL_DMA_Init(&hdma_lpuart1_tx) != HAL_OK)
+  {
+    return;
+  }
+  __HAL_LINKDMA(&hlpuart1, hdmatx, hdma_lpuart1_tx);
+
+  HAL_NVIC_SetPriority(DMA2_Channel6_IRQn, IRQ_PRIO_UART, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Channel6_IRQn);
+  HAL_NVIC_SetPriority(LPUART1_IRQn, IRQ_PRIO_UART, 0);
+  HAL_NVIC_EnableIRQ(LPUART1_IRQn);
+
+  /* Console output queued since reset */
+  kick();
+}
+
+void hci_capture_packet(uint8_t flags, const tHciIOVec* iov, uint8_t iovcnt)
+{
+  uint8_t hdr[SYNC_SIZE + RECORD_HDR_SIZE];
+  uint32_t start = DWT->CYCCNT;
+  uint32_t orig_len = 0;
+  uint32_t incl_len;
+  uint32_t used;
+  uint32_t primask;
+  uint64_t stamp;
+  uint8_t index;
+
+  for (index = 0; index < iovcnt; index++)
+  {
+    orig_len += iov[index].len;
+  }
+  incl_len = (orig_len > HCI_CAPTURE_SNAPLEN) ? HCI_CAPTURE_SNAPLEN : orig_len;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  if ((HCI_CAPTURE_RING_SIZE - (hciCapture.head - hciCapture.tail)) < (sizeof(hdr) + incl_len))
+  {
+    hciCapture.stats.dropped++;
+    __set_PRIMASK(primask);
+    return;
+  }
+
+  stamp = time_us();
+  hdr[0] = HCI_CAPTURE_SYNC_0;
+  hdr[1] = HCI_CAPTURE_SYNC_1;
+  hdr[2] = HCI_CAPTURE_SYNC_2;
+  hdr[3] = HCI_CAPTURE_SYNC_3;
+  put_be32(&hdr[4], orig_len);
+  put_be32(&hdr[8], incl_len);
+  put_be32(&hdr[12], flags);
+  put_be32(&hdr[16], hciCapture.stats.dropped);
+  put_be32(&hdr[20], (uint32_t)(stamp >> 32));
+  put_be32(&hdr[24], (uint32_t)stamp);
+  put_bytes(hdr, sizeof(hdr));
+
+  for (index = 0; (index < iovcnt) && (incl_len > 0); index++)
+  {
+    uint32_t len = (iov[index].len > incl_len) ? incl_len : iov[index].len;
+
+    put_bytes(iov[index].base, len);
+    incl_len -= len;
+  }
+
+  used = hciCapture.head - hciCapture.tail;
+  if (used > hciCapture.stats.high_watermark)
+  {
+    hciCapture.stats.high_watermark = used;
+  }
+  hciCapture.stats.records++;
+
+  start = DWT->CYCCNT - start;
+  hciCapture.stats.total_cycles += start;
+  if (start > hciCapture.stats.max_cycles)
+  {
+    hciCapture.stats.max_cycles = start;
+  }
+
+  __set_PRIMASK(primask);
+
+  kick();
+}
+
+void hci_capture_putchar(uint8_t ch)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (hciCapture.head - hciCapture.tail < HCI_CAPTURE_RING_SIZE)
+  {
+    hciCapture.ring[hciCapture.head & RING_MASK] = ch;
+    hciCapture.head++;
+  }
+  else
+  {
+    hciCapture.stats.text_dropped++;
+  }
+  __set_PRIMASK(primask);
+
+  /* Lines are streamed whole rather than one DMA per character */
+  if (ch == '\n')
+  {
+    kick();
+  }
+}
+
+void hci_capture_isr(void)
+{
+  uint32_t used;
+  uint32_t off;
+  uint32_t len;
+
+  if (hlpuart1.gState != HAL_UART_STATE_READY)
+  {
+    return;
+  }
+
+  /* The previous DMA is over: its part of the ring is free */
+  hciCapture.tail += hciCapture.chunk;
+  hciCapture.chunk = 0;
+
+  used = hciCapture.head - hciCapture.tail;
+  if (used == 0)
+  {
+    return;
+  }
+
+  off = hciCapture.tail & RING_MASK;
+  len = HCI_CAPTURE_RING_SIZE - off;
+  if (len > used)
+  {
+    len = used;
+  }
+  if (len > 0xFFFFU)
+  {
+    len = 0xFFFFU;
+  }
+
+  if (HAL_UART_Transmit_DMA(&hlpuart1, &hciCapture.ring[off], (uint16_t)len) == HAL_OK)
+  {
+    hciCapture.chunk = len;
+  }
+}
+
+void hci_capture_get_stats(tHciCaptureStats* stats)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *stats = hciCapture.stats;
+  __set_PRIMASK(primask);
+}
+
+#endif /* HCI_CAPTURE_ENABLED == 1 */
@@ -0,0 +1,101 @@
+/*
+ * hci_capture.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HCI_CAPTURE_H
+#define HCI_CAPTURE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "hci_tl.h"
+
+/* Exported Defines ----------------------------------------------------------*/
+
+/* btsnoop packet flags */
+#define HCI_CAPTURE_FLAG_RECEIVED  0x01U /* 0: host to controller, 1: controller to host */
+#define HCI_CAPTURE_FLAG_CMD_EVT   0x02U /* 0: ACL data, 1: command or event */
+
+/* Marker sent before each btsnoop record, so that the records can be told
+   apart from the console output sharing the UART */
+#define HCI_CAPTURE_SYNC_0         0xA5U
+#define HCI_CAPTURE_SYNC_1         0x5AU
+#define HCI_CAPTURE_SYNC_2         0xC3U
+#define HCI_CAPTURE_SYNC_3         0x3CU
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief Capture figures
+ */
+typedef struct
+{
+  uint32_t records;        /**< Packets captured */
+  uint32_t dropped;        /**< Packets lost for lack of room in the ring */
+  uint32_t text_dropped;   /**< Console characters lost for lack of room in the ring */
+  uint32_t high_watermark; /**< Highest occupancy of the ring, in bytes */
+  uint32_t max_cycles;     /**< Longest hci_capture_packet(), in core cycles */
+  uint32_t total_cycles;   /**< Sum of those times, divide by records for the mean */
+} tHciCaptureStats;
+
+/* Exported variables --------------------------------------------------------*/
+extern UART_HandleTypeDef hlpuart1;
+extern DMA_HandleTypeDef  hdma_lpuart1_tx;
+
+/* Exported Functions --------------------------------------------------------*/
+
+/**
+ * @brief  Sets LPUART1 to HCI_CAPTURE_BAUDRATE and starts streaming the ring.
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_capture_init(void);
+
+/**
+ * @brief  Appends a btsnoop record (H4 datalink) for one HCI packet.
+ *         Can be called from any context; the packet is copied.
+ *
+ * @param  flags  HCI_CAPTURE_FLAG_* of the packet
+ * @param  iov    Segments of the packet, H4 packet indicator first
+ * @param  iovcnt Number of segments
+ * @retval None
+ */
+void hci_capture_packet(uint8_t flags, const tHciIOVec* iov, uint8_t iovcnt);
+
+/**
+ * @brief  Appends a console character to the stream.
+ *         printf is routed here while the capture owns LPUART1.
+ *
+ * @param  ch Character
+ * @retval None
+ */
+void hci_capture_putchar(uint8_t ch);
+
+/**
+ * @brief  Starts the DMA for the next part of the ring. Called from the
+ *         LPUART1 interrupt, which the producers pend.
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_capture_isr(void);
+
+/**
+ * @brief  Get the capture figures.
+ *
+ * @param  stats Filled with the current figures
+ * @retval None
+ */
+void hci_capture_get_stats(tHciCaptureStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* HCI_CAPTURE_H */
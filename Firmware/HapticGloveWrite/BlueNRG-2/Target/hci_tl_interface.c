@@ -21,6 +21,9 @@
 #include "RTE_Components.h"
 
 #include "hci_tl.h"
+#include "irq_prof.h"
+
+#if (HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_SPI)
 
 /* Defines -------------------------------------------------------------------*/
 
@@ -29,12 +32,73 @@
 #define TIMEOUT_DURATION  100U
 #define TIMEOUT_IRQ_HIGH  1000U
 
+#define TX_SEG_MAX        4U  /* Segments of a scatter-gather write */
+#define TX_INLINE_SIZE    16U /* Leading bytes copied rather than sent in place */
+
+#define HEADER_CMD_WRITE  0x0aU
+#define HEADER_CMD_READ   0x0bU
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief SPI transport state. The machine is only advanced from the EXTI3
+ *        edge, the SPI DMA completion and the timeout tick, never by polling.
+ *        A frame read by DMA is handed over to hci_tl from PendSV, at the
+ *        bottom of the NVIC priority plan (see main.h).
+ */
+typedef enum
+{
+  HCI_TL_SPI_STATE_IDLE = 0, /**< CS released, nothing in flight */
+  HCI_TL_SPI_STATE_HEADER,   /**< CS asserted, waiting for IRQ high or exchanging the header */
+  HCI_TL_SPI_STATE_PAYLOAD,  /**< Payload DMA in progress */
+  HCI_TL_SPI_STATE_TRAILER   /**< Waiting for the BlueNRG-2 to drop IRQ before releasing CS */
+} HCI_TL_SPI_State_t;
+
+typedef enum
+{
+  HCI_TL_SPI_DIR_READ = 0,
+  HCI_TL_SPI_DIR_WRITE
+} HCI_TL_SPI_Dir_t;
+
+typedef struct
+{
+  volatile HCI_TL_SPI_State_t state;
+  volatile HCI_TL_SPI_Dir_t   dir;
+  volatile uint8_t            header_busy;  /**< Header DMA started for the current frame */
+  volatile uint32_t           deadline;     /**< Tick at which the current phase times out */
+  volatile uint32_t           tx_start;     /**< Tick at which the queued command was accepted */
+  volatile uint16_t           tx_len;       /**< Length of the queued command, 0 if none */
+  uint32_t                    tx_cycles;    /**< CYCCNT at which the queued command was accepted */
+  volatile uint16_t           rx_len;       /**< Length of the frame held for hci_tl, 0 if none */
+  volatile uint32_t           rx_retry;     /**< Tick at which a refused delivery is retried */
+  uint16_t                    xfer_len;     /**< Length of the payload DMA in progress */
+  uint8_t                     tx_seg_num;   /**< Segments of the queued command */
+  uint8_t                     tx_seg_idx;   /**< Segment whose DMA is in progress */
+  const uint8_t              *tx_seg_base[TX_SEG_MAX];
+  uint16_t                    tx_seg_len[TX_SEG_MAX];
+  uint8_t                     header_master[HEADER_SIZE];
+  uint8_t                     header_slave[HEADER_SIZE];
+  uint8_t                     tx_buf[MAX_BUFFER_SIZE];
+  uint8_t                     rx_buf[MAX_BUFFER_SIZE];
+  HCI_TL_Stats_t              stats;
+} HCI_TL_SPI_Context_t;
+
 /* Private variables ---------------------------------------------------------*/
 EXTI_HandleTypeDef hexti3;
 
+static HCI_TL_SPI_Context_t hci_tl_spi;
+static const uint8_t hci_tl_spi_dummy_tx[MAX_BUFFER_SIZE] = {0};
+static uint8_t hci_tl_spi_dummy_rx[MAX_BUFFER_SIZE];
+
 /* Private function prototypes -----------------------------------------------*/
 static void HCI_TL_SPI_Enable_IRQ(void);
 static void HCI_TL_SPI_Disable_IRQ(void);
+static void HCI_TL_SPI_Kick(void);
+static void HCI_TL_SPI_Process(void);
+static void HCI_TL_SPI_Release(void);
+static void HCI_TL_SPI_Deliver(void);
+static void HCI_TL_SPI_TransferCplt(void);
+static int32_t HCI_TL_SPI_TimedOut(void);
 static int32_t IsDataAvailable(void);
 
 /******************** IO Operation and BUS services ***************************/
@@ -71,9 +135,9 @@ int32_t HCI_TL_SPI_Init(void* pConf)
 
   __HAL_RCC_GPIOA_CLK_ENABLE();
 
-  /* Configure EXTI Line */
+  /* Configure EXTI Line: the rising edge starts a frame, the falling edge ends it */
   GPIO_InitStruct.Pin = HCI_TL_SPI_EXTI_PIN;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(HCI_TL_SPI_EXTI_PORT, &GPIO_InitStruct);
 
@@ -119,6 +183,15 @@ int32_t HCI_TL_SPI_DeInit(void)
  */
 int32_t HCI_TL_SPI_Reset(void)
 {
+  HCI_TL_SPI_Disable_IRQ();
+
+  /* Drop whatever was in flight, the BlueNRG-2 forgets it as well */
+  (void)HAL_SPI_Abort(&hspi1);
+  hci_tl_spi.state = HCI_TL_SPI_STATE_IDLE;
+  hci_tl_spi.header_busy = 0;
+  hci_tl_spi.tx_len = 0;
+  hci_tl_spi.rx_len = 0;
+
   // Deselect CS PIN for BlueNRG to avoid spurious commands
   HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
 
@@ -126,11 +199,17 @@ int32_t HCI_TL_SPI_Reset(void)
   HAL_Delay(5);
   HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_SET);
   HAL_Delay(5);
+
+  HCI_TL_SPI_Enable_IRQ();
   return 0;
 }
 
 /**
- * @brief  Reads from BlueNRG SPI buffer and store data into local buffer.
+ * @brief  Copies the frame held by the transport into the HCI buffer.
+ * @note   Called by hci_notify_asynch_evt() from the transport's deferred
+ *         delivery, in PendSV. The frame has already been read by DMA, so this never
+ *         touches the bus. The transport keeps the frame until
+ *         hci_notify_asynch_evt() reports it as consumed.
  *
  * @param  buffer : Buffer where data from SPI are stored
  * @param  size   : Buffer size
@@ -138,159 +217,438 @@ int32_t HCI_TL_SPI_Reset(void)
  */
 int32_t HCI_TL_SPI_Receive(uint8_t* buffer, uint16_t size)
 {
-  uint16_t byte_count;
-  uint8_t len = 0;
-  uint8_t char_00 = 0x00;
-  volatile uint8_t read_char;
+  uint16_t len = hci_tl_spi.rx_len;
 
-  uint8_t header_master[HEADER_SIZE] = {0x0b, 0x00, 0x00, 0x00, 0x00};
-  uint8_t header_slave[HEADER_SIZE];
+  /* avoid to read more data than the size of the buffer */
+  if (len > size)
+  {
+    len = size;
+  }
 
-  HCI_TL_SPI_Disable_IRQ();
+  BLUENRG_memcpy(buffer, hci_tl_spi.rx_buf, len);
 
-  /* CS reset */
-  HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_RESET);
+  return len;
+}
 
-  /* Read the header */
-  BSP_SPI1_SendRecv(header_master, header_slave, HEADER_SIZE);
+/**
+ * @brief  Queues a command to be written to the BlueNRG-2.
+ * @note   Returns immediately; the write is carried out by the transport
+ *         state machine as soon as the BlueNRG-2 signals it is ready.
+ *
+ * @param  buffer : data buffer to be written
+ * @param  size   : size of first data buffer to be written
+ * @retval int32_t: 0 if queued, -1 if a command is already pending, -2 if too long
+ */
+int32_t HCI_TL_SPI_Send(uint8_t* buffer, uint16_t size)
+{
+  if (size > MAX_BUFFER_SIZE)
+  {
+    return -2;
+  }
+
+  if (hci_tl_spi.tx_len != 0)
+  {
+    return -1;
+  }
+
+  BLUENRG_memcpy(hci_tl_spi.tx_buf, buffer, size);
+  hci_tl_spi.tx_seg_base[0] = hci_tl_spi.tx_buf;
+  hci_tl_spi.tx_seg_len[0] = size;
+  hci_tl_spi.tx_seg_num = 1;
+  hci_tl_spi.tx_start = HAL_GetTick();
+  hci_tl_spi.tx_cycles = DWT->CYCCNT;
+  __DMB();
+  hci_tl_spi.tx_len = size;
+
+  HCI_TL_SPI_Kick();
+
+  return 0;
+}
 
-  /* device is ready */
-  byte_count = (header_slave[4] << 8)| header_slave[3];
+/**
+ * @brief  Queues a command made of several segments, written as one frame.
+ * @note   The first segment and the following ones that fit in TX_INLINE_SIZE
+ *         bytes are copied; the others are read in place by the DMA and must
+ *         stay valid until the command has been answered.
+ *
+ * @param  iov    : segments to be written
+ * @param  iovcnt : number of segments
+ * @retval int32_t: 0 if queued, -1 if a command is already pending, -2 if too long
+ */
+int32_t HCI_TL_SPI_SendV(const tHciIOVec* iov, uint8_t iovcnt)
+{
+  uint16_t size = 0;
+  uint16_t inline_len = 0;
+  uint8_t index;
+  uint8_t seg;
 
-  if(byte_count > 0)
+  for (index = 0; index < iovcnt; index++)
   {
+    size += iov[index].len;
+  }
 
-    /* avoid to read more data than the size of the buffer */
-    if (byte_count > size)
-    {
-      byte_count = size;
-    }
+  if ((size > MAX_BUFFER_SIZE) || (iovcnt == 0) || (iovcnt > TX_SEG_MAX))
+  {
+    return -2;
+  }
+
+  if (hci_tl_spi.tx_len != 0)
+  {
+    return -1;
+  }
 
-    for(len = 0; len < byte_count; len++)
+  for (index = 0; index < iovcnt; index++)
+  {
+    if ((index > 0) && (inline_len + iov[index].len > TX_INLINE_SIZE))
     {
-      BSP_SPI1_SendRecv(&char_00, (uint8_t*)&read_char, 1);
-      buffer[len] = read_char;
+      break;
     }
+    BLUENRG_memcpy(&hci_tl_spi.tx_buf[inline_len], iov[index].base, iov[index].len);
+    inline_len += iov[index].len;
   }
 
-  /**
-   * To be aligned to the SPI protocol.
-   * Can bring to a delay inside the frame, due to the BlueNRG-2 that needs
-   * to check if the header is received or not.
-   */
-  uint32_t tickstart = HAL_GetTick();
-  while ((HAL_GetTick() - tickstart) < TIMEOUT_IRQ_HIGH) {
-    if (HAL_GPIO_ReadPin(HCI_TL_SPI_IRQ_PORT, HCI_TL_SPI_IRQ_PIN)==GPIO_PIN_RESET) {
-      break;
+  hci_tl_spi.tx_seg_base[0] = hci_tl_spi.tx_buf;
+  hci_tl_spi.tx_seg_len[0] = inline_len;
+  for (seg = 1; index < iovcnt; index++)
+  {
+    if (iov[index].len == 0)
+    {
+      continue;
     }
+    hci_tl_spi.tx_seg_base[seg] = iov[index].base;
+    hci_tl_spi.tx_seg_len[seg] = iov[index].len;
+    seg++;
   }
-  HCI_TL_SPI_Enable_IRQ();
+  hci_tl_spi.tx_seg_num = seg;
+  hci_tl_spi.tx_start = HAL_GetTick();
+  hci_tl_spi.tx_cycles = DWT->CYCCNT;
+  __DMB();
+  hci_tl_spi.tx_len = size;
 
-  /* Release CS line */
-  HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
+  HCI_TL_SPI_Kick();
 
-  return len;
+  return 0;
 }
 
 /**
- * @brief  Writes data from local buffer to SPI.
+ * @brief  Reports if the BlueNRG has data for the host micro.
  *
- * @param  buffer : data buffer to be written
- * @param  size   : size of first data buffer to be written
- * @retval int32_t: Number of read bytes
+ * @param  None
+ * @retval int32_t: 1 if data are present, 0 otherwise
  */
-int32_t HCI_TL_SPI_Send(uint8_t* buffer, uint16_t size)
+static int32_t IsDataAvailable(void)
 {
-  int32_t result;
-  uint16_t rx_bytes;
+  return (HAL_GPIO_ReadPin(HCI_TL_SPI_EXTI_PORT, HCI_TL_SPI_EXTI_PIN) == GPIO_PIN_SET);
+}
 
-  uint8_t header_master[HEADER_SIZE] = {0x0a, 0x00, 0x00, 0x00, 0x00};
-  uint8_t header_slave[HEADER_SIZE];
+/**
+ * @brief  Re-evaluates the state machine from the transport's interrupt level.
+ * @note   Raises a software trigger on the EXTI line so that every state
+ *         transition runs in the same interrupt context as the IRQ edge and
+ *         the DMA completion. No interrupt masking is needed around it.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_SPI_Kick(void)
+{
+  EXTI->SWIER1 = HCI_TL_SPI_EXTI_PIN;
+}
 
-  static uint8_t read_char_buf[MAX_BUFFER_SIZE];
-  uint32_t tickstart = HAL_GetTick();
+/**
+ * @brief  Checks whether the current phase has run past its deadline.
+ *
+ * @param  None
+ * @retval int32_t: 1 if timed out, 0 otherwise
+ */
+static int32_t HCI_TL_SPI_TimedOut(void)
+{
+  return ((int32_t)(HAL_GetTick() - hci_tl_spi.deadline) >= 0);
+}
 
-  HCI_TL_SPI_Disable_IRQ();
+/**
+ * @brief  Releases CS and returns the state machine to idle.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_SPI_Release(void)
+{
+  HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
+  hci_tl_spi.header_busy = 0;
+  hci_tl_spi.state = HCI_TL_SPI_STATE_IDLE;
+}
 
-  do
+/**
+ * @brief  Requests the delivery of the frame held by the transport.
+ * @note   The copy, check and classification of the packet by hci_tl run in
+ *         PendSV, so the transport interrupts only ever move bytes.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_SPI_Deliver(void)
+{
+  IRQ_Prof_Pend(IRQ_PROF_HCI_DELIVER);
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief  Advances the SPI transport state machine.
+ * @note   Runs from the EXTI3 interrupt (IRQ edges, software kicks and
+ *         timeouts) and from the SPI DMA completion, which share the same
+ *         NVIC priority and therefore never preempt each other.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_SPI_Process(void)
+{
+  for (;;)
   {
-    uint32_t tickstart_data_available = HAL_GetTick();
+    switch (hci_tl_spi.state)
+    {
+    case HCI_TL_SPI_STATE_IDLE:
+      if (IsDataAvailable() && (hci_tl_spi.rx_len == 0))
+      {
+        /* The BlueNRG-2 has an event for us: read the header */
+        hci_tl_spi.dir = HCI_TL_SPI_DIR_READ;
+        hci_tl_spi.state = HCI_TL_SPI_STATE_HEADER;
+        hci_tl_spi.header_busy = 1;
+        hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_IRQ_HIGH;
+        hci_tl_spi.header_master[0] = HEADER_CMD_READ;
+        BLUENRG_memset(&hci_tl_spi.header_master[1], 0x00, HEADER_SIZE - 1U);
+
+        /* CS reset */
+        HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_RESET);
+        if (BSP_SPI1_SendRecv_DMA(hci_tl_spi.header_master, hci_tl_spi.header_slave, HEADER_SIZE) != BSP_ERROR_NONE)
+        {
+          HCI_TL_SPI_Release();
+        }
+        return;
+      }
 
-    result = 0;
+      if (hci_tl_spi.tx_len != 0)
+      {
+        if ((HAL_GetTick() - hci_tl_spi.tx_start) > TIMEOUT_DURATION)
+        {
+          /* The BlueNRG-2 never accepted the command: drop it */
+          hci_tl_spi.tx_len = 0;
+          return;
+        }
+
+        /* CS reset, then wait for the BlueNRG-2 to raise IRQ when it is ready */
+        hci_tl_spi.dir = HCI_TL_SPI_DIR_WRITE;
+        hci_tl_spi.state = HCI_TL_SPI_STATE_HEADER;
+        hci_tl_spi.header_busy = 0;
+        hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_DURATION;
+        HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_RESET);
+        continue;
+      }
+      return;
 
-    /* CS reset */
-    HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_RESET);
+    case HCI_TL_SPI_STATE_HEADER:
+      if (hci_tl_spi.header_busy)
+      {
+        /* Header DMA still running: only a stuck transfer ends up here */
+        if (HCI_TL_SPI_TimedOut())
+        {
+          (void)HAL_SPI_Abort(&hspi1);
+          hci_tl_spi.stats.rx_errors++;
+          HCI_TL_SPI_Release();
+          continue;
+        }
+        return;
+      }
 
-    /*
-     * Wait until BlueNRG-2 is ready.
-     * When ready it will raise the IRQ pin.
-     */
-    while(!IsDataAvailable())
-    {
-      if((HAL_GetTick() - tickstart_data_available) > TIMEOUT_DURATION)
+      if (IsDataAvailable())
       {
-        result = -3;
-        break;
+        hci_tl_spi.header_busy = 1;
+        hci_tl_spi.header_master[0] = HEADER_CMD_WRITE;
+        BLUENRG_memset(&hci_tl_spi.header_master[1], 0x00, HEADER_SIZE - 1U);
+        if (BSP_SPI1_SendRecv_DMA(hci_tl_spi.header_master, hci_tl_spi.header_slave, HEADER_SIZE) != BSP_ERROR_NONE)
+        {
+          HCI_TL_SPI_Release();
+          hci_tl_spi.deadline = HAL_GetTick() + 1U;
+        }
+        return;
       }
-    }
-    if(result == -3)
-    {
-      /* The break causes the exiting from the "while", so the CS line must be released */
-      HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
-      break;
-    }
 
-    /* Read header */
-    BSP_SPI1_SendRecv(header_master, header_slave, HEADER_SIZE);
+      if (HCI_TL_SPI_TimedOut())
+      {
+        /* BlueNRG-2 not ready: release CS, the idle state retries or gives up */
+        HCI_TL_SPI_Release();
+        continue;
+      }
+      return;
+
+    case HCI_TL_SPI_STATE_PAYLOAD:
+      if (HCI_TL_SPI_TimedOut())
+      {
+        (void)HAL_SPI_Abort(&hspi1);
+        hci_tl_spi.stats.rx_errors++;
+        HCI_TL_SPI_Release();
+        continue;
+      }
+      return;
+
+    case HCI_TL_SPI_STATE_TRAILER:
+      /**
+       * To be aligned to the SPI protocol.
+       * Can bring to a delay inside the frame, due to the BlueNRG-2 that needs
+       * to check if the header is received or not.
+       * The falling edge of IRQ brings us back here instead of spinning.
+       * A read holds CS meanwhile, a write has already released it.
+       */
+      if ((HAL_GPIO_ReadPin(HCI_TL_SPI_IRQ_PORT, HCI_TL_SPI_IRQ_PIN) == GPIO_PIN_RESET) ||
+          HCI_TL_SPI_TimedOut())
+      {
+        HCI_TL_SPI_Release();
+        continue;
+      }
+      return;
+
+    default:
+      HCI_TL_SPI_Release();
+      return;
+    }
+  }
+}
 
-    rx_bytes = (((uint16_t)header_slave[2])<<8) | ((uint16_t)header_slave[1]);
+/**
+ * @brief  Header or payload DMA completed.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_SPI_TransferCplt(void)
+{
+  uint16_t byte_count;
 
-    if(rx_bytes >= size)
+  if (hci_tl_spi.state == HCI_TL_SPI_STATE_HEADER)
+  {
+    if (hci_tl_spi.dir == HCI_TL_SPI_DIR_READ)
     {
-      /* Buffer is big enough */
-      BSP_SPI1_SendRecv(buffer, read_char_buf, size);
+      /* device is ready */
+      byte_count = (hci_tl_spi.header_slave[4] << 8) | hci_tl_spi.header_slave[3];
+
+      /* avoid to read more data than the size of the buffer */
+      if (byte_count > MAX_BUFFER_SIZE)
+      {
+        byte_count = MAX_BUFFER_SIZE;
+      }
+
+      if (byte_count > 0)
+      {
+        hci_tl_spi.xfer_len = byte_count;
+        hci_tl_spi.state = HCI_TL_SPI_STATE_PAYLOAD;
+        hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_IRQ_HIGH;
+        if (BSP_SPI1_SendRecv_DMA((uint8_t *)hci_tl_spi_dummy_tx, hci_tl_spi.rx_buf, byte_count) != BSP_ERROR_NONE)
+        {
+          HCI_TL_SPI_Release();
+        }
+        return;
+      }
     }
     else
     {
-      /* Buffer is too small */
-      result = -2;
-    }
+      byte_count = (((uint16_t)hci_tl_spi.header_slave[2]) << 8) | ((uint16_t)hci_tl_spi.header_slave[1]);
 
-    /* Release CS line */
-    HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
+      if (byte_count >= hci_tl_spi.tx_len)
+      {
+        /* Buffer is big enough: the segments are chained with CS held low */
+        hci_tl_spi.tx_seg_idx = 0;
+        hci_tl_spi.xfer_len = hci_tl_spi.tx_seg_len[0];
+        hci_tl_spi.state = HCI_TL_SPI_STATE_PAYLOAD;
+        hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_DURATION;
+        if (BSP_SPI1_SendRecv_DMA((uint8_t *)hci_tl_spi.tx_seg_base[0], hci_tl_spi_dummy_rx, hci_tl_spi.xfer_len) != BSP_ERROR_NONE)
+        {
+          HCI_TL_SPI_Release();
+        }
+        return;
+      }
 
-    if((HAL_GetTick() - tickstart) > TIMEOUT_DURATION)
+      /* Buffer is too small: release CS and retry on the next tick */
+      HCI_TL_SPI_Release();
+      hci_tl_spi.deadline = HAL_GetTick() + 1U;
+      return;
+    }
+  }
+  else if (hci_tl_spi.state == HCI_TL_SPI_STATE_PAYLOAD)
+  {
+    if (hci_tl_spi.dir == HCI_TL_SPI_DIR_READ)
     {
-      result = -3;
-      break;
+      hci_tl_spi.rx_len = hci_tl_spi.xfer_len;
+      HCI_TL_SPI_Deliver();
     }
-  } while(result < 0);
-
-  /**
-   * To be aligned to the SPI protocol.
-   * Can bring to a delay inside the frame, due to the BlueNRG-2 that needs
-   * to check if the header is received or not.
-   */
-  tickstart = HAL_GetTick();
-  while ((HAL_GetTick() - tickstart) < TIMEOUT_IRQ_HIGH) {
-    if (HAL_GPIO_ReadPin(HCI_TL_SPI_IRQ_PORT, HCI_TL_SPI_IRQ_PIN)==GPIO_PIN_RESET) {
-      break;
+    else if (++hci_tl_spi.tx_seg_idx < hci_tl_spi.tx_seg_num)
+    {
+      uint8_t seg = hci_tl_spi.tx_seg_idx;
+
+      hci_tl_spi.xfer_len = hci_tl_spi.tx_seg_len[seg];
+      hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_DURATION;
+      if (BSP_SPI1_SendRecv_DMA((uint8_t *)hci_tl_spi.tx_seg_base[seg], hci_tl_spi_dummy_rx, hci_tl_spi.xfer_len) != BSP_ERROR_NONE)
+      {
+        HCI_TL_SPI_Release();
+      }
+      return;
+    }
+    else
+    {
+      uint32_t cycles = DWT->CYCCNT - hci_tl_spi.tx_cycles;
+
+      hci_tl_spi.stats.tx_frames++;
+      hci_tl_spi.stats.tx_bytes += hci_tl_spi.tx_len;
+      hci_tl_spi.stats.tx_total_cycles += cycles;
+      if (cycles > hci_tl_spi.stats.tx_max_cycles)
+      {
+        hci_tl_spi.stats.tx_max_cycles = cycles;
+      }
+      hci_tl_spi.tx_len = 0;
     }
   }
-  HCI_TL_SPI_Enable_IRQ();
+  else
+  {
+    return;
+  }
+
+  /* Release CS line after a write, as the blocking send did, before waiting for IRQ low */
+  if (hci_tl_spi.dir == HCI_TL_SPI_DIR_WRITE)
+  {
+    HAL_GPIO_WritePin(HCI_TL_SPI_CS_PORT, HCI_TL_SPI_CS_PIN, GPIO_PIN_SET);
+  }
 
-  return result;
+  hci_tl_spi.state = HCI_TL_SPI_STATE_TRAILER;
+  hci_tl_spi.deadline = HAL_GetTick() + TIMEOUT_IRQ_HIGH;
+  HCI_TL_SPI_Process();
 }
 
 /**
- * @brief  Reports if the BlueNRG has data for the host micro.
- *
- * @param  None
- * @retval int32_t: 1 if data are present, 0 otherwise
- */
-static int32_t IsDataAvailable(void)
+  * @brief  SPI full duplex DMA transfer completed.
+  * @param  hspi SPI handle
+  * @retval None
+  */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 {
-  return (HAL_GPIO_ReadPin(HCI_TL_SPI_EXTI_PORT, HCI_TL_SPI_EXTI_PIN) == GPIO_PIN_SET);
+  if (hspi->Instance == BUS_SPI1_INSTANCE)
+  {
+    HCI_TL_SPI_TransferCplt();
+  }
+}
+
+/**
+  * @brief  SPI transfer error: abandon the frame and resynchronise on IRQ.
+  * @param  hspi SPI handle
+  * @retval None
+  */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+  if (hspi->Instance == BUS_SPI1_INSTANCE)
+  {
+    hci_tl_spi.stats.rx_errors++;
+    HCI_TL_SPI_Release();
+    HCI_TL_SPI_Process();
+  }
 }
 
 /***************************** hci_tl_interface main functions *****************************/
@@ -311,6 +669,7 @@ void hci_tl_lowlevel_init(void)
   fops.Init    = HCI_TL_SPI_Init;
   fops.DeInit  = HCI_TL_SPI_DeInit;
   fops.Send    = HCI_TL_SPI_Send;
+  fops.SendV   = HCI_TL_SPI_SendV;
   fops.Receive = HCI_TL_SPI_Receive;
   fops.Reset   = HCI_TL_SPI_Reset;
   fops.GetTick = BSP_GetTick;
@@ -324,9 +683,21 @@ void hci_tl_lowlevel_init(void)
   /* Register event irq handler */
   HAL_EXTI_GetHandle(&hexti3, EXTI_LINE_3);
   HAL_EXTI_RegisterCallback(&hexti3, HAL_EXTI_COMMON_CB_ID, hci_tl_lowlevel_isr);
-  HAL_NVIC_SetPriority(EXTI3_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(EXTI3_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
   HAL_NVIC_EnableIRQ(EXTI3_IRQn);
 
+  /* The SPI DMA completion advances the same state machine as EXTI3, so it
+     must run at the same priority */
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+  HAL_NVIC_SetPriority(SPI1_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(SPI1_IRQn);
+
+  /* Received frames are handed over to hci_tl below every other interrupt */
+  HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_HCI_DELIVER, 0);
+
   /* USER CODE BEGIN hci_tl_lowlevel_init 3 */
 
   /* USER CODE END hci_tl_lowlevel_init 3 */
@@ -341,16 +712,97 @@ void hci_tl_lowlevel_init(void)
   */
 void hci_tl_lowlevel_isr(void)
 {
-  /* Call hci_notify_asynch_evt() */
-  while(IsDataAvailable())
+  /* IRQ edge, software kick or timeout: let the state machine decide */
+  HCI_TL_SPI_Process();
+
+  /* USER CODE BEGIN hci_tl_lowlevel_isr */
+
+  /* USER CODE END hci_tl_lowlevel_isr */
+}
+
+/**
+  * @brief HCI Transport Layer deferred delivery, called from PendSV
+  * @note  Hands the frame read by the transport over to hci_tl. If hci_tl has
+  *        no free packet the frame stays here and no further read is started,
+  *        so the BlueNRG-2 keeps the next events queued; the timeout tick
+  *        retries the delivery.
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_tl_lowlevel_deliver(void)
+{
+  if (hci_tl_spi.rx_len == 0)
+  {
+    return;
+  }
+
+  if (hci_notify_asynch_evt(NULL) == 0)
+  {
+    hci_tl_spi.stats.rx_frames++;
+    hci_tl_spi.stats.rx_bytes += hci_tl_spi.rx_len;
+    hci_tl_spi.rx_len = 0;
+
+    /* The BlueNRG-2 may hold further events: let the transport read them */
+    HCI_TL_SPI_Kick();
+  }
+  else
+  {
+    hci_tl_spi.rx_retry = HAL_GetTick() + 1U;
+  }
+}
+
+/**
+  * @brief HCI Transport Layer timeout tick, called every millisecond
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_tl_lowlevel_tick(void)
+{
+  if ((hci_tl_spi.rx_len != 0) &&
+      ((int32_t)(HAL_GetTick() - hci_tl_spi.rx_retry) >= 0))
+  {
+    HCI_TL_SPI_Deliver();
+  }
+
+  if ((hci_tl_spi.state != HCI_TL_SPI_STATE_IDLE) || (hci_tl_spi.tx_len != 0))
   {
-    if (hci_notify_asynch_evt(NULL))
+    if (HCI_TL_SPI_TimedOut())
     {
-      return;
+      HCI_TL_SPI_Kick();
     }
   }
+}
 
-  /* USER CODE BEGIN hci_tl_lowlevel_isr */
+/**
+  * @brief Deepest low-power mode the transport allows right now: Stop 2 once
+  *        the bus is idle, the EXTI line of the IRQ pin waking the MCU up
+  *
+  * @param  None
+  * @retval HCI_TL_IDLE_BUSY or HCI_TL_IDLE_STOP
+  */
+uint8_t hci_tl_lowlevel_idle_mode(void)
+{
+  if ((hci_tl_spi.state != HCI_TL_SPI_STATE_IDLE) || (hci_tl_spi.tx_len != 0) || (hci_tl_spi.rx_len != 0))
+  {
+    return HCI_TL_IDLE_BUSY;
+  }
 
-  /* USER CODE END hci_tl_lowlevel_isr */
+  return HCI_TL_IDLE_STOP;
 }
+
+/**
+  * @brief Get the figures of the transport in use
+  *
+  * @param  stats Filled with the current figures
+  * @retval None
+  */
+void hci_tl_lowlevel_get_stats(HCI_TL_Stats_t* stats)
+{
+  __disable_irq();
+  *stats = hci_tl_spi.stats;
+  __enable_irq();
+}
+
+#endif /* HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_SPI */
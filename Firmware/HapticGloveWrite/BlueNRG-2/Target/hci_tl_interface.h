@@ -26,6 +26,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "custom_bus.h"
+#include "bluenrg_conf.h"
 
 /* Exported Defines ----------------------------------------------------------*/
 
@@ -39,20 +40,62 @@
 #define HCI_TL_SPI_CS_PORT    GPIOC
 #define HCI_TL_SPI_CS_PIN     GPIO_PIN_0
 
+/* Highest SPI clock the BlueNRG-2 is driven at, whatever the system clock */
+#define HCI_TL_SPI_MAX_CLOCK_HZ  1000000U
+
 #define HCI_TL_RST_PORT       GPIOF
 #define HCI_TL_RST_PIN        GPIO_PIN_13
 
+#define HCI_TL_UART_INSTANCE  USART3
+#define HCI_TL_UART_IRQn      USART3_IRQn
+
+/* Deepest low-power mode the transport allows, from hci_tl_lowlevel_idle_mode() */
+#define HCI_TL_IDLE_BUSY      0U /* Transfer or retry in progress: keep the tick running */
+#define HCI_TL_IDLE_SLEEP     1U /* Nothing in progress, but the bus must stay clocked */
+#define HCI_TL_IDLE_STOP      2U /* Stop 2: the BlueNRG-2 IRQ line wakes the MCU up */
+
+/* Exported types ------------------------------------------------------------*/
+struct _tHciIOVec; /* tHciIOVec, defined in hci_tl.h */
+
+/**
+ * @brief Transport figures, used to compare the SPI and UART transports on a
+ *        board revision. Cycle counts come from the DWT cycle counter.
+ */
+typedef struct
+{
+  uint32_t rx_frames;       /**< Frames handed over to hci_tl */
+  uint32_t rx_bytes;        /**< Bytes of those frames */
+  uint32_t rx_errors;       /**< SPI: aborted transfers, UART: resynchronisations and overruns */
+  uint32_t tx_frames;       /**< Commands written to the BlueNRG-2 */
+  uint32_t tx_bytes;        /**< Bytes of those commands */
+  uint32_t tx_max_cycles;   /**< Longest time from Send() to the end of the write */
+  uint32_t tx_total_cycles; /**< Sum of those times, divide by tx_frames for the mean */
+} HCI_TL_Stats_t;
+
 /* Exported variables --------------------------------------------------------*/
 extern EXTI_HandleTypeDef     hexti3;
 #define H_EXTI_3 hexti3
 
+#if (HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_UART)
+extern DMA_HandleTypeDef      hdma_usart3_rx;
+extern DMA_HandleTypeDef      hdma_usart3_tx;
+#endif
+
 /* Exported Functions --------------------------------------------------------*/
 int32_t HCI_TL_SPI_Init    (void* pConf);
 int32_t HCI_TL_SPI_DeInit  (void);
 int32_t HCI_TL_SPI_Receive (uint8_t* buffer, uint16_t size);
 int32_t HCI_TL_SPI_Send    (uint8_t* buffer, uint16_t size);
+int32_t HCI_TL_SPI_SendV   (const struct _tHciIOVec* iov, uint8_t iovcnt);
 int32_t HCI_TL_SPI_Reset   (void);
 
+int32_t HCI_TL_UART_Init    (void* pConf);
+int32_t HCI_TL_UART_DeInit  (void);
+int32_t HCI_TL_UART_Receive (uint8_t* buffer, uint16_t size);
+int32_t HCI_TL_UART_Send    (uint8_t* buffer, uint16_t size);
+int32_t HCI_TL_UART_SendV   (const struct _tHciIOVec* iov, uint8_t iovcnt);
+int32_t HCI_TL_UART_Reset   (void);
+
 /**
  * @brief  Register hci_tl_interface IO bus services
  *
@@ -69,6 +112,39 @@ void hci_tl_lowlevel_init(void);
  */
 void hci_tl_lowlevel_isr(void);
 
+/**
+ * @brief HCI Transport Layer deferred delivery, called from PendSV
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_tl_lowlevel_deliver(void);
+
+/**
+ * @brief HCI Transport Layer timeout tick, called every millisecond
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_tl_lowlevel_tick(void);
+
+/**
+ * @brief Deepest low-power mode the transport allows right now.
+ *        Called with interrupts masked before the MCU goes idle.
+ *
+ * @param  None
+ * @retval HCI_TL_IDLE_BUSY, HCI_TL_IDLE_SLEEP or HCI_TL_IDLE_STOP
+ */
+uint8_t hci_tl_lowlevel_idle_mode(void);
+
+/**
+ * @brief Get the figures of the transport in use
+ *
+ * @param  stats Filled with the current figures
+ * @retval None
+ */
+void hci_tl_lowlevel_get_stats(HCI_TL_Stats_t* stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,743 @@
+/*
+ * hci_tl_interface_uart.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// HCI transport layer interface over UART (H4), used with the BlueNRG-2 UART
+// network coprocessor firmware, in place of hci_tl_interface.c.
+
+/* Includes ------------------------------------------------------------------*/
+#include "RTE_Components.h"
+
+#include "hci_tl.h"
+#include "irq_prof.h"
+
+#if (HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_UART)
+
+/* Defines -------------------------------------------------------------------*/
+
+#define MAX_BUFFER_SIZE   255U
+
+#define TX_SEG_MAX        4U  /* Segments of a scatter-gather write */
+#define TX_INLINE_SIZE    16U /* Leading bytes copied rather than sent in place */
+
+#define RX_RING_MASK      (HCI_TL_UART_RX_RING_SIZE - 1U)
+
+#if ((HCI_TL_UART_RX_RING_SIZE & RX_RING_MASK) != 0)
+#error "HCI_TL_UART_RX_RING_SIZE must be a power of two"
+#endif
+
+/* H4 packet indicators and header lengths */
+#define H4_TYPE_ACL       0x02U
+#define H4_TYPE_EVENT     0x04U
+#define H4_ACL_HDR_SIZE   4U
+#define H4_EVENT_HDR_SIZE 2U
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+ * @brief H4 reassembly state. The stream is parsed from the circular DMA
+ *        buffer each time the DMA reports progress (half, full or idle line).
+ */
+typedef enum
+{
+  HCI_TL_UART_H4_TYPE = 0, /**< Waiting for the packet indicator */
+  HCI_TL_UART_H4_HEADER,   /**< Reading the event or ACL header */
+  HCI_TL_UART_H4_PAYLOAD   /**< Reading the parameters */
+} HCI_TL_UART_H4_State_t;
+
+typedef struct
+{
+  volatile uint16_t           rx_len;       /**< Length of the frame held for hci_tl, 0 if none */
+  volatile uint32_t           rx_retry;     /**< Tick at which a refused delivery is retried */
+  volatile uint16_t           tx_len;       /**< Length of the queued command, 0 if none */
+  volatile uint8_t            tx_busy;      /**< Transmit DMA started for the queued command */
+  uint32_t                    tx_cycles;    /**< CYCCNT at which the queued command was accepted */
+  uint8_t                     tx_seg_num;   /**< Segments of the queued command */
+  uint8_t                     tx_seg_idx;   /**< Segment whose DMA is in progress */
+  const uint8_t              *tx_seg_base[TX_SEG_MAX];
+  uint16_t                    tx_seg_len[TX_SEG_MAX];
+  uint32_t                    rx_dma_pos;   /**< Offset in the ring the DMA will write next */
+  uint32_t                    rx_wr;        /**< Bytes written by the DMA, free running */
+  uint32_t                    rx_rd;        /**< Bytes parsed, free running */
+  HCI_TL_UART_H4_State_t      h4_state;
+  uint16_t                    h4_len;       /**< Bytes of the current frame */
+  uint16_t                    h4_need;      /**< Bytes missing to end the header or the payload */
+  uint8_t                     h4_hdr_size;  /**< Header length of the current packet type */
+  uint8_t                     h4_drop;      /**< Current frame is too long and is skipped */
+  uint8_t                     tx_buf[MAX_BUFFER_SIZE];
+  uint8_t                     rx_buf[MAX_BUFFER_SIZE];
+  uint8_t                     rx_ring[HCI_TL_UART_RX_RING_SIZE];
+  HCI_TL_Stats_t              stats;
+} HCI_TL_UART_Context_t;
+
+/* Private variables ---------------------------------------------------------*/
+EXTI_HandleTypeDef hexti3; /* EXTI3 is not used by the UART firmware */
+DMA_HandleTypeDef hdma_usart3_rx;
+DMA_HandleTypeDef hdma_usart3_tx;
+
+extern UART_HandleTypeDef huart3;
+
+static HCI_TL_UART_Context_t hci_tl_uart;
+
+/* Private function prototypes -----------------------------------------------*/
+static void HCI_TL_UART_Kick(void);
+static void HCI_TL_UART_StartRx(void);
+static void HCI_TL_UART_StartTx(void);
+static void HCI_TL_UART_Parse(void);
+static void HCI_TL_UART_EndFrame(void);
+static void HCI_TL_UART_Deliver(void);
+
+/******************** IO Operation and BUS services ***************************/
+/**
+ * @brief  Initializes the DMA channels of USART3 and starts the reception.
+ * @note   USART3 itself is configured by MX_USART3_UART_Init(); only the
+ *         baud rate is adapted to the network coprocessor firmware.
+ *
+ * @param  void* Pointer to configuration struct
+ * @retval int32_t Status
+ */
+int32_t HCI_TL_UART_Init(void* pConf)
+{
+  GPIO_InitTypeDef GPIO_InitStruct;
+
+  /* Configure RESET Line */
+  GPIO_InitStruct.Pin =  HCI_TL_RST_PIN ;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(HCI_TL_RST_PORT, &GPIO_InitStruct);
+
+  if (huart3.Init.BaudRate != HCI_TL_UART_BAUDRATE)
+  {
+    huart3.Init.BaudRate = HCI_TL_UART_BAUDRATE;
+    if (HAL_UART_Init(&huart3) != HAL_OK)
+    {
+      return BSP_ERROR_PERIPH_FAILURE;
+    }
+  }
+
+  /* USART3 DMA Init: USART3_TX on DMA1 Channel2, USART3_RX on DMA1 Channel3 */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  hdma_usart3_rx.Instance = DMA1_Channel3;
+  hdma_usart3_rx.Init.Request = DMA_REQUEST_2;
+  hdma_usart3_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_usart3_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_usart3_rx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usart3_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_usart3_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_usart3_rx.Init.Mode = DMA_CIRCULAR;
+  hdma_usart3_rx.Init.Priority = DMA_PRIORITY_HIGH;
+  if (HAL_DMA_Init(&hdma_usart3_rx) != HAL_OK)
+  {
+    return BSP_ERROR_PERIPH_FAILURE;
+  }
+  __HAL_LINKDMA(&huart3, hdmarx, hdma_usart3_rx);
+
+  hdma_usart3_tx.Instance = DMA1_Channel2;
+  hdma_usart3_tx.Init.Request = DMA_REQUEST_2;
+  hdma_usart3_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_usart3_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_usart3_tx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_usart3_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_usart3_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_usart3_tx.Init.Mode = DMA_NORMAL;
+  hdma_usart3_tx.Init.Priority = DMA_PRIORITY_HIGH;
+  if (HAL_DMA_Init(&hdma_usart3_tx) != HAL_OK)
+  {
+    return BSP_ERROR_PERIPH_FAILURE;
+  }
+  __HAL_LINKDMA(&huart3, hdmatx, hdma_usart3_tx);
+
+  HCI_TL_UART_StartRx();
+
+  return BSP_ERROR_NONE;
+}
+
+/**
+ * @brief  DeInitializes the peripherals communication with the BlueNRG
+ *
+ * @param  None
+ * @retval int32_t 0
+ */
+int32_t HCI_TL_UART_DeInit(void)
+{
+  (void)HAL_UART_Abort(&huart3);
+  HAL_DMA_DeInit(&hdma_usart3_rx);
+  HAL_DMA_DeInit(&hdma_usart3_tx);
+  HAL_GPIO_DeInit(HCI_TL_RST_PORT, HCI_TL_RST_PIN);
+  return 0;
+}
+
+/**
+ * @brief Reset BlueNRG module.
+ *
+ * @param  None
+ * @retval int32_t 0
+ */
+int32_t HCI_TL_UART_Reset(void)
+{
+  HAL_NVIC_DisableIRQ(HCI_TL_UART_IRQn);
+
+  /* Drop whatever was in flight, the BlueNRG-2 forgets it as well */
+  (void)HAL_UART_Abort(&huart3);
+  hci_tl_uart.tx_busy = 0;
+  hci_tl_uart.tx_len = 0;
+  hci_tl_uart.rx_len = 0;
+
+  HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_RESET);
+  HAL_Delay(5);
+  HAL_GPIO_WritePin(HCI_TL_RST_PORT, HCI_TL_RST_PIN, GPIO_PIN_SET);
+  HAL_Delay(5);
+
+  HCI_TL_UART_StartRx();
+  HAL_NVIC_EnableIRQ(HCI_TL_UART_IRQn);
+  return 0;
+}
+
+/**
+ * @brief  Copies the frame held by the transport into the HCI buffer.
+ * @note   Called by hci_notify_asynch_evt() from the deferred delivery, in
+ *         PendSV. The frame has already been reassembled from the DMA ring.
+ *
+ * @param  buffer : Buffer where the frame is stored
+ * @param  size   : Buffer size
+ * @retval int32_t: Number of read bytes
+ */
+int32_t HCI_TL_UART_Receive(uint8_t* buffer, uint16_t size)
+{
+  uint16_t len = hci_tl_uart.rx_len;
+
+  /* avoid to read more data than the size of the buffer */
+  if (len > size)
+  {
+    len = size;
+  }
+
+  BLUENRG_memcpy(buffer, hci_tl_uart.rx_buf, len);
+
+  return len;
+}
+
+/**
+ * @brief  Queues a command to be written to the BlueNRG-2.
+ *
+ * @param  buffer : data buffer to be written
+ * @param  size   : size of first data buffer to be written
+ * @retval int32_t: 0 if queued, -1 if a command is already pending, -2 if too long
+ */
+int32_t HCI_TL_UART_Send(uint8_t* buffer, uint16_t size)
+{
+  if (size > MAX_BUFFER_SIZE)
+  {
+    return -2;
+  }
+
+  if (hci_tl_uart.tx_len != 0)
+  {
+    return -1;
+  }
+
+  BLUENRG_memcpy(hci_tl_uart.tx_buf, buffer, size);
+  hci_tl_uart.tx_seg_base[0] = hci_tl_uart.tx_buf;
+  hci_tl_uart.tx_seg_len[0] = size;
+  hci_tl_uart.tx_seg_num = 1;
+  hci_tl_uart.tx_cycles = DWT->CYCCNT;
+  __DMB();
+  hci_tl_uart.tx_len = size;
+
+  HCI_TL_UART_Kick();
+
+  return 0;
+}
+
+/**
+ * @brief  Queues a command made of several segments, written as one frame.
+ * @note   The first segment and the following ones that fit in TX_INLINE_SIZE
+ *         bytes are copied; the others are read in place by the DMA and must
+ *         stay valid until the command has been answered.
+ *
+ * @param  iov    : segments to be written
+ * @param  iovcnt : number of segments
+ * @retval int32_t: 0 if queued, -1 if a command is already pending, -2 if too long
+ */
+int32_t HCI_TL_UART_SendV(const tHciIOVec* iov, uint8_t iovcnt)
+{
+  uint16_t size = 0;
+  uint16_t inline_len = 0;
+  uint8_t index;
+  uint8_t seg;
+
+  for (index = 0; index < iovcnt; index++)
+  {
+    size += iov[index].len;
+  }
+
+  if ((size > MAX_BUFFER_SIZE) || (iovcnt == 0) || (iovcnt > TX_SEG_MAX))
+  {
+    return -2;
+  }
+
+  if (hci_tl_uart.tx_len != 0)
+  {
+    return -1;
+  }
+
+  for (index = 0; index < iovcnt; index++)
+  {
+    if ((index > 0) && (inline_len + iov[index].len > TX_INLINE_SIZE))
+    {
+      break;
+    }
+    BLUENRG_memcpy(&hci_tl_uart.tx_buf[inline_len], iov[index].base, iov[index].len);
+    inline_len += iov[index].len;
+  }
+
+  hci_tl_uart.tx_seg_base[0] = hci_tl_uart.tx_buf;
+  hci_tl_uart.tx_seg_len[0] = inline_len;
+  for (seg = 1; index < iovcnt; index++)
+  {
+    if (iov[index].len == 0)
+    {
+      continue;
+    }
+    hci_tl_uart.tx_seg_base[seg] = iov[index].base;
+    hci_tl_uart.tx_seg_len[seg] = iov[index].len;
+    seg++;
+  }
+  hci_tl_uart.tx_seg_num = seg;
+  hci_tl_uart.tx_cycles = DWT->CYCCNT;
+  __DMB();
+  hci_tl_uart.tx_len = size;
+
+  HCI_TL_UART_Kick();
+
+  return 0;
+}
+
+/**
+ * @brief  Runs the transport from its own interrupt level.
+ * @note   Pends the USART3 interrupt, so that the DMA progress, the parser
+ *         and the start of a write never preempt each other.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_Kick(void)
+{
+  HAL_NVIC_SetPendingIRQ(HCI_TL_UART_IRQn);
+}
+
+/**
+ * @brief  (Re)starts the circular reception with idle-line detection.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_StartRx(void)
+{
+  hci_tl_uart.rx_dma_pos = 0;
+  hci_tl_uart.rx_rd = hci_tl_uart.rx_wr;
+  hci_tl_uart.h4_state = HCI_TL_UART_H4_TYPE;
+
+  if (HAL_UARTEx_ReceiveToIdle_DMA(&huart3, hci_tl_uart.rx_ring, HCI_TL_UART_RX_RING_SIZE) != HAL_OK)
+  {
+    hci_tl_uart.stats.rx_errors++;
+  }
+}
+
+/**
+ * @brief  Starts the write of the queued command, one DMA per segment.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_StartTx(void)
+{
+  if ((hci_tl_uart.tx_len == 0) || hci_tl_uart.tx_busy)
+  {
+    return;
+  }
+
+  hci_tl_uart.tx_busy = 1;
+  hci_tl_uart.tx_seg_idx = 0;
+  if (HAL_UART_Transmit_DMA(&huart3, (uint8_t *)hci_tl_uart.tx_seg_base[0], hci_tl_uart.tx_seg_len[0]) != HAL_OK)
+  {
+    /* UART still busy: the next kick or tick retries */
+    hci_tl_uart.tx_busy = 0;
+  }
+}
+
+/**
+ * @brief  Requests the delivery of the frame held by the transport.
+ * @note   The copy, check and classification of the packet by hci_tl run in
+ *         PendSV, so the transport interrupts only ever move bytes.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_Deliver(void)
+{
+  IRQ_Prof_Pend(IRQ_PROF_HCI_DELIVER);
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief  Ends the frame being reassembled and holds it for hci_tl.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_EndFrame(void)
+{
+  hci_tl_uart.h4_state = HCI_TL_UART_H4_TYPE;
+  if (!hci_tl_uart.h4_drop)
+  {
+    hci_tl_uart.rx_len = hci_tl_uart.h4_len;
+    HCI_TL_UART_Deliver();
+  }
+}
+
+/**
+ * @brief  Reassembles H4 packets from the bytes received so far.
+ * @note   Stops at the end of a frame while hci_tl has not taken it; the
+ *         following bytes wait in the ring. Unknown packet indicators are
+ *         skipped one byte at a time until the stream is back in step.
+ *
+ * @param  None
+ * @retval None
+ */
+static void HCI_TL_UART_Parse(void)
+{
+  while ((hci_tl_uart.rx_len == 0) && (hci_tl_uart.rx_rd != hci_tl_uart.rx_wr))
+  {
+    uint8_t byte;
+
+    if ((hci_tl_uart.rx_wr - hci_tl_uart.rx_rd) > HCI_TL_UART_RX_RING_SIZE)
+    {
+      /* The DMA lapped the parser: what is left is not a stream any more */
+      hci_tl_uart.rx_rd = hci_tl_uart.rx_wr;
+      hci_tl_uart.h4_state = HCI_TL_UART_H4_TYPE;
+      hci_tl_uart.stats.rx_errors++;
+      return;
+    }
+
+    byte = hci_tl_uart.rx_ring[hci_tl_uart.rx_rd & RX_RING_MASK];
+    hci_tl_uart.rx_rd++;
+
+    switch (hci_tl_uart.h4_state)
+    {
+    case HCI_TL_UART_H4_TYPE:
+      if (byte == H4_TYPE_EVENT)
+      {
+        hci_tl_uart.h4_hdr_size = H4_EVENT_HDR_SIZE;
+      }
+      else if (byte == H4_TYPE_ACL)
+      {
+        hci_tl_uart.h4_hdr_size = H4_ACL_HDR_SIZE;
+      }
+      else
+      {
+        hci_tl_uart.stats.rx_errors++;
+        break;
+      }
+      hci_tl_uart.rx_buf[0] = byte;
+      hci_tl_uart.h4_len = 1;
+      hci_tl_uart.h4_need = hci_tl_uart.h4_hdr_size;
+      hci_tl_uart.h4_drop = 0;
+      hci_tl_uart.h4_state = HCI_TL_UART_H4_HEADER;
+      break;
+
+    case HCI_TL_UART_H4_HEADER:
+      hci_tl_uart.rx_buf[hci_tl_uart.h4_len++] = byte;
+      if (--hci_tl_uart.h4_need != 0)
+      {
+        break;
+      }
+
+      if (hci_tl_uart.h4_hdr_size == H4_EVENT_HDR_SIZE)
+      {
+        hci_tl_uart.h4_need = hci_tl_uart.rx_buf[2];
+      }
+      else
+      {
+        hci_tl_uart.h4_need = ((uint16_t)hci_tl_uart.rx_buf[4] << 8) | hci_tl_uart.rx_buf[3];
+      }
+
+      if (hci_tl_uart.h4_len + hci_tl_uart.h4_need > MAX_BUFFER_SIZE)
+      {
+        /* Longer than any packet hci_tl accepts: skip it, staying in step */
+        hci_tl_uart.h4_drop = 1;
+        hci_tl_uart.stats.rx_errors++;
+      }
+
+      if (hci_tl_uart.h4_need == 0)
+      {
+        HCI_TL_UART_EndFrame();
+        break;
+      }
+      hci_tl_uart.h4_state = HCI_TL_UART_H4_PAYLOAD;
+      break;
+
+    case HCI_TL_UART_H4_PAYLOAD:
+      if (!hci_tl_uart.h4_drop)
+      {
+        hci_tl_uart.rx_buf[hci_tl_uart.h4_len] = byte;
+      }
+      hci_tl_uart.h4_len++;
+      if (--hci_tl_uart.h4_need == 0)
+      {
+        HCI_TL_UART_EndFrame();
+      }
+      break;
+
+    default:
+      hci_tl_uart.h4_state = HCI_TL_UART_H4_TYPE;
+      break;
+    }
+  }
+}
+
+/**
+  * @brief  Reception progress: half buffer, full buffer or idle line.
+  * @param  huart UART handle
+  * @param  Size  Offset in the ring up to which the DMA has written
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  uint32_t pos = Size;
+
+  if (huart->Instance != HCI_TL_UART_INSTANCE)
+  {
+    return;
+  }
+
+  if (pos >= hci_tl_uart.rx_dma_pos)
+  {
+    hci_tl_uart.rx_wr += pos - hci_tl_uart.rx_dma_pos;
+  }
+  else
+  {
+    hci_tl_uart.rx_wr += pos + HCI_TL_UART_RX_RING_SIZE - hci_tl_uart.rx_dma_pos;
+  }
+  hci_tl_uart.rx_dma_pos = (pos == HCI_TL_UART_RX_RING_SIZE) ? 0 : pos;
+
+  HCI_TL_UART_Parse();
+}
+
+/**
+  * @brief  Segment written: start the next one or end the command.
+  * @param  huart UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  uint8_t seg;
+  uint32_t cycles;
+
+  if (huart->Instance != HCI_TL_UART_INSTANCE)
+  {
+    return;
+  }
+
+  seg = ++hci_tl_uart.tx_seg_idx;
+  if (seg < hci_tl_uart.tx_seg_num)
+  {
+    if (HAL_UART_Transmit_DMA(&huart3, (uint8_t *)hci_tl_uart.tx_seg_base[seg], hci_tl_uart.tx_seg_len[seg]) == HAL_OK)
+    {
+      return;
+    }
+    /* The frame is broken: the controller resynchronises on the next indicator */
+    hci_tl_uart.stats.rx_errors++;
+  }
+  else
+  {
+    cycles = DWT->CYCCNT - hci_tl_uart.tx_cycles;
+    hci_tl_uart.stats.tx_frames++;
+    hci_tl_uart.stats.tx_bytes += hci_tl_uart.tx_len;
+    hci_tl_uart.stats.tx_total_cycles += cycles;
+    if (cycles > hci_tl_uart.stats.tx_max_cycles)
+    {
+      hci_tl_uart.stats.tx_max_cycles = cycles;
+    }
+  }
+
+  hci_tl_uart.tx_busy = 0;
+  hci_tl_uart.tx_len = 0;
+}
+
+/**
+  * @brief  UART error (overrun, framing, noise): the HAL stops the
+  *         reception, restart it and resynchronise on the next packet.
+  * @param  huart UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if (huart->Instance != HCI_TL_UART_INSTANCE)
+  {
+    return;
+  }
+
+  hci_tl_uart.stats.rx_errors++;
+  if (huart->RxState == HAL_UART_STATE_READY)
+  {
+    HCI_TL_UART_StartRx();
+  }
+  if ((huart->gState == HAL_UART_STATE_READY) && hci_tl_uart.tx_busy)
+  {
+    hci_tl_uart.tx_busy = 0;
+    hci_tl_uart.tx_len = 0;
+  }
+}
+
+/***************************** hci_tl_interface main functions *****************************/
+/**
+ * @brief  Register hci_tl_interface IO bus services
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_tl_lowlevel_init(void)
+{
+  /* USER CODE BEGIN hci_tl_lowlevel_init 1 */
+
+  /* USER CODE END hci_tl_lowlevel_init 1 */
+  tHciIO fops;
+
+  /* Register IO bus services */
+  fops.Init    = HCI_TL_UART_Init;
+  fops.DeInit  = HCI_TL_UART_DeInit;
+  fops.Send    = HCI_TL_UART_Send;
+  fops.SendV   = HCI_TL_UART_SendV;
+  fops.Receive = HCI_TL_UART_Receive;
+  fops.Reset   = HCI_TL_UART_Reset;
+  fops.GetTick = BSP_GetTick;
+
+  hci_register_io_bus (&fops);
+
+  /* USER CODE BEGIN hci_tl_lowlevel_init 2 */
+
+  /* USER CODE END hci_tl_lowlevel_init 2 */
+
+  /* The DMA progress, the UART events and the kicks all run the same
+     transport, so they share one priority */
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+  HAL_NVIC_SetPriority(HCI_TL_UART_IRQn, IRQ_PRIO_HCI_TRANSPORT, 0);
+  HAL_NVIC_EnableIRQ(HCI_TL_UART_IRQn);
+
+  /* Received frames are handed over to hci_tl below every other interrupt */
+  HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_HCI_DELIVER, 0);
+
+  /* USER CODE BEGIN hci_tl_lowlevel_init 3 */
+
+  /* USER CODE END hci_tl_lowlevel_init 3 */
+
+}
+
+/**
+  * @brief HCI Transport Layer Low Level Interrupt Service Routine
+  * @note  Called from the USART3 interrupt, after the HAL handler
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_tl_lowlevel_isr(void)
+{
+  HCI_TL_UART_Parse();
+  HCI_TL_UART_StartTx();
+
+  /* USER CODE BEGIN hci_tl_lowlevel_isr */
+
+  /* USER CODE END hci_tl_lowlevel_isr */
+}
+
+/**
+  * @brief HCI Transport Layer deferred delivery, called from PendSV
+  * @note  Hands the reassembled frame over to hci_tl. If hci_tl has no free
+  *        packet the frame stays here and the following bytes wait in the
+  *        DMA ring; the timeout tick retries the delivery.
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_tl_lowlevel_deliver(void)
+{
+  if (hci_tl_uart.rx_len == 0)
+  {
+    return;
+  }
+
+  if (hci_notify_asynch_evt(NULL) == 0)
+  {
+    hci_tl_uart.stats.rx_frames++;
+    hci_tl_uart.stats.rx_bytes += hci_tl_uart.rx_len;
+    hci_tl_uart.rx_len = 0;
+
+    /* Further packets may be waiting in the ring */
+    HCI_TL_UART_Kick();
+  }
+  else
+  {
+    hci_tl_uart.rx_retry = HAL_GetTick() + 1U;
+  }
+}
+
+/**
+  * @brief HCI Transport Layer timeout tick, called every millisecond
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_tl_lowlevel_tick(void)
+{
+  if ((hci_tl_uart.rx_len != 0) &&
+      ((int32_t)(HAL_GetTick() - hci_tl_uart.rx_retry) >= 0))
+  {
+    HCI_TL_UART_Deliver();
+  }
+
+  if ((hci_tl_uart.tx_len != 0) && !hci_tl_uart.tx_busy)
+  {
+    HCI_TL_UART_Kick();
+  }
+}
+
+/**
+  * @brief Deepest low-power mode the transport allows right now. The circular
+  *        reception DMA runs all the time, so USART3 is never stopped
+  *
+  * @param  None
+  * @retval HCI_TL_IDLE_BUSY or HCI_TL_IDLE_SLEEP
+  */
+uint8_t hci_tl_lowlevel_idle_mode(void)
+{
+  if ((hci_tl_uart.tx_len != 0) || (hci_tl_uart.rx_len != 0))
+  {
+    return HCI_TL_IDLE_BUSY;
+  }
+
+  return HCI_TL_IDLE_SLEEP;
+}
+
+/**
+  * @brief Get the figures of the transport in use
+  *
+  * @param  stats Filled with the current figures
+  * @retval None
+  */
+void hci_tl_lowlevel_get_stats(HCI_TL_Stats_t* stats)
+{
+  __disable_irq();
+  *stats = hci_tl_uart.stats;
+  __enable_irq();
+}
+
+#endif /* HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_UART */
@@ -0,0 +1,127 @@
+/*
+ * irq_prof.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef INC_IRQ_PROF_H_
+#define INC_IRQ_PROF_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Profiled handlers */
+typedef enum {
+	IRQ_PROF_HAPTIC_RENDER = 0,	// TIM6: render tick
+	IRQ_PROF_HCI_EXTI,	// EXTI3: BlueNRG-2 IRQ line, SPI transport kicks and timeouts
+	IRQ_PROF_HCI_DMA_RX,	// SPI1 or USART3 RX DMA
+	IRQ_PROF_HCI_DMA_TX,	// SPI1 or USART3 TX DMA
+	IRQ_PROF_HCI_SPI,		// SPI1 errors
+	IRQ_PROF_HCI_UART,		// USART3: idle line, errors and transport kicks
+	IRQ_PROF_HCI_DELIVER,	// PendSV: packet delivery to hci_tl
+	IRQ_PROF_SYSTICK,
+	IRQ_PROF_NUM
+} IRQ_Prof_Id_t;
+
+typedef struct {
+	uint32_t count;			// Runs of the handler
+	uint32_t max_cycles;	// Longest run, in core cycles
+	uint32_t max_pend_cycles;	// Longest time from IRQ_Prof_Pend() to the handler entry
+	uint32_t pend_at;		// CYCCNT of the first request still waiting, 0 if none
+} IRQ_Prof_Stats_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern IRQ_Prof_Stats_t irq_prof_stats[IRQ_PROF_NUM];
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Enables the DWT cycle counter used to time the handlers
+ * @param 	none
+ * @retval	none
+ *
+ */
+void IRQ_Prof_Init(void);
+
+/*
+ *
+ * @brief 	Copies the figures of one handler
+ * @param 	IRQ_Prof_Id_t handler
+ * @param 	IRQ_Prof_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void IRQ_Prof_Get(IRQ_Prof_Id_t id, IRQ_Prof_Stats_t *stats);
+
+/*
+ *
+ * @brief 	Worst case latency of an interrupt at a given priority, from the
+ * 			measured handlers: every handler above it may run once, plus the
+ * 			longest handler at its own level, which it cannot preempt
+ * @param 	uint32_t preemption priority (IRQ_PRIO_*)
+ * @retval	uint32_t bound in core cycles
+ *
+ */
+uint32_t IRQ_Prof_Bound(uint32_t priority);
+
+/*
+ *
+ * @brief 	Timestamp taken on entry of a profiled handler
+ * @param 	none
+ * @retval	uint32_t CYCCNT
+ *
+ */
+static inline uint32_t IRQ_Prof_Enter(void)
+{
+	return DWT->CYCCNT;
+}
+
+/*
+ *
+ * @brief 	Accounts a run of a profiled handler
+ * @note	Each entry is only written by its own handler, which never
+ * 			preempts itself
+ * @param 	IRQ_Prof_Id_t handler
+ * @param 	uint32_t timestamp from IRQ_Prof_Enter()
+ * @retval	none
+ *
+ */
+static inline void IRQ_Prof_Exit(IRQ_Prof_Id_t id, uint32_t start)
+{
+	IRQ_Prof_Stats_t *stats = &irq_prof_stats[id];
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	if (stats->pend_at != 0) {
+		uint32_t pend_cycles = start - stats->pend_at;
+
+		if (pend_cycles > stats->max_pend_cycles) {
+			stats->max_pend_cycles = pend_cycles;
+		}
+		stats->pend_at = 0;
+	}
+
+	stats->count++;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+}
+
+/*
+ *
+ * @brief 	Records when a deferred handler was requested
+ * @param 	IRQ_Prof_Id_t handler
+ * @retval	none
+ *
+ */
+static inline void IRQ_Prof_Pend(IRQ_Prof_Id_t id)
+{
+	if (irq_prof_stats[id].pend_at == 0) {
+		irq_prof_stats[id].pend_at = DWT->CYCCNT | 1U;
+	}
+}
+
+#endif /* INC_IRQ_PROF_H_ */
@@ -43,6 +43,21 @@ extern "C" {
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
 
+/*
+ * NVIC priority plan (NVIC_PRIORITYGROUP_4: preemption only, 0 is the most
+ * urgent). The haptic render runs above the radio so that a burst of HCI
+ * traffic can never delay a PWM update; the radio transport only moves bytes
+ * and leaves the packet handling to PendSV at the bottom of the plan.
+ * The Cube generated settings (HapticGloveWrite.ioc, TICK_INT_PRIORITY) follow
+ * the same numbers.
+ */
+#define IRQ_PRIO_HAPTIC_RENDER	1U	// Haptic render timer
+#define IRQ_PRIO_SYSTICK		4U	// HAL time base, also times out the HCI transport
+#define IRQ_PRIO_HCI_TRANSPORT	5U	// BlueNRG-2 IRQ line (EXTI3), SPI1 and its DMA channels
+#define IRQ_PRIO_UART			6U	// Console / capture UART
+#define IRQ_PRIO_USER_BUTTON	7U	// EXTI15_10
+#define IRQ_PRIO_HCI_DELIVER	15U	// PendSV: received packets handed over to hci_tl
+
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
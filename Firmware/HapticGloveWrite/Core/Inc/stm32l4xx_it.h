@@ -58,6 +58,9 @@ void SysTick_Handler(void);
 void EXTI3_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA1_Channel2_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void SPI1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -9,6 +9,7 @@
 #include "bluenrg_init.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "bluenrg1_aci.h"
 #include "bluenrg1_hci_le.h"
@@ -18,12 +19,38 @@
 
 #include "gatt_db.h"
 #include "sensor.h"
+#include "scheduler.h"
+#include "timer_wheel.h"
+#include "low_power.h"
+#include "clock_profile.h"
+#include "reconnect.h"
+#include "link_policy.h"
+#include "telemetry.h"
+#include "notify_queue.h"
 
 
 // Do these need to change? / Is the authentication hard coded into the swift code?
 #define SECURE_PAIRING (0)
 #define PERIPHERAL_PASS_KEY (123456)
 
+// The configuration starts on aci_blue_initialized_event, or after this delay
+// if the BlueNRG-2 does not report its boot
+#define BLUENRG_BOOT_TIMEOUT_MS (2000)
+
+// Reason_Code of aci_blue_initialized_event: 0x02 - 0x04 are the updater modes
+#define BLUE_INIT_UPDATER_FIRST (0x02)
+#define BLUE_INIT_UPDATER_LAST (0x04)
+
+// Completion context of a boot step: the step, and the boot it belongs to so
+// the completions of a boot cut short by a reset are told apart
+#define BOOT_CTX(step) ((void *)(uintptr_t)(((uint32_t)boot_generation << 8) | (uint32_t)(step)))
+#define BOOT_CTX_STEP(ctx) ((Boot_Step_t)((uintptr_t)(ctx) & 0xFFU))
+#define BOOT_CTX_GENERATION(ctx) ((uint8_t)((uintptr_t)(ctx) >> 8))
+
+// Blink period of the LED while paired
+#define PAIRED_BLINK_DELAY_MS (1000)
+#define PAIRED_BLINK_PERIOD_MS (1000)
+
 // TODO: Verify that this is not being used.
 //#define USE_BUTTON(0)
 
@@ -44,12 +71,93 @@ uint8_t bdaddr[BDADDR_SIZE];
 // static volatile uint8_t user_button_pressed = 0;
 extern __IO uint8_t send_num;
 
+// Timer driven continuations
+static Timer_t boot_timer;
+static Timer_t paired_timer;
+static Timer_t hci_timeout_timer;
+
+// Boot sequence. Each step is timed from the moment it is queued to its
+// completion; the steps queued together overlap
+typedef enum {
+	BOOT_STEP_RESET = 0,	// Hardware reset to aci_blue_initialized_event
+	BOOT_STEP_VERSION,
+	BOOT_STEP_READ_ADDR,
+	BOOT_STEP_TX_POWER,
+	BOOT_STEP_RADIO_MASK,
+	BOOT_STEP_WRITE_ADDR,
+	BOOT_STEP_GATT_INIT,
+	BOOT_STEP_GAP_INIT,
+	BOOT_STEP_DEVICE_NAME,
+	BOOT_STEP_AUTH,
+	BOOT_STEP_SERVICES,
+	BOOT_STEP_ADVERTISING,
+	BOOT_STEP_NUM
+} Boot_Step_t;
+
+typedef enum {
+	BOOT_STATE_RESET = 0,		// Waiting for the BlueNRG-2 to boot
+	BOOT_STATE_CONFIG,			// Configuration commands queued
+	BOOT_STATE_SERVICES,		// GATT services to add, from the user task
+	BOOT_STATE_ADVERTISING,		// Waiting for the advertising to start
+	BOOT_STATE_READY
+} Boot_State_t;
+
+#if (BLE2_DEBUG == 1)
+static const char *const boot_step_name[BOOT_STEP_NUM] = {
+	[BOOT_STEP_RESET] = "reset",
+	[BOOT_STEP_VERSION] = "version",
+	[BOOT_STEP_READ_ADDR] = "read address",
+	[BOOT_STEP_TX_POWER] = "tx power",
+	[BOOT_STEP_RADIO_MASK] = "radio mask",
+	[BOOT_STEP_WRITE_ADDR] = "write address",
+	[BOOT_STEP_GATT_INIT] = "gatt init",
+	[BOOT_STEP_GAP_INIT] = "gap init",
+	[BOOT_STEP_DEVICE_NAME] = "device name",
+	[BOOT_STEP_AUTH] = "authentication",
+	[BOOT_STEP_SERVICES] = "services",
+	[BOOT_STEP_ADVERTISING] = "advertising",
+};
+#endif
+
+static struct {
+	uint32_t start_us;
+	uint32_t end_us;
+} boot_profile[BOOT_STEP_NUM];
+
+static Boot_State_t boot_state = BOOT_STATE_RESET;
+static uint8_t boot_pending;	// Commands left before the services are added
+static uint8_t boot_generation;	// Boots started since power-on
+
+// Current link
+static struct {
+	uint32_t connect_tick;
+	uint32_t first_frame_ms;
+	uint8_t ready;		// Encrypted
+	uint8_t paired_now;	// Keys exchanged by pairing on this link, not taken from a bond
+	uint8_t framed;		// First haptic frame received
+	uint8_t peer_addr[6];	// Peer of the link, the target of a reconnection
+	uint8_t peer_type;
+} link;
+static Link_Stats_t link_stats;
+
 
 // -- Private Function Declarations
 static void User_Process(void);
 static void User_Init(void);
-static uint8_t Sensor_DeviceInit(void);
+static uint32_t Boot_Micros(void);
+static void Boot_Queue(Boot_Step_t step);
+static void Boot_Queued(Boot_Step_t step, tBleStatus ret);
+static void Boot_Start(void);
+static void Boot_Fail(Boot_Step_t step, uint8_t status);
+static void Boot_Report(void);
+static void Boot_Cplt_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx);
 static void Set_Number(float* data);
+static void Slave_Security_Req_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx);
+static void Boot_Timer_CB(void *ctx);
+static void Paired_Timer_CB(void *ctx);
+static void HCI_Timeout_Timer_CB(void *ctx);
+static void HCI_Process(void);
+static void Link_Ready(void);
 
 /**
  *
@@ -61,224 +169,407 @@ static void Set_Number(float* data);
  **/
 void MX_BlueNRG_2_Init(void) {
 
-	uint8_t ret;
-
 	User_Init();
+	Reconnect_Init();
+	LinkPolicy_Init();
+	Telemetry_Init();
+	Notify_Init();
 
 	// user_button_init_state = BSP_PB_GetState(BUTTON_KEY);
 
 	// This passes the callback that we made in sensor, which lets give it to this function, and it will call
-	// whenever some event occurs.
+	// whenever some event occurs. It also resets the BlueNRG-2
+	boot_profile[BOOT_STEP_RESET].start_us = Boot_Micros();
+	// Armed by the transport while asynchronous commands are pending
+	Timer_Create(&hci_timeout_timer, HCI_Timeout_Timer_CB, NULL);
 	hci_init(APP_UserEvtRx, NULL);
 
 	PRINT_DBG("\033[2J"); // Serial console clear screen
 	PRINT_DBG("\033[H"); // Serial console cursor to home
 	PRINT_DBG("Haptic Glove Grid Write Application\r\n");
 
-	// Initializing the sensor device
-	ret = Sensor_DeviceInit();
-	if (ret != BLE_STATUS_SUCCESS)
-	{
-		// Turn on the LED
-		HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, 1);
-		while (1); // endless loop to stop program.
+	// BlueNRG-2 background tasks: run when a packet arrives or the connection state changes
+	Sched_RegTask(SCHED_TASK_HCI, HCI_Process);
+	Sched_RegTask(SCHED_TASK_USER, User_Process);
 
-	}
+	Timer_Create(&boot_timer, Boot_Timer_CB, NULL);
+	Timer_Create(&paired_timer, Paired_Timer_CB, NULL);
 
-	PRINT_DBG("BLE Stack Initialized and Device Configured\r\n");
+	// Configured once it reports its boot, see aci_blue_initialized_event()
+	Timer_Start(&boot_timer, BLUENRG_BOOT_TIMEOUT_MS, 0);
 
 }
 
-// BlueNRG-2 background task
-void MX_BlueNRG_2_Process(void)
+/**
+ * @brief  Time since power-on in us, from the HAL tick and the SysTick counter
+ * @param  None
+ * @retval Time in us
+ */
+static uint32_t Boot_Micros(void)
 {
+	uint32_t ms;
+	uint32_t count;
 
-	hci_user_evt_proc();
-	User_Process();
+	// The tick may move between the two reads
+	do {
+		ms = HAL_GetTick();
+		count = SysTick->LOAD - SysTick->VAL;
+	} while (ms != HAL_GetTick());
 
+	return (ms * 1000U) + ((count * 1000U) / (SysTick->LOAD + 1U));
 }
 
-/*
- * @brief Initialize User Process
- *
- * @param None
+/**
+ * @brief  Makes the next ACI command a boot step: asynchronous, completed
+ *         in Boot_Cplt_CB()
+ * @param  step Boot step
  * @retval None
  */
-static void User_Init(void)
+static void Boot_Queue(Boot_Step_t step)
 {
-
-	// Null. Not required in this applciation
-
-	// BSP_PB_Init()
-	// BSP_LED_Init(LED2)
-	// BSP_COM_Init(COM1)
-
+	boot_profile[step].start_us = Boot_Micros();
+	hci_set_next_req_async(Boot_Cplt_CB, BOOT_CTX(step));
 }
 
+/**
+ * @brief  Completes at once a boot step whose command could not be queued
+ * @param  step Boot step
+ * @param  ret Status returned by the ACI command
+ * @retval None
+ */
+static void Boot_Queued(Boot_Step_t step, tBleStatus ret)
+{
+	if (ret != BLE_STATUS_SUCCESS) {
+		Boot_Cplt_CB(0, ret, NULL, 0, BOOT_CTX(step));
+	}
+}
 
-/*
- *
- * @brief Initalize the device sensors
- * @param None
+/**
+ * @brief  Start of the configuration. The commands that do not depend on
+ *         one another are queued together, the others from the completion
+ *         of the command they depend on
+ * @param  None
  * @retval None
- *
  */
-uint8_t Sensor_DeviceInit(void)
+static void Boot_Start(void)
 {
-	uint8_t ret;
-	uint16_t service_handle, dev_name_char_handle, appearance_char_handle;
-	uint8_t device_name[] = {SENSOR_DEMO_NAME};
-	uint8_t hwVersion;
-	uint16_t fwVersion;
+	uint8_t hci_version, lmp_pal_version;
+	uint16_t hci_revision, manufacturer_name, lmp_pal_subversion;
 	uint8_t bdaddr_len_out;
 	uint8_t config_data_stored_static_random_address = 0x80; // This is an offset of a static random address stored in NVM?
 
-	// Software reset of the device
-	hci_reset();
+	Timer_Stop(&boot_timer);
+	boot_state = BOOT_STATE_CONFIG;
+	boot_pending = 0;
 
-	// The BlueNRG-2 required a minimum delay of 2000ms for device boot
-	HAL_Delay(2000);
+	// Asynchronous: the output parameters are not written, the answers come to Boot_Cplt_CB()
+	Boot_Queue(BOOT_STEP_VERSION);
+	Boot_Queued(BOOT_STEP_VERSION, hci_read_local_version_information(&hci_version, &hci_revision, &lmp_pal_version,
+																	&manufacturer_name, &lmp_pal_subversion));
 
-	// getting the bluenrg hw and firmware versions
-	getBlueNRGVersion(&hwVersion, &fwVersion);
+	Boot_Queue(BOOT_STEP_READ_ADDR);
+	Boot_Queued(BOOT_STEP_READ_ADDR, aci_hal_read_config_data(config_data_stored_static_random_address,
+															&bdaddr_len_out, bdaddr));
+
+	// Set the TX power to -2 dBm
+	Boot_Queue(BOOT_STEP_TX_POWER);
+	Boot_Queued(BOOT_STEP_TX_POWER, aci_hal_set_tx_power_level(1, 4));
+
+	// Announce the next radio event at the end of each one, for the low-power idle
+	Boot_Queue(BOOT_STEP_RADIO_MASK);
+	Boot_Queued(BOOT_STEP_RADIO_MASK, aci_hal_set_radio_activity_mask(LOWPOWER_RADIO_ACTIVITY_MASK));
+}
+
+/**
+ * @brief  A boot step the glove cannot do without failed: stop there
+ * @param  step Boot step
+ * @param  status Command status
+ * @retval None
+ */
+static void Boot_Fail(Boot_Step_t step, uint8_t status)
+{
+	PRINT_DBG("Boot step %s failed: 0x%02x\r\n", boot_step_name[step], status);
 
-	PRINT_DBG("HWver %d\nFwver %d\r\n", hwVersion, fwVersion);
+	// Turn on the LED
+	HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, 1);
+	while (1); // endless loop to stop program.
+}
 
-	ret = aci_hal_read_config_data(config_data_stored_static_random_address,
-									&bdaddr_len_out, bdaddr);
-	if (ret) {
-		PRINT_DBG("Read Static Random address failed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
+/**
+ * @brief  Prints the boot profile: start of each step from the reset, and
+ *         its duration
+ * @param  None
+ * @retval None
+ */
+static void Boot_Report(void)
+{
+#if (BLE2_DEBUG == 1)
+	uint32_t origin = boot_profile[BOOT_STEP_RESET].start_us;
+	uint32_t step;
+
+	PRINT_DBG("Boot profile (us)        start  duration\r\n");
+	for (step = 0; step < BOOT_STEP_NUM; step++) {
+		PRINT_DBG("  %-16s %10lu %9lu\r\n", boot_step_name[step],
+				  (unsigned long)(boot_profile[step].start_us - origin),
+				  (unsigned long)(boot_profile[step].end_us - boot_profile[step].start_us));
 	}
+	PRINT_DBG("Connectable %lu us after power-on\r\n", (unsigned long)boot_profile[BOOT_STEP_ADVERTISING].end_us);
+#endif
+}
 
-	if ((bdaddr[5] & 0xC0) != 0xC0) {
-		PRINT_DBG("Static Random address not well formed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-		while(1);
+/**
+ * @brief  Completion of the boot steps
+ * @param  See hci_cmd_cplt_cb_t in hci_tl.h, ctx is BOOT_CTX(step)
+ * @retval None
+ */
+static void Boot_Cplt_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	Boot_Step_t step = BOOT_CTX_STEP(ctx);
+	uint8_t ok = (status == BLE_STATUS_SUCCESS) && (rparam != NULL);
+	uint8_t device_name[] = {SENSOR_DEMO_NAME};
+
+	// Step of a boot the BlueNRG-2 reset cut short: the new boot has taken over
+	if (BOOT_CTX_GENERATION(ctx) != boot_generation) {
+		return;
 	}
 
-	ret = aci_hal_write_config_data(CONFIG_DATA_PUBADDR_OFFSET,
-									bdaddr_len_out,
-									bdaddr);
+	boot_profile[step].end_us = Boot_Micros();
+
+	switch (step) {
+	case BOOT_STEP_VERSION:
+		if (ok && (rlen >= sizeof(hci_read_local_version_information_rp0))) {
+			const hci_read_local_version_information_rp0 *rp = (const void *)rparam;
+			uint16_t fw_version;
+
+			fw_version = (rp->HCI_Revision & 0xFF) << 8;              // Major Version Number
+			fw_version |= ((rp->LMP_PAL_Subversion >> 4) & 0xF) << 4; // Minor Version Number
+			fw_version |= rp->LMP_PAL_Subversion & 0xF;               // Patch Version Number
+			PRINT_DBG("HWver %d\nFwver %d\r\n", rp->HCI_Revision >> 8, fw_version);
+		}
+		break;
+
+	case BOOT_STEP_READ_ADDR:
+		if (ok && (rlen >= 2U)) {
+			const aci_hal_read_config_data_rp0 *rp = (const void *)rparam;
+			uint8_t len = (rp->Data_Length < BDADDR_SIZE) ? rp->Data_Length : BDADDR_SIZE;
+
+			memcpy(bdaddr, rp->Data, len);
+		} else {
+			PRINT_DBG("Read Static Random address failed\r\n");
+		}
+
+		if ((bdaddr[5] & 0xC0) != 0xC0) {
+			PRINT_DBG("Static Random address not well formed\r\n");
+			Boot_Fail(step, status);
+		}
+
+		// The public address must be set before the GAP
+		Boot_Queue(BOOT_STEP_WRITE_ADDR);
+		Boot_Queued(BOOT_STEP_WRITE_ADDR, aci_hal_write_config_data(CONFIG_DATA_PUBADDR_OFFSET, BDADDR_SIZE, bdaddr));
+		break;
+
+	case BOOT_STEP_TX_POWER:
+	case BOOT_STEP_RADIO_MASK:
+		if (status != BLE_STATUS_SUCCESS) {
+			PRINT_DBG("Boot step %s failed: 0x%02x\r\n", boot_step_name[step], status);
+		}
+		break;
+
+	case BOOT_STEP_WRITE_ADDR:
+		if (status != BLE_STATUS_SUCCESS) {
+			PRINT_DBG("aci_hal_write_config_data() Failed\r\n");
+		}
+
+		// GATT initialization
+		Boot_Queue(BOOT_STEP_GATT_INIT);
+		Boot_Queued(BOOT_STEP_GATT_INIT, aci_gatt_init());
+		break;
+
+	case BOOT_STEP_GATT_INIT:
+		if (status != BLE_STATUS_SUCCESS) {
+			Boot_Fail(step, status);
+		}
+
+		// GAP Initialization, its handles come with the answer
+		{
+			uint16_t service_handle, dev_name_char_handle, appearance_char_handle;
+
+			Boot_Queue(BOOT_STEP_GAP_INIT);
+			Boot_Queued(BOOT_STEP_GAP_INIT, aci_gap_init(GAP_PERIPHERAL_ROLE, 0x00, 0x07, &service_handle,
+														&dev_name_char_handle,
+														&appearance_char_handle));
+		}
+		break;
+
+	case BOOT_STEP_GAP_INIT:
+		if (!ok || (rlen < sizeof(aci_gap_init_rp0))) {
+			Boot_Fail(step, status);
+		}
+
+		boot_pending = 2;
+
+		// Update the device name
+		{
+			const aci_gap_init_rp0 *rp = (const void *)rparam;
+
+			Boot_Queue(BOOT_STEP_DEVICE_NAME);
+			Boot_Queued(BOOT_STEP_DEVICE_NAME, aci_gatt_update_char_value(rp->Service_Handle, rp->Dev_Name_Char_Handle, 0,
+																		sizeof(device_name), device_name));
+		}
+
+		/* BLE Security v4.2 is supported: BLE stack FW version >= 2.x (new API prototype) */
+		/* Bonding: the keys are kept in the security database of the BlueNRG-2, a
+		   bonded peer comes back with encryption alone */
+		Boot_Queue(BOOT_STEP_AUTH);
+		Boot_Queued(BOOT_STEP_AUTH, aci_gap_set_authentication_requirement(BONDING,
+																		MITM_PROTECTION_NOT_REQUIRED,
+																		SC_IS_NOT_SUPPORTED,
+																		KEYPRESS_IS_NOT_SUPPORTED,
+																		7,
+																		16,
+																		USE_FIXED_PIN_FOR_PAIRING,
+																		PERIPHERAL_PASS_KEY,
+																		0x00)); /* - 0x00: Public Identity Address
+																		           - 0x01: Random (static) Identity Address */
+		break;
+
+	case BOOT_STEP_DEVICE_NAME:
+	case BOOT_STEP_AUTH:
+		if (status != BLE_STATUS_SUCCESS) {
+			Boot_Fail(step, status);
+		}
+
+		// The services are added with blocking commands, from the user task
+		if (--boot_pending == 0) {
+			PRINT_DBG("BLE Stack Initialized with SUCCESS\r\n");
+			boot_state = BOOT_STATE_SERVICES;
+			Sched_SetTask(SCHED_TASK_USER);
+		}
+		break;
+
+	case BOOT_STEP_ADVERTISING:
+		if (status != BLE_STATUS_SUCCESS) {
+			PRINT_DBG("aci_gap_set_discoverable() failed: 0x%02x\r\n", status);
+		}
+
+		boot_state = BOOT_STATE_READY;
+		PRINT_DBG("BLE Stack Initialized and Device Configured\r\n");
+		Boot_Report();
+		break;
+
+	default:
+		break;
+	}
+}
 
-	if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_hal_write_config_data() Failed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-	} else {
-		PRINT_DBG("aci_hal_write_config_data() Success!\r\n");
+/**
+ * @brief  No aci_blue_initialized_event in time: configure the device anyway
+ * @param  ctx Unused
+ * @retval None
+ */
+static void Boot_Timer_CB(void *ctx)
+{
+	if (boot_state == BOOT_STATE_RESET) {
+		PRINT_DBG("No aci_blue_initialized_event, configuring anyway\r\n");
+		boot_profile[BOOT_STEP_RESET].end_us = Boot_Micros();
+		Boot_Start();
 	}
+}
 
+/**
+ * @brief  Deadline of the pending HCI commands: check their timeouts
+ * @param  ctx Unused
+ * @retval None
+ */
+static void HCI_Timeout_Timer_CB(void *ctx)
+{
+	Sched_SetTask(SCHED_TASK_HCI);
+}
 
-	// Set the TX power to -2 dBm
-	aci_hal_set_tx_power_level(1, 4);
-	if (ret != BLE_STATUS_SUCCESS) {
-		//PRINT_DBG("aci_hal_set_tx_power_level() failed");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-	} else {
-		PRINT_DBG("aci_hal_set_tx_power_level() Success!\r\n");
+/**
+ * @brief  LED blink while paired
+ * @param  ctx Unused
+ * @retval None
+ */
+static void Paired_Timer_CB(void *ctx)
+{
+	float grid[2][2];
+
+	// Generate random values for the grid
+	for (int i = 0; i < 2; i++) {
+		for (int j = 0; j < 2; j++) {
+			grid[i][j] = ((float)rand() / RAND_MAX) * 100.0f; // Random float between 0 and 100
+		}
 	}
 
-	// GATT initialization
-	ret = aci_gatt_init();
-	if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_gatt_init() failed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-		return ret;
-	} else {
-		PRINT_DBG("aci_gatt_init() Success!\r\n");
+	// Update the grid characteristic
+	//Grid_Update(grid);
+
+	// Toggle LED to indicate data sent
+	HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_7);
+}
+
+/**
+ * @brief  HCI task: boosts the system clock when packets pile up, then
+ *         processes them
+ * @param  None
+ * @retval None
+ */
+static void HCI_Process(void)
+{
+	tHciRxQueueStats rx;
+
+	hci_get_rx_queue_stats(&rx);
+	if (rx.used >= CLOCK_BOOST_BACKLOG) {
+		Clock_Boost();
 	}
 
-	// GAP Initialization
-	ret = aci_gap_init(GAP_PERIPHERAL_ROLE, 0x00, 0x07, &service_handle,
-														&dev_name_char_handle,
-														&appearance_char_handle);
+	hci_user_evt_proc();
+}
 
-	if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_gap_init() Failed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-		return ret;
+/**
+ * @brief  A received packet is queued: schedule hci_user_evt_proc()
+ * @param  None
+ * @retval None
+ */
+void hci_notify_user_evt(void)
+{
+	Sched_SetTask(SCHED_TASK_HCI);
+}
+
+/**
+ * @brief  Next deadline of the pending HCI commands: the timer wakes the HCI
+ *         task then, and stays off while no command is pending
+ * @param  delay_ms Time to the deadline, 0 for none
+ * @retval None
+ */
+void hci_notify_cmd_deadline(uint32_t delay_ms)
+{
+	if (delay_ms == 0) {
+		Timer_Stop(&hci_timeout_timer);
 	} else {
-		PRINT_DBG("aci_gap_init() Success!\r\n");
+		Timer_Start(&hci_timeout_timer, delay_ms, 0);
 	}
+}
 
-	// Update the device name
-	ret = aci_gatt_update_char_value(service_handle, dev_name_char_handle, 0,
-											sizeof(device_name), device_name);
+/*
+ * @brief Initialize User Process
+ *
+ * @param None
+ * @retval None
+ */
+static void User_Init(void)
+{
 
-	if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_gatt_update_char_value() Failed\r\n");
-		//HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-		return ret;
-	} else if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_gap_update_char_value() Success!\r\n");
-	}
+	// Null. Not required in this applciation
+
+	// BSP_PB_Init()
+	// BSP_LED_Init(LED2)
+	// BSP_COM_Init(COM1)
 
-	// Clear the security database, which ensures that each time the application is
-	// executed the full bonding process is executed with passkey generation and setting.
-//	ret = aci_gap_clear_security_db();
-//	if (ret != BLE_STATUS_SUCCESS) {
-//		PRINT_DBG("aci_gap_clear_security_db() failed.");
-//		return ret;
-//	} else {
-//		PRINT_DBG("aci_gap_clear_security_db() Sucess!\r\n");
-//	}
-
-	  /*
-	   * Set the I/O capability otherwise the Central device (e.g. the smartphone) will
-	   * propose a PIN that will be accepted without any control.
-	   */
-//	  if (aci_gap_set_io_capability(IO_CAP_DISPLAY_ONLY)==BLE_STATUS_SUCCESS) {
-//	    PRINT_DBG("I/O Capability Configurated\r\n");
-//	  } else {
-//	    PRINT_DBG("Error Setting I/O Capability\r\n");
-//	  }
-
-	  /* BLE Security v4.2 is supported: BLE stack FW version >= 2.x (new API prototype) */
-	  ret = aci_gap_set_authentication_requirement(NO_BONDING,
-	                                               MITM_PROTECTION_NOT_REQUIRED,
-	                                               SC_IS_NOT_SUPPORTED,
-	                                               KEYPRESS_IS_NOT_SUPPORTED,
-	                                               7,
-	                                               16,
-	                                               USE_FIXED_PIN_FOR_PAIRING,
-	                                               PERIPHERAL_PASS_KEY,
-	                                               0x00); /* - 0x00: Public Identity Address
-	                                                         - 0x01: Random (static) Identity Address */
-	  if (ret != BLE_STATUS_SUCCESS) {
-	    PRINT_DBG("aci_gap_set_authentication_requirement()failed: 0x%02x\r\n", ret);
-	    //HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-	    return ret;
-	  }
-	  else {
-	    PRINT_DBG("aci_gap_set_authentication_requirement() --> SUCCESS\r\n");
-	  }
-
-	  PRINT_DBG("BLE Stack Initialized with SUCCESS\r\n");
-
-	  ret = Add_HWServW2ST_Service();
-	  if (ret == BLE_STATUS_SUCCESS) {
-
-	    PRINT_DBG("BlueNRG2 HW service added successfully.\r\n");
-	  }
-	  else {
-	    PRINT_DBG("Error while adding BlueNRG2 HW service: 0x%02x\r\n", ret);
-		  HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-	    while(1);
-	  }
-
-//	  ret = Add_SWServW2ST_Service();
-//	  if(ret == BLE_STATUS_SUCCESS) {
-//		  HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-//	     PRINT_DBG("BlueNRG2 SW service added successfully.\r\n");
-//	  }
-//	  else {
-//	     PRINT_DBG("Error while adding BlueNRG2 HW service: 0x%02x\r\n", ret);
-//	     while(1);
-//	  }
-
-	  return BLE_STATUS_SUCCESS;
 }
 
+
 /*
  *
  * @brief User Process
@@ -289,73 +580,157 @@ uint8_t Sensor_DeviceInit(void)
 static void User_Process(void)
 {
 
-	    float grid[2][2];
-
 	    uint8_t ret = 0;
 
+	    // End of the boot: the GATT database, with blocking commands
+	    if (boot_state == BOOT_STATE_SERVICES) {
+	    	boot_profile[BOOT_STEP_SERVICES].start_us = Boot_Micros();
+	    	ret = Add_HWServW2ST_Service();
+	    	boot_profile[BOOT_STEP_SERVICES].end_us = Boot_Micros();
+	    	if (ret != BLE_STATUS_SUCCESS) {
+	    		Boot_Fail(BOOT_STEP_SERVICES, ret);
+	    	}
+
+	    	PRINT_DBG("BlueNRG2 HW service added successfully.\r\n");
+	    	boot_state = BOOT_STATE_ADVERTISING;
+	    	boot_profile[BOOT_STEP_ADVERTISING].start_us = Boot_Micros();
+	    	Set_DeviceConnectable(Boot_Cplt_CB, BOOT_CTX(BOOT_STEP_ADVERTISING));
+	    	set_connectable = FALSE;
+	    }
+
+	    if (boot_state != BOOT_STATE_READY) {
+	    	return;
+	    }
+
 	    if (set_connectable) {
 	    	PRINT_DBG("Setting device connectable!");
-	        Set_DeviceConnectable();
+	        Reconnect_Start();
 	        set_connectable = FALSE;
 	    }
 
+	    // A bonded peer answers with encryption alone, a new one pairs and bonds
 	    if ((connected) && (!pairing))
 	    {
 	    	PRINT_DBG("STARTING PAIRING");
+	        hci_set_next_req_async(Slave_Security_Req_CB, NULL);
 	        ret = aci_gap_slave_security_req(connection_handle);
 	        if (ret != BLE_STATUS_SUCCESS) {
-	            PRINT_DBG("aci_gap_slave_security_req() failed:0x%02x\r\n", ret);
-	            HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-	        }
-	        else {
-	            PRINT_DBG("aci_gap_slave_security_req --> SUCCESS\r\n");
+	            Slave_Security_Req_CB(0, ret, NULL, 0, NULL);
 	        }
 	        pairing = TRUE;
 	    }
+}
 
-	    if (paired) {
-	        // Generate random values for the grid
-	        for (int i = 0; i < 2; i++) {
-	            for (int j = 0; j < 2; j++) {
-	                grid[i][j] = ((float)rand() / RAND_MAX) * 100.0f; // Random float between 0 and 100
-	            }
-	        }
 
-	        // Update the grid characteristic
-	        //Grid_Update(grid);
+/**
+ * @brief  Completion of aci_gap_slave_security_req, issued asynchronously
+ *         from User_Process.
+ * @param  See hci_cmd_cplt_cb_t in hci_tl.h
+ * @retval None
+ */
+static void Slave_Security_Req_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	if (status != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("aci_gap_slave_security_req() failed:0x%02x\r\n", status);
+		HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
+	}
+	else {
+		PRINT_DBG("aci_gap_slave_security_req --> SUCCESS\r\n");
+	}
+}
+
+/**
+ * @brief  The link is encrypted, by a pairing or with the keys of a bond:
+ *         the glove is paired
+ * @param  None
+ * @retval None
+ */
+static void Link_Ready(void)
+{
+	if (link.ready) {
+		return;
+	}
 
-	        // Toggle LED to indicate data sent
-	        HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_7);
+	link.ready = TRUE;
+	paired = TRUE;
+	link_stats.ready_ms = HAL_GetTick() - link.connect_tick;
+	PRINT_DBG("Link ready %lu ms after connection\r\n", (unsigned long)link_stats.ready_ms);
 
-	        // Wait before sending next update
-	        HAL_Delay(1000);
-	    }
+	// A bonded peer, the first one advertised to after a disconnection
+	Reconnect_SetPeer(link.peer_type, link.peer_addr);
+	LinkPolicy_Ready();
+
+	// First blink a second after pairing, then every PAIRED_BLINK_PERIOD_MS
+	Timer_Start(&paired_timer, PAIRED_BLINK_DELAY_MS, PAIRED_BLINK_PERIOD_MS);
 }
 
+/**
+ * @brief  A haptic frame has been received: times the first one of the link
+ * @param  None
+ * @retval None
+ */
+void BlueNRG_HapticFrame(void)
+{
+	if (!connected || link.framed) {
+		return;
+	}
+
+	link.framed = TRUE;
+	link.first_frame_ms = HAL_GetTick() - link.connect_tick;
+	link_stats.first_frame_ms = link.first_frame_ms;
+	PRINT_DBG("First haptic frame %lu ms after connection\r\n", (unsigned long)link.first_frame_ms);
+}
 
 /**
- * @brief  Get hardware and firmware version
- *
- * @param  Hardware version
- * @param  Firmware version
- * @retval Status
+ * @brief  Copies the connection figures
+ * @param  stats Filled with the figures
+ * @retval None
  */
-uint8_t getBlueNRGVersion(uint8_t *hwVersion, uint16_t *fwVersion)
+void BlueNRG_GetLinkStats(Link_Stats_t *stats)
 {
-  uint8_t status;
-  uint8_t hci_version, lmp_pal_version;
-  uint16_t hci_revision, manufacturer_name, lmp_pal_subversion;
+	*stats = link_stats;
+}
 
-  status = hci_read_local_version_information(&hci_version, &hci_revision, &lmp_pal_version,
-                                              &manufacturer_name, &lmp_pal_subversion);
+/**
+ * @brief  This event is given when the BlueNRG-2 has booted, after a reset
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_blue_initialized_event(uint8_t Reason_Code)
+{
+  if ((Reason_Code >= BLUE_INIT_UPDATER_FIRST) && (Reason_Code <= BLUE_INIT_UPDATER_LAST)) {
+    PRINT_DBG("BlueNRG-2 in updater mode (0x%02x)\r\n", Reason_Code);
+    Timer_Stop(&boot_timer);
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, 1);
+    return;
+  }
 
-  if (status == BLE_STATUS_SUCCESS) {
-    *hwVersion = hci_revision >> 8;
-    *fwVersion = (hci_revision & 0xFF) << 8;              // Major Version Number
-    *fwVersion |= ((lmp_pal_subversion >> 4) & 0xF) << 4; // Minor Version Number
-    *fwVersion |= lmp_pal_subversion & 0xF;               // Patch Version Number
+  if (boot_state == BOOT_STATE_RESET) {
+    boot_profile[BOOT_STEP_RESET].end_us = Boot_Micros();
+    Boot_Start();
+  } else {
+    // Reset on its own (watchdog, lockup...), during the configuration or
+    // after it: connection, configuration and the commands in flight are lost
+    PRINT_DBG("BlueNRG-2 reset (0x%02x), configuring again\r\n", Reason_Code);
+    connected = FALSE;
+    pairing = FALSE;
+    paired = FALSE;
+    set_connectable = TRUE;
+    connection_handle = 0;
+    Timer_Stop(&paired_timer);
+    Reconnect_Stop();
+    LinkPolicy_Disconnected();
+    Telemetry_Stop();
+    Notify_SetConnection(0);
+
+    // The steps left of the boot cut short complete now, and are ignored
+    boot_generation++;
+    hci_flush_pending_cmds();
+
+    boot_profile[BOOT_STEP_RESET].start_us = Boot_Micros();
+    boot_profile[BOOT_STEP_RESET].end_us = boot_profile[BOOT_STEP_RESET].start_us;
+    Boot_Start();
   }
-  return status;
 }
 
 /**
@@ -380,15 +755,29 @@ void hci_le_connection_complete_event(uint8_t Status,
         uint8_t Master_Clock_Accuracy)
 {
     if (Status == 0x00) { // Success
+        memset(&link, 0, sizeof(link));
+        link.connect_tick = HAL_GetTick();
+        link.peer_type = Peer_Address_Type;
+        memcpy(link.peer_addr, Peer_Address, sizeof(link.peer_addr));
+        link_stats.connections++;
+        Reconnect_Connected();
+        LinkPolicy_Connected(Connection_Handle, Conn_Interval, Conn_Latency, Supervision_Timeout);
+        Telemetry_Start(Connection_Handle);
+        Notify_SetConnection(Connection_Handle);
+
         connection_handle = Connection_Handle;
         connected = TRUE;
         set_connectable = FALSE;
+        Sched_SetTask(SCHED_TASK_USER);
 
         PRINT_DBG("Connected to device: %02X:%02X:%02X:%02X:%02X:%02X\r\n",
                   Peer_Address[5], Peer_Address[4], Peer_Address[3],
                   Peer_Address[2], Peer_Address[1], Peer_Address[0]);
         PRINT_DBG("Connection Interval: %d\r\n", Conn_Interval);
         PRINT_DBG("Supervision Timeout: %d\r\n", Supervision_Timeout);
+    } else if (Status == BLE_ERROR_DIRECTED_ADVERTISING_TIMEOUT) {
+        // The directed advertising of a reconnection ended unanswered
+        Reconnect_DirectedTimeout();
     } else {
         PRINT_DBG("Connection failed with status: 0x%02X\r\n", Status);
     }
@@ -404,6 +793,14 @@ void hci_disconnection_complete_event(uint8_t Status,
                                       uint16_t Connection_Handle,
                                       uint8_t Reason)
 {
+  // Encrypted without pairing: a reconnection of a bonded peer
+  if (connected && link.ready && !link.paired_now) {
+    link_stats.bonded_links++;
+    if (link.framed && (link.first_frame_ms > link_stats.bonded_max_frame_ms)) {
+      link_stats.bonded_max_frame_ms = link.first_frame_ms;
+    }
+  }
+
   connected = FALSE;
   pairing = FALSE;
   paired = FALSE;
@@ -411,12 +808,30 @@ void hci_disconnection_complete_event(uint8_t Status,
   /* Make the device connectable again */
   set_connectable = TRUE;
   connection_handle = 0;
+  Timer_Stop(&paired_timer);
+  LinkPolicy_Disconnected();
+  Telemetry_Stop();
+  Notify_SetConnection(0);
+  Sched_SetTask(SCHED_TASK_USER);
   PRINT_DBG("Disconnected (0x%02x)\r\n", Reason);
 
   // Turn on LED upon disconnect
   HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, 1);
 }
 
+/**
+ * @brief  This event is given at the end of each radio activity enabled by
+ *         aci_hal_set_radio_activity_mask, with the time of the next one
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_hal_end_of_radio_activity_event(uint8_t Last_State,
+                                         uint8_t Next_State,
+                                         uint32_t Next_State_SysTime)
+{
+  LowPower_RadioActivity(Next_State, Next_State_SysTime);
+}
+
 /**
  * @brief  This event is given when a read request is received
  *         by the server from the client
@@ -457,11 +872,10 @@ void aci_gap_pass_key_req_event(uint16_t Connection_Handle)
 {
   uint8_t ret;
 
+  hci_set_next_req_async(APP_CmdCpltCB, "aci_gap_pass_key_resp");
   ret = aci_gap_pass_key_resp(connection_handle, PERIPHERAL_PASS_KEY);
   if (ret != BLE_STATUS_SUCCESS) {
-    PRINT_DBG("aci_gap_pass_key_resp failed:0x%02x\r\n", ret);
-  } else {
-    PRINT_DBG("aci_gap_pass_key_resp OK\r\n");
+    PRINT_DBG("aci_gap_pass_key_resp not queued:0x%02x\r\n", ret);
   }
 }
 
@@ -480,10 +894,126 @@ void aci_gap_pairing_complete_event(uint16_t connection_handle, uint8_t status,
     HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
   }
   else {
-    paired = TRUE;
+    link.paired_now = TRUE;
     PRINT_DBG("aci_gap_pairing_complete_event with status 0x%02x\r\n", status);
     //HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
-    HAL_Delay(1000);
-    //HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14);
+    Link_Ready();
   }
 }
+
+/**
+ * @brief  This event is given when the encryption of the link changes. A
+ *         bonded peer encrypts with the stored keys and no pairing follows:
+ *         the link is ready at once
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void hci_encryption_change_event(uint8_t Status,
+                                 uint16_t Connection_Handle,
+                                 uint8_t Encryption_Enabled)
+{
+  if ((Status != 0x00) || (Encryption_Enabled == 0)) {
+    PRINT_DBG("hci_encryption_change_event failed:0x%02x\r\n", Status);
+    return;
+  }
+
+  Link_Ready();
+}
+
+/**
+ * @brief  This event is given when a bonded peer asks to pair again, having
+ *         lost its keys (device forgotten on the phone)
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_gap_bond_lost_event(void)
+{
+  uint8_t ret;
+
+  // Pair again, replacing the bond
+  hci_set_next_req_async(APP_CmdCpltCB, "aci_gap_allow_rebond");
+  ret = aci_gap_allow_rebond(connection_handle);
+  if (ret != BLE_STATUS_SUCCESS) {
+    PRINT_DBG("aci_gap_allow_rebond not queued:0x%02x\r\n", ret);
+  }
+}
+
+/**
+ * @brief  This event is given when the central changed the connection
+ *         parameters, on its own or on a request of the link policy
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void hci_le_connection_update_complete_event(uint8_t Status,
+                                             uint16_t Connection_Handle,
+                                             uint16_t Conn_Interval,
+                                             uint16_t Conn_Latency,
+                                             uint16_t Supervision_Timeout)
+{
+  LinkPolicy_Updated(Status, Conn_Interval, Conn_Latency, Supervision_Timeout);
+}
+
+/**
+ * @brief  This event is given when the central answers a connection
+ *         parameter update request
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_l2cap_connection_update_resp_event(uint16_t Connection_Handle,
+                                            uint16_t Result)
+{
+  // Result 0x0000: accepted, 0x0001: rejected
+  LinkPolicy_Response(Result == 0x0000);
+}
+
+/**
+ * @brief  This event is given when the central did not answer a connection
+ *         parameter update request within 30 s
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_l2cap_proc_timeout_event(uint16_t Connection_Handle,
+                                  uint8_t Data_Length,
+                                  uint8_t Data[])
+{
+  LinkPolicy_Response(FALSE);
+}
+
+/**
+ * @brief  This event is given when the controller sent packets of the
+ *         connection to the central
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void hci_number_of_completed_packets_event(uint8_t Number_of_Handles,
+                                           Handle_Packets_Pair_Entry_t Handle_Packets_Pair_Entry[])
+{
+  uint8_t i;
+
+  for (i = 0; i < Number_of_Handles; i++) {
+    Telemetry_PacketsCompleted(Handle_Packets_Pair_Entry[i].HC_Num_Of_Completed_Packets);
+  }
+}
+
+/**
+ * @brief  This event is given when the data buffers of the controller
+ *         overflowed
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void hci_data_buffer_overflow_event(uint8_t Link_Type)
+{
+  Telemetry_BufferOverflow();
+}
+
+/**
+ * @brief  This event is given when the TX pool has room again, after an
+ *         update failed with BLE_STATUS_INSUFFICIENT_RESOURCES
+ * @param  See file bluenrg1_events.h
+ * @retval See file bluenrg1_events.h
+ */
+void aci_gatt_tx_pool_available_event(uint16_t Connection_Handle,
+                                      uint16_t Available_Buffers)
+{
+  Notify_TxPoolAvailable();
+}
@@ -30,6 +30,7 @@
 //#include "custom.h"
 
 /* USER CODE BEGIN Includes */
+#include <stdint.h>
 
 /* USER CODE END Includes */
 
@@ -49,6 +50,15 @@
 
 /* USER CODE BEGIN ED */
 
+/* Connection figures, times in ms from the connection complete event */
+typedef struct {
+  uint32_t connections;
+  uint32_t bonded_links;        /* Encrypted with the keys of a bond, without pairing */
+  uint32_t ready_ms;            /* Last link: until encrypted */
+  uint32_t first_frame_ms;      /* Last link: until the first haptic frame */
+  uint32_t bonded_max_frame_ms; /* Slowest first haptic frame over the bonded links */
+} Link_Stats_t;
+
 /* USER CODE END ED */
 
 /* Exported Variables --------------------------------------------------------*/
@@ -59,9 +69,10 @@
 
 /* Exported Functions Prototypes ---------------------------------------------*/
 void MX_BlueNRG_2_Init(void);
-void MX_BlueNRG_2_Process(void);
 
 /* USER CODE BEGIN EFP */
+void BlueNRG_HapticFrame(void);
+void BlueNRG_GetLinkStats(Link_Stats_t *stats);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,411 @@
+/*
+ * clock_profile.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// System clock profiles. The glove runs on the 4 MHz MSI, in voltage range
+// 2, and boosts to 64 MHz from the PLL while it drains a burst of received
+// packets; the low profile comes back once no burst has been seen for
+// CLOCK_BOOST_HOLD_MS. Each switch retunes what is clocked from the system
+// clock: the prescalers of the PWM and render timers keep their counting
+// rates, the SPI divider keeps the bus at most HCI_TL_SPI_MAX_CLOCK_HZ and the
+// UART baud rate divisors are computed again. A switch only happens between
+// two transfers, since a byte on the wire would otherwise change rate.
+// 64 MHz rather than the 80 MHz the part allows: the SPI dividers are powers
+// of two, and 80 MHz would leave the bus at 625 kHz (/128), slower than the
+// 1 MHz (/4) of the low profile, where 64 MHz / 64 keeps it at 1 MHz.
+
+// Includes
+#include "clock_profile.h"
+#include "timer_wheel.h"
+#include "motor_control.h"
+#include "hci_tl_interface.h"
+
+// Private defines
+#define CLOCK_PLL_M				1U
+#define CLOCK_PLL_N				32U		// VCO at 128 MHz from the 4 MHz MSI
+#define CLOCK_PLL_R				RCC_PLLR_DIV2
+#define CLOCK_SPI_DIV_MAX		7U		// Divider 256
+
+#define CLOCK_SPI_RATIO			(CLOCK_PERFORMANCE_HZ / HCI_TL_SPI_MAX_CLOCK_HZ)
+
+_Static_assert((CLOCK_LOW_HZ * CLOCK_PLL_N) / (CLOCK_PLL_M * 2U) == CLOCK_PERFORMANCE_HZ, "PLL settings do not give CLOCK_PERFORMANCE_HZ");
+_Static_assert(((CLOCK_PERFORMANCE_HZ % HCI_TL_SPI_MAX_CLOCK_HZ) == 0) && ((CLOCK_SPI_RATIO & (CLOCK_SPI_RATIO - 1U)) == 0),
+			   "the SPI would run under HCI_TL_SPI_MAX_CLOCK_HZ in the performance profile");
+
+extern UART_HandleTypeDef hlpuart1;
+extern UART_HandleTypeDef huart3;
+
+typedef struct {
+	TIM_HandleTypeDef *htim;
+	uint8_t apb2;			// Timer on the APB2 bus
+	uint32_t count_hz;		// Counting rate, kept across the profiles
+} Clock_Timer_t;
+
+// Variables
+static Clock_Timer_t clock_timers[] = {
+	{ &htim2, 0, 0 },
+	{ &htim1, 1, 0 },
+	{ &htim16, 1, 0 },
+	{ &htim6, 0, 0 },
+};
+
+static UART_HandleTypeDef *const clock_uarts[] = {
+	&hlpuart1,
+	&huart3,
+};
+
+static Clock_Profile_t clock_profile = CLOCK_PROFILE_LOW;
+static Clock_Stats_t clock_stats;
+static uint32_t clock_perf_start;	// HAL tick of the last boost
+static Timer_t clock_hold_timer;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Clock of the timers of an APB bus, twice the bus clock when the
+ * 			bus is divided
+ * @param 	uint8_t 1 for APB2, 0 for APB1
+ * @retval	uint32_t clock in Hz
+ *
+ */
+static uint32_t Clock_TimerClock(uint8_t apb2)
+{
+	uint32_t clock = apb2 ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+	uint32_t ppre = apb2 ? (RCC->CFGR & RCC_CFGR_PPRE2) : (RCC->CFGR & RCC_CFGR_PPRE1);
+
+	return (ppre == 0) ? clock : (clock * 2U);
+}
+
+/*
+ *
+ * @brief 	Locks the PLL of the performance profile, after raising the
+ * 			voltage range it needs
+ * @param 	none
+ * @retval	HAL_StatusTypeDef
+ *
+ */
+static HAL_StatusTypeDef Clock_StartPll(void)
+{
+	RCC_OscInitTypeDef osc = {0};
+
+	if (__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY)) {
+		return HAL_OK;
+	}
+
+	if (HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE1) != HAL_OK) {
+		return HAL_ERROR;
+	}
+
+	osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+	osc.PLL.PLLState = RCC_PLL_ON;
+	osc.PLL.PLLSource = RCC_PLLSOURCE_MSI;
+	osc.PLL.PLLM = CLOCK_PLL_M;
+	osc.PLL.PLLN = CLOCK_PLL_N;
+	osc.PLL.PLLP = RCC_PLLP_DIV7;
+	osc.PLL.PLLQ = RCC_PLLQ_DIV2;
+	osc.PLL.PLLR = CLOCK_PLL_R;
+
+	return HAL_RCC_OscConfig(&osc);
+}
+
+/*
+ *
+ * @brief 	Stops the PLL and lowers the voltage range, once the system
+ * 			clock is back on the MSI
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Clock_StopPll(void)
+{
+	RCC_OscInitTypeDef osc = {0};
+
+	if ((RCC->CR & RCC_CR_PLLON) == 0) {
+		return;
+	}
+
+	osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+	osc.PLL.PLLState = RCC_PLL_OFF;
+	(void)HAL_RCC_OscConfig(&osc);
+	(void)HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE2);
+}
+
+/*
+ *
+ * @brief 	Selects the system clock of a profile, with the flash wait states
+ * 			it needs. HAL_RCC_ClockConfig() also restarts the SysTick
+ * @param 	Clock_Profile_t profile
+ * @retval	HAL_StatusTypeDef
+ *
+ */
+static HAL_StatusTypeDef Clock_SelectSysclk(Clock_Profile_t profile)
+{
+	RCC_ClkInitTypeDef clk = {0};
+	HAL_StatusTypeDef ret;
+
+	clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	clk.APB1CLKDivider = RCC_HCLK_DIV1;
+	clk.APB2CLKDivider = RCC_HCLK_DIV1;
+
+	if (profile == CLOCK_PROFILE_PERFORMANCE) {
+		clk.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+		ret = HAL_RCC_ClockConfig(&clk, FLASH_LATENCY_3);
+		__HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+	} else {
+		__HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+		clk.SYSCLKSource = RCC_SYSCLKSOURCE_MSI;
+		ret = HAL_RCC_ClockConfig(&clk, FLASH_LATENCY_0);
+	}
+
+	return ret;
+}
+
+/*
+ *
+ * @brief 	Tells whether the clocks may change now: no transfer on the
+ * 			BlueNRG-2 bus and no byte leaving the UARTs
+ * @param 	none
+ * @retval	uint8_t 1 if the switch may happen
+ *
+ */
+static uint8_t Clock_CanSwitch(void)
+{
+	uint32_t i;
+
+	if (hci_tl_lowlevel_idle_mode() == HCI_TL_IDLE_BUSY) {
+		return 0;
+	}
+
+	for (i = 0; i < (sizeof(clock_uarts) / sizeof(clock_uarts[0])); i++) {
+		HAL_UART_StateTypeDef state = clock_uarts[i]->gState;
+
+		if ((state != HAL_UART_STATE_READY) && (state != HAL_UART_STATE_RESET)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Sets the timer prescalers, the SPI divider and the UART divisors
+ * 			for the current system clock
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Clock_Retune(void)
+{
+	uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+	uint32_t div = 0;
+	uint32_t i;
+
+	// Loaded at the next update event, the current period ends at the old rate
+	for (i = 0; i < (sizeof(clock_timers) / sizeof(clock_timers[0])); i++) {
+		Clock_Timer_t *t = &clock_timers[i];
+		uint32_t psc = (Clock_TimerClock(t->apb2) / t->count_hz) - 1U;
+
+		t->htim->Init.Prescaler = psc;
+		t->htim->Instance->PSC = psc;
+	}
+
+	// SPI1: fastest divider under the BlueNRG-2 limit
+	if (hspi1.State != HAL_SPI_STATE_RESET) {
+		while ((div < CLOCK_SPI_DIV_MAX) && ((pclk2 >> (div + 1U)) > HCI_TL_SPI_MAX_CLOCK_HZ)) {
+			div++;
+		}
+
+		__HAL_SPI_DISABLE(&hspi1);
+		hspi1.Init.BaudRatePrescaler = div << SPI_CR1_BR_Pos;
+		MODIFY_REG(hspi1.Instance->CR1, SPI_CR1_BR, hspi1.Init.BaudRatePrescaler);
+	}
+
+	for (i = 0; i < (sizeof(clock_uarts) / sizeof(clock_uarts[0])); i++) {
+		UART_HandleTypeDef *huart = clock_uarts[i];
+
+		if (huart->gState == HAL_UART_STATE_RESET) {
+			continue;
+		}
+
+		while ((huart->Instance->ISR & USART_ISR_TC) == 0) {
+		}
+
+		__HAL_UART_DISABLE(huart);
+		(void)UART_SetConfig(huart);
+		__HAL_UART_ENABLE(huart);
+	}
+}
+
+/*
+ *
+ * @brief 	End of the boost, or a switch put off
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Clock_Hold_CB(void *ctx)
+{
+	if (Clock_SetProfile(CLOCK_PROFILE_LOW) == HAL_BUSY) {
+		Timer_Start(&clock_hold_timer, CLOCK_RETRY_MS, 0);
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Records the counting rates of the timers and applies the low profile
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Init(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < (sizeof(clock_timers) / sizeof(clock_timers[0])); i++) {
+		Clock_Timer_t *t = &clock_timers[i];
+
+		t->count_hz = Clock_TimerClock(t->apb2) / (t->htim->Instance->PSC + 1U);
+	}
+
+	Timer_Create(&clock_hold_timer, Clock_Hold_CB, NULL);
+
+	// The MSI does not need voltage range 1
+	__disable_irq();
+	Clock_Retune();
+	__enable_irq();
+	(void)HAL_PWREx_ControlVoltageScaling(PWR_REGULATOR_VOLTAGE_SCALE2);
+}
+
+/*
+ *
+ * @brief 	Switches the system clock and retunes the peripherals
+ * @param 	Clock_Profile_t profile
+ * @retval	HAL_StatusTypeDef HAL_BUSY if a transfer is in progress
+ *
+ */
+HAL_StatusTypeDef Clock_SetProfile(Clock_Profile_t profile)
+{
+	HAL_StatusTypeDef ret;
+	uint32_t start;
+
+	if (profile == clock_profile) {
+		// A boost put off may have left the PLL running
+		if (profile == CLOCK_PROFILE_LOW) {
+			Clock_StopPll();
+		}
+		return HAL_OK;
+	}
+
+	// The PLL takes a while to lock: not with the interrupts masked
+	if ((profile == CLOCK_PROFILE_PERFORMANCE) && (Clock_StartPll() != HAL_OK)) {
+		return HAL_ERROR;
+	}
+
+	__disable_irq();
+	if (!Clock_CanSwitch()) {
+		clock_stats.deferred++;
+		__enable_irq();
+		return HAL_BUSY;
+	}
+
+	start = DWT->CYCCNT;
+	ret = Clock_SelectSysclk(profile);
+	if (ret == HAL_OK) {
+		Clock_Retune();
+		clock_profile = profile;
+
+		start = DWT->CYCCNT - start;
+		if (start > clock_stats.max_cycles) {
+			clock_stats.max_cycles = start;
+		}
+
+		if (profile == CLOCK_PROFILE_PERFORMANCE) {
+			clock_stats.boosts++;
+			clock_perf_start = HAL_GetTick();
+		} else {
+			clock_stats.perf_ms += HAL_GetTick() - clock_perf_start;
+		}
+	}
+	__enable_irq();
+
+	if ((ret == HAL_OK) && (profile == CLOCK_PROFILE_LOW)) {
+		Clock_StopPll();
+	}
+
+	return ret;
+}
+
+/*
+ *
+ * @brief 	Requests the performance profile for the next CLOCK_BOOST_HOLD_MS
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Boost(void)
+{
+#if (HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_SPI)
+	// Put off by a transfer: the next burst tries again
+	(void)Clock_SetProfile(CLOCK_PROFILE_PERFORMANCE);
+	Timer_Start(&clock_hold_timer, CLOCK_BOOST_HOLD_MS, 0);
+#else
+	// The USART3 receiver never stops: its divisor cannot change without
+	// losing bytes, the glove stays on the low profile
+#endif
+}
+
+/*
+ *
+ * @brief 	Current profile
+ * @param 	none
+ * @retval	Clock_Profile_t profile
+ *
+ */
+Clock_Profile_t Clock_GetProfile(void)
+{
+	return clock_profile;
+}
+
+/*
+ *
+ * @brief 	Restarts the system clock of the current profile after Stop 2
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Resume(void)
+{
+	if (clock_profile != CLOCK_PROFILE_PERFORMANCE) {
+		return;
+	}
+
+	// Stop 2 keeps the voltage range and the flash wait states
+	if ((Clock_StartPll() != HAL_OK) || (Clock_SelectSysclk(CLOCK_PROFILE_PERFORMANCE) != HAL_OK)) {
+		Error_Handler();
+	}
+}
+
+/*
+ *
+ * @brief 	Copies the clock profile figures
+ * @param 	Clock_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Clock_GetStats(Clock_Stats_t *stats)
+{
+	__disable_irq();
+	*stats = clock_stats;
+	if (clock_profile == CLOCK_PROFILE_PERFORMANCE) {
+		stats->perf_ms += HAL_GetTick() - clock_perf_start;
+	}
+	__enable_irq();
+}
@@ -0,0 +1,98 @@
+/*
+ * clock_profile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_CLOCK_PROFILE_H_
+#define SRC_HAPTICGLOVEWRITE_CLOCK_PROFILE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define CLOCK_LOW_HZ				4000000U	// MSI range 6, voltage range 2
+#define CLOCK_PERFORMANCE_HZ		64000000U	// PLL on the MSI, voltage range 1; a power of two times the SPI limit
+#define CLOCK_BOOST_BACKLOG			2U		// Received packets waiting that start a boost
+#define CLOCK_BOOST_HOLD_MS			20U		// Time the boost is kept after the last request
+#define CLOCK_RETRY_MS				2U		// Delay of a switch put off by a transfer
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+	CLOCK_PROFILE_LOW = 0,			// Idle and steady streaming
+	CLOCK_PROFILE_PERFORMANCE,		// Packet bursts
+	CLOCK_PROFILE_NUM
+} Clock_Profile_t;
+
+typedef struct {
+	uint32_t boosts;		// Switches to the performance profile
+	uint32_t deferred;		// Switches put off by a transfer in progress
+	uint32_t max_cycles;	// Longest switch, core cycles at the new clock
+	uint32_t perf_ms;		// Time spent in the performance profile
+} Clock_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Records the rates of the peripherals clocked from the system clock
+ * 			and applies the low profile. Called once every peripheral is set up
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Init(void);
+
+/*
+ *
+ * @brief 	Switches the system clock and retunes the timers, the SPI and the
+ * 			UARTs to keep their rates. Not to be called from an interrupt
+ * @param 	Clock_Profile_t profile
+ * @retval	HAL_StatusTypeDef HAL_BUSY if a transfer is in progress, the
+ * 			switch is then to be tried again later
+ *
+ */
+HAL_StatusTypeDef Clock_SetProfile(Clock_Profile_t profile);
+
+/*
+ *
+ * @brief 	Requests the performance profile for the next CLOCK_BOOST_HOLD_MS,
+ * 			after which the low profile comes back. Not to be called from an
+ * 			interrupt
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Boost(void);
+
+/*
+ *
+ * @brief 	Current profile
+ * @param 	none
+ * @retval	Clock_Profile_t profile
+ *
+ */
+Clock_Profile_t Clock_GetProfile(void);
+
+/*
+ *
+ * @brief 	Restarts the system clock of the current profile after Stop 2,
+ * 			which wakes up on the MSI. The peripherals keep their settings.
+ * 			Called with the interrupts masked
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Clock_Resume(void);
+
+/*
+ *
+ * @brief 	Copies the clock profile figures
+ * @param 	Clock_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Clock_GetStats(Clock_Stats_t *stats);
+
+#endif /* SRC_HAPTICGLOVEWRITE_CLOCK_PROFILE_H_ */
@@ -0,0 +1,279 @@
+/*
+ * depth_tile.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Region reduction on the glove. Instead of the four region depths, the phone
+// can send a downsampled depth tile of DEPTH_TILE_SIZE x DEPTH_TILE_SIZE
+// samples quantized to 8 bits, in rows, up to DEPTH_TILE_ROWS_MAX per write
+// so the attribute-modified event fits the HCI read buffer. The glove then
+// does what the phone did: min and max over all the regions, the average of
+// each region, normalized by the range, here with a weight per region. The
+// layout is a table of rectangles, one per motor, written over the layout
+// characteristic, so the regions and weights can change without the phone
+// reducing anything. The scans use the packed byte instructions of the
+// Cortex-M4 four samples at a time: USADA8 sums, USUB8 and SEL keep the
+// bytewise min and max. No HAL: the host builds it too.
+
+// Includes
+#include <string.h>
+#include "depth_tile.h"
+#if (defined (__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+#include "cmsis_compiler.h"
+#endif
+
+// Private defines
+#define DEPTH_ROWS_ALL		((1UL << DEPTH_TILE_SIZE) - 1UL)
+
+// Variables
+
+// Centre 4 x 4 of each quadrant, in the order of the grid
+static Depth_Region_t depth_layout[DEPTH_REGION_NUM] = {
+	{2, 2, 4, 4, DEPTH_WEIGHT_ONE},
+	{10, 2, 4, 4, DEPTH_WEIGHT_ONE},
+	{2, 10, 4, 4, DEPTH_WEIGHT_ONE},
+	{10, 10, 4, 4, DEPTH_WEIGHT_ONE},
+};
+
+static uint8_t depth_tile[DEPTH_TILE_SIZE * DEPTH_TILE_SIZE] __attribute__((aligned(4)));
+static uint16_t depth_timestamp;
+static uint32_t depth_rows;			// Rows of the tile received, one bit each
+
+// Private functions
+
+/*
+ *
+ * @brief 	Sum, min and max of the samples of a region
+ * @param 	const Depth_Region_t* region
+ * @param 	uint32_t* sum of the samples
+ * @param 	uint8_t* smallest sample
+ * @param 	uint8_t* largest sample
+ * @retval	none
+ *
+ */
+static void Depth_ScanRegion(const Depth_Region_t *region, uint32_t *sum, uint8_t *min, uint8_t *max)
+{
+	const uint8_t *p;
+	uint32_t row, n;
+	uint32_t acc = 0;
+	uint8_t lo = UINT8_MAX;
+	uint8_t hi = 0;
+#if (defined (__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+	uint32_t vmin = 0xFFFFFFFFUL;
+	uint32_t vmax = 0;
+	uint32_t v, i;
+#endif
+
+	for (row = region->y; row < (uint32_t)(region->y + region->h); row++) {
+		p = &depth_tile[(row * DEPTH_TILE_SIZE) + region->x];
+		n = region->w;
+
+#if (defined (__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+		// Up to the first word boundary one sample at a time
+		while ((n > 0) && (((uintptr_t)p & 3U) != 0)) {
+			acc += *p;
+			lo = (*p < lo) ? *p : lo;
+			hi = (*p > hi) ? *p : hi;
+			p++;
+			n--;
+		}
+
+		// Four samples per word. SEL reads the GE flags of the USUB8 just before it
+		for (; n >= 4U; n -= 4U, p += 4) {
+			v = *(const uint32_t *)p;
+			acc = __USADA8(v, 0, acc);
+			__USUB8(v, vmax);
+			vmax = __SEL(v, vmax);
+			__USUB8(vmin, v);
+			vmin = __SEL(v, vmin);
+		}
+#endif
+
+		for (; n > 0; n--, p++) {
+			acc += *p;
+			lo = (*p < lo) ? *p : lo;
+			hi = (*p > hi) ? *p : hi;
+		}
+	}
+
+#if (defined (__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+	// The bytes of the packed min and max
+	for (i = 0; i < 32U; i += 8U) {
+		lo = (((vmin >> i) & 0xFFU) < lo) ? ((vmin >> i) & 0xFFU) : lo;
+		hi = (((vmax >> i) & 0xFFU) > hi) ? ((vmax >> i) & 0xFFU) : hi;
+	}
+#endif
+
+	*sum = acc;
+	*min = lo;
+	*max = hi;
+}
+
+/*
+ *
+ * @brief 	Reduces the tile into the grid: each region average normalized by
+ * 			the range of all the regions, then weighted
+ * @param 	float* grid, DEPTH_REGION_NUM values
+ * @retval	none
+ *
+ */
+static void Depth_Reduce(float *grid)
+{
+	uint32_t sum[DEPTH_REGION_NUM];
+	uint8_t lo, hi;
+	uint8_t min = UINT8_MAX;
+	uint8_t max = 0;
+	float range, value;
+	uint32_t r;
+
+	for (r = 0; r < DEPTH_REGION_NUM; r++) {
+		Depth_ScanRegion(&depth_layout[r], &sum[r], &lo, &hi);
+		min = (lo < min) ? lo : min;
+		max = (hi > max) ? hi : max;
+	}
+
+	range = (max > min) ? (float)(max - min) : 1.0f;
+
+	for (r = 0; r < DEPTH_REGION_NUM; r++) {
+		value = ((float)sum[r] / (float)(depth_layout[r].w * depth_layout[r].h)) - (float)min;
+		value = (value / range) * ((float)depth_layout[r].weight / (float)DEPTH_WEIGHT_ONE);
+		grid[r] = (value > 1.0f) ? 1.0f : value;
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Replaces the actuator layout
+ * @param 	const Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	uint8_t 1 if the layout was taken
+ *
+ */
+uint8_t Depth_SetLayout(const Depth_Region_t *regions)
+{
+	uint32_t r;
+
+	for (r = 0; r < DEPTH_REGION_NUM; r++) {
+		if ((regions[r].w == 0) || (regions[r].h == 0) ||
+			((regions[r].x + regions[r].w) > DEPTH_TILE_SIZE) ||
+			((regions[r].y + regions[r].h) > DEPTH_TILE_SIZE)) {
+			return 0;
+		}
+	}
+
+	memcpy(depth_layout, regions, sizeof(depth_layout));
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Copies the actuator layout in use
+ * @param 	Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	none
+ *
+ */
+void Depth_GetLayout(Depth_Region_t *regions)
+{
+	memcpy(regions, depth_layout, sizeof(depth_layout));
+}
+
+/*
+ *
+ * @brief 	Decodes a write of the layout characteristic
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Depth_LayoutDecode(const uint8_t *data, uint16_t length, Depth_Region_t *regions)
+{
+	uint32_t r;
+
+	if (length < DEPTH_LAYOUT_LEN) {
+		return 0;
+	}
+
+	for (r = 0; r < DEPTH_REGION_NUM; r++, data += DEPTH_REGION_LEN) {
+		regions[r].x = data[0];
+		regions[r].y = data[1];
+		regions[r].w = data[2];
+		regions[r].h = data[3];
+		regions[r].weight = (uint16_t)(data[4] | (data[5] << 8));
+	}
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Encodes a layout as the layout characteristic value
+ * @param 	const Depth_Region_t* DEPTH_REGION_NUM regions
+ * @param 	uint8_t* value, DEPTH_LAYOUT_LEN bytes
+ * @retval	none
+ *
+ */
+void Depth_LayoutEncode(const Depth_Region_t *regions, uint8_t *data)
+{
+	uint32_t r;
+
+	for (r = 0; r < DEPTH_REGION_NUM; r++, data += DEPTH_REGION_LEN) {
+		data[0] = regions[r].x;
+		data[1] = regions[r].y;
+		data[2] = regions[r].w;
+		data[3] = regions[r].h;
+		data[4] = (uint8_t)(regions[r].weight & 0xFFU);
+		data[5] = (uint8_t)(regions[r].weight >> 8);
+	}
+}
+
+/*
+ *
+ * @brief 	Stores rows of the depth tile, reduces it once complete
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	float* grid, DEPTH_REGION_NUM values
+ * @retval	uint8_t 1 if the grid was written
+ *
+ */
+uint8_t Depth_TileWrite(const uint8_t *data, uint16_t length, float *grid)
+{
+	uint16_t timestamp;
+	uint8_t first, rows;
+
+	if (length < DEPTH_TILE_HEADER_LEN) {
+		return 0;
+	}
+
+	timestamp = data[0] | (data[1] << 8);
+	first = data[2];
+	rows = data[3];
+
+	// More rows than a write can carry would not have come in one event
+	if ((rows == 0) || (rows > DEPTH_TILE_ROWS_MAX) || ((uint32_t)first + rows > DEPTH_TILE_SIZE) ||
+		(length < DEPTH_TILE_HEADER_LEN + (rows * DEPTH_TILE_SIZE))) {
+		return 0;
+	}
+
+	// Rows of a new tile: the rows of an incomplete one are left over
+	if (timestamp != depth_timestamp) {
+		depth_timestamp = timestamp;
+		depth_rows = 0;
+	}
+
+	memcpy(&depth_tile[first * DEPTH_TILE_SIZE], data + DEPTH_TILE_HEADER_LEN, rows * DEPTH_TILE_SIZE);
+	depth_rows |= ((1UL << rows) - 1UL) << first;
+
+	if (depth_rows != DEPTH_ROWS_ALL) {
+		return 0;
+	}
+
+	depth_rows = 0;
+	Depth_Reduce(grid);
+
+	return 1;
+}
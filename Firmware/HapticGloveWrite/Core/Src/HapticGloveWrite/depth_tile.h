@@ -0,0 +1,102 @@
+/*
+ * depth_tile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_DEPTH_TILE_H_
+#define SRC_HAPTICGLOVEWRITE_DEPTH_TILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "haptic_render.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define DEPTH_TILE_SIZE			16U		// Tile width and height, in samples
+#define DEPTH_TILE_HEADER_LEN	4U		// Timestamp (2), first row (1), number of rows (1)
+#define DEPTH_TILE_EVENT_HDR_LEN	13U	// Headers of the aci_gatt_attribute_modified_event of a write
+#define DEPTH_TILE_ROWS_MAX		6U		// Rows per write: the event must fit the 128 byte HCI read buffer
+#define DEPTH_TILE_CHAR_LEN		(DEPTH_TILE_HEADER_LEN + (DEPTH_TILE_ROWS_MAX * DEPTH_TILE_SIZE))
+#define DEPTH_REGION_NUM		HAPTIC_CELL_NUM	// One region per motor
+#define DEPTH_REGION_LEN		6U		// Region in the layout characteristic: x, y, w, h, weight (2)
+#define DEPTH_LAYOUT_LEN		(DEPTH_REGION_NUM * DEPTH_REGION_LEN)
+#define DEPTH_WEIGHT_ONE		256U	// Region weight of 1.0, Q8
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Area of the tile reduced into the value of one motor */
+typedef struct {
+	uint8_t x;			// First column
+	uint8_t y;			// First row
+	uint8_t w;			// Columns
+	uint8_t h;			// Rows
+	uint16_t weight;	// Gain on the normalized depth, Q8
+} Depth_Region_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Replaces the actuator layout, one region per motor
+ * @param 	const Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	uint8_t 0 if a region is empty or leaves the tile, 1 otherwise
+ *
+ */
+uint8_t Depth_SetLayout(const Depth_Region_t *regions);
+
+/*
+ *
+ * @brief 	Copies the actuator layout in use
+ * @param 	Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	none
+ *
+ */
+void Depth_GetLayout(Depth_Region_t *regions);
+
+/*
+ *
+ * @brief 	Decodes a write of the layout characteristic: for each region its
+ * 			first column, first row, columns, rows, then its weight in Q8,
+ * 			little endian
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	Depth_Region_t* DEPTH_REGION_NUM regions
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Depth_LayoutDecode(const uint8_t *data, uint16_t length, Depth_Region_t *regions);
+
+/*
+ *
+ * @brief 	Encodes a layout as the layout characteristic value
+ * @param 	const Depth_Region_t* DEPTH_REGION_NUM regions
+ * @param 	uint8_t* value, DEPTH_LAYOUT_LEN bytes
+ * @retval	none
+ *
+ */
+void Depth_LayoutEncode(const Depth_Region_t *regions, uint8_t *data);
+
+/*
+ *
+ * @brief 	Stores rows of the depth tile written by the phone. Once all the
+ * 			rows of a tile are in, reduces it into the grid
+ * @param 	const uint8_t* characteristic value: timestamp, first row, number
+ * 			of rows, up to DEPTH_TILE_ROWS_MAX, then the rows of
+ * 			DEPTH_TILE_SIZE samples
+ * @param 	uint16_t length of the value
+ * @param 	float* grid, DEPTH_REGION_NUM values, written when the tile is complete
+ * @retval	uint8_t 1 if the grid was written
+ *
+ */
+uint8_t Depth_TileWrite(const uint8_t *data, uint16_t length, float *grid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAPTICGLOVEWRITE_DEPTH_TILE_H_ */
@@ -0,0 +1,117 @@
+/*
+ * event_dispatch.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Dispatch of the HCI/ACI events to the application handlers. The tables are
+// built by the compiler from the lists in event_dispatch.h and indexed directly
+// by the event code, so the cost of a dispatch does not depend on their size.
+
+// Includes
+#include <stddef.h>
+#include "event_dispatch.h"
+#include "sensor.h"
+#include "bluenrg1_types.h"
+#include "hci_const.h"
+
+// Private defines
+#define HCI_EVT_TABLE_SIZE          64    // Event codes 0x00 - 0x3F
+#define HCI_LE_META_TABLE_SIZE      16    // Subevent codes 0x00 - 0x0F
+#define VENDOR_GROUP_NUM            4     // HAL, GAP, L2CAP, GATT/ATT
+#define VENDOR_GROUP_SIZE           32
+#define VENDOR_ECODE_MASK           0x0C1F
+#define VENDOR_GROUP(ecode)         ((ecode) >> 10)
+#define VENDOR_INDEX(ecode)         ((ecode) & (VENDOR_GROUP_SIZE - 1))
+
+// Grid writes: checked before any lookup
+#define GATT_ATTRIBUTE_MODIFIED_ECODE   0x0c01
+
+// Parsers from bluenrg1_events.c
+#define EVENT_PROCESS_PROTOTYPE(code, handler) \
+	tBleStatus handler##_process(uint8_t *buffer_in);
+
+APP_HCI_EVENTS(EVENT_PROCESS_PROTOTYPE)
+APP_HCI_LE_META_EVENTS(EVENT_PROCESS_PROTOTYPE)
+APP_HCI_VENDOR_EVENTS(EVENT_PROCESS_PROTOTYPE)
+
+// Every code must fit its table
+#define CHECK_HCI_EVENT(code, handler) \
+	_Static_assert((code) < HCI_EVT_TABLE_SIZE, #handler ": event code out of the dispatch table");
+#define CHECK_LE_META_EVENT(code, handler) \
+	_Static_assert((code) < HCI_LE_META_TABLE_SIZE, #handler ": subevent code out of the dispatch table");
+#define CHECK_VENDOR_EVENT(code, handler) \
+	_Static_assert(((code) & ~VENDOR_ECODE_MASK) == 0, #handler ": ecode out of the dispatch table");
+
+APP_HCI_EVENTS(CHECK_HCI_EVENT)
+APP_HCI_LE_META_EVENTS(CHECK_LE_META_EVENT)
+APP_HCI_VENDOR_EVENTS(CHECK_VENDOR_EVENT)
+
+// Dispatch tables
+#define HCI_EVENT_ENTRY(code, handler)      [(code)] = handler##_process,
+#define VENDOR_EVENT_ENTRY(code, handler)   [VENDOR_GROUP(code)][VENDOR_INDEX(code)] = handler##_process,
+
+static const hci_event_process hci_events_dispatch[HCI_EVT_TABLE_SIZE] = {
+	APP_HCI_EVENTS(HCI_EVENT_ENTRY)
+};
+
+static const hci_event_process hci_le_meta_events_dispatch[HCI_LE_META_TABLE_SIZE] = {
+	APP_HCI_LE_META_EVENTS(HCI_EVENT_ENTRY)
+};
+
+static const hci_event_process hci_vendor_events_dispatch[VENDOR_GROUP_NUM][VENDOR_GROUP_SIZE] = {
+	APP_HCI_VENDOR_EVENTS(VENDOR_EVENT_ENTRY)
+};
+
+/*
+ *
+ * @brief 	Callback processing the ACI events
+ * @note	Each event is looked up by code in the dispatch tables; events
+ * 			without an application handler are ignored
+ * @param 	void* pointer to the ACI packet
+ * @retval	none
+ *
+ */
+void APP_UserEvtRx(void *pData)
+{
+	hci_spi_pckt *hci_pckt = (hci_spi_pckt *)pData;
+	hci_event_pckt *event_pckt;
+	hci_event_process process = NULL;
+	uint8_t *params = NULL;
+
+	if (hci_pckt->type != HCI_EVENT_PKT) {
+		return;
+	}
+
+	event_pckt = (hci_event_pckt *)hci_pckt->data;
+
+	if (event_pckt->evt == EVT_VENDOR) {
+		evt_blue_aci *blue_evt = (void *)event_pckt->data;
+		uint16_t ecode = blue_evt->ecode;
+
+		if (ecode == GATT_ATTRIBUTE_MODIFIED_ECODE) {
+			aci_gatt_attribute_modified_event_process(blue_evt->data);
+			return;
+		}
+
+		if ((ecode & ~VENDOR_ECODE_MASK) == 0) {
+			process = hci_vendor_events_dispatch[VENDOR_GROUP(ecode)][VENDOR_INDEX(ecode)];
+			params = blue_evt->data;
+		}
+	} else if (event_pckt->evt == EVT_LE_META_EVENT) {
+		evt_le_meta_event *evt = (void *)event_pckt->data;
+
+		if (evt->subevent < HCI_LE_META_TABLE_SIZE) {
+			process = hci_le_meta_events_dispatch[evt->subevent];
+			params = evt->data;
+		}
+	} else if (event_pckt->evt < HCI_EVT_TABLE_SIZE) {
+		process = hci_events_dispatch[event_pckt->evt];
+		params = event_pckt->data;
+	}
+
+	if (process != NULL) {
+		process(params);
+	}
+}
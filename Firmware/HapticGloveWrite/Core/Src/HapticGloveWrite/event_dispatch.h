@@ -0,0 +1,50 @@
+/*
+ * event_dispatch.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_EVENT_DISPATCH_H_
+#define SRC_HAPTICGLOVEWRITE_EVENT_DISPATCH_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/*
+ * Events handled by the application, as X(code, handler) entries.
+ * handler##_process is the parser from bluenrg1_events.c, which calls the
+ * handler the application defines. Only the events listed here get a slot in
+ * the dispatch tables of event_dispatch.c; the other parsers and the weak
+ * stubs of bluenrg1_events_cb.c are then no longer referenced and are left
+ * out of the image by the linker.
+ */
+
+/* HCI events, keyed by event code (0x00 - 0x3F) */
+#define APP_HCI_EVENTS(X) \
+	X(0x0005, hci_disconnection_complete_event) \
+	X(0x0008, hci_encryption_change_event) \
+	X(0x0013, hci_number_of_completed_packets_event) \
+	X(0x001a, hci_data_buffer_overflow_event)
+
+/* HCI LE meta events, keyed by subevent code (0x00 - 0x0F) */
+#define APP_HCI_LE_META_EVENTS(X) \
+	X(0x0001, hci_le_connection_complete_event) \
+	X(0x0003, hci_le_connection_update_complete_event)
+
+/* Vendor specific events, keyed by ecode: group in bits 11:10, event in bits 4:0 */
+#define APP_HCI_VENDOR_EVENTS(X) \
+	X(0x0001, aci_blue_initialized_event) \
+	X(0x0004, aci_hal_end_of_radio_activity_event) \
+	X(0x0401, aci_gap_pairing_complete_event) \
+	X(0x0402, aci_gap_pass_key_req_event) \
+	X(0x0405, aci_gap_bond_lost_event) \
+	X(0x0800, aci_l2cap_connection_update_resp_event) \
+	X(0x0801, aci_l2cap_proc_timeout_event) \
+	X(0x0c01, aci_gatt_attribute_modified_event) \
+	X(0x0c14, aci_gatt_read_permit_req_event) \
+	X(0x0c16, aci_gatt_tx_pool_available_event)
+
+#endif /* SRC_HAPTICGLOVEWRITE_EVENT_DISPATCH_H_ */
@@ -32,9 +32,17 @@
 #include "bluenrg1_aci.h"
 #include "bluenrg1_hci_le.h"
 #include "bluenrg1_gatt_aci.h"
+#include "hci_tl.h"
 
 #include "bluenrg_init.h"
 #include "sensor.h"
+#include "motor_control.h"
+#include "link_policy.h"
+#include "telemetry.h"
+#include "notify_queue.h"
+#include "depth_tile.h"
+#include "haptic_filter.h"
+#include "haptic_predict.h"
 #include "main.h"
 
 /* Private macros ------------------------------------------------------------*/
@@ -67,14 +75,31 @@ do {\
 
 // MARK: What we care about
 #define COPY_GRID_W2ST_CHAR_UUID(uuid_struct) 			COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x01,0x00,0x01,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
+#define COPY_TELEMETRY_W2ST_CHAR_UUID(uuid_struct) 		COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x02,0x00,0x01,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
+#define COPY_DEPTH_TILE_W2ST_CHAR_UUID(uuid_struct) 	COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x03,0x00,0x01,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
+#define COPY_FILTER_W2ST_CHAR_UUID(uuid_struct) 		COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x04,0x00,0x01,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
+#define COPY_DEPTH_LAYOUT_W2ST_CHAR_UUID(uuid_struct) 	COPY_UUID_128(uuid_struct,0x00,0x00,0x00,0x05,0x00,0x01,0x11,0xe1,0xac,0x36,0x00,0x02,0xa5,0xd5,0xc5,0x1b)
+
+// A longer write would come in an event the HCI read buffer truncates
+_Static_assert(DEPTH_TILE_EVENT_HDR_LEN + DEPTH_TILE_CHAR_LEN <= HCI_READ_PACKET_SIZE,
+			   "DEPTH_TILE_ROWS_MAX exceeds the HCI read buffer");
 
 uint16_t GridCharHandle;
+uint16_t TelemetryCharHandle;
+uint16_t DepthTileCharHandle;
+uint16_t FilterCharHandle;
+uint16_t DepthLayoutCharHandle;
 
 /* Private variables ---------------------------------------------------------*/
 uint16_t HWServW2STHandle, EnvironmentalCharHandle, AccGyroMagCharHandle;
 uint16_t SWServW2STHandle, QuaternionsCharHandle;
 float grid[4];
 //static volatile uint8_t notifiation_enabled = FALSE;
+static uint8_t grid_buff[2+4*4];
+static uint8_t filter_buff[HAPTIC_FILTER_PARAMS_LEN];
+static Haptic_FilterParams_t filter_params;
+static uint8_t layout_buff[DEPTH_LAYOUT_LEN];
+static Depth_Region_t layout_regions[DEPTH_REGION_NUM];
 
 /* UUIDS */
 Service_UUID_t service_uuid;
@@ -106,7 +131,7 @@ tBleStatus Add_HWServW2ST_Service(void)
     COPY_SW_SENS_W2ST_SERVICE_UUID(uuid);
     BLUENRG_memcpy(&service_uuid.Service_UUID_128, uuid, 16);
     ret = aci_gatt_add_service(UUID_TYPE_128, &service_uuid, PRIMARY_SERVICE,
-                               1+(3*1), &SWServW2STHandle);
+                               1+(3*2)+(3*2), &SWServW2STHandle);
     if (ret != BLE_STATUS_SUCCESS) {
         return BLE_STATUS_ERROR;
     }
@@ -115,15 +140,94 @@ tBleStatus Add_HWServW2ST_Service(void)
     COPY_GRID_W2ST_CHAR_UUID(uuid);
     BLUENRG_memcpy(&char_uuid.Char_UUID_128, uuid, 16);
     ret = aci_gatt_add_char(SWServW2STHandle, UUID_TYPE_128, &char_uuid,
-                            2+4*4, // 2 bytes for timestamp, 4 floats (4 bytes each)
+                            HAPTIC_GRID_LATENCY_LEN, // 2 bytes for timestamp, 4 floats (4 bytes each), optional latency
                             CHAR_PROP_NOTIFY | CHAR_PROP_READ | CHAR_PROP_WRITE,
                             ATTR_PERMISSION_NONE,
                             GATT_NOTIFY_ATTRIBUTE_WRITE,
-                            16, 0, &GridCharHandle);
+                            16, 1, &GridCharHandle);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Add Telemetry characteristic, notified once per window
+    COPY_TELEMETRY_W2ST_CHAR_UUID(uuid);
+    BLUENRG_memcpy(&char_uuid.Char_UUID_128, uuid, 16);
+    ret = aci_gatt_add_char(SWServW2STHandle, UUID_TYPE_128, &char_uuid,
+                            TELEMETRY_PACKET_LEN,
+                            CHAR_PROP_NOTIFY | CHAR_PROP_READ,
+                            ATTR_PERMISSION_NONE,
+                            GATT_DONT_NOTIFY_EVENTS,
+                            16, 0, &TelemetryCharHandle);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Add Depth Tile characteristic, rows of the tile reduced on the glove
+    COPY_DEPTH_TILE_W2ST_CHAR_UUID(uuid);
+    BLUENRG_memcpy(&char_uuid.Char_UUID_128, uuid, 16);
+    ret = aci_gatt_add_char(SWServW2STHandle, UUID_TYPE_128, &char_uuid,
+                            DEPTH_TILE_CHAR_LEN,
+                            CHAR_PROP_WRITE | CHAR_PROP_WRITE_WITHOUT_RESP,
+                            ATTR_PERMISSION_NONE,
+                            GATT_NOTIFY_ATTRIBUTE_WRITE,
+                            16, CHAR_VALUE_LEN_VARIABLE, &DepthTileCharHandle);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Each write carries other rows from offset 0: none of them replaces another
+    if (hci_rx_no_coalesce(DepthTileCharHandle + 1) != 0) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Add Filter characteristic, parameters of the temporal filter of the grid
+    COPY_FILTER_W2ST_CHAR_UUID(uuid);
+    BLUENRG_memcpy(&char_uuid.Char_UUID_128, uuid, 16);
+    ret = aci_gatt_add_char(SWServW2STHandle, UUID_TYPE_128, &char_uuid,
+                            HAPTIC_FILTER_PARAMS_LEN,
+                            CHAR_PROP_READ | CHAR_PROP_WRITE,
+                            ATTR_PERMISSION_NONE,
+                            GATT_NOTIFY_ATTRIBUTE_WRITE,
+                            16, 0, &FilterCharHandle);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Read back as the parameters in use
+    Haptic_FilterGetParams(&filter_params);
+    Haptic_FilterEncode(&filter_params, filter_buff);
+    ret = aci_gatt_update_char_value(SWServW2STHandle, FilterCharHandle, 0,
+                                     HAPTIC_FILTER_PARAMS_LEN, filter_buff);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Add Depth Layout characteristic, the region and weight of each motor in the depth tile
+    COPY_DEPTH_LAYOUT_W2ST_CHAR_UUID(uuid);
+    BLUENRG_memcpy(&char_uuid.Char_UUID_128, uuid, 16);
+    ret = aci_gatt_add_char(SWServW2STHandle, UUID_TYPE_128, &char_uuid,
+                            DEPTH_LAYOUT_LEN,
+                            CHAR_PROP_READ | CHAR_PROP_WRITE,
+                            ATTR_PERMISSION_NONE,
+                            GATT_NOTIFY_ATTRIBUTE_WRITE,
+                            16, 0, &DepthLayoutCharHandle);
+    if (ret != BLE_STATUS_SUCCESS) {
+        return BLE_STATUS_ERROR;
+    }
+
+    // Read back as the layout in use
+    Depth_GetLayout(layout_regions);
+    Depth_LayoutEncode(layout_regions, layout_buff);
+    ret = aci_gatt_update_char_value(SWServW2STHandle, DepthLayoutCharHandle, 0,
+                                     DEPTH_LAYOUT_LEN, layout_buff);
     if (ret != BLE_STATUS_SUCCESS) {
         return BLE_STATUS_ERROR;
     }
 
+    // Grid and telemetry are notified through the notification queue
+    Notify_Register(NOTIFY_CH_GRID, SWServW2STHandle, GridCharHandle);
+    Notify_Register(NOTIFY_CH_TELEMETRY, SWServW2STHandle, TelemetryCharHandle);
+
     return BLE_STATUS_SUCCESS;
 }
 
@@ -135,20 +239,19 @@ tBleStatus Grid_Update(float grid[2][2])
 	PRINT_DBG("HWServW2STHandle: 0x%04X, GridCharHandle: 0x%04X\r\n", SWServW2STHandle, GridCharHandle);
 
     tBleStatus ret;
-    uint8_t buff[2+4*4];
 
-    HOST_TO_LE_16(buff, HAL_GetTick()>>3);
+    HOST_TO_LE_16(grid_buff, HAL_GetTick()>>3);
 
     for (int i = 0; i < 2; i++) {
         for (int j = 0; j < 2; j++) {
             uint32_t temp;
             memcpy(&temp, &grid[i][j], sizeof(float));
-            HOST_TO_LE_32(buff + 2 + (i*2+j)*4, temp);
+            HOST_TO_LE_32(grid_buff + 2 + (i*2+j)*4, temp);
         }
     }
 
-    ret = aci_gatt_update_char_value(SWServW2STHandle, GridCharHandle,
-                                     0, 2+4*4, buff);
+    // Queued, or replacing the value still waiting on a congested link
+    ret = Notify_Post(NOTIFY_CH_GRID, grid_buff, sizeof(grid_buff));
     if (ret != BLE_STATUS_SUCCESS) {
         PRINT_DBG("Error while updating Grid characteristic: 0x%02X\r\n", ret);
         return BLE_STATUS_ERROR;
@@ -158,6 +261,27 @@ tBleStatus Grid_Update(float grid[2][2])
 }
 
 
+/**
+ * @brief  Update the Telemetry characteristic, notified if the central subscribed
+ * @param  data Value, copied
+ * @param  length Length of the value
+ * @retval tBleStatus Status
+ */
+tBleStatus Telemetry_Char_Update(const uint8_t *data, uint8_t length)
+{
+    tBleStatus ret;
+
+    // Background channel: sent when the grid has nothing waiting
+    ret = Notify_Post(NOTIFY_CH_TELEMETRY, data, length);
+    if (ret != BLE_STATUS_SUCCESS) {
+        PRINT_DBG("Error while updating Telemetry characteristic: 0x%02X\r\n", ret);
+        return BLE_STATUS_ERROR;
+    }
+
+    return BLE_STATUS_SUCCESS;
+}
+
+
 // TODO: MODIFY THIS INTO UPDATING THE CAMERA VALUE.
 
 
@@ -185,6 +309,8 @@ void Read_Request_CB(uint16_t handle)
 
   if(connection_handle !=0)
   {
+    // Called from the event dispatch: do not wait for the answer here
+    hci_set_next_req_async(APP_CmdCpltCB, NULL);
     ret = aci_gatt_allow_read(connection_handle);
     if (ret != BLE_STATUS_SUCCESS)
     {
@@ -237,35 +363,24 @@ void Attribute_Modified_Request_CB(uint16_t Connection_Handle,
 	        PRINT_DBG("Characteristic written: Handle=0x%04X, Data Length=%d\r\n",
 	                  attr_handle, data_length);
 
-	        // Timestamp
-	        uint16_t timestamp = att_data[0] | (att_data[1] << 8);
+	        // Timestamp and grid, decoded as on the host replay
+	        uint16_t timestamp;
+	        if (!Haptic_GridDecode(att_data, data_length, &timestamp, grid)) {
+	        	PRINT_DBG("Grid write of %d bytes rejected\r\n", data_length);
+	        	return;
+	        }
 	        PRINT_DBG("Timestamp: %u\r\n", timestamp);
 
-	        for (int i = 0; i < 4; ++i) {
-	        	float value;
-	        	memcpy(&value, att_data + 2 + (i*4), 4);
-	        	PRINT_DBG("Float %d: %f (Raw: 0x%08X)\r\n", i, value, *(uint32_t*)(att_data + 2 + (i * 4)));
-
-	        	// Convert 4 bytes to float
-	        					int index = 2 + (i * 4);
-
-	        	                uint32_t temp = 0;
-	        	                memcpy(&temp, att_data + 2 + (i*4), 4);
-
-	        	               union {
-	        	                	uint32_t i;
-	        	                	float f;
-	        	                } converter;
-	        	               converter.i = temp;
-
-
-	        	                // Use memcpy to avoid strict aliasing violations
-	        	                //memcpy(&value, &temp, sizeof(float));
-
-
-	        	               	grid[i] = converter.f;
-	        	                PRINT_DBG("Grid[%d]: %f\r\n", i, grid[i]);
+	        // Latency from the camera to the write, plus half a connection interval for the link
+	        uint16_t latency;
+	        if (Haptic_GridLatency(att_data, data_length, &latency)) {
+	        	LinkPolicy_Params_t link;
+	        	LinkPolicy_GetParams(&link);
+	        	Haptic_PredictLatency(latency + ((link.interval * 5U) / 8U));
+	        }
 
+	        for (int i = 0; i < 4; ++i) {
+	        	PRINT_DBG("Grid[%d]: %f\r\n", i, grid[i]);
 	        }
 
 	        // Hex dump
@@ -290,11 +405,49 @@ void Attribute_Modified_Request_CB(uint16_t Connection_Handle,
 	        	HAL_GPIO_WritePin(GPIOB, GPIO_PIN_14, 1);
 	        }
 
-	        // Handle the new data as needed
-	        change_pwm_pulse_2(&htim2, TIM_CHANNEL_3, (uint32_t) roundf(grid[0] * 24));
-	        change_pwm_pulse_2(&htim2, TIM_CHANNEL_4, (uint32_t) roundf(grid[1] * 24));
-	        change_pwm_pulse(&htim16, TIM_CHANNEL_1, (uint16_t) roundf(grid[2] * 24));
-	        change_pwm_pulse(&htim1, TIM_CHANNEL_4, (uint16_t) roundf(grid[3] * 24));
+	        // Applied to the motors by the render task on its next tick
+	        Motor_SetGrid(grid);
+	        BlueNRG_HapticFrame();
+	        LinkPolicy_Frame(grid);
+	    } else if (attr_handle == DepthTileCharHandle + 1) {
+	        // The grid comes once all the rows of a tile are in
+	        if (Depth_TileWrite(att_data, data_length, grid)) {
+	            Motor_SetGrid(grid);
+	            BlueNRG_HapticFrame();
+	            LinkPolicy_Frame(grid);
+	        }
+	    } else if (attr_handle == FilterCharHandle + 1) {
+	        if (Haptic_FilterDecode(att_data, data_length, &filter_params) &&
+	            Haptic_FilterSetParams(&filter_params)) {
+	            PRINT_DBG("Filter mode %u\r\n", filter_params.mode);
+	        } else {
+	            // Rejected: the value goes back to the parameters in use
+	            PRINT_DBG("Filter parameters rejected\r\n");
+	            Haptic_FilterGetParams(&filter_params);
+	            Haptic_FilterEncode(&filter_params, filter_buff);
+	            hci_set_next_req_async(APP_CmdCpltCB, NULL);
+	            if (aci_gatt_update_char_value(SWServW2STHandle, FilterCharHandle, 0,
+	                                           HAPTIC_FILTER_PARAMS_LEN, filter_buff) != BLE_STATUS_SUCCESS) {
+	                PRINT_DBG("Filter characteristic not restored\r\n");
+	            }
+	        }
+	    } else if (attr_handle == DepthLayoutCharHandle + 1) {
+	        if (Depth_LayoutDecode(att_data, data_length, layout_regions) &&
+	            Depth_SetLayout(layout_regions)) {
+	            PRINT_DBG("Depth layout updated\r\n");
+	        } else {
+	            // Rejected: the value goes back to the layout in use
+	            PRINT_DBG("Depth layout rejected\r\n");
+	            Depth_GetLayout(layout_regions);
+	            Depth_LayoutEncode(layout_regions, layout_buff);
+	            hci_set_next_req_async(APP_CmdCpltCB, NULL);
+	            if (aci_gatt_update_char_value(SWServW2STHandle, DepthLayoutCharHandle, 0,
+	                                           DEPTH_LAYOUT_LEN, layout_buff) != BLE_STATUS_SUCCESS) {
+	                PRINT_DBG("Depth layout characteristic not restored\r\n");
+	            }
+	        }
+	    } else if (attr_handle == TelemetryCharHandle + 2) { // Client characteristic configuration
+	        Telemetry_SetNotify(att_data[0] & 0x01);
 	    } else {
 	        PRINT_DBG("Attribute modification for unknown handle: 0x%04X\r\n", attr_handle);
 	    }
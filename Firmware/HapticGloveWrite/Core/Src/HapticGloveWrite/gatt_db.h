@@ -49,6 +49,7 @@ extern TIM_HandleTypeDef htim1;
 /* Exported function prototypes ----------------------------------------------*/
 tBleStatus Add_HWServW2ST_Service(void);
 tBleStatus Add_SWServW2ST_Service(void);
+tBleStatus Telemetry_Char_Update(const uint8_t *data, uint8_t length);
 void Read_Request_CB(uint16_t handle);
 void Attribute_Modified_Request_CB(uint16_t Connection_Handle, uint16_t attr_handle,
                                    uint16_t Offset, uint8_t data_length, uint8_t *att_data);
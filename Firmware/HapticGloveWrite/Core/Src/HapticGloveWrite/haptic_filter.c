@@ -0,0 +1,240 @@
+/*
+ * haptic_filter.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Temporal filter of the grid, cell by cell, between the decoding of a frame
+// and its mapping to the PWM, so that the flicker of the depth model does not
+// reach the motors. Either a moving average of fixed weight, or the one euro
+// filter (Casiez et al., CHI 2012): a low pass whose cutoff rises with the
+// speed of the cell, smooth when still and without lag when moving. All of it
+// in Q15 integers; the weights come out of the cutoff and the time between
+// frames as alpha = r / (1 + r), r = 2 pi fc dt, with one division per cell.
+// Nothing here touches the HAL, so it runs in the host replay as well.
+
+// Includes
+#include "haptic_filter.h"
+#include "haptic_render.h"
+
+// Private defines
+#define HAPTIC_ALPHA_K		52707U		// 2 pi 2^15 / (2^8 1000) in Q16: Q8 Hz times ms to r in Q15
+#define HAPTIC_R_MAX		(1UL << 30)
+
+// Variables
+static Haptic_FilterParams_t filter_params = {
+	HAPTIC_FILTER_ONE_EURO,
+	HAPTIC_Q15_ONE / 2,		// 0.5
+	256,					// 1 Hz
+	256,					// 1 Hz per unit per second
+	256,					// 1 Hz
+};
+
+static struct {
+	int32_t value;			// Filtered, Q15
+	int32_t raw;			// Last input, Q15
+	int32_t speed;			// Filtered speed, Q15 per second
+} filter_cells[HAPTIC_CELL_NUM];
+
+static uint32_t filter_time_ms;
+static uint8_t filter_primed = 0;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Weight of a new value for a low pass of a given cutoff
+ * @param 	uint32_t cutoff, Hz, Q8
+ * @param 	uint32_t time since the last value, ms
+ * @retval	uint32_t weight, Q15
+ *
+ */
+static uint32_t Haptic_Alpha(uint32_t cutoff, uint32_t dt_ms)
+{
+	uint64_t r = ((uint64_t)cutoff * dt_ms * HAPTIC_ALPHA_K) >> 16;
+
+	if (r > HAPTIC_R_MAX) {
+		r = HAPTIC_R_MAX;
+	}
+
+	// r / (1 + r) = 1 - 1 / (1 + r)
+	return HAPTIC_Q15_ONE - (uint32_t)(HAPTIC_R_MAX / ((uint32_t)r + HAPTIC_Q15_ONE));
+}
+
+/*
+ *
+ * @brief 	One step of a low pass
+ * @param 	int32_t last output
+ * @param 	int32_t new value
+ * @param 	uint32_t weight of the new value, Q15
+ * @retval	int32_t output
+ *
+ */
+static int32_t Haptic_Smooth(int32_t last, int32_t value, uint32_t alpha)
+{
+	return last + (int32_t)((((int64_t)(value - last) * alpha) + (HAPTIC_Q15_ONE / 2)) >> 15);
+}
+
+static uint16_t Haptic_Get16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void Haptic_Put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Replaces the filter parameters
+ * @param 	const Haptic_FilterParams_t* parameters
+ * @retval	uint8_t 1 if the parameters were valid and taken
+ *
+ */
+uint8_t Haptic_FilterSetParams(const Haptic_FilterParams_t *params)
+{
+	if ((params->mode >= HAPTIC_FILTER_NUM) ||
+		((params->mode == HAPTIC_FILTER_EMA) && ((params->alpha == 0) || (params->alpha > HAPTIC_Q15_ONE))) ||
+		((params->mode == HAPTIC_FILTER_ONE_EURO) && ((params->min_cutoff == 0) || (params->d_cutoff == 0)))) {
+		return 0;
+	}
+
+	if (params->mode != filter_params.mode) {
+		Haptic_FilterReset();
+	}
+
+	filter_params = *params;
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Copies the filter parameters
+ * @param 	Haptic_FilterParams_t* filled with the parameters
+ * @retval	none
+ *
+ */
+void Haptic_FilterGetParams(Haptic_FilterParams_t *params)
+{
+	*params = filter_params;
+}
+
+/*
+ *
+ * @brief 	Decodes a write of the filter characteristic
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	Haptic_FilterParams_t* parameters
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Haptic_FilterDecode(const uint8_t *data, uint16_t length, Haptic_FilterParams_t *params)
+{
+	if (length < HAPTIC_FILTER_PARAMS_LEN) {
+		return 0;
+	}
+
+	params->mode = data[0];
+	params->alpha = Haptic_Get16(data + 1);
+	params->min_cutoff = Haptic_Get16(data + 3);
+	params->beta = Haptic_Get16(data + 5);
+	params->d_cutoff = Haptic_Get16(data + 7);
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Encodes parameters as the filter characteristic value
+ * @param 	const Haptic_FilterParams_t* parameters
+ * @param 	uint8_t* value, HAPTIC_FILTER_PARAMS_LEN bytes
+ * @retval	none
+ *
+ */
+void Haptic_FilterEncode(const Haptic_FilterParams_t *params, uint8_t *data)
+{
+	data[0] = params->mode;
+	Haptic_Put16(data + 1, params->alpha);
+	Haptic_Put16(data + 3, params->min_cutoff);
+	Haptic_Put16(data + 5, params->beta);
+	Haptic_Put16(data + 7, params->d_cutoff);
+}
+
+/*
+ *
+ * @brief 	Forgets the past frames
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_FilterReset(void)
+{
+	filter_primed = 0;
+}
+
+/*
+ *
+ * @brief 	Filters a frame, cell by cell, in place
+ * @param 	int32_t* cells, HAPTIC_CELL_NUM values in Q15
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_FilterApply(int32_t *cells, uint32_t time_ms)
+{
+	uint32_t dt = time_ms - filter_time_ms;
+	uint32_t rate, alpha, alpha_d, cutoff, i;
+	int32_t speed;
+
+	if (filter_params.mode == HAPTIC_FILTER_OFF) {
+		return;
+	}
+
+	// First frame, or the last one is too old to smooth with: taken as it is
+	if (!filter_primed || (dt > HAPTIC_FILTER_GAP_MS)) {
+		for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+			filter_cells[i].value = cells[i];
+			filter_cells[i].raw = cells[i];
+			filter_cells[i].speed = 0;
+		}
+		filter_time_ms = time_ms;
+		filter_primed = 1;
+		return;
+	}
+
+	filter_time_ms = time_ms;
+	if (dt == 0) {
+		dt = 1;
+	}
+
+	if (filter_params.mode == HAPTIC_FILTER_EMA) {
+		for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+			filter_cells[i].value = Haptic_Smooth(filter_cells[i].value, cells[i], filter_params.alpha);
+			cells[i] = filter_cells[i].value;
+		}
+		return;
+	}
+
+	// One euro
+	rate = (1000UL << 16) / dt;		// Frames per second, Q16
+	alpha_d = Haptic_Alpha(filter_params.d_cutoff, dt);
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		speed = (int32_t)(((int64_t)(cells[i] - filter_cells[i].raw) * rate) >> 16);
+		filter_cells[i].raw = cells[i];
+		filter_cells[i].speed = Haptic_Smooth(filter_cells[i].speed, speed, alpha_d);
+
+		speed = (filter_cells[i].speed < 0) ? -filter_cells[i].speed : filter_cells[i].speed;
+		cutoff = filter_params.min_cutoff + (uint32_t)(((uint64_t)filter_params.beta * (uint32_t)speed) >> 15);
+		alpha = Haptic_Alpha(cutoff, dt);
+
+		filter_cells[i].value = Haptic_Smooth(filter_cells[i].value, cells[i], alpha);
+		cells[i] = filter_cells[i].value;
+	}
+}
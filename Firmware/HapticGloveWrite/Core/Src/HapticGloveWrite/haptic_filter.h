@@ -0,0 +1,104 @@
+/*
+ * haptic_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_HAPTIC_FILTER_H_
+#define SRC_HAPTICGLOVEWRITE_HAPTIC_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+#define HAPTIC_Q15_ONE				32768	// 1.0 in Q15
+#define HAPTIC_FILTER_PARAMS_LEN	9U		// Characteristic value: mode, then the four parameters, little endian
+#define HAPTIC_FILTER_GAP_MS		500U	// Longer without a frame and the filter starts over
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+	HAPTIC_FILTER_OFF = 0,
+	HAPTIC_FILTER_EMA,				// Exponential moving average, fixed weight
+	HAPTIC_FILTER_ONE_EURO,			// Cutoff rising with the speed of the cell
+	HAPTIC_FILTER_NUM
+} Haptic_FilterMode_t;
+
+typedef struct {
+	uint8_t mode;			// Haptic_FilterMode_t
+	uint16_t alpha;			// EMA: weight of a new value, Q15, 1 to 32768
+	uint16_t min_cutoff;	// One euro: cutoff of a still cell, Hz, Q8
+	uint16_t beta;			// One euro: cutoff added per unit per second of speed, Hz, Q8
+	uint16_t d_cutoff;		// One euro: cutoff of the speed estimate, Hz, Q8
+} Haptic_FilterParams_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Replaces the filter parameters. A change of mode starts the filter over
+ * @param 	const Haptic_FilterParams_t* parameters
+ * @retval	uint8_t 1 if the parameters were valid and taken
+ *
+ */
+uint8_t Haptic_FilterSetParams(const Haptic_FilterParams_t *params);
+
+/*
+ *
+ * @brief 	Copies the filter parameters
+ * @param 	Haptic_FilterParams_t* filled with the parameters
+ * @retval	none
+ *
+ */
+void Haptic_FilterGetParams(Haptic_FilterParams_t *params);
+
+/*
+ *
+ * @brief 	Decodes a write of the filter characteristic
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	Haptic_FilterParams_t* parameters
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Haptic_FilterDecode(const uint8_t *data, uint16_t length, Haptic_FilterParams_t *params);
+
+/*
+ *
+ * @brief 	Encodes parameters as the filter characteristic value
+ * @param 	const Haptic_FilterParams_t* parameters
+ * @param 	uint8_t* value, HAPTIC_FILTER_PARAMS_LEN bytes
+ * @retval	none
+ *
+ */
+void Haptic_FilterEncode(const Haptic_FilterParams_t *params, uint8_t *data);
+
+/*
+ *
+ * @brief 	Forgets the past frames: the next one goes through as it is
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_FilterReset(void);
+
+/*
+ *
+ * @brief 	Filters a frame, cell by cell, in place
+ * @param 	int32_t* cells, HAPTIC_CELL_NUM values in Q15, 0 to HAPTIC_Q15_ONE
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_FilterApply(int32_t *cells, uint32_t time_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAPTICGLOVEWRITE_HAPTIC_FILTER_H_ */
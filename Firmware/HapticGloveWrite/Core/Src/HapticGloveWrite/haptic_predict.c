@@ -0,0 +1,191 @@
+/*
+ * haptic_predict.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Latency compensation, after the temporal filter: by the time a frame
+// drives the motors, the camera, the depth model, the phone and the link
+// have made it old. Each cell is followed by an alpha-beta tracker, a value
+// and a speed corrected by each frame, and the cell is moved along its speed
+// by the lead: the latency reported by the phone plus the response of the
+// motors. The move is weighted by a confidence that falls when the tracker
+// misses (a step, flicker) and when the frames come far apart, and it is
+// clamped, so a bad guess costs little. Integers only, no HAL.
+
+// Includes
+#include "haptic_predict.h"
+#include "haptic_filter.h"
+#include "haptic_render.h"
+
+// Variables
+static struct {
+	int32_t value;			// Tracked value, Q15
+	int32_t speed;			// Tracked speed, Q15 per second
+	int32_t confidence;		// Q15
+} predict_cells[HAPTIC_CELL_NUM];
+
+static uint32_t predict_time_ms;
+static uint8_t predict_primed = 0;
+
+static uint32_t predict_latency_ms = HAPTIC_PREDICT_LATENCY_MS;
+static uint8_t predict_measured = 0;
+
+static uint8_t predict_enabled = 1;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Clamps a value
+ * @param 	int32_t value
+ * @param 	int32_t lowest
+ * @param 	int32_t highest
+ * @retval	int32_t clamped value
+ *
+ */
+static int32_t Haptic_Clamp(int32_t value, int32_t lo, int32_t hi)
+{
+	return (value < lo) ? lo : ((value > hi) ? hi : value);
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Turns the prediction on or off
+ * @param 	uint8_t 1 to turn it on
+ * @retval	none
+ *
+ */
+void Haptic_PredictEnable(uint8_t enable)
+{
+	predict_enabled = enable ? 1 : 0;
+	Haptic_PredictReset();
+}
+
+/*
+ *
+ * @brief 	Forgets the past frames
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_PredictReset(void)
+{
+	predict_primed = 0;
+}
+
+/*
+ *
+ * @brief 	Takes a measure of the latency from capture to glove
+ * @param 	uint32_t latency, ms
+ * @retval	none
+ *
+ */
+void Haptic_PredictLatency(uint32_t latency_ms)
+{
+	if (latency_ms > HAPTIC_PREDICT_MAX_LEAD_MS) {
+		latency_ms = HAPTIC_PREDICT_MAX_LEAD_MS;
+	}
+
+	if (!predict_measured) {
+		predict_latency_ms = latency_ms;
+		predict_measured = 1;
+	} else {
+		predict_latency_ms = (uint32_t)((int32_t)predict_latency_ms +
+							 (((int32_t)latency_ms - (int32_t)predict_latency_ms) / 8));
+	}
+}
+
+/*
+ *
+ * @brief 	How far ahead the cells are extrapolated
+ * @param 	none
+ * @retval	uint32_t lead, ms
+ *
+ */
+uint32_t Haptic_PredictLead(void)
+{
+	uint32_t lead = predict_latency_ms + HAPTIC_PREDICT_RESPONSE_MS;
+
+	return (lead > HAPTIC_PREDICT_MAX_LEAD_MS) ? HAPTIC_PREDICT_MAX_LEAD_MS : lead;
+}
+
+/*
+ *
+ * @brief 	Confidence in the extrapolation of a cell
+ * @param 	uint32_t cell
+ * @retval	int32_t confidence, Q15
+ *
+ */
+int32_t Haptic_PredictConfidence(uint32_t cell)
+{
+	return (predict_primed && (cell < HAPTIC_CELL_NUM)) ? predict_cells[cell].confidence : 0;
+}
+
+/*
+ *
+ * @brief 	Extrapolates a frame, cell by cell, in place
+ * @param 	int32_t* cells, HAPTIC_CELL_NUM values in Q15
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_PredictApply(int32_t *cells, uint32_t time_ms)
+{
+	uint32_t dt = time_ms - predict_time_ms;
+	uint32_t rate, lead, i;
+	int32_t fresh, guess, miss, target, confidence, step;
+
+	if (!predict_enabled) {
+		return;
+	}
+
+	// First frame, or the last one is too old to track from: nothing to extrapolate yet
+	if (!predict_primed || (dt > HAPTIC_FILTER_GAP_MS)) {
+		for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+			predict_cells[i].value = cells[i];
+			predict_cells[i].speed = 0;
+			predict_cells[i].confidence = 0;
+		}
+		predict_time_ms = time_ms;
+		predict_primed = 1;
+		return;
+	}
+
+	predict_time_ms = time_ms;
+	if (dt == 0) {
+		dt = 1;
+	}
+
+	rate = (1000UL << 16) / dt;		// Frames per second, Q16
+	fresh = (dt >= HAPTIC_PREDICT_STALE_MS) ? 0 :
+			(int32_t)(HAPTIC_Q15_ONE - ((dt * HAPTIC_Q15_ONE) / HAPTIC_PREDICT_STALE_MS));
+	lead = Haptic_PredictLead();
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		// Tracker: where the cell should be now, corrected by where it is
+		guess = predict_cells[i].value + ((predict_cells[i].speed * (int32_t)dt) / 1000);
+		miss = cells[i] - guess;
+
+		predict_cells[i].value = guess + (int32_t)(((int64_t)miss * HAPTIC_PREDICT_ALPHA) >> 15);
+		predict_cells[i].speed = Haptic_Clamp(predict_cells[i].speed +
+											  (int32_t)(((((int64_t)miss * HAPTIC_PREDICT_BETA) >> 15) * rate) >> 16),
+											  -HAPTIC_PREDICT_MAX_SPEED, HAPTIC_PREDICT_MAX_SPEED);
+
+		// Confidence: up while the tracker follows, down when it misses
+		target = HAPTIC_Q15_ONE - Haptic_Clamp(((miss < 0) ? -miss : miss) * HAPTIC_PREDICT_RESIDUAL_GAIN,
+											   0, HAPTIC_Q15_ONE);
+		predict_cells[i].confidence += (target - predict_cells[i].confidence) / 4;
+		confidence = (int32_t)(((int64_t)predict_cells[i].confidence * fresh) >> 15);
+
+		// The frame, moved along the speed by the lead, as far as it is trusted
+		step = (predict_cells[i].speed * (int32_t)lead) / 1000;
+		step = (int32_t)(((int64_t)step * confidence) >> 15);
+		step = Haptic_Clamp(step, -HAPTIC_PREDICT_MAX_STEP, HAPTIC_PREDICT_MAX_STEP);
+
+		cells[i] = Haptic_Clamp(cells[i] + step, 0, HAPTIC_Q15_ONE);
+	}
+}
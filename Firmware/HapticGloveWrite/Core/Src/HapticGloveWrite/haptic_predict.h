@@ -0,0 +1,94 @@
+/*
+ * haptic_predict.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_HAPTIC_PREDICT_H_
+#define SRC_HAPTICGLOVEWRITE_HAPTIC_PREDICT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+#define HAPTIC_PREDICT_ALPHA		16384	// Tracker gain on the value, Q15 (0.5)
+#define HAPTIC_PREDICT_BETA			5461	// Tracker gain on the speed, Q15 (alpha^2 / (2 - alpha))
+#define HAPTIC_PREDICT_LATENCY_MS	80U		// Capture to glove until the phone reports one
+#define HAPTIC_PREDICT_RESPONSE_MS	30U		// Render tick and spin up of the motors
+#define HAPTIC_PREDICT_MAX_LEAD_MS	250U	// Furthest the cells are extrapolated
+#define HAPTIC_PREDICT_MAX_SPEED	(16 * 32768)	// Q15 per second
+#define HAPTIC_PREDICT_MAX_STEP		8192	// Most the extrapolation moves a cell, Q15 (0.25)
+#define HAPTIC_PREDICT_RESIDUAL_GAIN	8	// A miss of 1/8 of the range and the confidence is gone
+#define HAPTIC_PREDICT_STALE_MS		400U	// Frames this far apart are not extrapolated at all, under HAPTIC_FILTER_GAP_MS
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Turns the prediction on or off. Off, the cells go through as they are
+ * @param 	uint8_t 1 to turn it on
+ * @retval	none
+ *
+ */
+void Haptic_PredictEnable(uint8_t enable);
+
+/*
+ *
+ * @brief 	Forgets the past frames; the latency is kept
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_PredictReset(void);
+
+/*
+ *
+ * @brief 	Takes a measure of the latency from the capture of a frame to its
+ * 			arrival on the glove. Smoothed, the first one taken as it is
+ * @param 	uint32_t latency, ms
+ * @retval	none
+ *
+ */
+void Haptic_PredictLatency(uint32_t latency_ms);
+
+/*
+ *
+ * @brief 	How far ahead the cells are extrapolated: latency and response of
+ * 			the motors
+ * @param 	none
+ * @retval	uint32_t lead, ms
+ *
+ */
+uint32_t Haptic_PredictLead(void);
+
+/*
+ *
+ * @brief 	Confidence in the extrapolation of a cell, from how well its
+ * 			tracker followed the last frames
+ * @param 	uint32_t cell
+ * @retval	int32_t confidence, Q15, 0 to HAPTIC_Q15_ONE
+ *
+ */
+int32_t Haptic_PredictConfidence(uint32_t cell);
+
+/*
+ *
+ * @brief 	Extrapolates a frame, cell by cell, in place, to the time the
+ * 			motors will respond to it
+ * @param 	int32_t* cells, HAPTIC_CELL_NUM values in Q15, 0 to HAPTIC_Q15_ONE
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_PredictApply(int32_t *cells, uint32_t time_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAPTICGLOVEWRITE_HAPTIC_PREDICT_H_ */
@@ -0,0 +1,202 @@
+/*
+ * haptic_render.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// From the value written by the phone to the motor compare values: the grid
+// is decoded, turned into Q15, filtered in time (haptic_filter.c),
+// extrapolated over the latency (haptic_predict.c), weighted by saliency
+// (haptic_saliency.c) and mapped to the PWM. The cells of the
+// last frame are kept, so the output can be refreshed between frames while
+// the emphasized cell pulses. Nothing here touches the HAL, so the same file is built for the glove and, with
+// HapticGloveDepth, on a host, where the replay of recorded depth sequences
+// runs it frame by frame.
+
+// Includes
+#include <string.h>
+#include "haptic_render.h"
+#include "haptic_filter.h"
+#include "haptic_predict.h"
+#include "haptic_saliency.h"
+
+// Variables
+static int32_t render_cells[HAPTIC_CELL_NUM];	// Last frame, filtered, Q15
+static volatile uint8_t render_animated = 0;	// Read by the render tick
+
+// Private functions
+
+/*
+ *
+ * @brief 	Q15 value of a grid value. The PWM is at full duty from 1 up
+ * @param 	float grid value
+ * @retval	int32_t 0 to HAPTIC_Q15_ONE, 0 for negative or invalid values
+ *
+ */
+static int32_t Haptic_ToQ15(float value)
+{
+	if (!(value > 0.0f)) {
+		return 0;
+	}
+	if (value >= 1.0f) {
+		return HAPTIC_Q15_ONE;
+	}
+
+	return (int32_t)((value * HAPTIC_Q15_ONE) + 0.5f);
+}
+
+/*
+ *
+ * @brief 	PWM compare value of a Q15 value
+ * @param 	int32_t value, 0 to HAPTIC_Q15_ONE
+ * @retval	uint32_t compare value
+ *
+ */
+static uint32_t Haptic_Pulse(int32_t value)
+{
+	return (((uint32_t)value * HAPTIC_PULSE_PER_UNIT) + (HAPTIC_Q15_ONE / 2)) >> 15;
+}
+
+/*
+ *
+ * @brief 	Compare values of the last frame at a given time
+ * @param 	uint32_t time, ms
+ * @param 	uint32_t* compare values
+ * @retval	none
+ *
+ */
+static void Haptic_Output(uint32_t time_ms, uint32_t *pulse)
+{
+	int32_t out[HAPTIC_CELL_NUM];
+	uint32_t i;
+
+	render_animated = Haptic_SaliencyApply(render_cells, time_ms, out);
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		pulse[i] = Haptic_Pulse(out[i]);
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Decodes a write of the grid characteristic
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	uint16_t* timestamp
+ * @param 	float* grid, HAPTIC_CELL_NUM values
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Haptic_GridDecode(const uint8_t *data, uint16_t length, uint16_t *timestamp, float *grid)
+{
+	uint32_t i, raw;
+
+	if (length < HAPTIC_GRID_LEN) {
+		return 0;
+	}
+
+	*timestamp = data[0] | (data[1] << 8);
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		raw = (uint32_t)data[2 + (i * 4)] | ((uint32_t)data[3 + (i * 4)] << 8) |
+			  ((uint32_t)data[4 + (i * 4)] << 16) | ((uint32_t)data[5 + (i * 4)] << 24);
+		memcpy(&grid[i], &raw, sizeof(float));
+	}
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Latency the phone measured for a grid, if the write carries it
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	uint16_t* latency, ms
+ * @retval	uint8_t 1 if the write carries it
+ *
+ */
+uint8_t Haptic_GridLatency(const uint8_t *data, uint16_t length, uint16_t *latency_ms)
+{
+	if (length < HAPTIC_GRID_LATENCY_LEN) {
+		return 0;
+	}
+
+	*latency_ms = data[HAPTIC_GRID_LEN] | (data[HAPTIC_GRID_LEN + 1] << 8);
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Renders a new grid into the PWM compare values
+ * @param 	const float* grid, HAPTIC_CELL_NUM values
+ * @param 	uint32_t time the grid came, ms
+ * @param 	uint32_t* compare values
+ * @retval	none
+ *
+ */
+void Haptic_Render(const float *grid, uint32_t time_ms, uint32_t *pulse)
+{
+	uint32_t i;
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		render_cells[i] = Haptic_ToQ15(grid[i]);
+	}
+
+	Haptic_FilterApply(render_cells, time_ms);
+	Haptic_PredictApply(render_cells, time_ms);
+	Haptic_SaliencyFrame(render_cells, time_ms);
+
+	Haptic_Output(time_ms, pulse);
+}
+
+/*
+ *
+ * @brief 	Renders the last grid again at a later time
+ * @param 	uint32_t time, ms
+ * @param 	uint32_t* compare values
+ * @retval	uint8_t 1 while the output still changes with the time
+ *
+ */
+uint8_t Haptic_Refresh(uint32_t time_ms, uint32_t *pulse)
+{
+	Haptic_Output(time_ms, pulse);
+
+	return render_animated;
+}
+
+/*
+ *
+ * @brief 	Tells whether the output changes with the time alone
+ * @param 	none
+ * @retval	uint8_t 1 if so
+ *
+ */
+uint8_t Haptic_IsAnimated(void)
+{
+	return render_animated;
+}
+
+/*
+ *
+ * @brief 	Forgets the past frames
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_RenderReset(void)
+{
+	uint32_t i;
+
+	Haptic_FilterReset();
+	Haptic_PredictReset();
+	Haptic_SaliencyReset();
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		render_cells[i] = 0;
+	}
+	render_animated = 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * haptic_render.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_HAPTIC_RENDER_H_
+#define SRC_HAPTICGLOVEWRITE_HAPTIC_RENDER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+#define HAPTIC_CELL_NUM			4U		// Cells of the grid, one motor each
+#define HAPTIC_PULSE_PER_UNIT	24U		// PWM compare value per unit of the grid values
+#define HAPTIC_GRID_LEN			(2U + (HAPTIC_CELL_NUM * 4U))	// Timestamp, then the cells as floats
+#define HAPTIC_GRID_LATENCY_LEN	(HAPTIC_GRID_LEN + 2U)			// Then, optionally, the latency of the frame
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Decodes a write of the grid characteristic: a 16 bit timestamp,
+ * 			then HAPTIC_CELL_NUM floats, little endian
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	uint16_t* timestamp
+ * @param 	float* grid, HAPTIC_CELL_NUM values
+ * @retval	uint8_t 1 if the value was long enough
+ *
+ */
+uint8_t Haptic_GridDecode(const uint8_t *data, uint16_t length, uint16_t *timestamp, float *grid);
+
+/*
+ *
+ * @brief 	Latency the phone measured for a grid, from the capture of the
+ * 			camera frame to the write, if the write carries it: 16 bits, ms,
+ * 			little endian, after the cells
+ * @param 	const uint8_t* characteristic value
+ * @param 	uint16_t length of the value
+ * @param 	uint16_t* latency, ms
+ * @retval	uint8_t 1 if the write carries it
+ *
+ */
+uint8_t Haptic_GridLatency(const uint8_t *data, uint16_t length, uint16_t *latency_ms);
+
+/*
+ *
+ * @brief 	Renders a new grid: to Q15, through the temporal filter, the
+ * 			latency prediction and the saliency weighting, then to the PWM compare values of the motors
+ * @param 	const float* grid, HAPTIC_CELL_NUM values
+ * @param 	uint32_t time the grid came, ms
+ * @param 	uint32_t* compare values, HAPTIC_CELL_NUM of them
+ * @retval	none
+ *
+ */
+void Haptic_Render(const float *grid, uint32_t time_ms, uint32_t *pulse);
+
+/*
+ *
+ * @brief 	Renders the last grid again at a later time, for the pulsing of
+ * 			the emphasized cell between frames
+ * @param 	uint32_t time, ms
+ * @param 	uint32_t* compare values, HAPTIC_CELL_NUM of them
+ * @retval	uint8_t 1 while the output still changes with the time
+ *
+ */
+uint8_t Haptic_Refresh(uint32_t time_ms, uint32_t *pulse);
+
+/*
+ *
+ * @brief 	Tells whether the output of the last render changes with the time
+ * 			alone, so it must be refreshed until the next grid
+ * @param 	none
+ * @retval	uint8_t 1 if so
+ *
+ */
+uint8_t Haptic_IsAnimated(void);
+
+/*
+ *
+ * @brief 	Forgets the past frames in every stage: the next grid is rendered
+ * 			as if it were the first
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_RenderReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAPTICGLOVEWRITE_HAPTIC_RENDER_H_ */
@@ -0,0 +1,204 @@
+/*
+ * haptic_saliency.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Saliency of the cells, after the temporal filter: what matters is the
+// nearest obstacle and the one coming closest fastest, not the background.
+// Each cell gets a threat, its value plus how much it would gain over the
+// next HAPTIC_SALIENCY_HORIZON_MS at its rate of approach, the rate taken
+// over the last HAPTIC_SALIENCY_HISTORY frames. The gain of a cell goes from
+// HAPTIC_SALIENCY_BACKGROUND for a far, still one up to 1 with its threat,
+// and the cell of the highest threat, past HAPTIC_SALIENCY_THRESHOLD, is
+// boosted and pulses, so it stands out even when the frames come slowly.
+// Fixed work per frame: HAPTIC_CELL_NUM cells, one division per frame.
+
+// Includes
+#include "haptic_saliency.h"
+#include "haptic_filter.h"
+#include "haptic_render.h"
+
+// Variables
+static int32_t saliency_values[HAPTIC_SALIENCY_HISTORY][HAPTIC_CELL_NUM];	// Past frames, Q15
+static uint32_t saliency_times[HAPTIC_SALIENCY_HISTORY];
+static uint32_t saliency_head = 0;		// Slot of the next frame
+static uint32_t saliency_count = 0;		// Frames in the history
+
+static int32_t saliency_threat[HAPTIC_CELL_NUM];	// Q15, 0 to HAPTIC_Q15_ONE
+static int32_t saliency_gain[HAPTIC_CELL_NUM];		// Q15
+static int32_t saliency_focus = -1;					// Emphasized cell
+static uint32_t saliency_focus_ms;					// When it was taken, for the phase of the pulsing
+static uint32_t saliency_frame_ms;
+
+static uint8_t saliency_enabled = 1;
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Turns the saliency stage on or off
+ * @param 	uint8_t 1 to turn it on
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyEnable(uint8_t enable)
+{
+	saliency_enabled = enable ? 1 : 0;
+	Haptic_SaliencyReset();
+}
+
+/*
+ *
+ * @brief 	Forgets the past frames and the emphasized cell
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyReset(void)
+{
+	uint32_t i;
+
+	saliency_head = 0;
+	saliency_count = 0;
+	saliency_focus = -1;
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		saliency_threat[i] = 0;
+		saliency_gain[i] = HAPTIC_Q15_ONE;
+	}
+}
+
+/*
+ *
+ * @brief 	Takes a new frame
+ * @param 	const int32_t* cells, HAPTIC_CELL_NUM values in Q15
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyFrame(const int32_t *cells, uint32_t time_ms)
+{
+	uint32_t oldest, dt, rate = 0, i;
+	int32_t approach, threat, best;
+
+	if (!saliency_enabled) {
+		return;
+	}
+
+	// The rate of approach over a gap would mean nothing
+	if ((saliency_count > 0) && ((time_ms - saliency_frame_ms) > HAPTIC_FILTER_GAP_MS)) {
+		Haptic_SaliencyReset();
+	}
+
+	oldest = (saliency_head + HAPTIC_SALIENCY_HISTORY - saliency_count) % HAPTIC_SALIENCY_HISTORY;
+	if (saliency_count > 0) {
+		dt = time_ms - saliency_times[oldest];
+		rate = (HAPTIC_SALIENCY_HORIZON_MS << 16) / ((dt == 0) ? 1U : dt);	// Horizon over the span, Q16
+	}
+
+	best = 0;
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		approach = 0;
+		if (saliency_count > 0) {
+			approach = (int32_t)(((int64_t)(cells[i] - saliency_values[oldest][i]) * rate) >> 16);
+		}
+
+		// Only coming closer counts, and no further than touching
+		threat = cells[i] + ((approach > 0) ? approach : 0);
+		if (threat > HAPTIC_Q15_ONE) {
+			threat = HAPTIC_Q15_ONE;
+		}
+
+		saliency_threat[i] = threat;
+		saliency_gain[i] = HAPTIC_SALIENCY_BACKGROUND +
+						   (((HAPTIC_Q15_ONE - HAPTIC_SALIENCY_BACKGROUND) * threat) >> 15);
+
+		if (threat > saliency_threat[best]) {
+			best = (int32_t)i;
+		}
+
+		saliency_values[saliency_head][i] = cells[i];
+	}
+
+	saliency_times[saliency_head] = time_ms;
+	saliency_head = (saliency_head + 1U) % HAPTIC_SALIENCY_HISTORY;
+	if (saliency_count < HAPTIC_SALIENCY_HISTORY) {
+		saliency_count++;
+	}
+	saliency_frame_ms = time_ms;
+
+	// The emphasis moves only for a clearly worse cell, not back and forth on noise
+	if ((saliency_focus >= 0) &&
+		((saliency_threat[saliency_focus] + HAPTIC_SALIENCY_HYSTERESIS) >= saliency_threat[best])) {
+		best = saliency_focus;
+	}
+
+	if (saliency_threat[best] < HAPTIC_SALIENCY_THRESHOLD) {
+		saliency_focus = -1;
+	} else if (best != saliency_focus) {
+		saliency_focus = best;
+		saliency_focus_ms = time_ms;
+	}
+}
+
+/*
+ *
+ * @brief 	Weights the cells of the last frame for the motors at a given time
+ * @param 	const int32_t* cells of the last frame, Q15
+ * @param 	uint32_t time, ms
+ * @param 	int32_t* weighted cells, Q15
+ * @retval	uint8_t 1 while pulsing
+ *
+ */
+uint8_t Haptic_SaliencyApply(const int32_t *cells, uint32_t time_ms, int32_t *out)
+{
+	uint32_t i;
+	int32_t value;
+
+	if (!saliency_enabled) {
+		for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+			out[i] = cells[i];
+		}
+		return 0;
+	}
+
+	for (i = 0; i < HAPTIC_CELL_NUM; i++) {
+		out[i] = (cells[i] * saliency_gain[i]) >> 15;
+	}
+
+	if (saliency_focus < 0) {
+		return 0;
+	}
+
+	value = (cells[saliency_focus] * HAPTIC_SALIENCY_BOOST) >> 8;
+	if (value > HAPTIC_Q15_ONE) {
+		value = HAPTIC_Q15_ONE;
+	}
+
+	// No more frames: the boost stays, the pulsing stops so the render tick can
+	if ((time_ms - saliency_frame_ms) > HAPTIC_SALIENCY_HOLD_MS) {
+		out[saliency_focus] = value;
+		return 0;
+	}
+
+	if (((time_ms - saliency_focus_ms) % HAPTIC_SALIENCY_PULSE_MS) >= (HAPTIC_SALIENCY_PULSE_MS / 2U)) {
+		value = (value * (HAPTIC_Q15_ONE - HAPTIC_SALIENCY_PULSE_DEPTH)) >> 15;
+	}
+	out[saliency_focus] = value;
+
+	return 1;
+}
+
+/*
+ *
+ * @brief 	Cell emphasized after the last frame
+ * @param 	none
+ * @retval	int32_t cell, -1 for none
+ *
+ */
+int32_t Haptic_SaliencyFocus(void)
+{
+	return saliency_focus;
+}
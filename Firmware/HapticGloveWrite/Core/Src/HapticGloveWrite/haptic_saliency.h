@@ -0,0 +1,85 @@
+/*
+ * haptic_saliency.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_HAPTIC_SALIENCY_H_
+#define SRC_HAPTICGLOVEWRITE_HAPTIC_SALIENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+#define HAPTIC_SALIENCY_HISTORY		4U		// Frames the rate of approach is taken over
+#define HAPTIC_SALIENCY_HORIZON_MS	500U	// How far ahead the approach counts: threat is the value then
+#define HAPTIC_SALIENCY_BACKGROUND	19661	// Gain of a far, still cell, Q15 (0.6)
+#define HAPTIC_SALIENCY_THRESHOLD	16384	// Threat from which the worst cell is emphasized, Q15 (0.5)
+#define HAPTIC_SALIENCY_HYSTERESIS	1638	// Threat another cell needs over the emphasized one to take over, Q15
+#define HAPTIC_SALIENCY_BOOST		320		// Gain of the emphasized cell, Q8 (1.25)
+#define HAPTIC_SALIENCY_PULSE_MS	250U	// Period of the pulsing of the emphasized cell
+#define HAPTIC_SALIENCY_PULSE_DEPTH	16384	// Cut of the off half of the pulsing, Q15 (0.5)
+#define HAPTIC_SALIENCY_HOLD_MS		1000U	// Longer without a frame and the pulsing stops
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Turns the saliency stage on or off. Off, the cells go through as they are
+ * @param 	uint8_t 1 to turn it on
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyEnable(uint8_t enable);
+
+/*
+ *
+ * @brief 	Forgets the past frames and the emphasized cell
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyReset(void);
+
+/*
+ *
+ * @brief 	Takes a new frame: rate of approach, weight of each cell and the
+ * 			cell to emphasize
+ * @param 	const int32_t* cells, HAPTIC_CELL_NUM values in Q15, 0 to HAPTIC_Q15_ONE
+ * @param 	uint32_t time of the frame, ms
+ * @retval	none
+ *
+ */
+void Haptic_SaliencyFrame(const int32_t *cells, uint32_t time_ms);
+
+/*
+ *
+ * @brief 	Weights the cells of the last frame for the motors at a given time,
+ * 			the emphasized cell boosted and pulsing
+ * @param 	const int32_t* cells of the last frame, Q15
+ * @param 	uint32_t time, ms
+ * @param 	int32_t* weighted cells, Q15, 0 to HAPTIC_Q15_ONE
+ * @retval	uint8_t 1 while the output changes with the time alone (pulsing)
+ *
+ */
+uint8_t Haptic_SaliencyApply(const int32_t *cells, uint32_t time_ms, int32_t *out);
+
+/*
+ *
+ * @brief 	Cell emphasized after the last frame
+ * @param 	none
+ * @retval	int32_t cell, -1 for none
+ *
+ */
+int32_t Haptic_SaliencyFocus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAPTICGLOVEWRITE_HAPTIC_SALIENCY_H_ */
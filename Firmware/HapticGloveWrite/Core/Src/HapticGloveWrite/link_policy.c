@@ -0,0 +1,294 @@
+/*
+ * link_policy.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Connection parameters. The central picks them at connection and would keep
+// them; the glove asks for the ones it needs with an L2CAP connection parameter
+// update request. While the grid changes, a short interval with no slave
+// latency keeps the frames close to the hand. Once the frames stop, or keep
+// repeating the same grid, a long interval with slave latency lets the radio
+// sleep through most connection events. Only one request is outstanding at a
+// time: a mode change made while it is pending is sent on its answer.
+
+// Includes
+#include <string.h>
+#include "link_policy.h"
+#include "motor_control.h"
+#include "timer_wheel.h"
+#include "bluenrg1_aci.h"
+#include "hci_tl.h"
+
+// Private defines
+#define LINK_REQ_NONE		0xFFU	// No request outstanding
+
+// Variables
+static Timer_t idle_timer;
+static Timer_t retry_timer;
+static LinkPolicy_Params_t link_params;
+static uint16_t link_handle;
+static uint8_t link_active = 0;				// Link ready, policy running
+static uint8_t link_pending = LINK_REQ_NONE;	// Mode of the outstanding request
+static uint8_t link_applied = LINK_REQ_NONE;	// Mode last accepted by the central
+static float last_grid[MOTOR_NUM];
+
+// Parameters requested in each mode
+static const struct {
+	uint16_t interval_min;
+	uint16_t interval_max;
+	uint16_t latency;
+} link_modes[LINK_POLICY_NUM] = {
+	[LINK_POLICY_STREAMING] = {L2CAP_INTERV_MIN, L2CAP_INTERV_MAX, 0},
+	[LINK_POLICY_IDLE] = {LINK_IDLE_INTERV_MIN, LINK_IDLE_INTERV_MAX, LINK_IDLE_LATENCY},
+};
+
+// Private functions
+
+/*
+ *
+ * @brief 	Completion of the update request command: a request the controller
+ * 			refused gets no answer from the central
+ * @param 	See hci_cmd_cplt_cb_t in hci_tl.h
+ * @retval	none
+ *
+ */
+static void LinkPolicy_Req_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	if (status != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("aci_l2cap_connection_parameter_update_req failed: 0x%02x\r\n", status);
+		LinkPolicy_Response(0);
+	}
+}
+
+/*
+ *
+ * @brief 	Asks the central for the parameters of the wanted mode, unless they
+ * 			are in use or a request is outstanding
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void LinkPolicy_Request(void)
+{
+	LinkPolicy_Mode_t mode = link_params.mode;
+	tBleStatus ret;
+
+	if (!link_active || (link_pending != LINK_REQ_NONE) || (link_applied == mode)) {
+		return;
+	}
+
+	link_pending = mode;
+	link_params.requests++;
+
+	hci_set_next_req_async(LinkPolicy_Req_CB, NULL);
+	ret = aci_l2cap_connection_parameter_update_req(link_handle,
+													link_modes[mode].interval_min,
+													link_modes[mode].interval_max,
+													link_modes[mode].latency,
+													L2CAP_TIMEOUT_MULTIPLIER);
+	if (ret != BLE_STATUS_SUCCESS) {
+		LinkPolicy_Req_CB(0, ret, NULL, 0, NULL);
+	}
+}
+
+/*
+ *
+ * @brief 	Changes the wanted mode
+ * @param 	LinkPolicy_Mode_t mode
+ * @retval	none
+ *
+ */
+static void LinkPolicy_SetMode(LinkPolicy_Mode_t mode)
+{
+	if (link_params.mode != mode) {
+		link_params.mode = mode;
+		Timer_Stop(&retry_timer);
+	}
+
+	LinkPolicy_Request();
+}
+
+/*
+ *
+ * @brief 	No changing frame for LINK_IDLE_AFTER_MS
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Idle_Timer_CB(void *ctx)
+{
+	LinkPolicy_SetMode(LINK_POLICY_IDLE);
+}
+
+/*
+ *
+ * @brief 	Asks again for parameters the central refused
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Retry_Timer_CB(void *ctx)
+{
+	LinkPolicy_Request();
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Creates the idle and retry timers
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Init(void)
+{
+	Timer_Create(&idle_timer, Idle_Timer_CB, NULL);
+	Timer_Create(&retry_timer, Retry_Timer_CB, NULL);
+}
+
+/*
+ *
+ * @brief 	Records the parameters of a new connection
+ * @param 	uint16_t connection handle
+ * @param 	uint16_t interval, latency and timeout chosen by the central
+ * @retval	none
+ *
+ */
+void LinkPolicy_Connected(uint16_t handle, uint16_t interval, uint16_t latency, uint16_t timeout)
+{
+	link_handle = handle;
+	link_params.interval = interval;
+	link_params.latency = latency;
+	link_params.timeout = timeout;
+	link_params.mode = LINK_POLICY_STREAMING;
+	link_active = 0;
+	link_pending = LINK_REQ_NONE;
+	link_applied = LINK_REQ_NONE;
+	memset(last_grid, 0, sizeof(last_grid));
+}
+
+/*
+ *
+ * @brief 	Starts the policy once the link is encrypted
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Ready(void)
+{
+	if (link_active) {
+		return;
+	}
+
+	link_active = 1;
+	LinkPolicy_SetMode(LINK_POLICY_STREAMING);
+	Timer_Start(&idle_timer, LINK_IDLE_AFTER_MS, 0);
+}
+
+/*
+ *
+ * @brief 	Stops the policy
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Disconnected(void)
+{
+	link_active = 0;
+	link_pending = LINK_REQ_NONE;
+	Timer_Stop(&idle_timer);
+	Timer_Stop(&retry_timer);
+}
+
+/*
+ *
+ * @brief 	A haptic frame has been received
+ * @param 	const float* grid values, MOTOR_NUM of them
+ * @retval	none
+ *
+ */
+void LinkPolicy_Frame(const float *grid)
+{
+	if (!link_active) {
+		return;
+	}
+
+	// The same grid again: nothing moves, the idle timer keeps running
+	if (memcmp(grid, last_grid, sizeof(last_grid)) == 0) {
+		return;
+	}
+
+	memcpy(last_grid, grid, sizeof(last_grid));
+	Timer_Start(&idle_timer, LINK_IDLE_AFTER_MS, 0);
+	LinkPolicy_SetMode(LINK_POLICY_STREAMING);
+}
+
+/*
+ *
+ * @brief 	The central changed the connection parameters
+ * @param 	uint8_t status of the update
+ * @param 	uint16_t interval, latency and timeout now in use
+ * @retval	none
+ *
+ */
+void LinkPolicy_Updated(uint8_t status, uint16_t interval, uint16_t latency, uint16_t timeout)
+{
+	if (status != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("Connection update failed: 0x%02x\r\n", status);
+		return;
+	}
+
+	link_params.interval = interval;
+	link_params.latency = latency;
+	link_params.timeout = timeout;
+	link_params.updates++;
+
+	PRINT_DBG("Connection interval %u, latency %u, timeout %u\r\n", interval, latency, timeout);
+}
+
+/*
+ *
+ * @brief 	The central answered the outstanding request
+ * @param 	uint8_t 1 if the request was accepted
+ * @retval	none
+ *
+ */
+void LinkPolicy_Response(uint8_t accepted)
+{
+	uint8_t mode = link_pending;
+
+	if (mode == LINK_REQ_NONE) {
+		return;
+	}
+	link_pending = LINK_REQ_NONE;
+
+	if (accepted) {
+		link_applied = mode;
+	} else {
+		link_params.rejected++;
+
+		// Not asked again before LINK_RETRY_MS, unless the mode changes
+		if (mode == link_params.mode) {
+			Timer_Start(&retry_timer, LINK_RETRY_MS, 0);
+			return;
+		}
+	}
+
+	// The mode changed while the request was outstanding
+	LinkPolicy_Request();
+}
+
+/*
+ *
+ * @brief 	Copies the current parameters and the policy figures
+ * @param 	LinkPolicy_Params_t* filled with the parameters
+ * @retval	none
+ *
+ */
+void LinkPolicy_GetParams(LinkPolicy_Params_t *params)
+{
+	*params = link_params;
+}
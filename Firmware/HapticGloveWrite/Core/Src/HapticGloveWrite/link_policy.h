@@ -0,0 +1,124 @@
+/*
+ * link_policy.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_LINK_POLICY_H_
+#define SRC_HAPTICGLOVEWRITE_LINK_POLICY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define LINK_IDLE_INTERV_MIN		80U		// 100 ms, in units of 1.25 ms
+#define LINK_IDLE_INTERV_MAX		120U	// 150 ms
+#define LINK_IDLE_LATENCY			4U		// Connection events the glove may skip
+#define LINK_IDLE_AFTER_MS			1000U	// Time without a changing frame before the idle parameters
+#define LINK_RETRY_MS				5000U	// Delay before asking again for parameters the central refused
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+	LINK_POLICY_STREAMING = 0,	// L2CAP_INTERV_MIN/MAX, no slave latency
+	LINK_POLICY_IDLE,			// LINK_IDLE_INTERV_MIN/MAX, LINK_IDLE_LATENCY
+	LINK_POLICY_NUM
+} LinkPolicy_Mode_t;
+
+typedef struct {
+	uint16_t interval;		// Connection interval in use, units of 1.25 ms
+	uint16_t latency;		// Slave latency in use
+	uint16_t timeout;		// Supervision timeout in use, units of 10 ms
+	LinkPolicy_Mode_t mode;	// Parameters the policy wants
+	uint32_t requests;		// Update requests sent to the central
+	uint32_t rejected;		// Of them, refused or unanswered
+	uint32_t updates;		// Parameter changes made by the central
+} LinkPolicy_Params_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Creates the idle and retry timers
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Init(void);
+
+/*
+ *
+ * @brief 	A connection is established with the parameters of the central.
+ * 			Nothing is requested until the link is ready
+ * @param 	uint16_t connection handle
+ * @param 	uint16_t connection interval, units of 1.25 ms
+ * @param 	uint16_t slave latency
+ * @param 	uint16_t supervision timeout, units of 10 ms
+ * @retval	none
+ *
+ */
+void LinkPolicy_Connected(uint16_t handle, uint16_t interval, uint16_t latency, uint16_t timeout);
+
+/*
+ *
+ * @brief 	The link is encrypted: the policy starts, in the streaming mode
+ * 			until LINK_IDLE_AFTER_MS without a changing frame
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Ready(void);
+
+/*
+ *
+ * @brief 	The connection is lost: stops the policy
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LinkPolicy_Disconnected(void);
+
+/*
+ *
+ * @brief 	A haptic frame has been received. A frame equal to the previous one
+ * 			does not count as streaming
+ * @param 	const float* grid values, MOTOR_NUM of them
+ * @retval	none
+ *
+ */
+void LinkPolicy_Frame(const float *grid);
+
+/*
+ *
+ * @brief 	The central changed the connection parameters
+ * 			(hci_le_connection_update_complete_event)
+ * @param 	uint8_t status of the update
+ * @param 	uint16_t connection interval, units of 1.25 ms
+ * @param 	uint16_t slave latency
+ * @param 	uint16_t supervision timeout, units of 10 ms
+ * @retval	none
+ *
+ */
+void LinkPolicy_Updated(uint8_t status, uint16_t interval, uint16_t latency, uint16_t timeout);
+
+/*
+ *
+ * @brief 	The central answered an update request
+ * 			(aci_l2cap_connection_update_resp_event), or never did
+ * 			(aci_l2cap_proc_timeout_event)
+ * @param 	uint8_t 1 if the request was accepted
+ * @retval	none
+ *
+ */
+void LinkPolicy_Response(uint8_t accepted);
+
+/*
+ *
+ * @brief 	Copies the current parameters and the policy figures
+ * @param 	LinkPolicy_Params_t* filled with the parameters
+ * @retval	none
+ *
+ */
+void LinkPolicy_GetParams(LinkPolicy_Params_t *params);
+
+#endif /* SRC_HAPTICGLOVEWRITE_LINK_POLICY_H_ */
@@ -0,0 +1,296 @@
+/*
+ * low_power.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Tickless idle. When the scheduler has nothing to run, the SysTick is
+// stopped and LPTIM1, clocked by the LSI, is set to wake the core up at the
+// next software timer deadline. The core waits in Stop 2 when nothing needs
+// the clocks (radio bus idle, motors off), in Sleep otherwise; the BlueNRG-2
+// IRQ line (EXTI3), LPTIM1 and the render tick end the wait. The time spent
+// is then read back from LPTIM1 and added to the HAL tick and to the timers.
+//
+// The BlueNRG-2 reports the end of each radio activity with the time of the
+// next one. Stop 2 is skipped right before a radio event, which the MCU
+// would have to leave again at once to read the packets it brings.
+
+// Includes
+#include "low_power.h"
+#include "timer_wheel.h"
+#include "motor_control.h"
+#include "clock_profile.h"
+#include "hci_tl_interface.h"
+
+// Private defines
+#define LPTIM_PERIOD			0x10000U	// 16-bit counter
+#define RADIO_SYSTIME_NUM		625U		// BlueNRG-2 system time unit: 625/256 us
+#define RADIO_SYSTIME_DEN		256U
+#define RADIO_MAX_STEP_US		4000000U	// Longest connection interval
+
+_Static_assert(((LOWPOWER_MAX_IDLE_MS * LSI_VALUE) / 1000U) < LPTIM_PERIOD, "LOWPOWER_MAX_IDLE_MS exceeds the LPTIM1 counter");
+
+// Variables
+static LowPower_Stats_t lowpower_stats;
+static uint32_t lowpower_frac;		// LSI cycles * 1000 not yet accounted as a whole ms
+
+static struct {
+	uint32_t prev_systime;	// Time of the radio event that just ended, BlueNRG-2 clock
+	uint32_t next_tick;		// HAL tick of the next one
+	uint8_t have_prev;
+	uint8_t valid;
+} lowpower_radio;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Reads the LPTIM1 counter, which runs on its own clock: two equal
+ * 			reads in a row are needed
+ * @param 	none
+ * @retval	uint32_t counter value
+ *
+ */
+static uint32_t LowPower_Counter(void)
+{
+	uint32_t cnt;
+
+	do {
+		cnt = LPTIM1->CNT;
+	} while (cnt != LPTIM1->CNT);
+
+	return cnt;
+}
+
+/*
+ *
+ * @brief 	Sets the LPTIM1 compare, hence the wake-up, a number of ms ahead
+ * @param 	uint32_t counter value now
+ * @param 	uint32_t delay in ms, at most LOWPOWER_MAX_IDLE_MS
+ * @retval	none
+ *
+ */
+static void LowPower_SetAlarm(uint32_t now, uint32_t ms)
+{
+	LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+	LPTIM1->CMP = (now + ((ms * LSI_VALUE) / 1000U)) & (LPTIM_PERIOD - 1U);
+	while ((LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0) {
+	}
+
+	LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+	NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+	NVIC_EnableIRQ(LPTIM1_IRQn);
+}
+
+/*
+ *
+ * @brief 	Adds the time spent idle to the HAL tick and the timers
+ * @param 	uint32_t LPTIM1 cycles elapsed
+ * @retval	uint32_t whole ms added
+ *
+ */
+static uint32_t LowPower_Compensate(uint32_t cycles)
+{
+	uint32_t ms;
+
+	lowpower_frac += cycles * 1000U;
+	ms = lowpower_frac / LSI_VALUE;
+	lowpower_frac -= ms * LSI_VALUE;
+
+	if (ms != 0) {
+		uwTick += ms;
+		Timer_Advance(ms);
+	}
+
+	return ms;
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Starts LPTIM1 on the LSI
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_Init(void)
+{
+	// LSI, which keeps running in Stop 2
+	RCC->CSR |= RCC_CSR_LSION;
+	while ((RCC->CSR & RCC_CSR_LSIRDY) == 0) {
+	}
+
+	MODIFY_REG(RCC->CCIPR, RCC_CCIPR_LPTIM1SEL, RCC_CCIPR_LPTIM1SEL_0);
+	__HAL_RCC_LPTIM1_CLK_ENABLE();
+
+	// Free running over the 16 bits, no prescaler. CFGR and IER are only
+	// written while the timer is disabled, ARR and CMP while it is enabled
+	LPTIM1->CR = 0;
+	LPTIM1->CFGR = 0;
+	LPTIM1->IER = LPTIM_IER_CMPMIE;
+	LPTIM1->CR = LPTIM_CR_ENABLE;
+	LPTIM1->ARR = LPTIM_PERIOD - 1U;
+	while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0) {
+	}
+	LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+	LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+	// Wake-up from Stop 2 on the compare match (EXTI line 32); the
+	// interrupt is only enabled in the NVIC while idle
+	EXTI->IMR2 |= EXTI_IMR2_IM32;
+	HAL_NVIC_SetPriority(LPTIM1_IRQn, IRQ_PRIO_SYSTICK, 0);
+
+#ifdef DEBUG
+	// Keep the debugger connected in Stop 2
+	HAL_DBGMCU_EnableDBGStopMode();
+#endif
+}
+
+/*
+ *
+ * @brief 	Idles the core until the next interrupt, tickless when possible
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_Idle(void)
+{
+	uint8_t mode = hci_tl_lowlevel_idle_mode();
+	uint32_t idle_ms = Timer_GetIdleTime();
+	uint32_t radio_ms;
+	uint32_t start;
+	uint32_t ms;
+	uint8_t stop2;
+
+	// A transfer in progress or a deadline too close: plain Sleep, with the tick
+	if ((mode == HCI_TL_IDLE_BUSY) || (idle_ms < LOWPOWER_MIN_TICKLESS_MS)) {
+		__DSB();
+		__WFI();
+		return;
+	}
+
+	if (idle_ms > LOWPOWER_MAX_IDLE_MS) {
+		idle_ms = LOWPOWER_MAX_IDLE_MS;
+	}
+
+	// The PWM and the render tick need their timers clocked
+	stop2 = (mode == HCI_TL_IDLE_STOP) && Motor_IsIdle();
+	if (LowPower_GetRadioNext(&radio_ms) && (radio_ms < LOWPOWER_RADIO_GUARD_MS)) {
+		stop2 = 0;
+	}
+#if (HCI_CAPTURE_ENABLED == 1)
+	// LPUART1 streams the capture by DMA
+	stop2 = 0;
+#endif
+
+	start = LowPower_Counter();
+	LowPower_SetAlarm(start, idle_ms);
+	HAL_SuspendTick();
+
+	if (stop2) {
+		HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+
+		// Woken up on the MSI: bring back the PLL of a boost
+		Clock_Resume();
+	} else {
+		__DSB();
+		__WFI();
+	}
+
+	NVIC_DisableIRQ(LPTIM1_IRQn);
+	ms = LowPower_Compensate((LowPower_Counter() - start) & (LPTIM_PERIOD - 1U));
+	HAL_ResumeTick();
+
+	if (stop2) {
+		lowpower_stats.stop2_count++;
+		lowpower_stats.stop2_ms += ms;
+	} else {
+		lowpower_stats.sleep_count++;
+		lowpower_stats.sleep_ms += ms;
+	}
+}
+
+/*
+ *
+ * @brief 	Records the next radio event announced by the BlueNRG-2
+ * @note	The event comes at the end of the activity announced by the
+ * 			previous one, so the next activity is the difference of the two
+ * 			announced times away
+ * @param 	uint8_t Next_State, 0 for none
+ * @param 	uint32_t Next_State_SysTime, in units of 625/256 us
+ * @retval	none
+ *
+ */
+void LowPower_RadioActivity(uint8_t next_state, uint32_t next_systime)
+{
+	lowpower_stats.radio_events++;
+
+	if (next_state == 0) {
+		lowpower_radio.have_prev = 0;
+		lowpower_radio.valid = 0;
+		return;
+	}
+
+	if (lowpower_radio.have_prev) {
+		uint32_t step_us = (uint32_t)(((uint64_t)(next_systime - lowpower_radio.prev_systime) * RADIO_SYSTIME_NUM) / RADIO_SYSTIME_DEN);
+
+		lowpower_radio.valid = (step_us <= RADIO_MAX_STEP_US);
+		lowpower_radio.next_tick = HAL_GetTick() + (step_us / 1000U);
+	}
+
+	lowpower_radio.prev_systime = next_systime;
+	lowpower_radio.have_prev = 1;
+}
+
+/*
+ *
+ * @brief 	Time left to the predicted next radio event
+ * @param 	uint32_t* filled with the time in ms
+ * @retval	uint8_t 1 if a radio event is predicted, 0 otherwise
+ *
+ */
+uint8_t LowPower_GetRadioNext(uint32_t *ms)
+{
+	int32_t left;
+
+	if (!lowpower_radio.valid) {
+		return 0;
+	}
+
+	left = (int32_t)(lowpower_radio.next_tick - HAL_GetTick());
+	if (left < 0) {
+		// Missed or not reported: no prediction until the next report
+		return 0;
+	}
+
+	*ms = (uint32_t)left;
+	return 1;
+}
+
+/*
+ *
+ * @brief 	LPTIM1 interrupt: only wakes the core up
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_LptimIsr(void)
+{
+	LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+}
+
+/*
+ *
+ * @brief 	Copies the low-power figures
+ * @param 	LowPower_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void LowPower_GetStats(LowPower_Stats_t *stats)
+{
+	__disable_irq();
+	*stats = lowpower_stats;
+	__enable_irq();
+}
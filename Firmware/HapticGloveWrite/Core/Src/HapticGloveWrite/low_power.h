@@ -0,0 +1,92 @@
+/*
+ * low_power.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_LOW_POWER_H_
+#define SRC_HAPTICGLOVEWRITE_LOW_POWER_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define LOWPOWER_MIN_TICKLESS_MS	2U		// Shorter idle times keep the SysTick
+#define LOWPOWER_MAX_IDLE_MS		2000U	// Longest LPTIM1 alarm, below its 16-bit wrap
+#define LOWPOWER_RADIO_GUARD_MS		2U		// No Stop 2 this close to the next radio event
+
+// Radio activities reported by aci_hal_end_of_radio_activity_event
+#define LOWPOWER_RADIO_ACTIVITY_MASK	0x0006U	// Advertising, connection event slave
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+	uint32_t stop2_count;	// Idle periods spent in Stop 2
+	uint32_t stop2_ms;		// Time spent there
+	uint32_t sleep_count;	// Tickless idle periods spent in Sleep
+	uint32_t sleep_ms;		// Time spent there
+	uint32_t radio_events;	// End of radio activity events received
+} LowPower_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Starts LPTIM1 on the LSI, the time base of the tickless idle
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_Init(void);
+
+/*
+ *
+ * @brief 	Idles the core until the next interrupt. Without the SysTick and
+ * 			in Stop 2 when nothing needs the clocks, woken up by LPTIM1 at
+ * 			the next timer deadline; the HAL tick and the software timers
+ * 			are then advanced by the time spent. Called with the interrupts
+ * 			masked, from the scheduler
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_Idle(void);
+
+/*
+ *
+ * @brief 	Records the next radio event announced by the BlueNRG-2
+ * @param 	uint8_t Next_State of aci_hal_end_of_radio_activity_event, 0 for none
+ * @param 	uint32_t Next_State_SysTime, in units of 625/256 us
+ * @retval	none
+ *
+ */
+void LowPower_RadioActivity(uint8_t next_state, uint32_t next_systime);
+
+/*
+ *
+ * @brief 	Time left to the predicted next radio event
+ * @param 	uint32_t* filled with the time in ms
+ * @retval	uint8_t 1 if a radio event is predicted, 0 otherwise
+ *
+ */
+uint8_t LowPower_GetRadioNext(uint32_t *ms);
+
+/*
+ *
+ * @brief 	LPTIM1 interrupt: only wakes the core up
+ * @param 	none
+ * @retval	none
+ *
+ */
+void LowPower_LptimIsr(void);
+
+/*
+ *
+ * @brief 	Copies the low-power figures
+ * @param 	LowPower_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void LowPower_GetStats(LowPower_Stats_t *stats);
+
+#endif /* SRC_HAPTICGLOVEWRITE_LOW_POWER_H_ */
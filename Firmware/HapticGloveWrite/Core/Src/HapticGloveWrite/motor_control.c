@@ -0,0 +1,172 @@
+/*
+ * motor_control.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Haptic rendering. The grid written over BLE is only stored here; the
+// render task applies the latest one to the motor PWM on the TIM6 tick, so
+// the motors are updated at a fixed rate whatever the timing of the writes.
+// The tick only runs while grids keep coming, or while the emphasized cell
+// pulses between them, so that it does not wake the core up when there is
+// nothing to render.
+
+// Includes
+#include "motor_control.h"
+#include "scheduler.h"
+
+// Private types
+typedef struct {
+	TIM_HandleTypeDef *tim;
+	uint32_t channel;
+} Motor_Output_t;
+
+// Variables
+TIM_HandleTypeDef htim6;
+
+static const Motor_Output_t motor_outputs[MOTOR_NUM] = {
+	{ &htim2, TIM_CHANNEL_3 },
+	{ &htim2, TIM_CHANNEL_4 },
+	{ &htim16, TIM_CHANNEL_1 },
+	{ &htim1, TIM_CHANNEL_4 },
+};
+
+// Written by the HCI task and read by the render task, which never preempt
+// each other
+static float motor_grid[MOTOR_NUM];
+static uint32_t motor_grid_tick;		// When the grid came, for the temporal filter
+static volatile uint8_t motor_grid_pending = 0;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Render task: applies the latest grid to the motors, or refreshes
+ * 			the last one while it pulses
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Motor_Render(void)
+{
+	uint32_t pulse[MOTOR_NUM];
+	uint32_t i;
+
+	if (motor_grid_pending) {
+		motor_grid_pending = 0;
+		Haptic_Render(motor_grid, motor_grid_tick, pulse);
+	} else {
+		Haptic_Refresh(HAL_GetTick(), pulse);
+	}
+
+	for (i = 0; i < MOTOR_NUM; i++) {
+		__HAL_TIM_SET_COMPARE(motor_outputs[i].tim, motor_outputs[i].channel, pulse[i]);
+	}
+}
+
+/*
+ *
+ * @brief 	Registers the render task and starts the render tick
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Motor_Init(void)
+{
+	uint32_t clock = HAL_RCC_GetPCLK1Freq();
+
+	// The APB1 timers run at twice PCLK1 when the bus clock is divided
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+		clock *= 2U;
+	}
+
+	Sched_RegTask(SCHED_TASK_RENDER, Motor_Render);
+
+	__HAL_RCC_TIM6_CLK_ENABLE();
+
+	htim6.Instance = TIM6;
+	htim6.Init.Prescaler = (clock / MOTOR_RENDER_TIMER_HZ) - 1U;
+	htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim6.Init.Period = ((MOTOR_RENDER_PERIOD_US * (MOTOR_RENDER_TIMER_HZ / 1000U)) / 1000U) - 1U;
+	htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+	if (HAL_TIM_Base_Init(&htim6) != HAL_OK) {
+		Error_Handler();
+	}
+
+	HAL_NVIC_SetPriority(TIM6_DAC_IRQn, IRQ_PRIO_HAPTIC_RENDER, 0);
+	HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+
+	// Started by the first grid
+	__HAL_TIM_ENABLE_IT(&htim6, TIM_IT_UPDATE);
+}
+
+/*
+ *
+ * @brief 	Stores a new grid, applied on the next render tick
+ * @param 	float grid values, MOTOR_NUM of them
+ * @retval	none
+ *
+ */
+void Motor_SetGrid(const float *grid)
+{
+	uint32_t i;
+
+	for (i = 0; i < MOTOR_NUM; i++) {
+		motor_grid[i] = grid[i];
+	}
+
+	motor_grid_tick = HAL_GetTick();
+	motor_grid_pending = 1;
+
+	if ((htim6.Instance->CR1 & TIM_CR1_CEN) == 0) {
+		__HAL_TIM_SET_COUNTER(&htim6, 0);
+		__HAL_TIM_ENABLE(&htim6);
+	}
+}
+
+/*
+ *
+ * @brief 	Render tick, from the TIM6 interrupt
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Motor_RenderIsr(void)
+{
+	if (__HAL_TIM_GET_FLAG(&htim6, TIM_FLAG_UPDATE) == RESET) {
+		return;
+	}
+	__HAL_TIM_CLEAR_FLAG(&htim6, TIM_FLAG_UPDATE);
+
+	if (motor_grid_pending || Haptic_IsAnimated()) {
+		Sched_SetTask(SCHED_TASK_RENDER);
+	} else {
+		// Nothing new to render for a whole period: restarted by the next grid
+		htim6.Instance->CR1 &= ~TIM_CR1_CEN;
+	}
+}
+
+/*
+ *
+ * @brief 	Tells whether the motor timers may be stopped
+ * @param 	none
+ * @retval	uint8_t 1 if idle
+ *
+ */
+uint8_t Motor_IsIdle(void)
+{
+	uint32_t i;
+
+	if (motor_grid_pending || Haptic_IsAnimated()) {
+		return 0;
+	}
+
+	for (i = 0; i < MOTOR_NUM; i++) {
+		if (__HAL_TIM_GET_COMPARE(motor_outputs[i].tim, motor_outputs[i].channel) != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
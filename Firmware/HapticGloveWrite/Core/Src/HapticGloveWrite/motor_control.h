@@ -0,0 +1,68 @@
+/*
+ * motor_control.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_MOTOR_CONTROL_H_
+#define SRC_HAPTICGLOVEWRITE_MOTOR_CONTROL_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "haptic_render.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define MOTOR_NUM					HAPTIC_CELL_NUM		// Cells of the grid, one motor each
+#define MOTOR_RENDER_PERIOD_US		5000U	// Render tick (TIM6)
+#define MOTOR_RENDER_TIMER_HZ		10000U	// TIM6 counter clock
+
+/* Exported variables --------------------------------------------------------*/
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim16;
+extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim6;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Registers the render task and starts the render tick. The PWM
+ * 			outputs must already be running
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Motor_Init(void);
+
+/*
+ *
+ * @brief 	Stores a new grid, applied to the motors on the next render tick
+ * @param 	float grid values, MOTOR_NUM of them
+ * @retval	none
+ *
+ */
+void Motor_SetGrid(const float *grid);
+
+/*
+ *
+ * @brief 	Render tick, called from the TIM6 interrupt. Requests the render
+ * 			task when a new grid is waiting or the last one pulses, stops the
+ * 			tick otherwise
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Motor_RenderIsr(void);
+
+/*
+ *
+ * @brief 	Tells whether the motor timers may be stopped: every motor off
+ * 			and nothing for the render tick to do
+ * @param 	none
+ * @retval	uint8_t 1 if idle
+ *
+ */
+uint8_t Motor_IsIdle(void);
+
+#endif /* SRC_HAPTICGLOVEWRITE_MOTOR_CONTROL_H_ */
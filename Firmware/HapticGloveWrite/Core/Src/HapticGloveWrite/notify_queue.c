@@ -0,0 +1,296 @@
+/*
+ * notify_queue.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Outbound notifications. Each notified characteristic is a channel holding
+// the latest value posted: a value that could not be sent yet is replaced by
+// the next one, so a congested link sends the newest state instead of a
+// backlog. One update command is in flight at a time, which keeps the HCI
+// command slots and the TX pool of the BlueNRG-2 for the time critical
+// channels: the channels are served in priority order, and a value of a
+// background channel split in several commands gives way between them to a
+// higher channel. When the TX pool is full the current command is sent again
+// on aci_gatt_tx_pool_available_event. A command that cannot even be queued,
+// the HCI command table being full, leaves its value waiting in the channel
+// and is tried again after NOTIFY_RETRY_MS. The updates use
+// aci_gatt_update_char_value_ext_nocopy, sent straight from the value being
+// sent; values longer than a command are written in parts, the last one
+// notified.
+
+// Includes
+#include <string.h>
+#include "notify_queue.h"
+#include "bluenrg1_aci.h"
+#include "hci_tl.h"
+#include "timer_wheel.h"
+
+// Private defines
+#define NOTIFY_UPDATE_LOCAL			0x00U	// Update_Type of aci_gatt_update_char_value_ext
+#define NOTIFY_UPDATE_NOTIFICATION	0x01U
+
+// Variables
+static struct {
+	uint16_t service_handle;
+	uint16_t char_handle;
+	uint16_t length;
+	uint8_t pending;			// Value waiting to be sent
+	uint8_t value[NOTIFY_VALUE_MAX];
+	Notify_Stats_t stats;
+} channels[NOTIFY_CH_NUM];
+
+// Value being sent
+static struct {
+	uint8_t active;
+	uint8_t queued;				// Update command waiting for its completion
+	uint8_t congested;			// TX pool full, waiting for it to have room
+	Notify_Channel_t ch;
+	uint16_t length;
+	uint16_t offset;			// Part being sent
+	uint16_t chunk;
+	uint8_t value[NOTIFY_VALUE_MAX];
+} tx;
+
+static uint16_t notify_conn_handle = 0;
+static Timer_t notify_retry_timer;
+
+// Private functions
+static void Notify_Drain(void);
+
+/*
+ *
+ * @brief 	Completion of an update command
+ * @param 	See hci_cmd_cplt_cb_t in hci_tl.h
+ * @retval	none
+ *
+ */
+static void Notify_Cplt_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	Notify_Stats_t *stats = &channels[tx.ch].stats;
+
+	tx.queued = 0;
+
+	// Dropped by a change of connection
+	if (!tx.active) {
+		Notify_Drain();
+		return;
+	}
+
+	if (status == BLE_STATUS_SUCCESS) {
+		tx.offset += tx.chunk;
+		if (tx.offset >= tx.length) {
+			stats->sent++;
+			tx.active = 0;
+		}
+	} else if (status == BLE_STATUS_INSUFFICIENT_RESOURCES) {
+		// Sent again from Notify_TxPoolAvailable()
+		stats->congested++;
+		tx.congested = 1;
+		return;
+	} else {
+		PRINT_DBG("Notification of channel %d failed: 0x%02x\r\n", tx.ch, status);
+		stats->failed++;
+		tx.active = 0;
+	}
+
+	Notify_Drain();
+}
+
+/*
+ *
+ * @brief 	Picks the value to send, highest channel first, and queues the
+ * 			command of its next part
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Notify_Drain(void)
+{
+	uint8_t update_type;
+	uint32_t ch;
+	tBleStatus ret;
+
+	if (tx.queued || tx.congested) {
+		return;
+	}
+
+	// A higher channel waits: the value being sent is sent again later
+	if (tx.active) {
+		for (ch = 0; ch < tx.ch; ch++) {
+			if (channels[ch].pending) {
+				channels[tx.ch].pending = 1;
+				tx.active = 0;
+				break;
+			}
+		}
+	}
+
+	if (!tx.active) {
+		for (ch = 0; ch < NOTIFY_CH_NUM; ch++) {
+			if (channels[ch].pending) {
+				break;
+			}
+		}
+		if (ch == NOTIFY_CH_NUM) {
+			return;
+		}
+
+		tx.ch = (Notify_Channel_t)ch;
+		tx.length = channels[ch].length;
+		tx.offset = 0;
+		memcpy(tx.value, channels[ch].value, tx.length);
+		channels[ch].pending = 0;
+		tx.active = 1;
+	}
+
+	tx.chunk = tx.length - tx.offset;
+	if (tx.chunk > NOTIFY_CHUNK_MAX) {
+		tx.chunk = NOTIFY_CHUNK_MAX;
+	}
+
+	// The parts before the last one only update the value
+	update_type = ((tx.offset + tx.chunk) >= tx.length) ? NOTIFY_UPDATE_NOTIFICATION : NOTIFY_UPDATE_LOCAL;
+
+	// tx.value is left alone until the completion: the part is sent from it
+	tx.queued = 1;
+	hci_set_next_req_async(Notify_Cplt_CB, NULL);
+	ret = aci_gatt_update_char_value_ext_nocopy(notify_conn_handle,
+												channels[tx.ch].service_handle, channels[tx.ch].char_handle,
+												update_type, tx.length, tx.offset,
+												(uint8_t)tx.chunk, tx.value + tx.offset);
+	if (ret != BLE_STATUS_SUCCESS) {
+		// Not queued, the command table is full: the value waits in its
+		// channel, unless a newer one is there already, and is tried again
+		tx.queued = 0;
+		tx.active = 0;
+		channels[tx.ch].pending = 1;
+		channels[tx.ch].stats.congested++;
+		Timer_Start(&notify_retry_timer, NOTIFY_RETRY_MS, 0);
+	}
+}
+
+/*
+ *
+ * @brief 	Tries again a command that could not be queued
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Notify_Retry_Timer_CB(void *ctx)
+{
+	Notify_Drain();
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Creates the retry timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Notify_Init(void)
+{
+	Timer_Create(&notify_retry_timer, Notify_Retry_Timer_CB, NULL);
+}
+
+/*
+ *
+ * @brief 	Binds a channel to its characteristic
+ * @param 	Notify_Channel_t channel
+ * @param 	uint16_t service handle
+ * @param 	uint16_t characteristic handle
+ * @retval	none
+ *
+ */
+void Notify_Register(Notify_Channel_t ch, uint16_t service_handle, uint16_t char_handle)
+{
+	channels[ch].service_handle = service_handle;
+	channels[ch].char_handle = char_handle;
+	channels[ch].pending = 0;
+}
+
+/*
+ *
+ * @brief 	Sets the connection the values are notified to
+ * @param 	uint16_t connection handle, 0 when not connected
+ * @retval	none
+ *
+ */
+void Notify_SetConnection(uint16_t handle)
+{
+	uint32_t ch;
+
+	if (handle == notify_conn_handle) {
+		return;
+	}
+
+	notify_conn_handle = handle;
+	for (ch = 0; ch < NOTIFY_CH_NUM; ch++) {
+		channels[ch].pending = 0;
+	}
+	tx.active = 0;
+	tx.congested = 0;
+}
+
+/*
+ *
+ * @brief 	Posts a new value of a characteristic
+ * @param 	Notify_Channel_t channel
+ * @param 	const uint8_t* value
+ * @param 	uint16_t length
+ * @retval	tBleStatus status
+ *
+ */
+tBleStatus Notify_Post(Notify_Channel_t ch, const uint8_t *value, uint16_t length)
+{
+	if ((ch >= NOTIFY_CH_NUM) || (length > NOTIFY_VALUE_MAX)) {
+		return BLE_STATUS_INVALID_PARAMS;
+	}
+
+	channels[ch].stats.posted++;
+	if (channels[ch].pending) {
+		channels[ch].stats.coalesced++;
+	}
+
+	memcpy(channels[ch].value, value, length);
+	channels[ch].length = length;
+	channels[ch].pending = 1;
+
+	Notify_Drain();
+
+	return BLE_STATUS_SUCCESS;
+}
+
+/*
+ *
+ * @brief 	The TX pool has room again
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Notify_TxPoolAvailable(void)
+{
+	if (!tx.congested) {
+		return;
+	}
+
+	tx.congested = 0;
+	Notify_Drain();
+}
+
+/*
+ *
+ * @brief 	Copies the figures of a channel
+ * @param 	Notify_Channel_t channel
+ * @param 	Notify_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Notify_GetStats(Notify_Channel_t ch, Notify_Stats_t *stats)
+{
+	*stats = channels[ch].stats;
+}
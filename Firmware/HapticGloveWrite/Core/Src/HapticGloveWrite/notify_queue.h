@@ -0,0 +1,112 @@
+/*
+ * notify_queue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_NOTIFY_QUEUE_H_
+#define SRC_HAPTICGLOVEWRITE_NOTIFY_QUEUE_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "bluenrg1_types.h"
+#include "hci_const.h"
+#include "haptic_render.h"
+#include "telemetry.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define NOTIFY_UPDATE_HDR_LEN	12U		// Parameters of aci_gatt_update_char_value_ext before the value
+
+// Longest characteristic value: the longest of the notified characteristics
+#define NOTIFY_VALUE_MAX		((HAPTIC_GRID_LATENCY_LEN > TELEMETRY_PACKET_LEN) ? \
+								 HAPTIC_GRID_LATENCY_LEN : TELEMETRY_PACKET_LEN)
+
+// Longest part of a value sent in one command: what the HCI command leaves
+#define NOTIFY_CHUNK_MAX		(HCI_CMD_PARAM_SIZE_MAX - NOTIFY_UPDATE_HDR_LEN)
+
+#define NOTIFY_RETRY_MS			5U		// Retry of a command the full HCI command table refused
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Notified characteristics, highest priority first */
+typedef enum {
+	NOTIFY_CH_GRID = 0,			// Haptic feedback, time critical
+	NOTIFY_CH_TELEMETRY,		// Link quality, background
+	NOTIFY_CH_NUM
+} Notify_Channel_t;
+
+typedef struct {
+	uint32_t posted;		// Values posted
+	uint32_t coalesced;		// Values replaced by a later one before being sent
+	uint32_t sent;			// Values sent
+	uint32_t congested;		// Times the TX pool or the HCI command table was full
+	uint32_t failed;		// Values dropped on another error
+} Notify_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Creates the retry timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Notify_Init(void);
+
+/*
+ *
+ * @brief 	Binds a channel to its characteristic
+ * @param 	Notify_Channel_t channel
+ * @param 	uint16_t service handle
+ * @param 	uint16_t characteristic handle
+ * @retval	none
+ *
+ */
+void Notify_Register(Notify_Channel_t ch, uint16_t service_handle, uint16_t char_handle);
+
+/*
+ *
+ * @brief 	Sets the connection the values are notified to, 0 when not connected.
+ * 			On a change, the values not sent yet are dropped
+ * @param 	uint16_t connection handle
+ * @retval	none
+ *
+ */
+void Notify_SetConnection(uint16_t handle);
+
+/*
+ *
+ * @brief 	Posts a new value of a characteristic. The value is copied, and
+ * 			replaces the one of the channel still waiting to be sent. Never
+ * 			blocks
+ * @param 	Notify_Channel_t channel
+ * @param 	const uint8_t* value
+ * @param 	uint16_t length, up to NOTIFY_VALUE_MAX
+ * @retval	tBleStatus BLE_STATUS_INVALID_PARAMS if the value is too long
+ *
+ */
+tBleStatus Notify_Post(Notify_Channel_t ch, const uint8_t *value, uint16_t length);
+
+/*
+ *
+ * @brief 	The TX pool has room again (aci_gatt_tx_pool_available_event):
+ * 			resumes the sending
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Notify_TxPoolAvailable(void);
+
+/*
+ *
+ * @brief 	Copies the figures of a channel
+ * @param 	Notify_Channel_t channel
+ * @param 	Notify_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Notify_GetStats(Notify_Channel_t ch, Notify_Stats_t *stats);
+
+#endif /* SRC_HAPTICGLOVEWRITE_NOTIFY_QUEUE_H_ */
@@ -0,0 +1,277 @@
+/*
+ * reconnect.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Advertising after a disconnection. A link dropped in a radio dead spot
+// should come back at once, so the glove first advertises directed at the
+// peer it lost (high duty cycle, ended by the controller after 1.28 s), then
+// fast, undirected and not discoverable, and only then slow and discoverable,
+// the advertising used at boot. Privacy is off (aci_gap_init), so there is no
+// resolving list: a phone on a resolvable private address would be refused
+// by a whitelist, and may have moved to a new address before a directed
+// advertising reaches it. The fast phase is open to anyone, the link is
+// encrypted with the bond, and the directed phase is kept for identity
+// addresses. Each phase has a timeout, and the time from the disconnection
+// to the next connection is recorded for the phase it happened in.
+
+// Includes
+#include <string.h>
+#include "reconnect.h"
+#include "timer_wheel.h"
+#include "sensor.h"
+#include "bluenrg1_aci.h"
+#include "bluenrg1_gap.h"
+#include "hci_tl.h"
+
+// Private defines
+#define RECONNECT_CTX(phase)	((void *)(uintptr_t)(phase))
+
+// Random address whose two top bits are 01: resolvable private
+#define RECONNECT_ADDR_RANDOM	0x01U
+#define RECONNECT_IS_RPA(type, addr)	(((type) == RECONNECT_ADDR_RANDOM) && (((addr)[5] & 0xC0U) == 0x40U))
+
+// Variables
+static Timer_t reconnect_timer;
+static Reconnect_Stats_t reconnect_stats;
+static Reconnect_Phase_t reconnect_phase;
+static uint8_t reconnect_active = 0;	// Advertising for a reconnection
+static uint32_t reconnect_start;		// HAL tick of the disconnection
+
+static struct {
+	uint8_t addr[6];
+	uint8_t addr_type;
+	uint8_t valid;
+	uint8_t identity;		// Not a private address: the directed phase can reach it
+} reconnect_peer;
+
+// Private functions
+static void Reconnect_Enter(Reconnect_Phase_t phase, uint8_t stop);
+
+/*
+ *
+ * @brief 	Completion of the command starting the advertising of a phase:
+ * 			on a failure, the next phase starts at once
+ * @param 	See hci_cmd_cplt_cb_t in hci_tl.h, ctx is the phase
+ * @retval	none
+ *
+ */
+static void Reconnect_Adv_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	Reconnect_Phase_t phase = (Reconnect_Phase_t)(uintptr_t)ctx;
+
+	if (status == BLE_STATUS_SUCCESS) {
+		return;
+	}
+
+	PRINT_DBG("Reconnection phase %d not started: 0x%02x\r\n", phase, status);
+	if (reconnect_active && (phase == reconnect_phase) && (phase < RECONNECT_PHASE_SLOW)) {
+		Timer_Stop(&reconnect_timer);
+		Reconnect_Enter(phase + 1, 0);
+	}
+}
+
+/*
+ *
+ * @brief 	Reports an ACI command that could not be queued
+ * @param 	tBleStatus status returned by the command
+ * @param 	const char* command name
+ * @retval	none
+ *
+ */
+static void Reconnect_Queued(tBleStatus ret, const char *name)
+{
+	if (ret != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("%s not queued: 0x%02x\r\n", name, ret);
+	}
+}
+
+/*
+ *
+ * @brief 	Starts the advertising of a phase
+ * @param 	Reconnect_Phase_t phase
+ * @param 	uint8_t 1 to stop the advertising of the previous phase first
+ * @retval	none
+ *
+ */
+static void Reconnect_Enter(Reconnect_Phase_t phase, uint8_t stop)
+{
+	tBleStatus ret;
+
+	reconnect_phase = phase;
+	reconnect_stats.phase[phase].starts++;
+
+	if (stop) {
+		hci_set_next_req_async(APP_CmdCpltCB, NULL);
+		Reconnect_Queued(aci_gap_set_non_discoverable(), "aci_gap_set_non_discoverable");
+	}
+
+	switch (phase) {
+	case RECONNECT_PHASE_DIRECTED:
+		hci_set_next_req_async(Reconnect_Adv_CB, RECONNECT_CTX(phase));
+		ret = aci_gap_set_direct_connectable(PUBLIC_ADDR, HIGH_DUTY_CYCLE_DIRECTED_ADV,
+											 reconnect_peer.addr_type & 0x01, reconnect_peer.addr,
+											 RECONNECT_FAST_INTERV_MIN, RECONNECT_FAST_INTERV_MAX);
+		if (ret != BLE_STATUS_SUCCESS) {
+			Reconnect_Adv_CB(0, ret, NULL, 0, RECONNECT_CTX(phase));
+			return;
+		}
+		Timer_Start(&reconnect_timer, RECONNECT_DIRECTED_MS, 0);
+		break;
+
+	case RECONNECT_PHASE_FAST:
+		// No whitelist: without a resolving list it would refuse a private address
+		hci_set_next_req_async(Reconnect_Adv_CB, RECONNECT_CTX(phase));
+		ret = aci_gap_set_undirected_connectable(RECONNECT_FAST_INTERV_MIN, RECONNECT_FAST_INTERV_MAX,
+												 PUBLIC_ADDR, NO_WHITE_LIST_USE);
+		if (ret != BLE_STATUS_SUCCESS) {
+			Reconnect_Adv_CB(0, ret, NULL, 0, RECONNECT_CTX(phase));
+			return;
+		}
+		Timer_Start(&reconnect_timer, RECONNECT_FAST_MS, 0);
+		break;
+
+	default:
+		// Until a connection
+		Set_DeviceConnectable(APP_CmdCpltCB, "aci_gap_set_discoverable()");
+		break;
+	}
+}
+
+/*
+ *
+ * @brief 	Timeout of the directed or fast phase
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Reconnect_Timer_CB(void *ctx)
+{
+	if (reconnect_active && (reconnect_phase < RECONNECT_PHASE_SLOW)) {
+		Reconnect_Enter(reconnect_phase + 1, 1);
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Creates the phase timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Init(void)
+{
+	Timer_Create(&reconnect_timer, Reconnect_Timer_CB, NULL);
+}
+
+/*
+ *
+ * @brief 	Records the peer of an encrypted link
+ * @param 	uint8_t peer address type
+ * @param 	const uint8_t* peer address, 6 bytes
+ * @retval	none
+ *
+ */
+void Reconnect_SetPeer(uint8_t addr_type, const uint8_t *addr)
+{
+	memcpy(reconnect_peer.addr, addr, sizeof(reconnect_peer.addr));
+	reconnect_peer.addr_type = addr_type;
+	reconnect_peer.valid = 1;
+
+	// A private address changes: the directed advertising would miss the peer
+	reconnect_peer.identity = RECONNECT_IS_RPA(addr_type, addr) ? 0 : 1;
+}
+
+/*
+ *
+ * @brief 	Makes the device connectable again after a disconnection
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Start(void)
+{
+	reconnect_start = HAL_GetTick();
+	reconnect_active = 1;
+
+	if (!reconnect_peer.valid) {
+		Reconnect_Enter(RECONNECT_PHASE_SLOW, 0);
+	} else {
+		Reconnect_Enter(reconnect_peer.identity ? RECONNECT_PHASE_DIRECTED : RECONNECT_PHASE_FAST, 0);
+	}
+}
+
+/*
+ *
+ * @brief 	A connection is established: records the reconnection latency
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Connected(void)
+{
+	Reconnect_PhaseStats_t *stats;
+	uint32_t latency;
+
+	if (!reconnect_active) {
+		return;
+	}
+
+	reconnect_active = 0;
+	Timer_Stop(&reconnect_timer);
+
+	latency = HAL_GetTick() - reconnect_start;
+	stats = &reconnect_stats.phase[reconnect_phase];
+	stats->connections++;
+	stats->last_ms = latency;
+	if (latency > stats->max_ms) {
+		stats->max_ms = latency;
+	}
+
+	PRINT_DBG("Reconnected in %lu ms, phase %d\r\n", (unsigned long)latency, reconnect_phase);
+}
+
+/*
+ *
+ * @brief 	The directed advertising ended without a connection
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_DirectedTimeout(void)
+{
+	if (reconnect_active && (reconnect_phase == RECONNECT_PHASE_DIRECTED)) {
+		Timer_Stop(&reconnect_timer);
+		Reconnect_Enter(RECONNECT_PHASE_FAST, 0);
+	}
+}
+
+/*
+ *
+ * @brief 	Abandons the reconnection phases
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Stop(void)
+{
+	reconnect_active = 0;
+	reconnect_phase = RECONNECT_PHASE_DIRECTED;
+	Timer_Stop(&reconnect_timer);
+}
+
+/*
+ *
+ * @brief 	Copies the reconnection figures
+ * @param 	Reconnect_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Reconnect_GetStats(Reconnect_Stats_t *stats)
+{
+	*stats = reconnect_stats;
+}
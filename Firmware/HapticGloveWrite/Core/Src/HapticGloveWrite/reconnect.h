@@ -0,0 +1,113 @@
+/*
+ * reconnect.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_RECONNECT_H_
+#define SRC_HAPTICGLOVEWRITE_RECONNECT_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define RECONNECT_DIRECTED_MS		1500U	// Guard of the directed phase, which the controller ends after 1.28 s
+#define RECONNECT_FAST_MS			10000U	// Fast undirected advertising, before the slow discoverable one
+#define RECONNECT_FAST_INTERV_MIN	32U		// 20 ms, in units of 0.625 ms
+#define RECONNECT_FAST_INTERV_MAX	48U		// 30 ms
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+	RECONNECT_PHASE_DIRECTED = 0,	// High duty cycle directed advertising to the last peer, identity address only
+	RECONNECT_PHASE_FAST,			// Fast undirected, non discoverable advertising
+	RECONNECT_PHASE_SLOW,			// Slow discoverable advertising, anyone
+	RECONNECT_PHASE_NUM
+} Reconnect_Phase_t;
+
+typedef struct {
+	uint32_t starts;		// Times the phase was entered
+	uint32_t connections;	// Connections made during the phase
+	uint32_t last_ms;		// Latest of them: disconnection to connection
+	uint32_t max_ms;		// Slowest of them
+} Reconnect_PhaseStats_t;
+
+typedef struct {
+	Reconnect_PhaseStats_t phase[RECONNECT_PHASE_NUM];
+} Reconnect_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Creates the phase timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Init(void);
+
+/*
+ *
+ * @brief 	Records the peer of an encrypted link, the target of the directed
+ * 			phase after a disconnection
+ * @param 	uint8_t peer address type, as in hci_le_connection_complete_event
+ * @param 	const uint8_t* peer address, 6 bytes
+ * @retval	none
+ *
+ */
+void Reconnect_SetPeer(uint8_t addr_type, const uint8_t *addr);
+
+/*
+ *
+ * @brief 	Makes the device connectable again after a disconnection: directed,
+ * 			then fast undirected, then slow discoverable advertising. A peer on
+ * 			a private address skips the directed phase; without a bonded peer,
+ * 			goes straight to the slow phase
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Start(void);
+
+/*
+ *
+ * @brief 	A connection is established: ends the advertising phases and
+ * 			records the reconnection latency
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Connected(void);
+
+/*
+ *
+ * @brief 	The directed advertising ended without a connection
+ * 			(hci_le_connection_complete_event with status 0x3C)
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_DirectedTimeout(void);
+
+/*
+ *
+ * @brief 	Abandons the reconnection phases without a connection, when the
+ * 			BlueNRG-2 reset: no more advertising commands until the next
+ * 			Reconnect_Start()
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Reconnect_Stop(void);
+
+/*
+ *
+ * @brief 	Copies the reconnection figures
+ * @param 	Reconnect_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Reconnect_GetStats(Reconnect_Stats_t *stats);
+
+#endif /* SRC_HAPTICGLOVEWRITE_RECONNECT_H_ */
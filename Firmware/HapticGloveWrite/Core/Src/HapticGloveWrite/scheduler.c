@@ -0,0 +1,116 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Cooperative scheduler of the main loop. The interrupts only request tasks
+// (a packet is ready, the render tick, a period elapsed); the tasks run to
+// completion in thread mode, highest priority first, so the BLE handling
+// and the haptic rendering never interleave. With nothing requested the
+// core idles in low_power.c (Sleep or Stop 2) instead of polling. Periodic work goes through the
+// software timers of timer_wheel.c, which run as a task of their own.
+
+// Includes
+#include "scheduler.h"
+#include "low_power.h"
+
+// Variables
+static Sched_Task_t sched_tasks[SCHED_TASK_NUM];
+static volatile uint32_t sched_pending;		// Requested tasks, bit n for task n
+static Sched_Stats_t sched_stats;
+
+/*
+ *
+ * @brief 	Registers the function run for a task
+ * @param 	Sched_TaskId_t task
+ * @param 	Sched_Task_t function, run to completion from Sched_Run()
+ * @retval	none
+ *
+ */
+void Sched_RegTask(Sched_TaskId_t id, Sched_Task_t task)
+{
+	sched_tasks[id] = task;
+}
+
+/*
+ *
+ * @brief 	Requests a run of a task, from any context
+ * @param 	Sched_TaskId_t task
+ * @retval	none
+ *
+ */
+void Sched_SetTask(Sched_TaskId_t id)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	sched_pending |= 1U << id;
+	__set_PRIMASK(primask);
+}
+
+/*
+ *
+ * @brief 	Runs the highest priority requested task, or idles until an
+ * 			interrupt when none is
+ * @note	The pending mask is checked with the interrupts masked, so a
+ * 			request made just before going idle still wakes the core: the
+ * 			interrupt stays pending and runs once they are unmasked. The
+ * 			cycle counter stops in Stop 2, idle_cycles only counts Sleep
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Sched_Run(void)
+{
+	Sched_TaskStats_t *stats;
+	uint32_t pending;
+	uint32_t start;
+	uint32_t id;
+
+	__disable_irq();
+	pending = sched_pending;
+
+	if (pending == 0) {
+		start = DWT->CYCCNT;
+		LowPower_Idle();
+		sched_stats.sleeps++;
+		sched_stats.idle_cycles += DWT->CYCCNT - start;
+		__enable_irq();
+		return;
+	}
+
+	id = __CLZ(__RBIT(pending));
+	sched_pending = pending & ~(1U << id);
+	__enable_irq();
+
+	if (sched_tasks[id] == NULL) {
+		return;
+	}
+
+	start = DWT->CYCCNT;
+	sched_tasks[id]();
+	start = DWT->CYCCNT - start;
+
+	stats = &sched_stats.task[id];
+	stats->runs++;
+	stats->total_cycles += start;
+	if (start > stats->max_cycles) {
+		stats->max_cycles = start;
+	}
+}
+
+/*
+ *
+ * @brief 	Copies the run counters and times
+ * @param 	Sched_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Sched_GetStats(Sched_Stats_t *stats)
+{
+	__disable_irq();
+	*stats = sched_stats;
+	__enable_irq();
+}
@@ -0,0 +1,81 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_SCHEDULER_H_
+#define SRC_HAPTICGLOVEWRITE_SCHEDULER_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Tasks, by priority: each one is a bit of the pending mask and the lowest
+   set bit runs first */
+typedef enum {
+	SCHED_TASK_RENDER = 0,	// Haptic render: latest grid to the motor PWM
+	SCHED_TASK_TIMER,		// Software timer expiries (timer_wheel.c)
+	SCHED_TASK_HCI,			// hci_user_evt_proc: received packets, command queue and timeouts
+	SCHED_TASK_USER,		// Connection state machine (User_Process)
+	SCHED_TASK_NUM
+} Sched_TaskId_t;
+
+typedef void (*Sched_Task_t)(void);
+
+typedef struct {
+	uint32_t runs;			// Runs of the task
+	uint32_t max_cycles;	// Longest run, in core cycles
+	uint32_t total_cycles;	// Sum of the runs, divide by runs for the mean
+} Sched_TaskStats_t;
+
+typedef struct {
+	Sched_TaskStats_t task[SCHED_TASK_NUM];
+	uint32_t sleeps;		// Times the core went idle
+	uint32_t idle_cycles;	// Core cycles spent in Sleep (see LowPower_GetStats for Stop 2)
+} Sched_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Registers the function run for a task
+ * @param 	Sched_TaskId_t task
+ * @param 	Sched_Task_t function, run to completion from Sched_Run()
+ * @retval	none
+ *
+ */
+void Sched_RegTask(Sched_TaskId_t id, Sched_Task_t task);
+
+/*
+ *
+ * @brief 	Requests a run of a task. Can be called from any context;
+ * 			requests made before the task runs are merged into one run
+ * @param 	Sched_TaskId_t task
+ * @retval	none
+ *
+ */
+void Sched_SetTask(Sched_TaskId_t id);
+
+/*
+ *
+ * @brief 	Runs the highest priority requested task, or idles until an
+ * 			interrupt when none is (LowPower_Idle). Called from the main loop
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Sched_Run(void);
+
+/*
+ *
+ * @brief 	Copies the run counters and times
+ * @param 	Sched_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void Sched_GetStats(Sched_Stats_t *stats);
+
+#endif /* SRC_HAPTICGLOVEWRITE_SCHEDULER_H_ */
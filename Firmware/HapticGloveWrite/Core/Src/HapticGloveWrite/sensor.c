@@ -19,6 +19,7 @@
 #include "bluenrg1_hci_le.h"
 #include "hci_const.h"
 #include "bluenrg1_gatt_aci.h"
+#include "hci_tl.h"
 
 // Private Variables
 extern uint8_t bdaddr[BDADDR_SIZE];
@@ -45,10 +46,11 @@ void GAP_ConnectionComplete_CB(uint8_t addr[6], uint16_t handle);
  *
  * @brief	Set_DeviceConnectable
  * @note	Puts the devie in a connectable mode
- * @param	None
+ * @param	adv_cb Completion of aci_gap_set_discoverable, once advertising
+ * @param	adv_ctx Context passed to adv_cb
  * @retval None
  */
-void Set_DeviceConnectable(void)
+void Set_DeviceConnectable(hci_cmd_cplt_cb_t adv_cb, void *adv_ctx)
 {
 	uint8_t ret;
 	uint8_t local_name[] = {AD_TYPE_COMPLETE_LOCAL_NAME, SENSOR_DEMO_NAME};
@@ -73,77 +75,48 @@ void Set_DeviceConnectable(void)
 	// Sensor fusion?
 	manuf_data[18] |= 0x01;
 
+	// Runs from the main loop: queue the three commands instead of blocking on each answer
+	hci_set_next_req_async(APP_CmdCpltCB, NULL);
 	hci_le_set_scan_response_data(0, NULL);
 
 	PRINT_DBG("Set General Discoverable Mode.\r\n");
 
+	hci_set_next_req_async(adv_cb, adv_ctx);
 	ret = aci_gap_set_discoverable(ADV_DATA_TYPE,
 									ADV_INTERV_MIN, ADV_INTERV_MAX,
 									PUBLIC_ADDR,
 									NO_WHITE_LIST_USE,
 									sizeof(local_name), local_name, 0, NULL, 0, 0);
 
+	hci_set_next_req_async(APP_CmdCpltCB, NULL);
 	aci_gap_update_adv_data(26, manuf_data);
 
 	if (ret != BLE_STATUS_SUCCESS) {
-		PRINT_DBG("aci_gap_set_discoverable() failed: 0x%02x\r\n", ret);
-	} else {
-		PRINT_DBG("aci_gap_set_discoverable() success!\r\n");
+		PRINT_DBG("aci_gap_set_discoverable() not queued: 0x%02x\r\n", ret);
+		if (adv_cb != NULL) {
+			adv_cb(0, ret, NULL, 0, adv_ctx);
+		}
 	}
 
 }
 
 /*
  *
- * @brief 	Callback processing the ACI events
- * @note	Inside this function each event must be identified and correctly parsed
- * @param 	void* pointer to the ACI packet
+ * @brief 	Completion callback of the ACI commands issued asynchronously
+ * @note	Reports failures; ctx is an optional name printed on success
+ * @param 	opcode Command opcode
+ * @param 	status Command status, BLE_STATUS_TIMEOUT if the controller did not answer
+ * @param 	rparam Return parameters
+ * @param 	rlen Return parameters length
+ * @param 	ctx Command name or NULL
  * @retval	none
  *
  */
-void APP_UserEvtRx(void *pData)
+void APP_CmdCpltCB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
 {
-	uint32_t i;
-
-	  hci_spi_pckt *hci_pckt = (hci_spi_pckt *)pData;
-
-	  if(hci_pckt->type == HCI_EVENT_PKT)
-	  {
-	    hci_event_pckt *event_pckt = (hci_event_pckt*)hci_pckt->data;
-
-	    if(event_pckt->evt == EVT_LE_META_EVENT)
-	    {
-	      evt_le_meta_event *evt = (void *)event_pckt->data;
-
-	      for (i = 0; i < (sizeof(hci_le_meta_events_table)/sizeof(hci_le_meta_events_table_type)); i++)
-	      {
-	        if (evt->subevent == hci_le_meta_events_table[i].evt_code)
-	        {
-	          hci_le_meta_events_table[i].process((void *)evt->data);
-	        }
-	      }
-	    }
-	    else if(event_pckt->evt == EVT_VENDOR)
-	    {
-	      evt_blue_aci *blue_evt = (void*)event_pckt->data;
-
-	      for (i = 0; i < (sizeof(hci_vendor_specific_events_table)/sizeof(hci_vendor_specific_events_table_type)); i++)
-	      {
-	        if (blue_evt->ecode == hci_vendor_specific_events_table[i].evt_code)
-	        {
-	          hci_vendor_specific_events_table[i].process((void *)blue_evt->data);
-	        }
-	      }
-	    }
-	    else
-	    {
-	      for (i = 0; i < (sizeof(hci_events_table)/sizeof(hci_events_table_type)); i++)
-	      {
-	        if (event_pckt->evt == hci_events_table[i].evt_code)
-	        {
-	          hci_events_table[i].process((void *)event_pckt->data);
-	        }
-	      }
-	    }
-	  }
+	if (status != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("ACI command 0x%04x failed: 0x%02x\r\n", opcode, status);
+	} else if (ctx != NULL) {
+		PRINT_DBG("%s success!\r\n", (const char *)ctx);
+	}
 }
@@ -10,12 +10,14 @@
 
 // Includes
 #include <stdint.h>
+#include "hci_tl.h"
 
 #define SENSOR_DEMO_NAME 'H','a','p','t','i','c',' '
 #define BDADDR_SIZE 6
 
-void Set_DeviceConnectable(void);
+void Set_DeviceConnectable(hci_cmd_cplt_cb_t adv_cb, void *adv_ctx);
 void APP_UserEvtRx(void *pData);
+void APP_CmdCpltCB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx);
 
 extern volatile uint8_t notification_enabled;
 
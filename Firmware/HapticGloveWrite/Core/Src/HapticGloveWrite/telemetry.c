@@ -0,0 +1,354 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Link quality telemetry. While connected, the RSSI, the link status and the
+// anchor period are read every TELEMETRY_SAMPLE_MS, and the packets the
+// controller sent and its buffer overflows are counted from their events.
+// Every TELEMETRY_WINDOW_SAMPLES samples the window is closed, with the
+// connection parameters in use, and notified on the telemetry characteristic
+// if the central subscribed: one notification per window whatever the link
+// does, so the phone can log it next to the haptic latency it measures.
+
+// Includes
+#include <string.h>
+#include "telemetry.h"
+#include "timer_wheel.h"
+#include "link_policy.h"
+#include "gatt_db.h"
+#include "bluenrg1_aci.h"
+#include "bluenrg1_hci_le.h"
+#include "hci_tl.h"
+
+// Private defines
+#define TELEMETRY_READ_RSSI		0U
+#define TELEMETRY_READ_LINK		1U
+#define TELEMETRY_READ_ANCHOR	2U
+#define TELEMETRY_READ_NUM		3U
+#define TELEMETRY_READS_ALL		((1U << TELEMETRY_READ_NUM) - 1U)
+
+#define TELEMETRY_CTX(read)		((void *)(uintptr_t)(read))
+
+// Stores a value into a buffer in little endian
+#define PUT_LE_16(buf, val)		((buf)[0] = (uint8_t)(val), (buf)[1] = (uint8_t)((val) >> 8))
+#define PUT_LE_32(buf, val)		(PUT_LE_16(buf, val), PUT_LE_16((buf) + 2, (val) >> 16))
+
+// Variables
+static Timer_t sample_timer;
+static Telemetry_Window_t last_window;
+static uint16_t telemetry_handle;
+static uint8_t telemetry_active = 0;
+static uint8_t telemetry_notify = 0;
+static uint8_t telemetry_pending = 0;		// Reads of the sample not answered yet
+static uint8_t telemetry_answered;			// Reads of the sample answered, one bit each
+static uint8_t telemetry_packet[TELEMETRY_PACKET_LEN];
+
+// Window being filled
+static struct {
+	int8_t rssi_min;
+	int8_t rssi_max;
+	int32_t rssi_sum;
+	uint8_t rssi_count;
+	uint8_t link_status;
+	uint32_t anchor_period;
+	uint32_t completed;
+	uint32_t overflows;
+	uint8_t ticks;
+	uint8_t samples;
+	uint16_t seq;
+} window;
+
+// Private functions
+
+/*
+ *
+ * @brief 	Starts a new window
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Telemetry_Reset(void)
+{
+	uint16_t seq = window.seq;
+
+	memset(&window, 0, sizeof(window));
+	window.rssi_min = INT8_MAX;
+	window.rssi_max = INT8_MIN;
+	window.seq = seq;
+}
+
+/*
+ *
+ * @brief 	Closes the window and notifies it
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Telemetry_Close(void)
+{
+	LinkPolicy_Params_t params;
+	Telemetry_Window_t *w = &last_window;
+	uint8_t *p = telemetry_packet;
+	tBleStatus ret;
+
+	LinkPolicy_GetParams(&params);
+
+	w->tick = HAL_GetTick();
+	if (window.rssi_count > 0) {
+		w->rssi_min = window.rssi_min;
+		w->rssi_max = window.rssi_max;
+		w->rssi_mean = (int8_t)(window.rssi_sum / window.rssi_count);
+	} else {
+		w->rssi_min = w->rssi_max = w->rssi_mean = TELEMETRY_RSSI_NONE;
+	}
+	w->link_status = window.link_status;
+	w->interval = params.interval;
+	w->latency = params.latency;
+	w->anchor_period = (window.anchor_period > UINT16_MAX) ? UINT16_MAX : window.anchor_period;
+	w->completed = (window.completed > UINT16_MAX) ? UINT16_MAX : window.completed;
+	w->overflows = (window.overflows > UINT8_MAX) ? UINT8_MAX : window.overflows;
+	w->samples = window.samples;
+	w->seq = window.seq++;
+
+	Telemetry_Reset();
+
+	if (!telemetry_notify) {
+		return;
+	}
+
+	PUT_LE_32(p, w->tick);
+	p[4] = (uint8_t)w->rssi_min;
+	p[5] = (uint8_t)w->rssi_max;
+	p[6] = (uint8_t)w->rssi_mean;
+	p[7] = w->link_status;
+	PUT_LE_16(p + 8, w->interval);
+	PUT_LE_16(p + 10, w->latency);
+	PUT_LE_16(p + 12, w->anchor_period);
+	PUT_LE_16(p + 14, w->completed);
+	p[16] = w->overflows;
+	p[17] = w->samples;
+	PUT_LE_16(p + 18, w->seq);
+
+	ret = Telemetry_Char_Update(telemetry_packet, sizeof(telemetry_packet));
+	if (ret != BLE_STATUS_SUCCESS) {
+		PRINT_DBG("Telemetry not notified: 0x%02x\r\n", ret);
+	}
+}
+
+/*
+ *
+ * @brief 	Completion of the link quality reads
+ * @param 	See hci_cmd_cplt_cb_t in hci_tl.h, ctx is the read
+ * @retval	none
+ *
+ */
+static void Telemetry_Read_CB(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx)
+{
+	uint8_t read = (uint8_t)(uintptr_t)ctx;
+	uint8_t i;
+
+	if (telemetry_pending > 0) {
+		telemetry_pending--;
+	}
+
+	if (!telemetry_active || (status != BLE_STATUS_SUCCESS) || (rparam == NULL)) {
+		return;
+	}
+
+	switch (read) {
+	case TELEMETRY_READ_RSSI:
+		if (rlen >= sizeof(hci_read_rssi_rp0)) {
+			const hci_read_rssi_rp0 *rp = (const void *)rparam;
+
+			if (rp->RSSI != TELEMETRY_RSSI_NONE) {
+				if (rp->RSSI < window.rssi_min) {
+					window.rssi_min = rp->RSSI;
+				}
+				if (rp->RSSI > window.rssi_max) {
+					window.rssi_max = rp->RSSI;
+				}
+				window.rssi_sum += rp->RSSI;
+				window.rssi_count++;
+			}
+			telemetry_answered |= (1U << read);
+		}
+		break;
+
+	case TELEMETRY_READ_LINK:
+		if (rlen >= sizeof(aci_hal_get_link_status_rp0)) {
+			const aci_hal_get_link_status_rp0 *rp = (const void *)rparam;
+
+			for (i = 0; i < 8U; i++) {
+				if (rp->Link_Connection_Handle[i] == telemetry_handle) {
+					window.link_status = rp->Link_Status[i];
+					break;
+				}
+			}
+			telemetry_answered |= (1U << read);
+		}
+		break;
+
+	case TELEMETRY_READ_ANCHOR:
+		if (rlen >= sizeof(aci_hal_get_anchor_period_rp0)) {
+			const aci_hal_get_anchor_period_rp0 *rp = (const void *)rparam;
+
+			window.anchor_period = rp->Anchor_Period;
+			telemetry_answered |= (1U << read);
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (telemetry_answered == TELEMETRY_READS_ALL) {
+		telemetry_answered = 0;
+		window.samples++;
+	}
+}
+
+/*
+ *
+ * @brief 	Sampling tick: closes the window when it is full, then reads the
+ * 			link quality, unless the reads of the previous sample are pending
+ * @param 	void* unused
+ * @retval	none
+ *
+ */
+static void Sample_Timer_CB(void *ctx)
+{
+	int8_t rssi;
+	uint8_t link_status[8];
+	uint16_t link_handles[8];
+	uint32_t anchor_period, max_free_slot;
+	tBleStatus ret;
+
+	if (++window.ticks > TELEMETRY_WINDOW_SAMPLES) {
+		Telemetry_Close();
+		window.ticks = 1;
+	}
+
+	if (telemetry_pending > 0) {
+		return;
+	}
+	telemetry_answered = 0;
+
+	// Asynchronous: the output parameters are not written, the answers come to Telemetry_Read_CB()
+	telemetry_pending = TELEMETRY_READ_NUM;
+
+	hci_set_next_req_async(Telemetry_Read_CB, TELEMETRY_CTX(TELEMETRY_READ_RSSI));
+	ret = hci_read_rssi(telemetry_handle, &rssi);
+	if (ret != BLE_STATUS_SUCCESS) {
+		Telemetry_Read_CB(0, ret, NULL, 0, TELEMETRY_CTX(TELEMETRY_READ_RSSI));
+	}
+
+	hci_set_next_req_async(Telemetry_Read_CB, TELEMETRY_CTX(TELEMETRY_READ_LINK));
+	ret = aci_hal_get_link_status(link_status, link_handles);
+	if (ret != BLE_STATUS_SUCCESS) {
+		Telemetry_Read_CB(0, ret, NULL, 0, TELEMETRY_CTX(TELEMETRY_READ_LINK));
+	}
+
+	hci_set_next_req_async(Telemetry_Read_CB, TELEMETRY_CTX(TELEMETRY_READ_ANCHOR));
+	ret = aci_hal_get_anchor_period(&anchor_period, &max_free_slot);
+	if (ret != BLE_STATUS_SUCCESS) {
+		Telemetry_Read_CB(0, ret, NULL, 0, TELEMETRY_CTX(TELEMETRY_READ_ANCHOR));
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Creates the sampling timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_Init(void)
+{
+	Timer_Create(&sample_timer, Sample_Timer_CB, NULL);
+	Telemetry_Reset();
+}
+
+/*
+ *
+ * @brief 	Starts the sampling of a connection
+ * @param 	uint16_t connection handle
+ * @retval	none
+ *
+ */
+void Telemetry_Start(uint16_t handle)
+{
+	telemetry_handle = handle;
+	telemetry_active = 1;
+	telemetry_notify = 0;
+	telemetry_pending = 0;
+	Telemetry_Reset();
+
+	Timer_Start(&sample_timer, TELEMETRY_SAMPLE_MS, TELEMETRY_SAMPLE_MS);
+}
+
+/*
+ *
+ * @brief 	Stops the sampling
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_Stop(void)
+{
+	telemetry_active = 0;
+	telemetry_notify = 0;
+	Timer_Stop(&sample_timer);
+}
+
+/*
+ *
+ * @brief 	Enables or disables the notifications
+ * @param 	uint8_t 1 if notifications are enabled
+ * @retval	none
+ *
+ */
+void Telemetry_SetNotify(uint8_t enabled)
+{
+	telemetry_notify = enabled;
+}
+
+/*
+ *
+ * @brief 	Counts packets the controller sent
+ * @param 	uint16_t number of packets
+ * @retval	none
+ *
+ */
+void Telemetry_PacketsCompleted(uint16_t packets)
+{
+	window.completed += packets;
+}
+
+/*
+ *
+ * @brief 	Counts an overflow of the controller buffers
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_BufferOverflow(void)
+{
+	window.overflows++;
+}
+
+/*
+ *
+ * @brief 	Copies the last complete window
+ * @param 	Telemetry_Window_t* filled with the window
+ * @retval	none
+ *
+ */
+void Telemetry_GetWindow(Telemetry_Window_t *w)
+{
+	*w = last_window;
+}
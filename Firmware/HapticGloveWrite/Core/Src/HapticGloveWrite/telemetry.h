@@ -0,0 +1,106 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_TELEMETRY_H_
+#define SRC_HAPTICGLOVEWRITE_TELEMETRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define TELEMETRY_SAMPLE_MS			250U	// Period of the link quality reads
+#define TELEMETRY_WINDOW_SAMPLES	8U		// Samples per window, one notification each: 2 s
+#define TELEMETRY_PACKET_LEN		20U		// Telemetry characteristic value, fits the default ATT MTU
+#define TELEMETRY_RSSI_NONE			127		// RSSI not available
+
+/* Exported types ------------------------------------------------------------*/
+
+/*
+ * Link quality over a window. Sent little endian, in this order, as the
+ * value of the telemetry characteristic
+ */
+typedef struct {
+	uint32_t tick;			// HAL tick at the end of the window, ms
+	int8_t rssi_min;		// dBm, TELEMETRY_RSSI_NONE without a reading
+	int8_t rssi_max;
+	int8_t rssi_mean;
+	uint8_t link_status;	// State of the link from aci_hal_get_link_status
+	uint16_t interval;		// Connection interval, units of 1.25 ms
+	uint16_t latency;		// Slave latency
+	uint16_t anchor_period;	// Anchor period, units of 625 us
+	uint16_t completed;		// Packets sent to the central
+	uint8_t overflows;		// Data buffer overflows, saturated
+	uint8_t samples;		// Samples with all three reads answered
+	uint16_t seq;			// Window number, to spot lost notifications
+} Telemetry_Window_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Creates the sampling timer
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_Init(void);
+
+/*
+ *
+ * @brief 	A connection is established: starts the sampling
+ * @param 	uint16_t connection handle
+ * @retval	none
+ *
+ */
+void Telemetry_Start(uint16_t handle);
+
+/*
+ *
+ * @brief 	The connection is lost: stops the sampling
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_Stop(void);
+
+/*
+ *
+ * @brief 	The central subscribed to the telemetry characteristic, or left it
+ * @param 	uint8_t 1 if notifications are enabled
+ * @retval	none
+ *
+ */
+void Telemetry_SetNotify(uint8_t enabled);
+
+/*
+ *
+ * @brief 	Counts packets the controller sent (hci_number_of_completed_packets_event)
+ * @param 	uint16_t number of packets
+ * @retval	none
+ *
+ */
+void Telemetry_PacketsCompleted(uint16_t packets);
+
+/*
+ *
+ * @brief 	Counts an overflow of the controller buffers (hci_data_buffer_overflow_event)
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Telemetry_BufferOverflow(void);
+
+/*
+ *
+ * @brief 	Copies the last complete window
+ * @param 	Telemetry_Window_t* filled with the window
+ * @retval	none
+ *
+ */
+void Telemetry_GetWindow(Telemetry_Window_t *window);
+
+#endif /* SRC_HAPTICGLOVEWRITE_TELEMETRY_H_ */
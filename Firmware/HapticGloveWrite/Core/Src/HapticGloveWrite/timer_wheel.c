@@ -0,0 +1,359 @@
+/*
+ * timer_wheel.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Software timers on a hierarchical timing wheel, driven by the 1 ms SysTick
+// (and by the low-power timer across a tickless idle, see low_power.c).
+// Level n has 32 slots of 32^n ms; a timer sits in the slot of the level its
+// delay fits, and moves down a level each time the level below it wraps, so
+// starting and stopping a timer only link or unlink a list node. The
+// interrupt only counts the ticks and compares them with the next tick
+// anything is due; the expiries and the cascades run in the timer task, and
+// so do the callbacks, which may then use the ACI commands.
+
+// Includes
+#include "timer_wheel.h"
+#include "scheduler.h"
+
+// Private defines
+#define TIMER_SLOTS			(1U << TIMER_WHEEL_BITS)
+#define TIMER_SLOT_MASK		(TIMER_SLOTS - 1U)
+#define TIMER_SHIFT(level)	((level) * TIMER_WHEEL_BITS)
+
+// Variables
+static Timer_t *timer_wheel[TIMER_WHEEL_LEVELS][TIMER_SLOTS];
+static uint32_t timer_map[TIMER_WHEEL_LEVELS];	// Non empty slots, bit n for slot n
+static uint32_t timer_now;						// Last tick processed by the timer task
+static volatile uint32_t timer_ticks;			// Ticks counted by the interrupt
+static volatile uint32_t timer_next;			// Next tick the timer task has work at
+static volatile uint8_t timer_armed = 0;	// timer_next is valid
+
+// Private functions
+
+/*
+ *
+ * @brief 	Makes the interrupt request the timer task at a given tick, if
+ * 			that is earlier than the tick it waits for
+ * @param 	uint32_t tick
+ * @retval	none
+ *
+ */
+static void Timer_WakeAt(uint32_t tick)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (!timer_armed || ((int32_t)(tick - timer_next) < 0)) {
+		timer_next = tick;
+		timer_armed = 1;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*
+ *
+ * @brief 	Puts a timer in the slot of its expiry
+ * @param 	Timer_t* timer, not linked
+ * @retval	none
+ *
+ */
+static void Timer_Link(Timer_t *timer)
+{
+	uint32_t delta = timer->expires - timer_now;
+	uint32_t level = 0;
+	uint32_t slot;
+	Timer_t **head;
+
+	if (delta > TIMER_MAX_DELAY_MS) {
+		delta = TIMER_MAX_DELAY_MS;
+		timer->expires = timer_now + delta;
+	}
+
+	while ((level < (TIMER_WHEEL_LEVELS - 1U)) && (delta >= (1UL << TIMER_SHIFT(level + 1U)))) {
+		level++;
+	}
+
+	slot = (timer->expires >> TIMER_SHIFT(level)) & TIMER_SLOT_MASK;
+	head = &timer_wheel[level][slot];
+
+	timer->level = (uint8_t)level;
+	timer->slot = (uint8_t)slot;
+	timer->prev = NULL;
+	timer->next = *head;
+	if (*head != NULL) {
+		(*head)->prev = timer;
+	}
+	*head = timer;
+	timer_map[level] |= 1UL << slot;
+
+	// Level 0 slots are due at the expiry, the others when they cascade
+	Timer_WakeAt(timer->expires & ~((1UL << TIMER_SHIFT(level)) - 1U));
+}
+
+/*
+ *
+ * @brief 	Takes a timer out of its slot
+ * @param 	Timer_t* timer, linked
+ * @retval	none
+ *
+ */
+static void Timer_Unlink(Timer_t *timer)
+{
+	if (timer->prev != NULL) {
+		timer->prev->next = timer->next;
+	} else {
+		timer_wheel[timer->level][timer->slot] = timer->next;
+		if (timer->next == NULL) {
+			timer_map[timer->level] &= ~(1UL << timer->slot);
+		}
+	}
+	if (timer->next != NULL) {
+		timer->next->prev = timer->prev;
+	}
+}
+
+/*
+ *
+ * @brief 	Moves the timers of the slots reached by timer_now down a level
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Timer_Cascade(void)
+{
+	uint32_t level;
+
+	for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+		uint32_t slot;
+		Timer_t *timer;
+
+		if ((timer_now & ((1UL << TIMER_SHIFT(level)) - 1U)) != 0) {
+			break;
+		}
+
+		slot = (timer_now >> TIMER_SHIFT(level)) & TIMER_SLOT_MASK;
+		timer = timer_wheel[level][slot];
+		timer_wheel[level][slot] = NULL;
+		timer_map[level] &= ~(1UL << slot);
+
+		while (timer != NULL) {
+			Timer_t *next = timer->next;
+
+			Timer_Link(timer);
+			timer = next;
+		}
+	}
+}
+
+/*
+ *
+ * @brief 	Computes the next tick the timer task has work at, from the
+ * 			nearest non empty slot of each level
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Timer_UpdateNext(void)
+{
+	uint32_t best = 0;
+	uint8_t found = 0;
+	uint32_t level;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		uint32_t base;
+		uint32_t dist;
+		uint32_t wake;
+
+		if (timer_map[level] == 0) {
+			continue;
+		}
+
+		// Slots after the current one, which comes last: full turn
+		base = timer_now >> TIMER_SHIFT(level);
+		dist = __CLZ(__RBIT(__ROR(timer_map[level], (base + 1U) & TIMER_SLOT_MASK))) + 1U;
+		wake = (base + dist) << TIMER_SHIFT(level);
+
+		if (!found || ((wake - timer_now) < (best - timer_now))) {
+			best = wake;
+			found = 1;
+		}
+	}
+
+	__disable_irq();
+	timer_next = best;
+	timer_armed = found;
+	__enable_irq();
+}
+
+/*
+ *
+ * @brief 	Timer task: processes the ticks counted since its last run,
+ * 			running the callbacks of the expired timers
+ * @param 	none
+ * @retval	none
+ *
+ */
+static void Timer_Process(void)
+{
+	while (timer_now != timer_ticks) {
+		Timer_t *timer;
+
+		timer_now++;
+		Timer_Cascade();
+
+		// Callbacks may start or stop any timer, this slot is taken again each time
+		while ((timer = timer_wheel[0][timer_now & TIMER_SLOT_MASK]) != NULL) {
+			Timer_Unlink(timer);
+
+			if (timer->period != 0) {
+				timer->expires += timer->period;
+				if ((int32_t)(timer->expires - timer_now) <= 0) {
+					timer->expires = timer_now + 1U;
+				}
+				Timer_Link(timer);
+			} else {
+				timer->running = 0;
+			}
+
+			timer->cb(timer->ctx);
+		}
+	}
+
+	Timer_UpdateNext();
+
+	// A tick due while updating
+	if (timer_armed && ((int32_t)(timer_ticks - timer_next) >= 0)) {
+		Sched_SetTask(SCHED_TASK_TIMER);
+	}
+}
+
+// Exported functions
+
+/*
+ *
+ * @brief 	Registers the timer task with the scheduler
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Timer_Init(void)
+{
+	Sched_RegTask(SCHED_TASK_TIMER, Timer_Process);
+}
+
+/*
+ *
+ * @brief 	Sets the callback of a timer, which is left stopped
+ * @param 	Timer_t* timer
+ * @param 	Timer_Callback_t callback, run from the timer task
+ * @param 	void* context passed to the callback
+ * @retval	none
+ *
+ */
+void Timer_Create(Timer_t *timer, Timer_Callback_t cb, void *ctx)
+{
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->period = 0;
+	timer->cb = cb;
+	timer->ctx = ctx;
+	timer->running = 0;
+}
+
+/*
+ *
+ * @brief 	Starts or restarts a timer
+ * @param 	Timer_t* timer
+ * @param 	uint32_t delay in ms to the first expiry
+ * @param 	uint32_t period in ms of the following ones, 0 for a one-shot timer
+ * @retval	none
+ *
+ */
+void Timer_Start(Timer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+	if (timer->running) {
+		Timer_Unlink(timer);
+	}
+
+	if (delay_ms == 0) {
+		delay_ms = 1;
+	}
+
+	// From the current time, the wheel may lag behind it
+	timer->expires = timer_ticks + delay_ms;
+	timer->period = period_ms;
+	timer->running = 1;
+	Timer_Link(timer);
+}
+
+/*
+ *
+ * @brief 	Stops a timer
+ * @param 	Timer_t* timer
+ * @retval	none
+ *
+ */
+void Timer_Stop(Timer_t *timer)
+{
+	if (timer->running) {
+		Timer_Unlink(timer);
+		timer->running = 0;
+	}
+}
+
+/*
+ *
+ * @brief 	Advances the time by 1 ms, from the SysTick handler
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Timer_Tick(void)
+{
+	uint32_t ticks = timer_ticks + 1U;
+
+	timer_ticks = ticks;
+	if (timer_armed && ((int32_t)(ticks - timer_next) >= 0)) {
+		Sched_SetTask(SCHED_TASK_TIMER);
+	}
+}
+
+/*
+ *
+ * @brief 	Advances the time by the ms spent without the SysTick
+ * @param 	uint32_t elapsed time in ms
+ * @retval	none
+ *
+ */
+void Timer_Advance(uint32_t ms)
+{
+	uint32_t ticks = timer_ticks + ms;
+
+	timer_ticks = ticks;
+	if (timer_armed && ((int32_t)(ticks - timer_next) >= 0)) {
+		Sched_SetTask(SCHED_TASK_TIMER);
+	}
+}
+
+/*
+ *
+ * @brief 	Time left to the next tick the timer task has work at
+ * @param 	none
+ * @retval	uint32_t time in ms, 0 if due, TIMER_IDLE_FOREVER if no timer runs
+ *
+ */
+uint32_t Timer_GetIdleTime(void)
+{
+	int32_t left;
+
+	if (!timer_armed) {
+		return TIMER_IDLE_FOREVER;
+	}
+
+	left = (int32_t)(timer_next - timer_ticks);
+
+	return (left > 0) ? (uint32_t)left : 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * timer_wheel.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef SRC_HAPTICGLOVEWRITE_TIMER_WHEEL_H_
+#define SRC_HAPTICGLOVEWRITE_TIMER_WHEEL_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported defines ----------------------------------------------------------*/
+#define TIMER_WHEEL_BITS		5U		// 32 slots per level
+#define TIMER_WHEEL_LEVELS		4U		// 1 ms, 32 ms, 1.024 s and 32.768 s slots
+#define TIMER_MAX_DELAY_MS		((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1U)	// About 17 min, longer delays are clamped
+#define TIMER_IDLE_FOREVER		0xFFFFFFFFUL
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*Timer_Callback_t)(void *ctx);
+
+/* Software timer. Allocated by the user, who must not touch the fields */
+typedef struct Timer_s {
+	struct Timer_s *next;
+	struct Timer_s *prev;
+	uint32_t expires;		// Tick of the next expiry
+	uint32_t period;		// 0 for a one-shot timer
+	Timer_Callback_t cb;
+	void *ctx;
+	uint8_t level;
+	uint8_t slot;
+	uint8_t running;
+} Timer_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/*
+ *
+ * @brief 	Registers the timer task with the scheduler
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Timer_Init(void);
+
+/*
+ *
+ * @brief 	Sets the callback of a timer, which is left stopped
+ * @param 	Timer_t* timer
+ * @param 	Timer_Callback_t callback, run from the timer task
+ * @param 	void* context passed to the callback
+ * @retval	none
+ *
+ */
+void Timer_Create(Timer_t *timer, Timer_Callback_t cb, void *ctx);
+
+/*
+ *
+ * @brief 	Starts or restarts a timer, in O(1). Not to be called from an interrupt
+ * @param 	Timer_t* timer
+ * @param 	uint32_t delay in ms to the first expiry
+ * @param 	uint32_t period in ms of the following ones, 0 for a one-shot timer
+ * @retval	none
+ *
+ */
+void Timer_Start(Timer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+
+/*
+ *
+ * @brief 	Stops a timer, in O(1). Not to be called from an interrupt
+ * @param 	Timer_t* timer
+ * @retval	none
+ *
+ */
+void Timer_Stop(Timer_t *timer);
+
+/*
+ *
+ * @brief 	Advances the time by 1 ms and requests the timer task when an
+ * 			expiry is due. Called from the SysTick handler
+ * @param 	none
+ * @retval	none
+ *
+ */
+void Timer_Tick(void);
+
+/*
+ *
+ * @brief 	Advances the time by the ms spent without the SysTick (tickless
+ * 			idle). Called with the interrupts masked
+ * @param 	uint32_t elapsed time in ms
+ * @retval	none
+ *
+ */
+void Timer_Advance(uint32_t ms);
+
+/*
+ *
+ * @brief 	Time left to the next tick the timer task has work at
+ * @param 	none
+ * @retval	uint32_t time in ms, 0 if due, TIMER_IDLE_FOREVER if no timer runs
+ *
+ */
+uint32_t Timer_GetIdleTime(void);
+
+#endif /* SRC_HAPTICGLOVEWRITE_TIMER_WHEEL_H_ */
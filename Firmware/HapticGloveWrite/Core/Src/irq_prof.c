@@ -0,0 +1,88 @@
+/*
+ * irq_prof.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Timing of the interrupt handlers with the DWT cycle counter. The handlers
+// of the radio transport do a bounded amount of work (no loop waits on the
+// bus, the packet copy runs in PendSV), so their longest runs measured here
+// give the worst case latency they add to the levels below them.
+
+// Includes
+#include "irq_prof.h"
+
+// Private defines
+#define IRQ_ENTRY_CYCLES	12U		// Exception entry (stacking) of the Cortex-M4
+
+_Static_assert(TICK_INT_PRIORITY == IRQ_PRIO_SYSTICK, "TICK_INT_PRIORITY does not follow the NVIC priority plan");
+
+// Variables
+IRQ_Prof_Stats_t irq_prof_stats[IRQ_PROF_NUM];
+
+static const uint8_t irq_prof_priority[IRQ_PROF_NUM] = {
+	[IRQ_PROF_HAPTIC_RENDER]	= IRQ_PRIO_HAPTIC_RENDER,
+	[IRQ_PROF_HCI_EXTI]		= IRQ_PRIO_HCI_TRANSPORT,
+	[IRQ_PROF_HCI_DMA_RX]	= IRQ_PRIO_HCI_TRANSPORT,
+	[IRQ_PROF_HCI_DMA_TX]	= IRQ_PRIO_HCI_TRANSPORT,
+	[IRQ_PROF_HCI_SPI]		= IRQ_PRIO_HCI_TRANSPORT,
+	[IRQ_PROF_HCI_UART]		= IRQ_PRIO_HCI_TRANSPORT,
+	[IRQ_PROF_HCI_DELIVER]	= IRQ_PRIO_HCI_DELIVER,
+	[IRQ_PROF_SYSTICK]		= IRQ_PRIO_SYSTICK,
+};
+
+/*
+ *
+ * @brief 	Enables the DWT cycle counter used to time the handlers
+ * @param 	none
+ * @retval	none
+ *
+ */
+void IRQ_Prof_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*
+ *
+ * @brief 	Copies the figures of one handler
+ * @param 	IRQ_Prof_Id_t handler
+ * @param 	IRQ_Prof_Stats_t* filled with the figures
+ * @retval	none
+ *
+ */
+void IRQ_Prof_Get(IRQ_Prof_Id_t id, IRQ_Prof_Stats_t *stats)
+{
+	__disable_irq();
+	*stats = irq_prof_stats[id];
+	__enable_irq();
+}
+
+/*
+ *
+ * @brief 	Worst case latency of an interrupt at a given priority
+ * @param 	uint32_t preemption priority (IRQ_PRIO_*)
+ * @retval	uint32_t bound in core cycles
+ *
+ */
+uint32_t IRQ_Prof_Bound(uint32_t priority)
+{
+	uint32_t above = 0;
+	uint32_t same = 0;
+	uint8_t id;
+
+	for (id = 0; id < IRQ_PROF_NUM; id++) {
+		uint32_t cycles = irq_prof_stats[id].max_cycles;
+
+		if (irq_prof_priority[id] < priority) {
+			above += cycles + IRQ_ENTRY_CYCLES;
+		} else if ((irq_prof_priority[id] == priority) && (cycles > same)) {
+			same = cycles;
+		}
+	}
+
+	return IRQ_ENTRY_CYCLES + same + above;
+}
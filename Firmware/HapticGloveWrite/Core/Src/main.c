@@ -22,7 +22,16 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include <stdio.h>
+#include "irq_prof.h"
+#if (HCI_CAPTURE_ENABLED == 1)
+#include "hci_capture.h"
+#endif
 #include "HapticGloveWrite/bluenrg_init.h"
+#include "HapticGloveWrite/motor_control.h"
+#include "HapticGloveWrite/scheduler.h"
+#include "HapticGloveWrite/timer_wheel.h"
+#include "HapticGloveWrite/low_power.h"
+#include "HapticGloveWrite/clock_profile.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -106,6 +115,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  IRQ_Prof_Init();
 
   /* USER CODE END SysInit */
 
@@ -133,7 +143,12 @@ int main(void)
   HAL_TIM_Base_Start_IT(&htim16);
   HAL_TIM_PWM_Start(&htim16, TIM_CHANNEL_1);
 
+  Timer_Init();
+  LowPower_Init();
+  Motor_Init();
+
   MX_BlueNRG_2_Init();
+  Clock_Init();
 
 
   /* USER CODE END 2 */
@@ -149,7 +164,8 @@ int main(void)
 	  //HAL_Delay(200);
 
 
-	  MX_BlueNRG_2_Process();
+	  // Runs the requested tasks, sleeps when there are none
+	  Sched_Run();
   }
   /* USER CODE END 3 */
 }
@@ -515,10 +531,10 @@ static void MX_GPIO_Init(void)
   HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   /* EXTI interrupt init*/
-  HAL_NVIC_SetPriority(EXTI3_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(EXTI3_IRQn, 5, 0);
   HAL_NVIC_EnableIRQ(EXTI3_IRQn);
 
-  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 7, 0);
   HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
 
 /* USER CODE BEGIN MX_GPIO_Init_2 */
@@ -527,7 +543,12 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 int __io_putchar(int ch) {
+#if (HCI_CAPTURE_ENABLED == 1)
+	// LPUART1 streams the HCI capture: the console output goes along with it
+	hci_capture_putchar((uint8_t)ch);
+#else
 	HAL_UART_Transmit(&hlpuart1, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
+#endif
 	return(ch);
 }
 
@@ -22,6 +22,13 @@
 #include "stm32l4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "irq_prof.h"
+#include "HapticGloveWrite/motor_control.h"
+#include "HapticGloveWrite/timer_wheel.h"
+#include "HapticGloveWrite/low_power.h"
+#if (HCI_CAPTURE_ENABLED == 1)
+#include "hci_capture.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,6 +64,10 @@
 /* External variables --------------------------------------------------------*/
 
 /* USER CODE BEGIN EV */
+extern SPI_HandleTypeDef hspi1;
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+extern UART_HandleTypeDef huart3;
 
 /* USER CODE END EV */
 
@@ -170,10 +181,11 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  uint32_t prof = IRQ_Prof_Enter();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
-
+  hci_tl_lowlevel_deliver();
+  IRQ_Prof_Exit(IRQ_PROF_HCI_DELIVER, prof);
   /* USER CODE END PendSV_IRQn 1 */
 }
 
@@ -183,11 +195,13 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  uint32_t prof = IRQ_Prof_Enter();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  hci_tl_lowlevel_tick();
+  Timer_Tick();
+  IRQ_Prof_Exit(IRQ_PROF_SYSTICK, prof);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -204,11 +218,11 @@ void SysTick_Handler(void)
 void EXTI3_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI3_IRQn 0 */
-
+  uint32_t prof = IRQ_Prof_Enter();
   /* USER CODE END EXTI3_IRQn 0 */
   HAL_EXTI_IRQHandler(&H_EXTI_3);
   /* USER CODE BEGIN EXTI3_IRQn 1 */
-
+  IRQ_Prof_Exit(IRQ_PROF_HCI_EXTI, prof);
   /* USER CODE END EXTI3_IRQn 1 */
 }
 
@@ -228,4 +242,117 @@ void EXTI15_10_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles TIM6 global interrupt: haptic render tick.
+  */
+void TIM6_DAC_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  Motor_RenderIsr();
+  IRQ_Prof_Exit(IRQ_PROF_HAPTIC_RENDER, prof);
+}
+
+/**
+  * @brief This function handles LPTIM1 global interrupt: tickless idle wake-up.
+  */
+void LPTIM1_IRQHandler(void)
+{
+  LowPower_LptimIsr();
+}
+
+#if (HCI_TL_TRANSPORT == HCI_TL_TRANSPORT_UART)
+
+/**
+  * @brief This function handles DMA1 channel2 global interrupt (USART3_TX).
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_usart3_tx);
+  IRQ_Prof_Exit(IRQ_PROF_HCI_DMA_TX, prof);
+}
+
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (USART3_RX).
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_usart3_rx);
+  IRQ_Prof_Exit(IRQ_PROF_HCI_DMA_RX, prof);
+}
+
+/**
+  * @brief This function handles USART3 global interrupt.
+  */
+void USART3_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_UART_IRQHandler(&huart3);
+  hci_tl_lowlevel_isr();
+  IRQ_Prof_Exit(IRQ_PROF_HCI_UART, prof);
+}
+
+#else
+
+/**
+  * @brief This function handles DMA1 channel2 global interrupt (SPI1_RX).
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_spi1_rx);
+  IRQ_Prof_Exit(IRQ_PROF_HCI_DMA_RX, prof);
+}
+
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (SPI1_TX).
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+  IRQ_Prof_Exit(IRQ_PROF_HCI_DMA_TX, prof);
+}
+
+/**
+  * @brief This function handles SPI1 global interrupt.
+  */
+void SPI1_IRQHandler(void)
+{
+  uint32_t prof = IRQ_Prof_Enter();
+
+  HAL_SPI_IRQHandler(&hspi1);
+  IRQ_Prof_Exit(IRQ_PROF_HCI_SPI, prof);
+}
+
+#endif /* HCI_TL_TRANSPORT */
+
+#if (HCI_CAPTURE_ENABLED == 1)
+
+/**
+  * @brief This function handles DMA2 channel6 global interrupt (LPUART1_TX).
+  */
+void DMA2_Channel6_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_lpuart1_tx);
+}
+
+/**
+  * @brief This function handles LPUART1 global interrupt.
+  */
+void LPUART1_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&hlpuart1);
+  hci_capture_isr();
+}
+
+#endif /* HCI_CAPTURE_ENABLED */
+
 /* USER CODE END 1 */
@@ -5,13 +5,19 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
-../BlueNRG-2/Target/hci_tl_interface.c 
+../BlueNRG-2/Target/hci_capture.c \
+../BlueNRG-2/Target/hci_tl_interface.c \
+../BlueNRG-2/Target/hci_tl_interface_uart.c 
 
 OBJS += \
-./BlueNRG-2/Target/hci_tl_interface.o 
+./BlueNRG-2/Target/hci_capture.o \
+./BlueNRG-2/Target/hci_tl_interface.o \
+./BlueNRG-2/Target/hci_tl_interface_uart.o 
 
 C_DEPS += \
-./BlueNRG-2/Target/hci_tl_interface.d 
+./BlueNRG-2/Target/hci_capture.d \
+./BlueNRG-2/Target/hci_tl_interface.d \
+./BlueNRG-2/Target/hci_tl_interface_uart.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -21,7 +27,7 @@ BlueNRG-2/Target/%.o BlueNRG-2/Target/%.su BlueNRG-2/Target/%.cyclo: ../BlueNRG-
 clean: clean-BlueNRG-2d-2-2f-Target
 
 clean-BlueNRG-2d-2-2f-Target:
-	-$(RM) ./BlueNRG-2/Target/hci_tl_interface.cyclo ./BlueNRG-2/Target/hci_tl_interface.d ./BlueNRG-2/Target/hci_tl_interface.o ./BlueNRG-2/Target/hci_tl_interface.su
+	-$(RM) ./BlueNRG-2/Target/hci_capture.cyclo ./BlueNRG-2/Target/hci_capture.d ./BlueNRG-2/Target/hci_capture.o ./BlueNRG-2/Target/hci_capture.su ./BlueNRG-2/Target/hci_tl_interface.cyclo ./BlueNRG-2/Target/hci_tl_interface.d ./BlueNRG-2/Target/hci_tl_interface.o ./BlueNRG-2/Target/hci_tl_interface.su ./BlueNRG-2/Target/hci_tl_interface_uart.cyclo ./BlueNRG-2/Target/hci_tl_interface_uart.d ./BlueNRG-2/Target/hci_tl_interface_uart.o ./BlueNRG-2/Target/hci_tl_interface_uart.su
 
 .PHONY: clean-BlueNRG-2d-2-2f-Target
 
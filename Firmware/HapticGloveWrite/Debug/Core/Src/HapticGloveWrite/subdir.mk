@@ -6,21 +6,63 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../Core/Src/HapticGloveWrite/bluenrg_init.c \
+../Core/Src/HapticGloveWrite/clock_profile.c \
+../Core/Src/HapticGloveWrite/depth_tile.c \
+../Core/Src/HapticGloveWrite/event_dispatch.c \
 ../Core/Src/HapticGloveWrite/gatt_db.c \
+../Core/Src/HapticGloveWrite/haptic_filter.c \
+../Core/Src/HapticGloveWrite/haptic_predict.c \
+../Core/Src/HapticGloveWrite/haptic_render.c \
+../Core/Src/HapticGloveWrite/haptic_saliency.c \
+../Core/Src/HapticGloveWrite/link_policy.c \
+../Core/Src/HapticGloveWrite/low_power.c \
 ../Core/Src/HapticGloveWrite/motor_control.c \
-../Core/Src/HapticGloveWrite/sensor.c 
+../Core/Src/HapticGloveWrite/notify_queue.c \
+../Core/Src/HapticGloveWrite/reconnect.c \
+../Core/Src/HapticGloveWrite/scheduler.c \
+../Core/Src/HapticGloveWrite/sensor.c \
+../Core/Src/HapticGloveWrite/telemetry.c \
+../Core/Src/HapticGloveWrite/timer_wheel.c 
 
 OBJS += \
 ./Core/Src/HapticGloveWrite/bluenrg_init.o \
+./Core/Src/HapticGloveWrite/clock_profile.o \
+./Core/Src/HapticGloveWrite/depth_tile.o \
+./Core/Src/HapticGloveWrite/event_dispatch.o \
 ./Core/Src/HapticGloveWrite/gatt_db.o \
+./Core/Src/HapticGloveWrite/haptic_filter.o \
+./Core/Src/HapticGloveWrite/haptic_predict.o \
+./Core/Src/HapticGloveWrite/haptic_render.o \
+./Core/Src/HapticGloveWrite/haptic_saliency.o \
+./Core/Src/HapticGloveWrite/link_policy.o \
+./Core/Src/HapticGloveWrite/low_power.o \
 ./Core/Src/HapticGloveWrite/motor_control.o \
-./Core/Src/HapticGloveWrite/sensor.o 
+./Core/Src/HapticGloveWrite/notify_queue.o \
+./Core/Src/HapticGloveWrite/reconnect.o \
+./Core/Src/HapticGloveWrite/scheduler.o \
+./Core/Src/HapticGloveWrite/sensor.o \
+./Core/Src/HapticGloveWrite/telemetry.o \
+./Core/Src/HapticGloveWrite/timer_wheel.o 
 
 C_DEPS += \
 ./Core/Src/HapticGloveWrite/bluenrg_init.d \
+./Core/Src/HapticGloveWrite/clock_profile.d \
+./Core/Src/HapticGloveWrite/depth_tile.d \
+./Core/Src/HapticGloveWrite/event_dispatch.d \
 ./Core/Src/HapticGloveWrite/gatt_db.d \
+./Core/Src/HapticGloveWrite/haptic_filter.d \
+./Core/Src/HapticGloveWrite/haptic_predict.d \
+./Core/Src/HapticGloveWrite/haptic_render.d \
+./Core/Src/HapticGloveWrite/haptic_saliency.d \
+./Core/Src/HapticGloveWrite/link_policy.d \
+./Core/Src/HapticGloveWrite/low_power.d \
 ./Core/Src/HapticGloveWrite/motor_control.d \
-./Core/Src/HapticGloveWrite/sensor.d 
+./Core/Src/HapticGloveWrite/notify_queue.d \
+./Core/Src/HapticGloveWrite/reconnect.d \
+./Core/Src/HapticGloveWrite/scheduler.d \
+./Core/Src/HapticGloveWrite/sensor.d \
+./Core/Src/HapticGloveWrite/telemetry.d \
+./Core/Src/HapticGloveWrite/timer_wheel.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -30,7 +72,7 @@ Core/Src/HapticGloveWrite/%.o Core/Src/HapticGloveWrite/%.su Core/Src/HapticGlov
 clean: clean-Core-2f-Src-2f-HapticGloveWrite
 
 clean-Core-2f-Src-2f-HapticGloveWrite:
-	-$(RM) ./Core/Src/HapticGloveWrite/bluenrg_init.cyclo ./Core/Src/HapticGloveWrite/bluenrg_init.d ./Core/Src/HapticGloveWrite/bluenrg_init.o ./Core/Src/HapticGloveWrite/bluenrg_init.su ./Core/Src/HapticGloveWrite/gatt_db.cyclo ./Core/Src/HapticGloveWrite/gatt_db.d ./Core/Src/HapticGloveWrite/gatt_db.o ./Core/Src/HapticGloveWrite/gatt_db.su ./Core/Src/HapticGloveWrite/motor_control.cyclo ./Core/Src/HapticGloveWrite/motor_control.d ./Core/Src/HapticGloveWrite/motor_control.o ./Core/Src/HapticGloveWrite/motor_control.su ./Core/Src/HapticGloveWrite/sensor.cyclo ./Core/Src/HapticGloveWrite/sensor.d ./Core/Src/HapticGloveWrite/sensor.o ./Core/Src/HapticGloveWrite/sensor.su
+	-$(RM) ./Core/Src/HapticGloveWrite/bluenrg_init.cyclo ./Core/Src/HapticGloveWrite/bluenrg_init.d ./Core/Src/HapticGloveWrite/bluenrg_init.o ./Core/Src/HapticGloveWrite/bluenrg_init.su ./Core/Src/HapticGloveWrite/clock_profile.cyclo ./Core/Src/HapticGloveWrite/clock_profile.d ./Core/Src/HapticGloveWrite/clock_profile.o ./Core/Src/HapticGloveWrite/clock_profile.su ./Core/Src/HapticGloveWrite/depth_tile.cyclo ./Core/Src/HapticGloveWrite/depth_tile.d ./Core/Src/HapticGloveWrite/depth_tile.o ./Core/Src/HapticGloveWrite/depth_tile.su ./Core/Src/HapticGloveWrite/event_dispatch.cyclo ./Core/Src/HapticGloveWrite/event_dispatch.d ./Core/Src/HapticGloveWrite/event_dispatch.o ./Core/Src/HapticGloveWrite/event_dispatch.su ./Core/Src/HapticGloveWrite/gatt_db.cyclo ./Core/Src/HapticGloveWrite/gatt_db.d ./Core/Src/HapticGloveWrite/gatt_db.o ./Core/Src/HapticGloveWrite/gatt_db.su ./Core/Src/HapticGloveWrite/haptic_filter.cyclo ./Core/Src/HapticGloveWrite/haptic_filter.d ./Core/Src/HapticGloveWrite/haptic_filter.o ./Core/Src/HapticGloveWrite/haptic_filter.su ./Core/Src/HapticGloveWrite/haptic_predict.cyclo ./Core/Src/HapticGloveWrite/haptic_predict.d ./Core/Src/HapticGloveWrite/haptic_predict.o ./Core/Src/HapticGloveWrite/haptic_predict.su ./Core/Src/HapticGloveWrite/haptic_render.cyclo ./Core/Src/HapticGloveWrite/haptic_render.d ./Core/Src/HapticGloveWrite/haptic_render.o ./Core/Src/HapticGloveWrite/haptic_render.su ./Core/Src/HapticGloveWrite/haptic_saliency.cyclo ./Core/Src/HapticGloveWrite/haptic_saliency.d ./Core/Src/HapticGloveWrite/haptic_saliency.o ./Core/Src/HapticGloveWrite/haptic_saliency.su ./Core/Src/HapticGloveWrite/link_policy.cyclo ./Core/Src/HapticGloveWrite/link_policy.d ./Core/Src/HapticGloveWrite/link_policy.o ./Core/Src/HapticGloveWrite/link_policy.su ./Core/Src/HapticGloveWrite/low_power.cyclo ./Core/Src/HapticGloveWrite/low_power.d ./Core/Src/HapticGloveWrite/low_power.o ./Core/Src/HapticGloveWrite/low_power.su ./Core/Src/HapticGloveWrite/motor_control.cyclo ./Core/Src/HapticGloveWrite/motor_control.d ./Core/Src/HapticGloveWrite/motor_control.o ./Core/Src/HapticGloveWrite/motor_control.su ./Core/Src/HapticGloveWrite/notify_queue.cyclo ./Core/Src/HapticGloveWrite/notify_queue.d ./Core/Src/HapticGloveWrite/notify_queue.o ./Core/Src/HapticGloveWrite/notify_queue.su ./Core/Src/HapticGloveWrite/reconnect.cyclo ./Core/Src/HapticGloveWrite/reconnect.d ./Core/Src/HapticGloveWrite/reconnect.o ./Core/Src/HapticGloveWrite/reconnect.su ./Core/Src/HapticGloveWrite/scheduler.cyclo ./Core/Src/HapticGloveWrite/scheduler.d ./Core/Src/HapticGloveWrite/scheduler.o ./Core/Src/HapticGloveWrite/scheduler.su ./Core/Src/HapticGloveWrite/sensor.cyclo ./Core/Src/HapticGloveWrite/sensor.d ./Core/Src/HapticGloveWrite/sensor.o ./Core/Src/HapticGloveWrite/sensor.su ./Core/Src/HapticGloveWrite/telemetry.cyclo ./Core/Src/HapticGloveWrite/telemetry.d ./Core/Src/HapticGloveWrite/telemetry.o ./Core/Src/HapticGloveWrite/telemetry.su ./Core/Src/HapticGloveWrite/timer_wheel.cyclo ./Core/Src/HapticGloveWrite/timer_wheel.d ./Core/Src/HapticGloveWrite/timer_wheel.o ./Core/Src/HapticGloveWrite/timer_wheel.su
 
 .PHONY: clean-Core-2f-Src-2f-HapticGloveWrite
 
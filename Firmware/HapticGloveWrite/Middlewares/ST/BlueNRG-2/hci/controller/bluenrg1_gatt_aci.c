@@ -325,6 +325,42 @@ tBleStatus aci_gatt_update_char_value(uint16_t Service_Handle,
   }
   return BLE_STATUS_SUCCESS;
 }
+tBleStatus aci_gatt_update_char_value_nocopy(uint16_t Service_Handle,
+                                             uint16_t Char_Handle,
+                                             uint8_t Val_Offset,
+                                             uint8_t Char_Value_Length,
+                                             const uint8_t Char_Value[])
+{
+  struct hci_request rq;
+  uint8_t cmd_buffer[6];
+  aci_gatt_update_char_value_cp0 *cp0 = (aci_gatt_update_char_value_cp0*)(cmd_buffer);
+  tBleStatus status = 0;
+  uint8_t index_input = 0;
+  cp0->Service_Handle = htob(Service_Handle, 2);
+  index_input += 2;
+  cp0->Char_Handle = htob(Char_Handle, 2);
+  index_input += 2;
+  cp0->Val_Offset = htob(Val_Offset, 1);
+  index_input += 1;
+  cp0->Char_Value_Length = htob(Char_Value_Length, 1);
+  index_input += 1;
+  BLUENRG_memset(&rq, 0, sizeof(rq));
+  rq.ogf = 0x3f;
+  rq.ocf = 0x106;
+  rq.cparam = cmd_buffer;
+  rq.clen = index_input;
+  /* var_len_data input: sent from the caller buffer */
+  rq.cdata = Char_Value;
+  rq.cdlen = Char_Value_Length*sizeof(uint8_t);
+  rq.rparam = &status;
+  rq.rlen = 1;
+  if (hci_send_req(&rq, FALSE) < 0)
+    return BLE_STATUS_TIMEOUT;
+  if (status) {
+    return status;
+  }
+  return BLE_STATUS_SUCCESS;
+}
 tBleStatus aci_gatt_del_char(uint16_t Serv_Handle,
                              uint16_t Char_Handle)
 {
@@ -1566,6 +1602,51 @@ tBleStatus aci_gatt_update_char_value_ext(uint16_t Conn_Handle_To_Notify,
   }
   return BLE_STATUS_SUCCESS;
 }
+tBleStatus aci_gatt_update_char_value_ext_nocopy(uint16_t Conn_Handle_To_Notify,
+                                                 uint16_t Service_Handle,
+                                                 uint16_t Char_Handle,
+                                                 uint8_t Update_Type,
+                                                 uint16_t Char_Length,
+                                                 uint16_t Value_Offset,
+                                                 uint8_t Value_Length,
+                                                 const uint8_t Value[])
+{
+  struct hci_request rq;
+  uint8_t cmd_buffer[12];
+  aci_gatt_update_char_value_ext_cp0 *cp0 = (aci_gatt_update_char_value_ext_cp0*)(cmd_buffer);
+  tBleStatus status = 0;
+  uint8_t index_input = 0;
+  cp0->Conn_Handle_To_Notify = htob(Conn_Handle_To_Notify, 2);
+  index_input += 2;
+  cp0->Service_Handle = htob(Service_Handle, 2);
+  index_input += 2;
+  cp0->Char_Handle = htob(Char_Handle, 2);
+  index_input += 2;
+  cp0->Update_Type = htob(Update_Type, 1);
+  index_input += 1;
+  cp0->Char_Length = htob(Char_Length, 2);
+  index_input += 2;
+  cp0->Value_Offset = htob(Value_Offset, 2);
+  index_input += 2;
+  cp0->Value_Length = htob(Value_Length, 1);
+  index_input += 1;
+  BLUENRG_memset(&rq, 0, sizeof(rq));
+  rq.ogf = 0x3f;
+  rq.ocf = 0x12c;
+  rq.cparam = cmd_buffer;
+  rq.clen = index_input;
+  /* var_len_data input: sent from the caller buffer */
+  rq.cdata = Value;
+  rq.cdlen = Value_Length*sizeof(uint8_t);
+  rq.rparam = &status;
+  rq.rlen = 1;
+  if (hci_send_req(&rq, FALSE) < 0)
+    return BLE_STATUS_TIMEOUT;
+  if (status) {
+    return status;
+  }
+  return BLE_STATUS_SUCCESS;
+}
 tBleStatus aci_gatt_deny_read(uint16_t Connection_Handle,
                               uint8_t Error_Code)
 {
@@ -19,6 +19,9 @@
 #include "hci_const.h"
 #include "hci.h"
 #include "hci_tl.h"
+#if (HCI_CAPTURE_ENABLED == 1)
+#include "hci_capture.h"
+#endif
 
 #define HCI_LOG_ON                      0
 #define HCI_PCK_TYPE_OFFSET             0
@@ -29,7 +32,72 @@
  * or high number of incoming notifications from peripheral devices 
  */
 #ifndef HCI_READ_PACKET_NUM_MAX
-  #define HCI_READ_PACKET_NUM_MAX 	   (5)
+  #define HCI_READ_PACKET_NUM_MAX 	   (8)
+#endif
+
+/* The read ring indexes are free running and masked: the capacity must be a power of two */
+#if ((HCI_READ_PACKET_NUM_MAX & (HCI_READ_PACKET_NUM_MAX - 1)) != 0)
+  #error "HCI_READ_PACKET_NUM_MAX must be a power of two"
+#endif
+#define HCI_READ_PACKET_MASK    (HCI_READ_PACKET_NUM_MAX - 1)
+#define HCI_NO_SLOT             (-1)
+
+/**
+ * Read slots kept free for the answers to commands, and on top of them for
+ * attribute-modified events (GATT writes): ordinary events are only admitted
+ * while more than HCI_READ_PACKET_RSV_CMD + HCI_READ_PACKET_RSV_PRIO slots
+ * are free. A packet that is not admitted stays in the transport, which
+ * retries it, so the BlueNRG keeps the following events queued meanwhile.
+ */
+#ifndef HCI_READ_PACKET_RSV_CMD
+  #define HCI_READ_PACKET_RSV_CMD      (1)
+#endif
+#ifndef HCI_READ_PACKET_RSV_PRIO
+  #define HCI_READ_PACKET_RSV_PRIO     (2)
+#endif
+
+/**
+ * Number of attributes whose writes are never coalesced, see
+ * hci_rx_no_coalesce().
+ */
+#ifndef HCI_RX_NO_COALESCE_NUM_MAX
+  #define HCI_RX_NO_COALESCE_NUM_MAX   (4)
+#endif
+
+#if ((HCI_READ_PACKET_RSV_CMD + HCI_READ_PACKET_RSV_PRIO) >= HCI_READ_PACKET_NUM_MAX)
+  #error "HCI_READ_PACKET_RSV_CMD + HCI_READ_PACKET_RSV_PRIO must leave room for other events"
+#endif
+
+/* Packet classes, by admission priority */
+#define HCI_PKT_CLASS_NORMAL    0
+#define HCI_PKT_CLASS_PRIO      1 /* aci_gatt_attribute_modified_event */
+#define HCI_PKT_CLASS_CMD       2 /* Command Complete/Status */
+
+/* Raw offsets in a read packet */
+#define EVENT_CODE_OFFSET               1
+#define EVENT_PARAMETERS_OFFSET         (1 + HCI_EVENT_HDR_SIZE)
+#define VENDOR_ECODE_OFFSET             EVENT_PARAMETERS_OFFSET
+#define VENDOR_PARAMETERS_OFFSET        (VENDOR_ECODE_OFFSET + 2)
+
+#define ACI_BLUE_EVENTS_LOST_ECODE      0x0002
+#define ACI_GATT_ATTR_MODIFIED_ECODE    0x0c01
+
+/* aci_gatt_attribute_modified_event: Connection_Handle, Attr_Handle, Offset, Attr_Data_Length */
+#define ATTR_MODIFIED_CONN_OFFSET       (VENDOR_PARAMETERS_OFFSET)
+#define ATTR_MODIFIED_HANDLE_OFFSET     (VENDOR_PARAMETERS_OFFSET + 2)
+#define ATTR_MODIFIED_OFFSET_OFFSET     (VENDOR_PARAMETERS_OFFSET + 4)
+#define ATTR_MODIFIED_LENGTH_OFFSET     (VENDOR_PARAMETERS_OFFSET + 6)
+#define ATTR_MODIFIED_HDR_END           (VENDOR_PARAMETERS_OFFSET + 8)
+
+#define LE16(p)                         ((uint16_t)((p)[0] | ((uint16_t)(p)[1] << 8)))
+
+/**
+ * Number of asynchronous commands that can be queued or in flight at the same time.
+ * How many of them are actually handed to the controller is bounded by the
+ * Num_HCI_Command_Packets credits it reports in Command Complete/Status events.
+ */
+#ifndef HCI_PENDING_CMD_NUM_MAX
+  #define HCI_PENDING_CMD_NUM_MAX      (4)
 #endif
 
 #ifndef MIN
@@ -39,10 +107,56 @@
   #define MAX(a,b)      ((a) > (b))? (a) : (b)
 #endif
 
-tListNode             hciReadPktPool;
-tListNode             hciReadPktRxQueue;
-static tHciDataPacket hciReadPacketBuffer[HCI_READ_PACKET_NUM_MAX];
+#ifndef HCI_CMD_RETRY_MS
+  #define HCI_CMD_RETRY_MS             (5) /* Retry of a command the busy transport refused */
+#endif
+
+/* Pending asynchronous command states */
+#define HCI_CMD_FREE            0 /* Slot unused */
+#define HCI_CMD_QUEUED          1 /* Waiting for a controller credit */
+#define HCI_CMD_ISSUED          2 /* Sent, waiting for Command Complete/Status */
+
+typedef struct
+{
+  uint8_t           state;
+  uint8_t           event;
+  uint8_t           plen;
+  uint8_t           dlen;
+  uint16_t          ogf;
+  uint16_t          ocf;
+  uint16_t          opcode;
+  uint32_t          seq;
+  uint32_t          tickstart;
+  hci_cmd_cplt_cb_t cb;
+  void             *ctx;
+  const void       *data;  /* Caller-owned parameters sent in place */
+  uint8_t           param[HCI_CMD_PARAM_SIZE_MAX];
+} tHciPendingCmd;
+
+/* Single producer (hci_notify_asynch_evt, interrupt context) / single consumer
+   (main context) ring of read packets. hciRxHead is only written by the producer,
+   hciRxTail and hciRxHeldSlot only by the consumer. */
+static tHciDataPacket    hciReadPacketBuffer[HCI_READ_PACKET_NUM_MAX];
+static volatile uint32_t hciRxHead;
+static volatile uint32_t hciRxTail;
+static volatile int32_t  hciRxHeldSlot = HCI_NO_SLOT; /* Slot dispatched by hci_user_evt_proc */
+static uint32_t          hciRxHighWatermark;
+static volatile uint8_t  hciRxStalledClass;  /* Class refused by the producer, if hciRxStalled */
+static volatile uint8_t  hciRxStalled;
+static tHciRxQueueStats  hciRxStats;
+static uint16_t          hciRxNoCoalesce[HCI_RX_NO_COALESCE_NUM_MAX];
+static uint8_t           hciRxNoCoalesceNum;
 static tHciContext    hciContext;
+static tHciPendingCmd hciPendingCmd[HCI_PENDING_CMD_NUM_MAX];
+static uint32_t       hciPendingCmdSeq;
+
+/* Completion armed by hci_set_next_req_async() for the next hci_send_req() */
+static struct
+{
+  BOOL              armed;
+  hci_cmd_cplt_cb_t cb;
+  void             *ctx;
+} hciNextReq;
 
 /************************* Static internal functions **************************/
 
@@ -67,89 +181,526 @@ static int verify_packet(const tHciDataPacket * hciReadPacket)
 
 /**
   * @brief  Send an HCI command.
+  *         With a scatter-gather transport only the 4-byte packet header is
+  *         built here; the parameters are transmitted from where they are,
+  *         so they must stay valid until the command is answered.
   *
   * @param  ogf The Opcode Group Field
   * @param  ocf The Opcode Command Field
-  * @param  plen The HCI command length
   * @param  param The HCI command parameters
-  * @retval None
+  * @param  plen The HCI command parameters length
+  * @param  data Parameters appended to param, NULL if none
+  * @param  dlen Length of data
+  * @retval 0 when the command has been handed to the transport, -1 otherwise
   */
-static void send_cmd(uint16_t ogf, uint16_t ocf, uint8_t plen, void *param)
+static int send_cmd(uint16_t ogf, uint16_t ocf, const void *param, uint8_t plen, const void *data, uint8_t dlen)
 {
-  uint8_t payload[HCI_MAX_PAYLOAD_SIZE];  
+  uint8_t hdr[HCI_HDR_SIZE + HCI_COMMAND_HDR_SIZE];
   hci_command_hdr hc;
+  tHciIOVec iov[3];
+  uint8_t iovcnt = 1;
+  
+  if ((uint16_t)plen + dlen > 0xFF)
+  {
+    return -1;
+  }
   
   hc.opcode = htobs(cmd_opcode_pack(ogf, ocf));
-  hc.plen = plen;
+  hc.plen = plen + dlen;
 
-  payload[0] = HCI_COMMAND_PKT;
-  BLUENRG_memcpy(payload + 1, &hc, sizeof(hc));
-  BLUENRG_memcpy(payload + HCI_HDR_SIZE + HCI_COMMAND_HDR_SIZE, param, plen);
+  hdr[0] = HCI_COMMAND_PKT;
+  BLUENRG_memcpy(hdr + 1, &hc, sizeof(hc));
+  
+  iov[0].base = hdr;
+  iov[0].len  = sizeof(hdr);
+  if (plen > 0)
+  {
+    iov[iovcnt].base = param;
+    iov[iovcnt].len  = plen;
+    iovcnt++;
+  }
+  if (dlen > 0)
+  {
+    iov[iovcnt].base = data;
+    iov[iovcnt].len  = dlen;
+    iovcnt++;
+  }
+  
+  if (hciContext.io.SendV)
+  {
+    if (hciContext.io.SendV(iov, iovcnt) < 0)
+    {
+      return -1;
+    }
+#if (HCI_CAPTURE_ENABLED == 1)
+    hci_capture_packet(HCI_CAPTURE_FLAG_CMD_EVT, iov, iovcnt);
+#endif
+    return 0;
+  }
   
   if (hciContext.io.Send)
   {
-    hciContext.io.Send (payload, HCI_HDR_SIZE + HCI_COMMAND_HDR_SIZE + plen);
+    uint8_t payload[HCI_MAX_PAYLOAD_SIZE];
+    uint16_t len = 0;
+    uint8_t index;
+    
+    if (sizeof(hdr) + hc.plen > HCI_MAX_PAYLOAD_SIZE)
+    {
+      return -1;
+    }
+    
+    for (index = 0; index < iovcnt; index++)
+    {
+      BLUENRG_memcpy(payload + len, iov[index].base, iov[index].len);
+      len += iov[index].len;
+    }
+    
+    if (hciContext.io.Send (payload, len) < 0)
+    {
+      return -1;
+    }
+#if (HCI_CAPTURE_ENABLED == 1)
+    hci_capture_packet(HCI_CAPTURE_FLAG_CMD_EVT, iov, iovcnt);
+#endif
   }
+
+  return 0;
 }
 
 /**
-  * @brief  Remove the tail from a source list and insert it to the head 
-  *         of a destination list.
+  * @brief  Release the ring slots already consumed out of order, oldest first.
   *
-  * @param  dest_list
-  * @param  src_list
+  * @param  scan Ring index up to which the slots have been looked at
   * @retval None
   */
-static void move_list(tListNode * dest_list, tListNode * src_list)
+static void release_consumed_slots(uint32_t scan)
 {
-  pListNode tmp_node;
-  
-  while (!list_is_empty(src_list))
+  uint32_t tail = hciRxTail;
+
+  while ((tail != scan) && hciReadPacketBuffer[tail & HCI_READ_PACKET_MASK].consumed)
+  {
+    tail++;
+  }
+
+  /* Slot contents are no longer read once the producer sees the new tail */
+  __DMB();
+  hciRxTail = tail;
+}
+
+/**
+  * @brief  Get the admission class of a read packet.
+  *
+  * @param  hciReadPacket The HCI data packet
+  * @retval HCI_PKT_CLASS_CMD, HCI_PKT_CLASS_PRIO or HCI_PKT_CLASS_NORMAL
+  */
+static uint8_t classify_packet(const tHciDataPacket * hciReadPacket)
+{
+  const uint8_t *pckt = hciReadPacket->dataBuff;
+  uint8_t evt = pckt[EVENT_CODE_OFFSET];
+
+  if ((evt == EVT_CMD_COMPLETE) || (evt == EVT_CMD_STATUS))
+    return HCI_PKT_CLASS_CMD;
+
+  if ((evt == EVT_VENDOR) && (hciReadPacket->data_len >= ATTR_MODIFIED_HDR_END) &&
+      (LE16(&pckt[VENDOR_ECODE_OFFSET]) == ACI_GATT_ATTR_MODIFIED_ECODE))
+    return HCI_PKT_CLASS_PRIO;
+
+  return HCI_PKT_CLASS_NORMAL;
+}
+
+/**
+  * @brief  Check whether a packet of a given class can take one of the free slots.
+  *
+  * @param  pkt_class The packet class
+  * @param  free_slots Number of slots the producer can still fill
+  * @retval TRUE if admitted
+  */
+static BOOL admit_packet(uint8_t pkt_class, uint32_t free_slots)
+{
+  switch (pkt_class)
+  {
+  case HCI_PKT_CLASS_CMD:
+    return (free_slots > 0);
+  case HCI_PKT_CLASS_PRIO:
+    return (free_slots > HCI_READ_PACKET_RSV_CMD);
+  default:
+    return (free_slots > HCI_READ_PACKET_RSV_CMD + HCI_READ_PACKET_RSV_PRIO);
+  }
+}
+
+/**
+  * @brief  Number of slots the producer can fill, the held slot excluded.
+  *
+  * @param  head Producer index
+  * @retval Number of free slots
+  */
+static uint32_t free_slots(uint32_t head)
+{
+  uint32_t free_num = HCI_READ_PACKET_NUM_MAX - (head - hciRxTail);
+
+  if ((hciRxHeldSlot != HCI_NO_SLOT) && (free_num > 0))
+    free_num--;
+
+  return free_num;
+}
+
+/**
+  * @brief  Check whether an attribute-modified event is overwritten by a more
+  *         recent one still in the ring (same connection and attribute,
+  *         rewritten from offset 0 over at least the same bytes). Never for
+  *         the attributes registered with hci_rx_no_coalesce().
+  *
+  * @param  pos Ring index of the event
+  * @retval TRUE if a newer write supersedes it
+  */
+static BOOL is_superseded(uint32_t pos)
+{
+  const uint8_t *old = hciReadPacketBuffer[pos & HCI_READ_PACKET_MASK].dataBuff;
+  uint32_t old_end = LE16(&old[ATTR_MODIFIED_OFFSET_OFFSET]) + LE16(&old[ATTR_MODIFIED_LENGTH_OFFSET]);
+  uint32_t head = hciRxHead;
+  uint8_t index;
+
+  for (index = 0; index < hciRxNoCoalesceNum; index++)
+  {
+    if (hciRxNoCoalesce[index] == LE16(&old[ATTR_MODIFIED_HANDLE_OFFSET]))
+      return FALSE;
+  }
+
+  __DMB();
+  for (pos++; pos != head; pos++)
+  {
+    const tHciDataPacket *pkt = &hciReadPacketBuffer[pos & HCI_READ_PACKET_MASK];
+    const uint8_t *cur = pkt->dataBuff;
+
+    if (pkt->consumed || (pkt->pkt_class != HCI_PKT_CLASS_PRIO))
+      continue;
+
+    if ((LE16(&cur[ATTR_MODIFIED_CONN_OFFSET]) == LE16(&old[ATTR_MODIFIED_CONN_OFFSET])) &&
+        (LE16(&cur[ATTR_MODIFIED_HANDLE_OFFSET]) == LE16(&old[ATTR_MODIFIED_HANDLE_OFFSET])) &&
+        (LE16(&cur[ATTR_MODIFIED_OFFSET_OFFSET]) == 0) &&
+        (LE16(&cur[ATTR_MODIFIED_LENGTH_OFFSET]) >= old_end))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  * @brief  Make room for the packet the producer refused, while a blocking
+  *         request waits for its answer. Superseded writes go first, then the
+  *         oldest ordinary event; a pending write is only evicted when
+  *         nothing else is left.
+  *
+  * @param  scan Ring index up to which the slots have been looked at
+  * @retval None
+  */
+static void evict_packet(uint32_t scan)
+{
+  uint32_t victim_normal = scan;
+  uint32_t victim_prio = scan;
+  uint32_t pos;
+
+  for (pos = hciRxTail; pos != scan; pos++)
+  {
+    tHciDataPacket *pkt = &hciReadPacketBuffer[pos & HCI_READ_PACKET_MASK];
+
+    if (pkt->consumed)
+      continue;
+
+    if (pkt->pkt_class == HCI_PKT_CLASS_PRIO)
+    {
+      if (is_superseded(pos))
+      {
+        pkt->consumed = 1;
+        hciRxStats.superseded++;
+        release_consumed_slots(scan);
+        return;
+      }
+      if (victim_prio == scan)
+        victim_prio = pos;
+    }
+    else if (victim_normal == scan)
+    {
+      victim_normal = pos;
+    }
+  }
+
+  pos = (victim_normal != scan) ? victim_normal : victim_prio;
+  if (pos != scan)
   {
-    list_remove_tail(src_list, &tmp_node);
-    list_insert_head(dest_list, tmp_node);
+    hciReadPacketBuffer[pos & HCI_READ_PACKET_MASK].consumed = 1;
+    hciRxStats.dropped_evicted++;
+    release_consumed_slots(scan);
   }
 }
 
 /**
-  * @brief  Free the HCI event list.
+  * @brief  Account the events the controller reports it had to drop.
+  *
+  * @param  hciReadPacket The HCI data packet
+  * @retval None
+  */
+static void account_controller_lost(const tHciDataPacket * hciReadPacket)
+{
+  const uint8_t *pckt = hciReadPacket->dataBuff;
+  uint8_t index;
+
+  if ((pckt[EVENT_CODE_OFFSET] != EVT_VENDOR) ||
+      (hciReadPacket->data_len < VENDOR_PARAMETERS_OFFSET + sizeof(hciRxStats.controller_lost_events)) ||
+      (LE16(&pckt[VENDOR_ECODE_OFFSET]) != ACI_BLUE_EVENTS_LOST_ECODE))
+    return;
+
+  hciRxStats.controller_lost++;
+  for (index = 0; index < sizeof(hciRxStats.controller_lost_events); index++)
+  {
+    hciRxStats.controller_lost_events[index] |= pckt[VENDOR_PARAMETERS_OFFSET + index];
+  }
+}
+
+/**
+  * @brief  Get the oldest pending command in a given state.
+  *
+  * @param  state HCI_CMD_QUEUED or HCI_CMD_ISSUED
+  * @param  opcode Opcode to match, 0 to match any opcode
+  * @retval Pointer to the pending command, NULL if none
+  */
+static tHciPendingCmd * find_pending_cmd(uint8_t state, uint16_t opcode)
+{
+  tHciPendingCmd *oldest = NULL;
+  uint8_t index;
+
+  for (index = 0; index < HCI_PENDING_CMD_NUM_MAX; index++)
+  {
+    tHciPendingCmd *cmd = &hciPendingCmd[index];
+
+    if ((cmd->state != state) || ((opcode != 0) && (cmd->opcode != opcode)))
+      continue;
+
+    if ((oldest == NULL) || ((int32_t)(cmd->seq - oldest->seq) < 0))
+      oldest = cmd;
+  }
+
+  return oldest;
+}
+
+/**
+  * @brief  Release a pending command and run its completion callback.
+  *         The slot is freed first so that the callback can issue a new command.
+  *
+  * @param  cmd The pending command
+  * @param  status Command status
+  * @param  rparam Return parameters (valid only during the callback)
+  * @param  rlen Return parameters length
+  * @retval None
+  */
+static void complete_pending_cmd(tHciPendingCmd *cmd, uint8_t status, const uint8_t *rparam, uint8_t rlen)
+{
+  hci_cmd_cplt_cb_t cb = cmd->cb;
+  void *ctx = cmd->ctx;
+  uint16_t opcode = cmd_opcode_pack(cmd->ogf, cmd->ocf);
+
+  cmd->state = HCI_CMD_FREE;
+
+  if (cb != NULL)
+  {
+    cb(opcode, status, rparam, rlen, ctx);
+  }
+}
+
+/**
+  * @brief  Hand queued commands to the transport, oldest first, as long as the
+  *         controller has command credits left.
   *
   * @param  None
   * @retval None
   */
-static void free_event_list(void)
+static void issue_pending_cmds(void)
 {
-  tHciDataPacket * pckt;
+  tHciPendingCmd *cmd;
+
+  while (hciContext.cmd_credits > 0)
+  {
+    cmd = find_pending_cmd(HCI_CMD_QUEUED, 0);
+    if (cmd == NULL)
+      break;
+
+    /* Transport still busy with the previous frame: retry on the next pass */
+    if (send_cmd(cmd->ogf, cmd->ocf, cmd->param, cmd->plen, cmd->data, cmd->dlen) < 0)
+      break;
 
-  while(list_get_size(&hciReadPktPool) < HCI_READ_PACKET_NUM_MAX/2){
-    list_remove_head(&hciReadPktRxQueue, (tListNode **)&pckt);    
-    list_insert_tail(&hciReadPktPool, (tListNode *)pckt);
+    cmd->state = HCI_CMD_ISSUED;
+    cmd->tickstart = HAL_GetTick();
+    hciContext.cmd_credits--;
   }
 }
 
-/********************** HCI Transport layer functions *****************************/
+/**
+  * @brief  Complete the commands the controller did not answer in time.
+  *
+  * @param  None
+  * @retval None
+  */
+static void check_pending_timeouts(void)
+{
+  uint8_t index;
 
-void hci_init(void(* UserEvtRx)(void* pData), void* pConf)
+  for (index = 0; index < HCI_PENDING_CMD_NUM_MAX; index++)
+  {
+    tHciPendingCmd *cmd = &hciPendingCmd[index];
+
+    if ((cmd->state == HCI_CMD_ISSUED) && ((HAL_GetTick() - cmd->tickstart) > HCI_DEFAULT_TIMEOUT_MS))
+    {
+      /* The answer is lost: do not let the missing credit stall the queue */
+      if (hciContext.cmd_credits == 0)
+        hciContext.cmd_credits = 1;
+
+      complete_pending_cmd(cmd, BLE_STATUS_TIMEOUT, NULL, 0);
+    }
+  }
+}
+
+/**
+  * @brief  Tell the application when hci_user_evt_proc() must run next for the
+  *         pending commands: at the timeout of the oldest issued one, soon for
+  *         a queued one the busy transport refused, never when none is left.
+  *
+  * @param  None
+  * @retval None
+  */
+static void update_cmd_deadline(void)
 {
+  uint32_t now = HAL_GetTick();
+  uint32_t delay = 0;
+  uint32_t left, elapsed;
   uint8_t index;
 
+  for (index = 0; index < HCI_PENDING_CMD_NUM_MAX; index++)
+  {
+    const tHciPendingCmd *cmd = &hciPendingCmd[index];
+
+    if (cmd->state == HCI_CMD_ISSUED)
+    {
+      elapsed = now - cmd->tickstart;
+      left = (elapsed > HCI_DEFAULT_TIMEOUT_MS) ? 1 : (HCI_DEFAULT_TIMEOUT_MS - elapsed + 1);
+    }
+    else if ((cmd->state == HCI_CMD_QUEUED) && (hciContext.cmd_credits > 0))
+    {
+      left = HCI_CMD_RETRY_MS;
+    }
+    else
+    {
+      continue;
+    }
+
+    if ((delay == 0) || (left < delay))
+      delay = left;
+  }
+
+  hci_notify_cmd_deadline(delay);
+}
+
+/**
+  * @brief  Update the command credits from a Command Complete/Status event and
+  *         resolve the asynchronous command it refers to, if any.
+  *
+  * @param  hciReadPacket The HCI data packet
+  * @retval 1 if the event completed an asynchronous command, 0 otherwise
+  */
+static int resolve_pending_cmd(const tHciDataPacket * hciReadPacket)
+{
+  const uint8_t *ptr = hciReadPacket->dataBuff + (1 + HCI_EVENT_HDR_SIZE);
+  uint32_t len = hciReadPacket->data_len - (1 + HCI_EVENT_HDR_SIZE);
+  const hci_event_pckt *event_pckt = (const void *)(hciReadPacket->dataBuff + HCI_HDR_SIZE);
+  tHciPendingCmd *cmd;
+
+  if (hciReadPacket->dataBuff[HCI_PCK_TYPE_OFFSET] != HCI_EVENT_PKT)
+    return 0;
+
+  if ((event_pckt->evt == EVT_CMD_COMPLETE) && (len >= EVT_CMD_COMPLETE_SIZE))
+  {
+    const evt_cmd_complete *cc = (const void *)ptr;
+
+    hciContext.cmd_credits = cc->ncmd;
+
+    cmd = find_pending_cmd(HCI_CMD_ISSUED, cc->opcode);
+    if (cmd == NULL)
+      return 0;
+
+    ptr += EVT_CMD_COMPLETE_SIZE;
+    len -= EVT_CMD_COMPLETE_SIZE;
+    complete_pending_cmd(cmd, (len > 0) ? ptr[0] : BLE_STATUS_SUCCESS, ptr, len);
+    return 1;
+  }
+
+  if ((event_pckt->evt == EVT_CMD_STATUS) && (len >= EVT_CMD_STATUS_SIZE))
+  {
+    const evt_cmd_status *cs = (const void *)ptr;
+
+    hciContext.cmd_credits = cs->ncmd;
+
+    cmd = find_pending_cmd(HCI_CMD_ISSUED, cs->opcode);
+    if (cmd == NULL)
+      return 0;
+
+    /* Either the final answer (EVT_CMD_STATUS commands, or an error) or the
+       acknowledge of a command completed later by an event the application
+       receives through UserEvtRx */
+    complete_pending_cmd(cmd, cs->status, ptr, len);
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+  * @brief  Send a blocking request once the queued asynchronous commands
+  *         have been issued and the controller has a command credit.
+  *
+  * @param  r The HCI request
+  * @retval TRUE when the command has been handed to the transport
+  */
+static BOOL send_req_in_order(const struct hci_request* r)
+{
+  issue_pending_cmds();
+
+  if ((hciContext.cmd_credits == 0) || (find_pending_cmd(HCI_CMD_QUEUED, 0) != NULL))
+    return FALSE;
+
+  if (send_cmd(r->ogf, r->ocf, r->cparam, r->clen, r->cdata, r->cdlen) < 0)
+    return FALSE;
+
+  hciContext.cmd_credits--;
+  return TRUE;
+}
+
+/********************** HCI Transport layer functions *****************************/
+
+void hci_init(void(* UserEvtRx)(void* pData), void* pConf)
+{
   if(UserEvtRx != NULL)
   {
     hciContext.UserEvtRx = UserEvtRx;
   }
   
-  /* Initialize list heads of ready and free hci data packet queues */
-  list_init_head(&hciReadPktPool);
-  list_init_head(&hciReadPktRxQueue);
+  /* The controller accepts one command after reset */
+  hciContext.cmd_credits = 1;
+  BLUENRG_memset(hciPendingCmd, 0, sizeof(hciPendingCmd));
+  BLUENRG_memset(&hciNextReq, 0, sizeof(hciNextReq));
+
+  /* Empty the ring of read packets */
+  hciRxHead = 0;
+  hciRxTail = 0;
+  hciRxHeldSlot = HCI_NO_SLOT;
+  hciRxHighWatermark = 0;
+  hciRxStalled = 0;
+  BLUENRG_memset(&hciRxStats, 0, sizeof(hciRxStats));
+
+#if (HCI_CAPTURE_ENABLED == 1)
+  hci_capture_init();
+#endif
 
   /* Initialize TL BLE layer */
   hci_tl_lowlevel_init();
-
-  /* Initialize the queue of free hci data packets */
-  for (index = 0; index < HCI_READ_PACKET_NUM_MAX; index++)
-  {
-    list_insert_tail(&hciReadPktPool, (tListNode *)&hciReadPacketBuffer[index]);
-  } 
   
   /* Initialize low level driver */
   if (hciContext.io.Init)  hciContext.io.Init(NULL);
@@ -162,6 +713,7 @@ void hci_register_io_bus(tHciIO* fops)
   hciContext.io.Init    = fops->Init; 
   hciContext.io.Receive = fops->Receive;  
   hciContext.io.Send    = fops->Send;
+  hciContext.io.SendV   = fops->SendV;
   hciContext.io.GetTick = fops->GetTick;
   hciContext.io.Reset   = fops->Reset;
 }
@@ -172,21 +724,26 @@ int hci_send_req(struct hci_request* r, BOOL async)
   uint16_t opcode = htobs(cmd_opcode_pack(r->ogf, r->ocf));
   hci_event_pckt *event_pckt;
   hci_spi_pckt *hci_hdr;
+  BOOL sent = FALSE;
+  uint32_t scan;
 
   tHciDataPacket * hciReadPacket = NULL;
-  tListNode hciTempQueue;
   
-  list_init_head(&hciTempQueue);
-
-  free_event_list();
-  
-  send_cmd(r->ogf, r->ocf, r->clen, r->cparam);
+  if (hciNextReq.armed)
+  {
+    hciNextReq.armed = FALSE;
+    return hci_send_req_async(r, hciNextReq.cb, hciNextReq.ctx);
+  }
   
   if (async)
   {
-    return 0;
+    return hci_send_req_async(r, NULL, NULL);
   }
   
+  /* The answer is searched in place: the events received meanwhile stay in the
+     ring, in order, to be processed later by the application. */
+  scan = hciRxTail;
+  
   while (1) 
   {
     evt_cmd_complete  *cc;
@@ -198,23 +755,50 @@ int hci_send_req(struct hci_request* r, BOOL async)
       
     while (1)
     {
+      if (!sent)
+      {
+        sent = send_req_in_order(r);
+      }
+      
       if ((HAL_GetTick() - tickstart) > HCI_DEFAULT_TIMEOUT_MS)
       {
         goto failed;
       }
       
-      if (!list_is_empty(&hciReadPktRxQueue)) 
+      if (scan != hciRxHead) 
       {
         break;
       }
+      
+      /* Everything has been looked at and the producer cannot store what it
+         holds: the awaited answer cannot be received until room is made */
+      if (hciRxStalled && !admit_packet(hciRxStalledClass, free_slots(scan)))
+      {
+        evict_packet(scan);
+      }
+    }
+    
+    /* Slot contents are read only after the producer published them */
+    __DMB();
+    hciReadPacket = &hciReadPacketBuffer[scan & HCI_READ_PACKET_MASK];
+    scan++;
+    
+    if (hciReadPacket->consumed)
+    {
+      continue;
     }
     
-    /* Extract packet from HCI event queue. */
-    list_remove_head(&hciReadPktRxQueue, (tListNode **)&hciReadPacket);    
+    /* Answers to asynchronous commands are resolved here as they arrive */
+    if (resolve_pending_cmd(hciReadPacket))
+    {
+      hciReadPacket->consumed = 1;
+      release_consumed_slots(scan);
+      continue;
+    }
     
     hci_hdr = (void *)hciReadPacket->dataBuff;
 
-    if (hci_hdr->type == HCI_EVENT_PKT)
+    if ((hci_hdr->type == HCI_EVENT_PKT) && sent)
     {
       event_pckt = (void *)(hci_hdr->data);
     
@@ -271,93 +855,249 @@ int hci_send_req(struct hci_request* r, BOOL async)
         break;
       }
     }
-    
-    /* If there are no more packets to be processed, be sure there is at list one
-       packet in the pool to process the expected event.
-       If no free packets are available, discard the processed event and insert it
-       into the pool. */
-    if (list_is_empty(&hciReadPktPool) && list_is_empty(&hciReadPktRxQueue)) {
-      list_insert_tail(&hciReadPktPool, (tListNode *)hciReadPacket);
-      hciReadPacket=NULL;
-    }
-    else {
-      /* Insert the packet in a different queue. These packets will be
-      inserted back in the main queue just before exiting from send_req(), so that
-      these events can be processed by the application.
-    */
-    list_insert_tail(&hciTempQueue, (tListNode *)hciReadPacket);
-      hciReadPacket=NULL;
-    }
   }
   
 failed: 
-  if (hciReadPacket!=NULL) {
-    list_insert_head(&hciReadPktPool, (tListNode *)hciReadPacket);
-  }
-  move_list(&hciReadPktRxQueue, &hciTempQueue);
-
+  update_cmd_deadline();
   return -1;
   
 done:
-  /* Insert the packet back into the pool.*/
-  list_insert_head(&hciReadPktPool, (tListNode *)hciReadPacket); 
-  move_list(&hciReadPktRxQueue, &hciTempQueue);
+  /* The answer has been copied out: free its slot without reordering the others */
+  hciReadPacket->consumed = 1;
+  release_consumed_slots(scan);
+  update_cmd_deadline();
+
+  return 0;
+}
+
+int hci_send_req_async(struct hci_request* r, hci_cmd_cplt_cb_t cb, void* ctx)
+{
+  tHciPendingCmd *cmd = NULL;
+  uint8_t index;
+
+  if ((r->clen > HCI_CMD_PARAM_SIZE_MAX) || (r->clen + r->cdlen > 0xFF))
+  {
+    return -1;
+  }
+
+  for (index = 0; index < HCI_PENDING_CMD_NUM_MAX; index++)
+  {
+    if (hciPendingCmd[index].state == HCI_CMD_FREE)
+    {
+      cmd = &hciPendingCmd[index];
+      break;
+    }
+  }
+
+  if (cmd == NULL)
+  {
+    return -1;
+  }
+
+  /* cparam is copied, the ACI wrappers build it on their stack; cdata is
+     owned by the caller until the completion callback */
+  cmd->ogf    = r->ogf;
+  cmd->ocf    = r->ocf;
+  cmd->opcode = htobs(cmd_opcode_pack(r->ogf, r->ocf));
+  cmd->event  = (uint8_t)r->event;
+  cmd->plen   = (uint8_t)r->clen;
+  cmd->data   = r->cdata;
+  cmd->dlen   = (uint8_t)r->cdlen;
+  cmd->cb     = cb;
+  cmd->ctx    = ctx;
+  cmd->seq    = hciPendingCmdSeq++;
+  BLUENRG_memcpy(cmd->param, r->cparam, r->clen);
+  cmd->state  = HCI_CMD_QUEUED;
+
+  issue_pending_cmds();
+  update_cmd_deadline();
 
   return 0;
 }
 
+void hci_set_next_req_async(hci_cmd_cplt_cb_t cb, void* ctx)
+{
+  hciNextReq.cb    = cb;
+  hciNextReq.ctx   = ctx;
+  hciNextReq.armed = TRUE;
+}
+
+void hci_flush_pending_cmds(void)
+{
+  uint32_t seq = hciPendingCmdSeq;
+  uint8_t index;
+
+  /* A controller out of reset takes one command */
+  hciContext.cmd_credits = 1;
+
+  /* Only the commands pending now: the callbacks may queue new ones */
+  for (index = 0; index < HCI_PENDING_CMD_NUM_MAX; index++)
+  {
+    tHciPendingCmd *cmd = &hciPendingCmd[index];
+
+    if ((cmd->state != HCI_CMD_FREE) && ((int32_t)(cmd->seq - seq) < 0))
+    {
+      complete_pending_cmd(cmd, BLE_STATUS_ERROR, NULL, 0);
+    }
+  }
+
+  update_cmd_deadline();
+}
+
 void hci_user_evt_proc(void)
 {
   tHciDataPacket * hciReadPacket = NULL;
+  uint32_t tail;
+  
+  /* Not reentrant: a blocking request issued from UserEvtRx only waits for its answer */
+  if (hciRxHeldSlot != HCI_NO_SLOT)
+  {
+    return;
+  }
      
   /* process any pending events read */
-  while (list_is_empty(&hciReadPktRxQueue) == FALSE)
+  for (tail = hciRxTail; tail != hciRxHead; tail = hciRxTail)
   {
-    list_remove_head (&hciReadPktRxQueue, (tListNode **)&hciReadPacket);
+    __DMB();
+    hciReadPacket = &hciReadPacketBuffer[tail & HCI_READ_PACKET_MASK];
+    
+    /* Hand the ring position back to the producer right away, keeping the slot
+       itself held until the application is done with it */
+    hciRxHeldSlot = tail & HCI_READ_PACKET_MASK;
+    __DMB();
+    hciRxTail = tail + 1;
 
-    if (hciContext.UserEvtRx != NULL)
+    if (!hciReadPacket->consumed && (hciReadPacket->pkt_class == HCI_PKT_CLASS_PRIO) && is_superseded(tail))
     {
-      hciContext.UserEvtRx(hciReadPacket->dataBuff);
+      /* Latest write wins: a newer value for the same attribute is queued */
+      hciRxStats.superseded++;
     }
+    else if (!hciReadPacket->consumed && (resolve_pending_cmd(hciReadPacket) == 0))
+    {
+      account_controller_lost(hciReadPacket);
 
-    list_insert_tail(&hciReadPktPool, (tListNode *)hciReadPacket);
+      if (hciContext.UserEvtRx != NULL)
+      {
+        hciContext.UserEvtRx(hciReadPacket->dataBuff);
+      }
+    }
+
+    __DMB();
+    hciRxHeldSlot = HCI_NO_SLOT;
   }
+  
+  check_pending_timeouts();
+  issue_pending_cmds();
+  update_cmd_deadline();
+}
+
+int hci_rx_no_coalesce(uint16_t attr_handle)
+{
+  uint8_t index;
+
+  for (index = 0; index < hciRxNoCoalesceNum; index++)
+  {
+    if (hciRxNoCoalesce[index] == attr_handle)
+      return 0;
+  }
+
+  if (hciRxNoCoalesceNum >= HCI_RX_NO_COALESCE_NUM_MAX)
+    return -1;
+
+  hciRxNoCoalesce[hciRxNoCoalesceNum] = attr_handle;
+  hciRxNoCoalesceNum++;
+
+  return 0;
+}
+
+void hci_get_rx_queue_stats(tHciRxQueueStats* stats)
+{
+  *stats = hciRxStats;
+  stats->capacity       = HCI_READ_PACKET_NUM_MAX;
+  stats->used           = hciRxHead - hciRxTail;
+  stats->high_watermark = hciRxHighWatermark;
 }
 
 int32_t hci_notify_asynch_evt(void* pdata)
 {
   tHciDataPacket * hciReadPacket = NULL;
+  uint32_t head = hciRxHead;
+  uint32_t used = head - hciRxTail;
   uint8_t data_len;
   
   int32_t ret = 0;
   
-  if (list_is_empty (&hciReadPktPool) == FALSE)
+  /* Full, or the next slot is still being dispatched by the consumer:
+     let the transport hold the packet and retry */
+  if ((used >= HCI_READ_PACKET_NUM_MAX) || ((int32_t)(head & HCI_READ_PACKET_MASK) == hciRxHeldSlot))
   {
-    /* Queuing a packet to read */
-    list_remove_head (&hciReadPktPool, (tListNode **)&hciReadPacket);
+    hciRxStalledClass = HCI_PKT_CLASS_CMD;
+    hciRxStalled = 1;
+    hciRxStats.stalls++;
+    return 1;
+  }
+  
+  /* The consumer is done with the slot once it published the tail */
+  __DMB();
+  hciReadPacket = &hciReadPacketBuffer[head & HCI_READ_PACKET_MASK];
     
-    if (hciContext.io.Receive)
-    {
-      data_len = hciContext.io.Receive(hciReadPacket->dataBuff, HCI_READ_PACKET_SIZE);
-      if (data_len > 0)
-      {                    
-        hciReadPacket->data_len = data_len;
-        if (verify_packet(hciReadPacket) == 0)
-          list_insert_tail(&hciReadPktRxQueue, (tListNode *)hciReadPacket);
-        else
-          list_insert_head(&hciReadPktPool, (tListNode *)hciReadPacket);          
+  if (hciContext.io.Receive)
+  {
+    data_len = hciContext.io.Receive(hciReadPacket->dataBuff, HCI_READ_PACKET_SIZE);
+    if (data_len > 0)
+    {                    
+      hciReadPacket->data_len = data_len;
+      hciReadPacket->consumed = 0;
+      if (verify_packet(hciReadPacket) != 0)
+      {
+        hciRxStats.dropped_malformed++;
+        return ret;
       }
-      else 
+      
+      /* Read into the slot, but only published if its class is admitted */
+      hciReadPacket->pkt_class = classify_packet(hciReadPacket);
+      if (!admit_packet(hciReadPacket->pkt_class, free_slots(head)))
       {
-        /* Insert the packet back into the pool*/
-        list_insert_head(&hciReadPktPool, (tListNode *)hciReadPacket);
+        hciRxStalledClass = hciReadPacket->pkt_class;
+        hciRxStalled = 1;
+        hciRxStats.stalls++;
+        return 1;
       }
+      hciRxStalled = 0;
+      
+#if (HCI_CAPTURE_ENABLED == 1)
+      {
+        tHciIOVec iov = { hciReadPacket->dataBuff, hciReadPacket->data_len };
+        uint8_t flags = HCI_CAPTURE_FLAG_RECEIVED;
+        
+        if (hciReadPacket->dataBuff[HCI_PCK_TYPE_OFFSET] == HCI_EVENT_PKT)
+        {
+          flags |= HCI_CAPTURE_FLAG_CMD_EVT;
+        }
+        hci_capture_packet(flags, &iov, 1);
+      }
+#endif
+      
+      /* Publish the slot contents before the new head */
+      __DMB();
+      hciRxHead = head + 1;
+      
+      if (used + 1 > hciRxHighWatermark)
+      {
+        hciRxHighWatermark = used + 1;
+      }
+      
+      hci_notify_user_evt();
     }
   }
-  else 
-  {
-    ret = 1;
-  }
-  return ret;
   
+  return ret;
+}
+
+__weak void hci_notify_user_evt(void)
+{
+}
+
+__weak void hci_notify_cmd_deadline(uint32_t delay_ms)
+{
 }
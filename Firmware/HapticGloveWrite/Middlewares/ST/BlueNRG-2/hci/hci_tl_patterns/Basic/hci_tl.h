@@ -20,7 +20,6 @@
 
 #include "hci_tl_interface.h"
 #include "ble_types.h"
-#include "ble_list.h"
 #include "bluenrg_conf.h"
 
 /** 
@@ -54,6 +53,8 @@ struct hci_request {
   uint32_t clen;    /**< Command Length */
   void     *rparam; /**< Response from Host to MCU */
   uint32_t rlen;    /**< Response Length */
+  const void *cdata; /**< Optional caller-owned parameters appended to cparam, sent without copy */
+  uint32_t cdlen;   /**< Length of cdata */
 };
 /**
  * @}
@@ -65,14 +66,28 @@ struct hci_request {
  */
 typedef struct _tHciDataPacket
 {
-  tListNode currentNode;
   uint8_t dataBuff[HCI_READ_PACKET_SIZE];
   uint8_t data_len;
+  uint8_t consumed; /**< Already handled out of order by a blocking request */
+  uint8_t pkt_class; /**< Admission class (command answer, attribute write, other) */
 } tHciDataPacket;
 /**
  * @}
  */
 
+/**
+ * @brief Segment of a scatter-gather transmission
+ * @{
+ */
+typedef struct _tHciIOVec
+{
+  const uint8_t *base; /**< Start of the segment */
+  uint16_t       len;  /**< Length of the segment */
+} tHciIOVec;
+/**
+ * @}
+ */
+
 /**
  * @brief Structure used to manage the BUS IO operations.
  *        All the structure fields will point to functions defined at user level.
@@ -85,6 +100,7 @@ typedef struct
   int32_t (* Reset)   (void); /**< Pointer to HCI TL function for the IO Bus reset */    
   int32_t (* Receive) (uint8_t*, uint16_t); /**< Pointer to HCI TL function for the IO Bus data reception */
   int32_t (* Send)    (uint8_t*, uint16_t); /**< Pointer to HCI TL function for the IO Bus data transmission */
+  int32_t (* SendV)   (const tHciIOVec*, uint8_t); /**< Pointer to HCI TL function for the IO Bus scatter-gather transmission (optional) */
   int32_t (* DataAck) (uint8_t*, uint16_t* len); /**< Pointer to HCI TL function for the IO Bus data ack reception */	
   int32_t (* GetTick) (void); /**< Pointer to BSP function for getting the HAL time base timestamp */    
 } tHciIO;
@@ -92,6 +108,26 @@ typedef struct
  * @}
  */
 
+/**
+ * @brief Occupancy of the ring of HCI read packets and packet losses by reason
+ * @{
+ */
+typedef struct
+{
+  uint32_t capacity;          /**< Number of packet slots (HCI_READ_PACKET_NUM_MAX) */
+  uint32_t used;              /**< Packets waiting to be processed */
+  uint32_t high_watermark;    /**< Highest number of packets waiting since hci_init() */
+  uint32_t stalls;            /**< Packets left in the transport for lack of an admissible slot */
+  uint32_t dropped_malformed; /**< Packets with a wrong type or length */
+  uint32_t dropped_evicted;   /**< Events discarded to receive the answer of a blocking request */
+  uint32_t superseded;        /**< Attribute writes skipped for a newer write of the same attribute */
+  uint32_t controller_lost;   /**< aci_blue_events_lost_event received */
+  uint8_t  controller_lost_events[8]; /**< Lost_Events bitmaps reported by the controller, OR-ed */
+} tHciRxQueueStats;
+/**
+ * @}
+ */
+
 /**
  * @brief Describe the HCI flow status
  * @{
@@ -105,6 +141,19 @@ typedef enum
  * @}
  */
  
+/**
+ * @brief Completion callback of an asynchronous HCI command.
+ *        opcode is the command opcode, status the command status (BLE_STATUS_TIMEOUT
+ *        when the controller did not answer). rparam points to the Command Complete
+ *        return parameters (status first) or to the Command Status event parameters,
+ *        it is NULL on timeout and is only valid during the call.
+ * @{
+ */
+typedef void (* hci_cmd_cplt_cb_t)(uint16_t opcode, uint8_t status, const uint8_t *rparam, uint8_t rlen, void *ctx);
+/**
+ * @}
+ */
+
 /**
  * @brief Contain the HCI context
  * @{
@@ -113,6 +162,7 @@ typedef struct
 {   
   tHciIO io; /**< Manage the BUS IO operations */
   void (* UserEvtRx) (void * pData); /**< ACI events callback function pointer */
+  uint8_t cmd_credits; /**< Num_HCI_Command_Packets last reported by the controller */
 } tHciContext;
 
 /**
@@ -135,6 +185,48 @@ typedef struct
   * @retval int: 0 when success, -1 when failure
   */
 int hci_send_req(struct hci_request *r, BOOL async);
+
+/**
+  * @brief  Queue an HCI request without waiting for its answer.
+  *         The command is handed to the controller as soon as it reports a free
+  *         command credit (Num_HCI_Command_Packets); queued commands are issued in
+  *         order. The completion callback is run from hci_user_evt_proc(), or from
+  *         a blocking hci_send_req() that receives the answer while waiting for its own.
+  *
+  * @param  r: The HCI request. cparam is copied, cdata must stay valid
+  *         until the completion callback
+  * @param  cb: Completion callback, NULL if the answer is not needed
+  * @param  ctx: User context passed to the callback
+  * @retval int: 0 when queued, -1 when the pending command table is full
+  */
+int hci_send_req_async(struct hci_request *r, hci_cmd_cplt_cb_t cb, void *ctx);
+
+/**
+  * @brief  Make the next hci_send_req() asynchronous.
+  *         Allows the generated ACI/HCI wrappers to be used without blocking:
+  *         @code
+            hci_set_next_req_async(Allow_Read_Cplt_CB, NULL);
+            ret = aci_gatt_allow_read(connection_handle);
+  *         @endcode
+  *         The wrapper then returns BLE_STATUS_SUCCESS as soon as the command is
+  *         queued; its output parameters are not written, the answer is delivered
+  *         to the callback instead.
+  *
+  * @param  cb: Completion callback, NULL if the answer is not needed
+  * @param  ctx: User context passed to the callback
+  * @retval None
+  */
+void hci_set_next_req_async(hci_cmd_cplt_cb_t cb, void *ctx);
+
+/**
+  * @brief  Drop the asynchronous commands still pending, after a reset of the
+  *         controller: they will never be answered. Each one is completed with
+  *         BLE_STATUS_ERROR and the command credits are reset.
+  *
+  * @param  None
+  * @retval None
+  */
+void hci_flush_pending_cmds(void);
  
 /**
  * @brief  Register IO bus services.
@@ -147,6 +239,7 @@ int hci_send_req(struct hci_request *r, BOOL async);
              hciContext.io.Init    = fops->Init; 
              hciContext.io.Receive = fops->Receive;  
              hciContext.io.Send    = fops->Send;
+             hciContext.io.SendV   = fops->SendV;
              hciContext.io.GetTick = fops->GetTick;
              hciContext.io.Reset   = fops->Reset;    
            }
@@ -166,6 +259,7 @@ int hci_send_req(struct hci_request *r, BOOL async);
              fops.Init    = HCI_TL_SPI_Init;
              fops.DeInit  = HCI_TL_SPI_DeInit;
              fops.Send    = HCI_TL_SPI_Send;
+             fops.SendV   = HCI_TL_SPI_SendV;
              fops.Receive = HCI_TL_SPI_Receive;
              fops.Reset   = HCI_TL_SPI_Reset;
              fops.GetTick = BSP_GetTick;
@@ -192,6 +286,46 @@ void hci_register_io_bus(tHciIO* fops);
  */
 int32_t hci_notify_asynch_evt(void* pdata);
 
+/**
+ * @brief  Called by hci_notify_asynch_evt() each time a packet is queued for
+ *         hci_user_evt_proc(). This weak definition does nothing; the
+ *         application overrides it to schedule hci_user_evt_proc() instead
+ *         of polling it.
+ *
+ * @param  None
+ * @retval None
+ */
+void hci_notify_user_evt(void);
+
+/**
+ * @brief  Called whenever the pending asynchronous commands change, with the
+ *         time after which hci_user_evt_proc() must run to time them out or
+ *         retry them. This weak definition does nothing; the application
+ *         overrides it to arm a one-shot timer instead of polling.
+ *
+ * @param  delay_ms Time to the next deadline, 0 when no command is pending
+ * @retval None
+ */
+void hci_notify_cmd_deadline(uint32_t delay_ms);
+
+/**
+ * @brief  Keep every write of an attribute: its attribute-modified events are
+ *         never dropped for a newer write of the same bytes. For values sent
+ *         in parts that each start at offset 0, like the rows of a depth tile.
+ *
+ * @param  attr_handle Handle of the attribute value
+ * @retval 0 if registered or already there, -1 if the table is full
+ */
+int hci_rx_no_coalesce(uint16_t attr_handle);
+
+/**
+ * @brief  Get the occupancy of the ring of received HCI packets.
+ *
+ * @param  stats Filled with the current statistics
+ * @retval None
+ */
+void hci_get_rx_queue_stats(tHciRxQueueStats* stats);
+
 /**
  * @brief  This function resume the User Event Flow which has been stopped on return 
  *         from UserEvtRx() when the User Event has not been processed.
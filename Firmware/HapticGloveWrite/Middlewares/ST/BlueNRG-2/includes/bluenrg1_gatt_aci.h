@@ -352,6 +352,24 @@ tBleStatus aci_gatt_update_char_value(uint16_t Service_Handle,
                                       uint8_t Val_Offset,
                                       uint8_t Char_Value_Length,
                                       uint8_t Char_Value[]);
+/**
+ * @brief Same as aci_gatt_update_char_value, but Char_Value is transmitted
+ *        directly from the caller buffer instead of being copied into the
+ *        command. When issued asynchronously (hci_set_next_req_async) the
+ *        buffer must stay unchanged until the completion callback.
+ * @param Service_Handle Handle of service to which the characteristic belongs
+ * @param Char_Handle Handle of the characteristic
+ * @param Val_Offset The offset from which the attribute value has to be
+ *        updated
+ * @param Char_Value_Length Length of the characteristic value in octets
+ * @param Char_Value Characteristic value
+ * @retval Value indicating success or error code.
+ */
+tBleStatus aci_gatt_update_char_value_nocopy(uint16_t Service_Handle,
+                                             uint16_t Char_Handle,
+                                             uint8_t Val_Offset,
+                                             uint8_t Char_Value_Length,
+                                             const uint8_t Char_Value[]);
 /**
  * @brief Delete the specified characteristic from the service.
  * @param Serv_Handle Handle of service to which the characteristic belongs
@@ -1129,6 +1147,30 @@ tBleStatus aci_gatt_update_char_value_ext(uint16_t Conn_Handle_To_Notify,
                                           uint16_t Value_Offset,
                                           uint8_t Value_Length,
                                           uint8_t Value[]);
+/**
+ * @brief Same as aci_gatt_update_char_value_ext, but Value is transmitted
+ *        directly from the caller buffer instead of being copied into the
+ *        command. When issued asynchronously (hci_set_next_req_async) the
+ *        buffer must stay unchanged until the completion callback.
+ * @param Conn_Handle_To_Notify Connection handle to notify, 0x0000 for all
+ * @param Service_Handle Handle of service to which the characteristic belongs
+ * @param Char_Handle Handle of the characteristic
+ * @param Update_Type GATT_LOCAL_UPDATE, GATT_NOTIFICATION or GATT_INDICATION
+ * @param Char_Length Total length of the characteristic value
+ * @param Value_Offset The offset from which the attribute value has to be
+ *        updated
+ * @param Value_Length Length of the Value parameter in octets
+ * @param Value Updated characteristic value
+ * @retval Value indicating success or error code.
+ */
+tBleStatus aci_gatt_update_char_value_ext_nocopy(uint16_t Conn_Handle_To_Notify,
+                                                 uint16_t Service_Handle,
+                                                 uint16_t Char_Handle,
+                                                 uint8_t Update_Type,
+                                                 uint16_t Char_Length,
+                                                 uint16_t Value_Offset,
+                                                 uint8_t Value_Length,
+                                                 const uint8_t Value[]);
 /**
  * @brief Deny the GATT server to send a response to a read request from a
  *        client. The application may send this command when it receives the
@@ -52,6 +52,9 @@ typedef PACKED(struct) _hci_command_hdr{
 } hci_command_hdr;
 #define HCI_COMMAND_HDR_SIZE 	3
 
+/* Longest parameters of a command: what the payload leaves after the headers */
+#define HCI_CMD_PARAM_SIZE_MAX	(HCI_MAX_PAYLOAD_SIZE - HCI_HDR_SIZE - HCI_COMMAND_HDR_SIZE)
+
 typedef PACKED(struct) _hci_event_pckt{
   uint8_t evt;
   uint8_t plen;
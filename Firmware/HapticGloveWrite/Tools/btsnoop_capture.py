@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+#
+# btsnoop_capture.py
+#
+#  Created on: Oct 18, 2026
+#      Author: Peter Alpajaro
+#
+# Reads the HCI capture streamed by the glove over LPUART1 (firmware built
+# with HCI_CAPTURE_ENABLED = 1) and writes a .btsnoop file Wireshark can open.
+# The console output sharing the UART is printed as it arrives.
+#
+#   python3 btsnoop_capture.py /dev/ttyACM0 glove.btsnoop
+#   python3 btsnoop_capture.py --raw dump.bin glove.btsnoop
+#
+# Each record is sent as the 4-byte marker of hci_capture.h followed by a
+# btsnoop record (H4 datalink). The time stamps are microseconds since the
+# glove was reset; they are rebased here on the host clock.
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = bytes([0xA5, 0x5A, 0xC3, 0x3C])
+RECORD_HDR = struct.Struct(">IIIIq")
+
+BTSNOOP_MAGIC = b"btsnoop\0"
+BTSNOOP_VERSION = 1
+BTSNOOP_DATALINK_H4 = 1002
+
+# Microseconds between 0 AD and the Unix epoch, as btsnoop counts time
+BTSNOOP_EPOCH_DELTA_US = 0x00DCDDB30F2F8000
+
+# Longest record the firmware sends (HCI_CAPTURE_SNAPLEN)
+MAX_INCL_LEN = 255
+
+
+class CaptureParser:
+    """Splits the UART stream into console text and btsnoop records."""
+
+    def __init__(self, out, console):
+        self.out = out
+        self.console = console
+        self.buf = bytearray()
+        self.base_us = None
+        self.records = 0
+        self.drops = 0
+
+        out.write(BTSNOOP_MAGIC)
+        out.write(struct.pack(">II", BTSNOOP_VERSION, BTSNOOP_DATALINK_H4))
+
+    def feed(self, data):
+        self.buf += data
+
+        while True:
+            pos = self.buf.find(SYNC)
+            if pos < 0:
+                # Keep a possible partial marker for the next read
+                keep = len(SYNC) - 1
+                self._text(self.buf[:-keep] if len(self.buf) > keep else b"")
+                del self.buf[:max(0, len(self.buf) - keep)]
+                return
+
+            self._text(self.buf[:pos])
+            del self.buf[:pos]
+
+            if len(self.buf) < len(SYNC) + RECORD_HDR.size:
+                return
+
+            orig_len, incl_len, flags, drops, stamp = RECORD_HDR.unpack_from(self.buf, len(SYNC))
+            if incl_len > orig_len or incl_len > MAX_INCL_LEN or flags > 3:
+                # Not a record after all: skip the marker byte and resync
+                self._text(self.buf[:1])
+                del self.buf[:1]
+                continue
+
+            end = len(SYNC) + RECORD_HDR.size + incl_len
+            if len(self.buf) < end:
+                return
+
+            self._record(orig_len, incl_len, flags, drops, stamp,
+                         bytes(self.buf[len(SYNC) + RECORD_HDR.size:end]))
+            del self.buf[:end]
+
+    def finish(self):
+        # Whatever is left cannot start a record any more
+        self._text(self.buf)
+        self.buf.clear()
+
+    def _record(self, orig_len, incl_len, flags, drops, stamp, data):
+        if self.base_us is None:
+            host_us = int(time.time() * 1000000) + BTSNOOP_EPOCH_DELTA_US
+            self.base_us = host_us - stamp
+
+        self.out.write(RECORD_HDR.pack(orig_len, incl_len, flags, drops, self.base_us + stamp))
+        self.out.write(data)
+        self.out.flush()
+
+        self.records += 1
+        if drops != self.drops:
+            self.console.write("[capture] %d packet(s) lost on the glove\n" % (drops - self.drops))
+            self.drops = drops
+
+    def _text(self, data):
+        if data:
+            self.console.write(bytes(data).decode("latin-1"))
+            self.console.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Write the glove HCI capture to a .btsnoop file")
+    parser.add_argument("source", help="serial port, or a raw dump of the stream with --raw")
+    parser.add_argument("output", help=".btsnoop file to write")
+    parser.add_argument("--baud", type=int, default=921600, help="HCI_CAPTURE_BAUDRATE (default 921600)")
+    parser.add_argument("--raw", action="store_true", help="read the stream from a file")
+    args = parser.parse_args()
+
+    with open(args.output, "wb") as out:
+        capture = CaptureParser(out, sys.stdout)
+
+        try:
+            if args.raw:
+                with open(args.source, "rb") as src:
+                    capture.feed(src.read())
+            else:
+                import serial
+
+                with serial.Serial(args.source, args.baud, timeout=0.1) as port:
+                    while True:
+                        capture.feed(port.read(4096))
+        except KeyboardInterrupt:
+            pass
+
+        capture.finish()
+
+    sys.stderr.write("%d record(s) written to %s, %d lost on the glove\n"
+                     % (capture.records, args.output, capture.drops))
+
+
+if __name__ == "__main__":
+    main()
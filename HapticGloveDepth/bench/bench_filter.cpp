@@ -0,0 +1,92 @@
+/*
+ * bench_filter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Cost of the render path of the firmware, built for the host: Haptic_Render
+// (Q15 conversion, temporal filter, prediction, saliency, PWM mapping) per
+// frame, for each filter mode with and without the later stages, in nanoseconds and, on x86, in TSC cycles. The code is the integer
+// code of the glove, so the relative costs carry over to the Cortex-M4, the
+// absolute ones do not.
+//
+//	bench_filter [-n frames]
+
+// Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "haptic_filter.h"
+#include "haptic_predict.h"
+#include "haptic_render.h"
+#include "haptic_saliency.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HGDEPTH_TSC		1
+#endif
+
+// Private functions
+
+static void run(const char *name, const Haptic_FilterParams_t &params, uint8_t predict, uint8_t saliency, int frames)
+{
+	std::vector<float> grids((size_t)frames * HAPTIC_CELL_NUM);
+	uint32_t pulse[HAPTIC_CELL_NUM];
+	uint32_t sink = 0;
+	uint32_t seed = 1;
+
+	for (float &g : grids) {
+		seed = (seed * 1664525u) + 1013904223u;
+		g = (float)(seed >> 8) / (float)(1u << 24);
+	}
+
+	Haptic_FilterSetParams(&params);
+	Haptic_PredictEnable(predict);
+	Haptic_SaliencyEnable(saliency);
+	Haptic_RenderReset();
+
+	auto start = std::chrono::steady_clock::now();
+#if defined(HGDEPTH_TSC)
+	uint64_t tsc = __rdtsc();
+#endif
+	for (int i = 0; i < frames; i++) {
+		Haptic_Render(&grids[(size_t)i * HAPTIC_CELL_NUM], (uint32_t)i * 33U, pulse);
+		sink += pulse[0];
+	}
+#if defined(HGDEPTH_TSC)
+	tsc = __rdtsc() - tsc;
+#endif
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+#if defined(HGDEPTH_TSC)
+	std::printf("  %-20s %8.1f ns/frame %8.1f cycles/frame %6.1f cycles/cell  (%u)\n",
+				name, ns, (double)tsc / frames, (double)tsc / frames / HAPTIC_CELL_NUM, sink & 1);
+#else
+	std::printf("  %-20s %8.1f ns/frame  (%u)\n", name, ns, sink & 1);
+#endif
+}
+
+// Exported functions
+
+int main(int argc, char **argv)
+{
+	int frames = 1000000;
+
+	if ((argc == 3) && (std::strcmp(argv[1], "-n") == 0)) {
+		frames = std::atoi(argv[2]);
+	}
+	frames = (frames <= 0) ? 1 : frames;
+
+	std::printf("Haptic_Render, %u cells, %d frames\n", HAPTIC_CELL_NUM, frames);
+	run("off", {HAPTIC_FILTER_OFF, 0, 0, 0, 0}, 0, 0, frames);
+	run("ema", {HAPTIC_FILTER_EMA, HAPTIC_Q15_ONE / 2, 0, 0, 0}, 0, 0, frames);
+	run("one euro", {HAPTIC_FILTER_ONE_EURO, 0, 256, 256, 256}, 0, 0, frames);
+	run("off + predict", {HAPTIC_FILTER_OFF, 0, 0, 0, 0}, 1, 0, frames);
+	run("off + saliency", {HAPTIC_FILTER_OFF, 0, 0, 0, 0}, 0, 1, frames);
+	run("one euro + all", {HAPTIC_FILTER_ONE_EURO, 0, 256, 256, 256}, 1, 1, frames);
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * bench_reduce.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Time per frame of each kernel and thread count, on the layout of the app
+// (quadrant centres, every second sample) and on a dense 8 x 8 grid, over
+// synthetic depth maps of 518 x 518 (the DepthAnythingV2 Small output) and
+// larger, or over a recorded map. Each result is checked against the scalar
+// kernel on one thread.
+//
+//	bench_reduce [-t threads] [-n frames] [-f map.f32 width height]
+//
+// A recorded map is raw 32 bit floats, row after row, as dumped from the
+// depth CVPixelBuffer.
+
+// Includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "hgdepth/reduce.h"
+
+using namespace hgdepth;
+
+// Variables
+
+struct Map {
+	std::string name;
+	uint32_t width;
+	uint32_t height;
+	std::vector<float> depth;
+	std::vector<uint8_t> depth_u8;
+};
+
+static const Isa isas[] = {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Neon};
+
+// Private functions
+
+// A floor, a wall and a few blobs, with some noise: smooth like a depth map, not constant
+static Map synthetic(uint32_t size)
+{
+	Map map{"synthetic " + std::to_string(size), size, size, {}, {}};
+	uint32_t seed = 0x9E3779B9u;
+
+	map.depth.resize((size_t)size * size);
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			float u = (float)x / (float)size;
+			float v = (float)y / (float)size;
+			float d = 1.0f + (4.0f * v);
+			d += 2.0f * std::exp(-(((u - 0.3f) * (u - 0.3f)) + ((v - 0.4f) * (v - 0.4f))) * 40.0f);
+			d += 1.5f * std::exp(-(((u - 0.7f) * (u - 0.7f)) + ((v - 0.6f) * (v - 0.6f))) * 25.0f);
+			seed = (seed * 1664525u) + 1013904223u;
+			d += (float)(seed >> 8) / (float)(1u << 24) * 0.05f;
+			map.depth[((size_t)y * size) + x] = d;
+		}
+	}
+
+	return map;
+}
+
+static bool recorded(const char *path, uint32_t width, uint32_t height, Map *map)
+{
+	FILE *f = std::fopen(path, "rb");
+	size_t n = (size_t)width * height;
+
+	if (f == nullptr) {
+		std::perror(path);
+		return false;
+	}
+
+	map->name = path;
+	map->width = width;
+	map->height = height;
+	map->depth.resize(n);
+	n = std::fread(map->depth.data(), sizeof(float), n, f);
+	std::fclose(f);
+
+	if (n != map->depth.size()) {
+		std::fprintf(stderr, "%s: %zu samples, %zu expected\n", path, n, map->depth.size());
+		return false;
+	}
+
+	return true;
+}
+
+// The same map quantized as the app quantizes the tile it sends to the glove
+static void quantize(Map *map)
+{
+	float lo = map->depth[0];
+	float hi = map->depth[0];
+
+	for (float d : map->depth) {
+		lo = (d < lo) ? d : lo;
+		hi = (d > hi) ? d : hi;
+	}
+
+	map->depth_u8.resize(map->depth.size());
+	for (size_t k = 0; k < map->depth.size(); k++) {
+		float v = (hi > lo) ? ((map->depth[k] - lo) / (hi - lo)) : 0.0f;
+		map->depth_u8[k] = (uint8_t)std::lround(v * 255.0f);
+	}
+}
+
+template <typename T>
+static void run(const char *label, const Image<T> &image, const std::vector<Region> &regions,
+				unsigned max_threads, int frames)
+{
+	size_t n = regions.size();
+	std::vector<float> want(n), got(n);
+	uint64_t samples = 0;
+	Reducer reference;
+
+	reference.init({Isa::Scalar, 1});
+	reference.reduce(image, regions.data(), n, want.data());
+	for (const Region &r : regions) {
+		samples += (uint64_t)((r.width + r.step_x - 1) / r.step_x) * ((r.height + r.step_y - 1) / r.step_y);
+	}
+
+	for (Isa isa : isas) {
+		if (!isa_supported(isa)) {
+			continue;
+		}
+		for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+			Reducer reducer;
+			reducer.init({isa, threads});
+			reducer.reduce(image, regions.data(), n, got.data());
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < frames; i++) {
+				reducer.reduce(image, regions.data(), n, got.data());
+			}
+			double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+			std::printf("  %-14s %-6s %2u thread(s) %10.2f us/frame %8.1f Msamples/s  %s\n",
+						label, isa_name(isa), threads, us, (double)samples / us,
+						std::memcmp(want.data(), got.data(), n * sizeof(float)) ? "MISMATCH" : "exact");
+		}
+	}
+}
+
+static void bench(Map &map, unsigned threads, int frames)
+{
+	quantize(&map);
+
+	Image<float> image{map.depth.data(), map.width, map.height, map.width};
+	Image<uint8_t> image_u8{map.depth_u8.data(), map.width, map.height, map.width};
+	std::vector<Region> quadrants = quadrant_layout(map.width, map.height);
+	std::vector<Region> grid = grid_layout(map.width, map.height, 8, 8);
+
+	std::printf("%s (%u x %u)\n", map.name.c_str(), map.width, map.height);
+	run("quadrants f32", image, quadrants, threads, frames);
+	run("grid 8x8 f32", image, grid, threads, frames);
+	run("grid 8x8 u8", image_u8, grid, threads, frames);
+}
+
+// Exported functions
+
+int main(int argc, char **argv)
+{
+	unsigned threads = std::thread::hardware_concurrency();
+	int frames = 200;
+	std::vector<Map> maps;
+
+	for (int i = 1; i < argc; i++) {
+		if ((std::strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) {
+			threads = (unsigned)std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+			frames = std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-f") == 0) && (i + 3 < argc)) {
+			Map map;
+			if (!recorded(argv[i + 1], (uint32_t)std::atoi(argv[i + 2]), (uint32_t)std::atoi(argv[i + 3]), &map)) {
+				return 1;
+			}
+			maps.push_back(map);
+			i += 3;
+		} else {
+			std::fprintf(stderr, "usage: %s [-t threads] [-n frames] [-f map.f32 width height]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (maps.empty()) {
+		for (uint32_t size : {518u, 1036u, 2072u}) {
+			maps.push_back(synthetic(size));
+		}
+	}
+
+	threads = (threads == 0) ? 1 : threads;
+	frames = (frames <= 0) ? 1 : frames;
+
+	for (Map &map : maps) {
+		bench(map, threads, frames);
+	}
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * reduce.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_REDUCE_H_
+#define HGDEPTH_REDUCE_H_
+
+// Depth map to actuator reduction: what DataModel.calculateRegionDepths does
+// on the phone and depth_tile.c on the glove, for any layout of regions. Each
+// region is scanned once for its min, max and sum; the region averages are
+// then normalized by the range over all the regions and weighted.
+//
+// Every kernel (scalar, SSE2, AVX2, NEON) and every thread count gives the
+// same bits: the samples of a row are summed in 8 lanes, sample k in lane
+// k % 8, the lanes are folded in a fixed order and the rows are added up in
+// row order. The scalar kernel is the reference the others are tested against.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "hgdepth/status.h"
+
+namespace hgdepth {
+
+// Kernels
+enum class Isa {
+	Scalar = 0,
+	Sse2,
+	Avx2,
+	Neon,
+	Best,			// Fastest one available
+};
+
+// Depth map of samples of type T. stride is the distance between two rows, in samples
+template <typename T>
+struct Image {
+	const T *data = nullptr;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	size_t stride = 0;
+};
+
+// Area reduced into one actuator value. Every step_x-th sample of every step_y-th row
+struct Region {
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t step_x = 1;
+	uint32_t step_y = 1;
+	float weight = 1.0f;	// Gain on the normalized depth
+};
+
+// Figures of a region, before the normalization
+struct RegionStats {
+	double sum = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+	uint64_t count = 0;
+};
+
+struct Options {
+	Isa isa = Isa::Best;
+	unsigned threads = 1;	// Threads scanning the rows, the calling one included
+};
+
+// True if the kernels of isa are built in and the CPU runs them
+bool isa_supported(Isa isa);
+
+// Fastest kernels available
+Isa best_isa();
+
+const char *isa_name(Isa isa);
+
+// Layout of calculateRegionDepths: the centre quarter of each quadrant of a
+// 2 x 2 grid, every second sample of every second row, in the order of the grid
+std::vector<Region> quadrant_layout(uint32_t width, uint32_t height);
+
+// Layout of depth_tile.c: the centre half of each cell of a cols x rows grid, all samples
+std::vector<Region> grid_layout(uint32_t width, uint32_t height, uint32_t cols, uint32_t rows);
+
+class Reducer {
+public:
+	Reducer();
+	~Reducer();
+
+	Reducer(const Reducer &) = delete;
+	Reducer &operator=(const Reducer &) = delete;
+
+	// Selects the kernels and starts the threads
+	Status init(const Options &options);
+
+	Isa isa() const;
+	unsigned threads() const;
+
+	// Reduces the map into one value per region, in out[count]. stats, if
+	// not null, receives the figures of each region. Floating point maps are
+	// normalized like calculateRegionDepths (range at least FLT_EPSILON),
+	// 8 bit maps like depth_tile.c (range at least 1). Values are clamped to 1
+	Status reduce(const Image<float> &image, const Region *regions, size_t count,
+				  float *out, RegionStats *stats = nullptr);
+	Status reduce(const Image<uint8_t> &image, const Region *regions, size_t count,
+				  float *out, RegionStats *stats = nullptr);
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> impl_;
+};
+
+} // namespace hgdepth
+
+#endif /* HGDEPTH_REDUCE_H_ */
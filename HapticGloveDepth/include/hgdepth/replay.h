@@ -0,0 +1,85 @@
+/*
+ * replay.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_REPLAY_H_
+#define HGDEPTH_REPLAY_H_
+
+// Replay of a depth sequence through the whole pipeline, frame by frame:
+//
+//	decode		samples of the file to depth, as the app gets it from the model,
+//				for the samples the layout reads
+//	reduce		depth map to grid, with the Reducer
+//	encode		grid to the value of the grid characteristic, as BluetoothManager.writeData
+//	apply		the firmware, built for the host: Haptic_GridDecode and Haptic_Render,
+//				temporal filter included, timed by the frame timestamps
+//
+// at the rate of the recording or as fast as it goes, timing each stage.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "hgdepth/reduce.h"
+#include "hgdepth/sequence.h"
+
+namespace hgdepth {
+
+#define HGDEPTH_GRID_CELLS		4U
+#define HGDEPTH_GRID_LEN		(2U + (HGDEPTH_GRID_CELLS * 4U))	// Timestamp, then the cells as floats
+
+enum class ReplayRate {
+	Recorded,		// Each frame at its timestamp
+	Max,			// Back to back
+};
+
+struct ReplayOptions {
+	ReplayRate rate = ReplayRate::Max;
+	Options reducer;
+	std::vector<Region> layout;		// HGDEPTH_GRID_CELLS regions, quadrant_layout() when empty
+	unsigned loops = 1;				// Times the sequence is played
+	int latency_ms = -1;			// Capture to glove latency measure for the firmware predictor, -1 for none
+};
+
+// One frame out of the pipeline
+struct ReplayFrame {
+	size_t index = 0;
+	uint64_t timestamp_us = 0;
+	float grid[HGDEPTH_GRID_CELLS] = {};		// Out of the reduction
+	float applied[HGDEPTH_GRID_CELLS] = {};		// As decoded by the firmware
+	uint32_t pulse[HGDEPTH_GRID_CELLS] = {};	// PWM compare values
+	double stage_us[4] = {};					// decode, reduce, encode, apply
+};
+
+// Time of a stage over the frames, in microseconds
+struct StageStats {
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+struct ReplayStats {
+	size_t frames = 0;
+	StageStats decode;
+	StageStats reduce;
+	StageStats encode;
+	StageStats apply;
+	StageStats total;
+	double wall_s = 0.0;
+	size_t late = 0;			// Recorded rate: frames done after the next one was due
+};
+
+// Grid characteristic value of a grid, in out[HGDEPTH_GRID_LEN]
+void encode_grid(uint16_t timestamp, const float *grid, uint8_t *out);
+
+// Plays the sequence. on_frame, if set, is called with each frame, out of the timing
+Status replay(const SequenceReader &sequence, const ReplayOptions &options, ReplayStats *stats,
+			  const std::function<void(const ReplayFrame &)> &on_frame = {});
+
+} // namespace hgdepth
+
+#endif /* HGDEPTH_REPLAY_H_ */
@@ -0,0 +1,139 @@
+/*
+ * sequence.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_SEQUENCE_H_
+#define HGDEPTH_SEQUENCE_H_
+
+// Depth sequence files: recorded walks, replayed through the pipeline as
+// often as needed. Little endian throughout:
+//
+//	header		64 bytes, see below
+//	frames		one after the other, each at a multiple of 64 bytes from the
+//				start of the file: width x height samples of 16 bits, row after row
+//	index		at the end, one entry of 16 bytes per frame: its offset in the
+//				file (u64) and its timestamp in microseconds (u64)
+//
+// A sample is a float16 or a uint16; the depth is sample * scale + offset.
+// The writer streams the frames out as they come and writes the index and
+// the frame count on close, so a file whose recording was cut short has no
+// index and is refused by the reader. The reader maps the file and hands out
+// pointers into it: a frame is never copied.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "hgdepth/reduce.h"
+#include "hgdepth/status.h"
+
+namespace hgdepth {
+
+#define HGDEPTH_SEQ_MAGIC			"HGDS"
+#define HGDEPTH_SEQ_VERSION			1U
+#define HGDEPTH_SEQ_HEADER_LEN		64U
+#define HGDEPTH_SEQ_ALIGN			64U		// Alignment of the frames in the file
+#define HGDEPTH_SEQ_INDEX_ENTRY		16U
+
+/*
+ * Header:
+ *	0	magic "HGDS"
+ *	4	u16 version
+ *	6	u16 header length
+ *	8	u32 width
+ *	12	u32 height
+ *	16	u16 sample type
+ *	18	u16 flags, 0
+ *	20	f32 scale
+ *	24	f32 offset
+ *	28	u32 frame count
+ *	32	u64 frame length, in bytes
+ *	40	u64 index offset
+ *	48	reserved, 0
+ */
+
+enum class SampleType : uint16_t {
+	Float16 = 1,
+	Uint16 = 2,
+};
+
+struct SequenceInfo {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	SampleType type = SampleType::Float16;
+	float scale = 1.0f;
+	float offset = 0.0f;
+	uint32_t frames = 0;		// Filled in by the reader
+};
+
+struct Frame {
+	const uint16_t *samples = nullptr;		// width x height, 64 byte aligned
+	uint64_t timestamp_us = 0;
+};
+
+class SequenceReader {
+public:
+	SequenceReader() = default;
+	~SequenceReader();
+
+	SequenceReader(const SequenceReader &) = delete;
+	SequenceReader &operator=(const SequenceReader &) = delete;
+
+	// Maps the file and checks the header and the index
+	Status open(const char *path);
+	void close();
+
+	const SequenceInfo &info() const { return info_; }
+	size_t size() const { return info_.frames; }
+
+	// Frame i, pointing into the mapping: valid until close()
+	Status frame(size_t i, Frame *out) const;
+
+private:
+	const uint8_t *map_ = nullptr;
+	size_t length_ = 0;
+	const uint8_t *index_ = nullptr;
+	SequenceInfo info_;
+};
+
+class SequenceWriter {
+public:
+	SequenceWriter() = default;
+	~SequenceWriter();
+
+	SequenceWriter(const SequenceWriter &) = delete;
+	SequenceWriter &operator=(const SequenceWriter &) = delete;
+
+	Status open(const char *path, const SequenceInfo &info);
+
+	// Writes a frame of width x height samples. Timestamps should increase
+	Status append(const uint16_t *samples, uint64_t timestamp_us);
+
+	// Writes the index and completes the header
+	Status close();
+
+private:
+	std::FILE *file_ = nullptr;
+	uint64_t position_ = 0;
+	std::vector<uint8_t> index_;
+	SequenceInfo info_;
+};
+
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t half);
+
+// Depth of each sample of a frame, in out[width x height]. With regions, only
+// the samples the regions read are decoded, the others are left as they are
+void decode_frame(const SequenceInfo &info, const uint16_t *samples, float *out,
+				  const Region *regions = nullptr, size_t count = 0);
+
+// Samples of a depth map: (depth - offset) / scale, rounded to the nearest,
+// saturated for uint16
+void encode_frame(const SequenceInfo &info, const float *depth, uint16_t *out);
+
+} // namespace hgdepth
+
+#endif /* HGDEPTH_SEQUENCE_H_ */
@@ -0,0 +1,26 @@
+/*
+ * status.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_STATUS_H_
+#define HGDEPTH_STATUS_H_
+
+namespace hgdepth {
+
+// Status codes of the library
+enum class Status {
+	Ok = 0,
+	InvalidArgument,	// Region outside the map, empty, or a null buffer
+	UnsupportedIsa,		// Instruction set not built in or not on this CPU
+	IoError,			// File could not be opened, mapped, read or written
+	InvalidFormat,		// File is not a depth sequence, or is truncated
+};
+
+const char *status_name(Status status);
+
+} // namespace hgdepth
+
+#endif /* HGDEPTH_STATUS_H_ */
@@ -0,0 +1,83 @@
+/*
+ * kernels.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_KERNELS_H_
+#define HGDEPTH_KERNELS_H_
+
+// Row kernels: one pass over the samples of a row of a region for their sum,
+// min and max. A row of count samples starts at p, the samples are step apart.
+//
+// Floating point rows are summed in 8 lanes, sample k in lane k % 8, and the
+// lanes folded by lanes_fold() below, which is what makes the kernels agree
+// to the bit. The vector kernels keep the 8 lanes in registers and hand the
+// samples after the last full group to lanes_fold() as well. 8 bit rows are
+// summed in integers, in any order.
+
+#include <cstdint>
+
+namespace hgdepth {
+namespace detail {
+
+#define HGDEPTH_LANES	8
+
+struct RowF32 {
+	double sum;
+	float min;
+	float max;
+};
+
+struct RowU8 {
+	uint64_t sum;
+	uint8_t min;
+	uint8_t max;
+};
+
+struct Kernels {
+	void (*row_f32)(const float *p, uint32_t count, uint32_t step, RowF32 *out);
+	void (*row_u8)(const uint8_t *p, uint32_t count, uint32_t step, RowU8 *out);
+};
+
+// Kernels of each instruction set, nullptr when not built for this target
+const Kernels *kernels_scalar();
+const Kernels *kernels_sse2();
+const Kernels *kernels_avx2();
+const Kernels *kernels_neon();
+
+// Adds samples first to count - 1 of the row to the lanes, sample k in lane
+// k % 8, then folds the lanes into out. min and max as _mm_min_ps(v, m) and
+// _mm_max_ps(v, m), so a NaN sample is skipped by every kernel alike
+inline void lanes_fold(const float *p, uint32_t first, uint32_t count, uint32_t step,
+					   float *sum, float *lo, float *hi, RowF32 *out)
+{
+	uint32_t k, l;
+	float v, m_lo, m_hi;
+
+	for (k = first; k < count; k++) {
+		v = p[(uint64_t)k * step];
+		l = k % HGDEPTH_LANES;
+		sum[l] += v;
+		lo[l] = (v < lo[l]) ? v : lo[l];
+		hi[l] = (v > hi[l]) ? v : hi[l];
+	}
+
+	m_lo = lo[0];
+	m_hi = hi[0];
+	for (l = 1; l < HGDEPTH_LANES; l++) {
+		m_lo = (lo[l] < m_lo) ? lo[l] : m_lo;
+		m_hi = (hi[l] > m_hi) ? hi[l] : m_hi;
+	}
+
+	out->sum = (((double)sum[0] + (double)sum[1]) + ((double)sum[2] + (double)sum[3])) +
+			   (((double)sum[4] + (double)sum[5]) + ((double)sum[6] + (double)sum[7]));
+	out->min = m_lo;
+	out->max = m_hi;
+}
+
+} // namespace detail
+} // namespace hgdepth
+
+#endif /* HGDEPTH_KERNELS_H_ */
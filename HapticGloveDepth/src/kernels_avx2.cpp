@@ -0,0 +1,146 @@
+/*
+ * kernels_avx2.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// AVX2 kernels, built with -mavx2 and used when the CPU has it. Floating point
+// rows in one register of 8 lanes; every second sample is picked out of 16
+// with VSHUFPS and put back in order with VPERMPD. 8 bit rows 32 samples per
+// step, summed with VPSADBW.
+
+// Includes
+#include <limits>
+#include "kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace hgdepth {
+namespace detail {
+
+#if defined(__AVX2__)
+
+// Private functions
+namespace {
+
+void row_f32(const float *p, uint32_t count, uint32_t step, RowF32 *out)
+{
+	alignas(32) float sum[HGDEPTH_LANES];
+	alignas(32) float lo[HGDEPTH_LANES];
+	alignas(32) float hi[HGDEPTH_LANES];
+	__m256 s = _mm256_setzero_ps();
+	__m256 vlo = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+	__m256 vhi = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+	__m256 v;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + HGDEPTH_LANES <= count; k += HGDEPTH_LANES) {
+			v = _mm256_loadu_ps(p + k);
+			s = _mm256_add_ps(s, v);
+			vlo = _mm256_min_ps(v, vlo);
+			vhi = _mm256_max_ps(v, vhi);
+		}
+	} else if (step == 2) {
+		// Last group left to the tail so as not to read past the row
+		for (; k + HGDEPTH_LANES < count; k += HGDEPTH_LANES) {
+			const float *q = p + (2 * k);
+			v = _mm256_shuffle_ps(_mm256_loadu_ps(q), _mm256_loadu_ps(q + 8), _MM_SHUFFLE(2, 0, 2, 0));
+			v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3, 1, 2, 0)));
+			s = _mm256_add_ps(s, v);
+			vlo = _mm256_min_ps(v, vlo);
+			vhi = _mm256_max_ps(v, vhi);
+		}
+	}
+
+	_mm256_store_ps(sum, s);
+	_mm256_store_ps(lo, vlo);
+	_mm256_store_ps(hi, vhi);
+
+	lanes_fold(p, k, count, step, sum, lo, hi, out);
+}
+
+void row_u8(const uint8_t *p, uint32_t count, uint32_t step, RowU8 *out)
+{
+	alignas(32) uint64_t sum[4];
+	alignas(32) uint8_t lo[32];
+	alignas(32) uint8_t hi[32];
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i even = _mm256_set1_epi16(0x00FF);
+	__m256i acc = zero;
+	__m256i vlo = _mm256_set1_epi8((char)0xFF);
+	__m256i vhi = zero;
+	__m256i v;
+	uint64_t total;
+	uint8_t m_lo, m_hi;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + 32 <= count; k += 32) {
+			v = _mm256_loadu_si256((const __m256i *)(p + k));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+			vlo = _mm256_min_epu8(v, vlo);
+			vhi = _mm256_max_epu8(v, vhi);
+		}
+	} else if (step == 2) {
+		// Even bytes of 64, packed per 128 bit half: out of order, which
+		// neither the sum nor the min and max care about
+		for (; k + 32 < count; k += 32) {
+			const uint8_t *q = p + (2 * k);
+			v = _mm256_packus_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)q), even),
+									_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(q + 32)), even));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+			vlo = _mm256_min_epu8(v, vlo);
+			vhi = _mm256_max_epu8(v, vhi);
+		}
+	}
+
+	_mm256_store_si256((__m256i *)sum, acc);
+	_mm256_store_si256((__m256i *)lo, vlo);
+	_mm256_store_si256((__m256i *)hi, vhi);
+
+	total = sum[0] + sum[1] + sum[2] + sum[3];
+	m_lo = UINT8_MAX;
+	m_hi = 0;
+	for (uint32_t l = 0; l < 32; l++) {
+		m_lo = (lo[l] < m_lo) ? lo[l] : m_lo;
+		m_hi = (hi[l] > m_hi) ? hi[l] : m_hi;
+	}
+
+	for (; k < count; k++) {
+		uint8_t b = p[(uint64_t)k * step];
+		total += b;
+		m_lo = (b < m_lo) ? b : m_lo;
+		m_hi = (b > m_hi) ? b : m_hi;
+	}
+
+	out->sum = total;
+	out->min = m_lo;
+	out->max = m_hi;
+}
+
+const Kernels kernels = {row_f32, row_u8};
+
+} // namespace
+
+// Exported functions
+
+const Kernels *kernels_avx2()
+{
+	return &kernels;
+}
+
+#else
+
+const Kernels *kernels_avx2()
+{
+	return nullptr;
+}
+
+#endif
+
+} // namespace detail
+} // namespace hgdepth
@@ -0,0 +1,166 @@
+/*
+ * kernels_neon.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// NEON kernels, AArch64 and ARMv7 built with NEON. Floating point rows in two
+// registers of 4 lanes; every second sample comes out of the deinterleaving
+// VLD2. The min and max select with a compare, as _mm_min_ps does, so a NaN
+// sample is skipped like in the other kernels. 8 bit rows 16 samples per
+// step, summed by pairwise widening adds.
+
+// Includes
+#include <limits>
+#include "kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HGDEPTH_NEON	1
+#endif
+
+namespace hgdepth {
+namespace detail {
+
+#if defined(HGDEPTH_NEON)
+
+// Private functions
+namespace {
+
+inline float32x4_t min_f32(float32x4_t v, float32x4_t m)
+{
+	return vbslq_f32(vcltq_f32(v, m), v, m);
+}
+
+inline float32x4_t max_f32(float32x4_t v, float32x4_t m)
+{
+	return vbslq_f32(vcgtq_f32(v, m), v, m);
+}
+
+void row_f32(const float *p, uint32_t count, uint32_t step, RowF32 *out)
+{
+	float sum[HGDEPTH_LANES];
+	float lo[HGDEPTH_LANES];
+	float hi[HGDEPTH_LANES];
+	float32x4_t s0 = vdupq_n_f32(0.0f);
+	float32x4_t s1 = s0;
+	float32x4_t lo0 = vdupq_n_f32(std::numeric_limits<float>::infinity());
+	float32x4_t lo1 = lo0;
+	float32x4_t hi0 = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+	float32x4_t hi1 = hi0;
+	float32x4_t a, b;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + HGDEPTH_LANES <= count; k += HGDEPTH_LANES) {
+			a = vld1q_f32(p + k);
+			b = vld1q_f32(p + k + 4);
+			s0 = vaddq_f32(s0, a);
+			s1 = vaddq_f32(s1, b);
+			lo0 = min_f32(a, lo0);
+			lo1 = min_f32(b, lo1);
+			hi0 = max_f32(a, hi0);
+			hi1 = max_f32(b, hi1);
+		}
+	} else if (step == 2) {
+		// Last group left to the tail so as not to read past the row
+		for (; k + HGDEPTH_LANES < count; k += HGDEPTH_LANES) {
+			const float *q = p + (2 * k);
+			a = vld2q_f32(q).val[0];
+			b = vld2q_f32(q + 8).val[0];
+			s0 = vaddq_f32(s0, a);
+			s1 = vaddq_f32(s1, b);
+			lo0 = min_f32(a, lo0);
+			lo1 = min_f32(b, lo1);
+			hi0 = max_f32(a, hi0);
+			hi1 = max_f32(b, hi1);
+		}
+	}
+
+	vst1q_f32(sum, s0);
+	vst1q_f32(sum + 4, s1);
+	vst1q_f32(lo, lo0);
+	vst1q_f32(lo + 4, lo1);
+	vst1q_f32(hi, hi0);
+	vst1q_f32(hi + 4, hi1);
+
+	lanes_fold(p, k, count, step, sum, lo, hi, out);
+}
+
+void row_u8(const uint8_t *p, uint32_t count, uint32_t step, RowU8 *out)
+{
+	uint32_t sum[4];
+	uint8_t lo[16];
+	uint8_t hi[16];
+	uint32x4_t acc = vdupq_n_u32(0);
+	uint8x16_t vlo = vdupq_n_u8(UINT8_MAX);
+	uint8x16_t vhi = vdupq_n_u8(0);
+	uint8x16_t v;
+	uint64_t total = 0;
+	uint8_t m_lo, m_hi;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + 16 <= count; k += 16) {
+			v = vld1q_u8(p + k);
+			acc = vpadalq_u16(acc, vpaddlq_u8(v));
+			vlo = vminq_u8(v, vlo);
+			vhi = vmaxq_u8(v, vhi);
+		}
+	} else if (step == 2) {
+		// Last group left to the tail so as not to read past the row
+		for (; k + 16 < count; k += 16) {
+			v = vld2q_u8(p + (2 * k)).val[0];
+			acc = vpadalq_u16(acc, vpaddlq_u8(v));
+			vlo = vminq_u8(v, vlo);
+			vhi = vmaxq_u8(v, vhi);
+		}
+	}
+
+	vst1q_u32(sum, acc);
+	vst1q_u8(lo, vlo);
+	vst1q_u8(hi, vhi);
+
+	total = (uint64_t)sum[0] + sum[1] + sum[2] + sum[3];
+	m_lo = UINT8_MAX;
+	m_hi = 0;
+	for (uint32_t l = 0; l < 16; l++) {
+		m_lo = (lo[l] < m_lo) ? lo[l] : m_lo;
+		m_hi = (hi[l] > m_hi) ? hi[l] : m_hi;
+	}
+
+	for (; k < count; k++) {
+		uint8_t b = p[(uint64_t)k * step];
+		total += b;
+		m_lo = (b < m_lo) ? b : m_lo;
+		m_hi = (b > m_hi) ? b : m_hi;
+	}
+
+	out->sum = total;
+	out->min = m_lo;
+	out->max = m_hi;
+}
+
+const Kernels kernels = {row_f32, row_u8};
+
+} // namespace
+
+// Exported functions
+
+const Kernels *kernels_neon()
+{
+	return &kernels;
+}
+
+#else
+
+const Kernels *kernels_neon()
+{
+	return nullptr;
+}
+
+#endif
+
+} // namespace detail
+} // namespace hgdepth
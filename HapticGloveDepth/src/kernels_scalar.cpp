@@ -0,0 +1,66 @@
+/*
+ * kernels_scalar.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Reference kernels, plain C++ on any target. The vector kernels are tested
+// against these.
+
+// Includes
+#include <limits>
+#include "kernels.h"
+
+namespace hgdepth {
+namespace detail {
+
+// Private functions
+namespace {
+
+void row_f32(const float *p, uint32_t count, uint32_t step, RowF32 *out)
+{
+	float sum[HGDEPTH_LANES];
+	float lo[HGDEPTH_LANES];
+	float hi[HGDEPTH_LANES];
+
+	for (uint32_t l = 0; l < HGDEPTH_LANES; l++) {
+		sum[l] = 0.0f;
+		lo[l] = std::numeric_limits<float>::infinity();
+		hi[l] = -std::numeric_limits<float>::infinity();
+	}
+
+	lanes_fold(p, 0, count, step, sum, lo, hi, out);
+}
+
+void row_u8(const uint8_t *p, uint32_t count, uint32_t step, RowU8 *out)
+{
+	uint64_t sum = 0;
+	uint8_t lo = UINT8_MAX;
+	uint8_t hi = 0;
+
+	for (uint32_t k = 0; k < count; k++) {
+		uint8_t v = p[(uint64_t)k * step];
+		sum += v;
+		lo = (v < lo) ? v : lo;
+		hi = (v > hi) ? v : hi;
+	}
+
+	out->sum = sum;
+	out->min = lo;
+	out->max = hi;
+}
+
+const Kernels kernels = {row_f32, row_u8};
+
+} // namespace
+
+// Exported functions
+
+const Kernels *kernels_scalar()
+{
+	return &kernels;
+}
+
+} // namespace detail
+} // namespace hgdepth
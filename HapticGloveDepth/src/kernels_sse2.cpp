@@ -0,0 +1,159 @@
+/*
+ * kernels_sse2.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// SSE2 kernels, x86 and x86-64. Floating point rows in two registers of 4
+// lanes, 8 samples per step; every second sample is picked out of 16 with
+// SHUFPS. 8 bit rows 16 samples per step, summed with PSADBW.
+
+// Includes
+#include <limits>
+#include "kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define HGDEPTH_SSE2	1
+#endif
+
+namespace hgdepth {
+namespace detail {
+
+#if defined(HGDEPTH_SSE2)
+
+// Private functions
+namespace {
+
+void row_f32(const float *p, uint32_t count, uint32_t step, RowF32 *out)
+{
+	alignas(16) float sum[HGDEPTH_LANES];
+	alignas(16) float lo[HGDEPTH_LANES];
+	alignas(16) float hi[HGDEPTH_LANES];
+	__m128 s0 = _mm_setzero_ps();
+	__m128 s1 = _mm_setzero_ps();
+	__m128 lo0 = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	__m128 lo1 = lo0;
+	__m128 hi0 = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+	__m128 hi1 = hi0;
+	__m128 a, b;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + HGDEPTH_LANES <= count; k += HGDEPTH_LANES) {
+			a = _mm_loadu_ps(p + k);
+			b = _mm_loadu_ps(p + k + 4);
+			s0 = _mm_add_ps(s0, a);
+			s1 = _mm_add_ps(s1, b);
+			lo0 = _mm_min_ps(a, lo0);
+			lo1 = _mm_min_ps(b, lo1);
+			hi0 = _mm_max_ps(a, hi0);
+			hi1 = _mm_max_ps(b, hi1);
+		}
+	} else if (step == 2) {
+		// The 16 floats of a step end one sample past the last one used: the
+		// last group is left to the tail so as not to read past the row
+		for (; k + HGDEPTH_LANES < count; k += HGDEPTH_LANES) {
+			const float *q = p + (2 * k);
+			a = _mm_shuffle_ps(_mm_loadu_ps(q), _mm_loadu_ps(q + 4), _MM_SHUFFLE(2, 0, 2, 0));
+			b = _mm_shuffle_ps(_mm_loadu_ps(q + 8), _mm_loadu_ps(q + 12), _MM_SHUFFLE(2, 0, 2, 0));
+			s0 = _mm_add_ps(s0, a);
+			s1 = _mm_add_ps(s1, b);
+			lo0 = _mm_min_ps(a, lo0);
+			lo1 = _mm_min_ps(b, lo1);
+			hi0 = _mm_max_ps(a, hi0);
+			hi1 = _mm_max_ps(b, hi1);
+		}
+	}
+
+	_mm_store_ps(sum, s0);
+	_mm_store_ps(sum + 4, s1);
+	_mm_store_ps(lo, lo0);
+	_mm_store_ps(lo + 4, lo1);
+	_mm_store_ps(hi, hi0);
+	_mm_store_ps(hi + 4, hi1);
+
+	lanes_fold(p, k, count, step, sum, lo, hi, out);
+}
+
+void row_u8(const uint8_t *p, uint32_t count, uint32_t step, RowU8 *out)
+{
+	alignas(16) uint64_t sum[2];
+	alignas(16) uint8_t lo[16];
+	alignas(16) uint8_t hi[16];
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i even = _mm_set1_epi16(0x00FF);
+	__m128i acc = zero;
+	__m128i vlo = _mm_set1_epi8((char)0xFF);
+	__m128i vhi = zero;
+	__m128i v;
+	uint64_t total;
+	uint8_t m_lo, m_hi;
+	uint32_t k = 0;
+
+	if (step == 1) {
+		for (; k + 16 <= count; k += 16) {
+			v = _mm_loadu_si128((const __m128i *)(p + k));
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+			vlo = _mm_min_epu8(v, vlo);
+			vhi = _mm_max_epu8(v, vhi);
+		}
+	} else if (step == 2) {
+		// Even bytes of 32, packed. Last group left to the tail as above
+		for (; k + 16 < count; k += 16) {
+			const uint8_t *q = p + (2 * k);
+			v = _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)q), even),
+								 _mm_and_si128(_mm_loadu_si128((const __m128i *)(q + 16)), even));
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+			vlo = _mm_min_epu8(v, vlo);
+			vhi = _mm_max_epu8(v, vhi);
+		}
+	}
+
+	_mm_store_si128((__m128i *)sum, acc);
+	_mm_store_si128((__m128i *)lo, vlo);
+	_mm_store_si128((__m128i *)hi, vhi);
+
+	total = sum[0] + sum[1];
+	m_lo = UINT8_MAX;
+	m_hi = 0;
+	for (uint32_t l = 0; l < 16; l++) {
+		m_lo = (lo[l] < m_lo) ? lo[l] : m_lo;
+		m_hi = (hi[l] > m_hi) ? hi[l] : m_hi;
+	}
+
+	for (; k < count; k++) {
+		uint8_t s = p[(uint64_t)k * step];
+		total += s;
+		m_lo = (s < m_lo) ? s : m_lo;
+		m_hi = (s > m_hi) ? s : m_hi;
+	}
+
+	out->sum = total;
+	out->min = m_lo;
+	out->max = m_hi;
+}
+
+const Kernels kernels = {row_f32, row_u8};
+
+} // namespace
+
+// Exported functions
+
+const Kernels *kernels_sse2()
+{
+	return &kernels;
+}
+
+#else
+
+const Kernels *kernels_sse2()
+{
+	return nullptr;
+}
+
+#endif
+
+} // namespace detail
+} // namespace hgdepth
@@ -0,0 +1,65 @@
+/*
+ * layout.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Region layouts of the app and of the glove, for the tests and the benchmark
+// and as a starting point for others.
+
+// Includes
+#include "hgdepth/reduce.h"
+
+namespace hgdepth {
+
+// Exported functions
+
+std::vector<Region> quadrant_layout(uint32_t width, uint32_t height)
+{
+	std::vector<Region> regions;
+	uint32_t quad_w = width / 2;
+	uint32_t quad_h = height / 2;
+	uint32_t centre_w = quad_w / 4;
+	uint32_t centre_h = quad_h / 4;
+
+	for (uint32_t r = 0; r < 4; r++) {
+		Region region;
+		region.x = ((r % 2) * quad_w) + ((quad_w - centre_w) / 2);
+		region.y = ((r / 2) * quad_h) + ((quad_h - centre_h) / 2);
+		region.width = centre_w;
+		region.height = centre_h;
+		region.step_x = 2;
+		region.step_y = 2;
+		regions.push_back(region);
+	}
+
+	return regions;
+}
+
+std::vector<Region> grid_layout(uint32_t width, uint32_t height, uint32_t cols, uint32_t rows)
+{
+	std::vector<Region> regions;
+
+	if ((cols == 0) || (rows == 0)) {
+		return regions;
+	}
+
+	uint32_t cell_w = width / cols;
+	uint32_t cell_h = height / rows;
+
+	for (uint32_t j = 0; j < rows; j++) {
+		for (uint32_t i = 0; i < cols; i++) {
+			Region region;
+			region.width = cell_w / 2;
+			region.height = cell_h / 2;
+			region.x = (i * cell_w) + ((cell_w - region.width) / 2);
+			region.y = (j * cell_h) + ((cell_h - region.height) / 2);
+			regions.push_back(region);
+		}
+	}
+
+	return regions;
+}
+
+} // namespace hgdepth
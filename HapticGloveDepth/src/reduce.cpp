@@ -0,0 +1,355 @@
+/*
+ * reduce.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Reducer. The rows of all the regions are listed once per frame and handed
+// out to the threads in contiguous ranges; each row result lands in its own
+// slot. The slots are then combined region by region in row order by the
+// calling thread, which is why neither the thread count nor the kernels
+// change the result.
+
+// Includes
+#include <cfloat>
+#include "hgdepth/reduce.h"
+#include "kernels.h"
+#include "thread_pool.h"
+
+namespace hgdepth {
+
+using detail::Kernels;
+using detail::RowF32;
+using detail::RowU8;
+
+// Variables
+
+struct Reducer::Impl {
+	// Row of a region, as scanned by a kernel
+	struct Row {
+		size_t offset;		// First sample, from the start of the map
+		uint32_t count;
+		uint32_t step;
+	};
+
+	Isa isa = Isa::Scalar;
+	const Kernels *kernels = nullptr;
+	std::unique_ptr<detail::ThreadPool> pool;
+	std::vector<Row> rows;
+	std::vector<size_t> first;		// First row of each region, and the end
+	std::vector<RowF32> out_f32;
+	std::vector<RowU8> out_u8;
+
+	// Per region, kept from frame to frame
+	std::vector<float> average;
+	std::vector<float> lo;
+	std::vector<float> hi;
+	std::vector<uint64_t> sum;
+	std::vector<uint64_t> samples;
+
+	template <typename T>
+	Status plan(const Image<T> &image, const Region *regions, size_t count, const float *out);
+};
+
+// Private functions
+namespace {
+
+const Kernels *kernels_of(Isa isa)
+{
+	switch (isa) {
+	case Isa::Scalar:
+		return detail::kernels_scalar();
+	case Isa::Sse2:
+		return detail::kernels_sse2();
+	case Isa::Avx2:
+		return detail::kernels_avx2();
+	case Isa::Neon:
+		return detail::kernels_neon();
+	default:
+		return nullptr;
+	}
+}
+
+bool cpu_has(Isa isa)
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	if (isa == Isa::Sse2) {
+		return __builtin_cpu_supports("sse2");
+	}
+	if (isa == Isa::Avx2) {
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+	// Built in means runnable for the others: NEON is part of AArch64, and
+	// ARMv7 builds only have it when compiled for it
+	return (isa == Isa::Scalar) || (isa == Isa::Neon);
+}
+
+uint32_t steps(uint32_t length, uint32_t step)
+{
+	return (length + step - 1) / step;
+}
+
+// Average of a region normalized by the range of all the regions, weighted, at most 1
+float normalize(float average, float min, float range, float weight)
+{
+	float value = ((average - min) / range) * weight;
+
+	return (value > 1.0f) ? 1.0f : value;
+}
+
+} // namespace
+
+template <typename T>
+Status Reducer::Impl::plan(const Image<T> &image, const Region *regions, size_t count, const float *out)
+{
+	if ((image.data == nullptr) || (image.stride < image.width) ||
+		(regions == nullptr) || (count == 0) || (out == nullptr)) {
+		return Status::InvalidArgument;
+	}
+
+	for (size_t r = 0; r < count; r++) {
+		const Region &region = regions[r];
+		if ((region.width == 0) || (region.height == 0) ||
+			(region.step_x == 0) || (region.step_y == 0) ||
+			((uint64_t)region.x + region.width > image.width) ||
+			((uint64_t)region.y + region.height > image.height)) {
+			return Status::InvalidArgument;
+		}
+	}
+
+	rows.clear();
+	first.clear();
+
+	for (size_t r = 0; r < count; r++) {
+		const Region &region = regions[r];
+		uint32_t n = steps(region.height, region.step_y);
+		uint32_t samples = steps(region.width, region.step_x);
+
+		first.push_back(rows.size());
+		for (uint32_t i = 0; i < n; i++) {
+			size_t y = (size_t)region.y + ((size_t)i * region.step_y);
+			rows.push_back({(y * image.stride) + region.x, samples, region.step_x});
+		}
+	}
+	first.push_back(rows.size());
+
+	return Status::Ok;
+}
+
+// Exported functions
+
+bool isa_supported(Isa isa)
+{
+	if (isa == Isa::Best) {
+		return true;
+	}
+
+	return (kernels_of(isa) != nullptr) && cpu_has(isa);
+}
+
+Isa best_isa()
+{
+	static const Isa order[] = {Isa::Avx2, Isa::Neon, Isa::Sse2};
+
+	for (Isa isa : order) {
+		if (isa_supported(isa)) {
+			return isa;
+		}
+	}
+
+	return Isa::Scalar;
+}
+
+const char *status_name(Status status)
+{
+	switch (status) {
+	case Status::Ok:
+		return "ok";
+	case Status::InvalidArgument:
+		return "invalid argument";
+	case Status::UnsupportedIsa:
+		return "unsupported instruction set";
+	case Status::IoError:
+		return "i/o error";
+	case Status::InvalidFormat:
+		return "invalid format";
+	}
+
+	return "unknown";
+}
+
+const char *isa_name(Isa isa)
+{
+	switch (isa) {
+	case Isa::Scalar:
+		return "scalar";
+	case Isa::Sse2:
+		return "sse2";
+	case Isa::Avx2:
+		return "avx2";
+	case Isa::Neon:
+		return "neon";
+	case Isa::Best:
+		return "best";
+	}
+
+	return "unknown";
+}
+
+Reducer::Reducer() : impl_(new Impl)
+{
+	init(Options());
+}
+
+Reducer::~Reducer() = default;
+
+Status Reducer::init(const Options &options)
+{
+	Isa isa = (options.isa == Isa::Best) ? best_isa() : options.isa;
+	unsigned threads = (options.threads == 0) ? 1 : options.threads;
+
+	if (!isa_supported(isa)) {
+		return Status::UnsupportedIsa;
+	}
+
+	impl_->isa = isa;
+	impl_->kernels = kernels_of(isa);
+	if (!impl_->pool || (impl_->pool->threads() != threads)) {
+		impl_->pool.reset(new detail::ThreadPool(threads));
+	}
+
+	return Status::Ok;
+}
+
+Isa Reducer::isa() const
+{
+	return impl_->isa;
+}
+
+unsigned Reducer::threads() const
+{
+	return impl_->pool->threads();
+}
+
+Status Reducer::reduce(const Image<float> &image, const Region *regions, size_t count,
+					   float *out, RegionStats *stats)
+{
+	Impl &m = *impl_;
+	Status status = m.plan(image, regions, count, out);
+	std::vector<float> &average = m.average;
+	std::vector<float> &lo = m.lo;
+	std::vector<float> &hi = m.hi;
+	float min = FLT_MAX;
+	float max = -FLT_MAX;
+	float range;
+
+	if (status != Status::Ok) {
+		return status;
+	}
+
+	average.resize(count);
+	lo.resize(count);
+	hi.resize(count);
+	m.out_f32.resize(m.rows.size());
+	m.pool->run(m.rows.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const Impl::Row &row = m.rows[i];
+			m.kernels->row_f32(image.data + row.offset, row.count, row.step, &m.out_f32[i]);
+		}
+	});
+
+	for (size_t r = 0; r < count; r++) {
+		double sum = 0.0;
+		uint64_t samples = 0;
+
+		lo[r] = m.out_f32[m.first[r]].min;
+		hi[r] = m.out_f32[m.first[r]].max;
+		for (size_t i = m.first[r]; i < m.first[r + 1]; i++) {
+			sum += m.out_f32[i].sum;
+			samples += m.rows[i].count;
+			lo[r] = (m.out_f32[i].min < lo[r]) ? m.out_f32[i].min : lo[r];
+			hi[r] = (m.out_f32[i].max > hi[r]) ? m.out_f32[i].max : hi[r];
+		}
+
+		average[r] = (float)(sum / (double)samples);
+		min = (lo[r] < min) ? lo[r] : min;
+		max = (hi[r] > max) ? hi[r] : max;
+
+		if (stats != nullptr) {
+			stats[r].sum = sum;
+			stats[r].min = lo[r];
+			stats[r].max = hi[r];
+			stats[r].count = samples;
+		}
+	}
+
+	// As calculateRegionDepths
+	range = ((max - min) > FLT_EPSILON) ? (max - min) : FLT_EPSILON;
+
+	for (size_t r = 0; r < count; r++) {
+		out[r] = normalize(average[r], min, range, regions[r].weight);
+	}
+
+	return Status::Ok;
+}
+
+Status Reducer::reduce(const Image<uint8_t> &image, const Region *regions, size_t count,
+					   float *out, RegionStats *stats)
+{
+	Impl &m = *impl_;
+	Status status = m.plan(image, regions, count, out);
+	std::vector<uint64_t> &sum = m.sum;
+	std::vector<uint64_t> &samples = m.samples;
+	uint8_t min = UINT8_MAX;
+	uint8_t max = 0;
+	float range;
+
+	if (status != Status::Ok) {
+		return status;
+	}
+
+	sum.assign(count, 0);
+	samples.assign(count, 0);
+	m.out_u8.resize(m.rows.size());
+	m.pool->run(m.rows.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const Impl::Row &row = m.rows[i];
+			m.kernels->row_u8(image.data + row.offset, row.count, row.step, &m.out_u8[i]);
+		}
+	});
+
+	for (size_t r = 0; r < count; r++) {
+		uint8_t lo = UINT8_MAX;
+		uint8_t hi = 0;
+
+		for (size_t i = m.first[r]; i < m.first[r + 1]; i++) {
+			sum[r] += m.out_u8[i].sum;
+			samples[r] += m.rows[i].count;
+			lo = (m.out_u8[i].min < lo) ? m.out_u8[i].min : lo;
+			hi = (m.out_u8[i].max > hi) ? m.out_u8[i].max : hi;
+		}
+
+		min = (lo < min) ? lo : min;
+		max = (hi > max) ? hi : max;
+
+		if (stats != nullptr) {
+			stats[r].sum = (double)sum[r];
+			stats[r].min = lo;
+			stats[r].max = hi;
+			stats[r].count = samples[r];
+		}
+	}
+
+	// As depth_tile.c
+	range = (max > min) ? (float)(max - min) : 1.0f;
+
+	for (size_t r = 0; r < count; r++) {
+		out[r] = normalize((float)sum[r] / (float)samples[r], (float)min, range, regions[r].weight);
+	}
+
+	return Status::Ok;
+}
+
+} // namespace hgdepth
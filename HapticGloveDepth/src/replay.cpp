@@ -0,0 +1,184 @@
+/*
+ * replay.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "hgdepth/replay.h"
+#include "haptic_predict.h"
+#include "haptic_render.h"
+
+namespace hgdepth {
+
+static_assert(HGDEPTH_GRID_CELLS == HAPTIC_CELL_NUM, "grid of the firmware");
+static_assert(HGDEPTH_GRID_LEN == HAPTIC_GRID_LEN, "grid characteristic of the firmware");
+
+// Private functions
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double us_between(Clock::time_point a, Clock::time_point b)
+{
+	return std::chrono::duration<double, std::micro>(b - a).count();
+}
+
+StageStats summarize(std::vector<double> &times)
+{
+	StageStats s;
+	double sum = 0.0;
+
+	if (times.empty()) {
+		return s;
+	}
+
+	for (double t : times) {
+		sum += t;
+	}
+	std::sort(times.begin(), times.end());
+
+	s.mean = sum / (double)times.size();
+	s.p50 = times[times.size() / 2];
+	s.p99 = times[std::min(times.size() - 1, (times.size() * 99) / 100)];
+	s.max = times.back();
+
+	return s;
+}
+
+} // namespace
+
+// Exported functions
+
+void encode_grid(uint16_t timestamp, const float *grid, uint8_t *out)
+{
+	out[0] = (uint8_t)timestamp;
+	out[1] = (uint8_t)(timestamp >> 8);
+
+	for (uint32_t i = 0; i < HGDEPTH_GRID_CELLS; i++) {
+		uint32_t raw;
+		std::memcpy(&raw, &grid[i], sizeof(raw));
+		out[2 + (i * 4)] = (uint8_t)raw;
+		out[3 + (i * 4)] = (uint8_t)(raw >> 8);
+		out[4 + (i * 4)] = (uint8_t)(raw >> 16);
+		out[5 + (i * 4)] = (uint8_t)(raw >> 24);
+	}
+}
+
+Status replay(const SequenceReader &sequence, const ReplayOptions &options, ReplayStats *stats,
+			  const std::function<void(const ReplayFrame &)> &on_frame)
+{
+	const SequenceInfo &info = sequence.info();
+	std::vector<Region> layout = options.layout.empty() ? quadrant_layout(info.width, info.height) : options.layout;
+	std::vector<float> depth((size_t)info.width * info.height);
+	std::vector<double> times[5];
+	uint8_t value[HGDEPTH_GRID_LEN];
+	Image<float> image{depth.data(), info.width, info.height, info.width};
+	Reducer reducer;
+	ReplayFrame out;
+	Status status;
+	Clock::time_point start, due;
+	uint64_t first_us = 0;
+
+	if ((sequence.size() == 0) || (layout.size() != HGDEPTH_GRID_CELLS) || (stats == nullptr)) {
+		return Status::InvalidArgument;
+	}
+
+	status = reducer.init(options.reducer);
+	if (status != Status::Ok) {
+		return status;
+	}
+
+	if (options.latency_ms >= 0) {
+		Haptic_PredictLatency((uint32_t)options.latency_ms);
+	}
+
+	*stats = ReplayStats();
+	for (std::vector<double> &t : times) {
+		t.reserve(sequence.size() * options.loops);
+	}
+
+	start = Clock::now();
+
+	for (unsigned loop = 0; loop < options.loops; loop++) {
+		Clock::time_point loop_start = Clock::now();
+
+		// The render path of the firmware starts over with the sequence
+		Haptic_RenderReset();
+
+		for (size_t i = 0; i < sequence.size(); i++) {
+			Frame frame;
+			uint16_t timestamp;
+
+			sequence.frame(i, &frame);
+			if (i == 0) {
+				first_us = frame.timestamp_us;
+			}
+
+			if (options.rate == ReplayRate::Recorded) {
+				due = loop_start + std::chrono::microseconds(frame.timestamp_us - first_us);
+				std::this_thread::sleep_until(due);
+			}
+
+			out.index = i;
+			out.timestamp_us = frame.timestamp_us;
+
+			Clock::time_point t0 = Clock::now();
+			decode_frame(info, frame.samples, depth.data(), layout.data(), layout.size());
+
+			Clock::time_point t1 = Clock::now();
+			status = reducer.reduce(image, layout.data(), layout.size(), out.grid);
+			if (status != Status::Ok) {
+				return status;
+			}
+
+			Clock::time_point t2 = Clock::now();
+			encode_grid((uint16_t)(frame.timestamp_us / 1000U), out.grid, value);
+
+			Clock::time_point t3 = Clock::now();
+			Haptic_GridDecode(value, sizeof(value), &timestamp, out.applied);
+			Haptic_Render(out.applied, (uint32_t)(frame.timestamp_us / 1000U), out.pulse);
+
+			Clock::time_point t4 = Clock::now();
+
+			out.stage_us[0] = us_between(t0, t1);
+			out.stage_us[1] = us_between(t1, t2);
+			out.stage_us[2] = us_between(t2, t3);
+			out.stage_us[3] = us_between(t3, t4);
+			for (int s = 0; s < 4; s++) {
+				times[s].push_back(out.stage_us[s]);
+			}
+			times[4].push_back(us_between(t0, t4));
+
+			// Late if the next frame was due before this one was done
+			if ((options.rate == ReplayRate::Recorded) && (i + 1 < sequence.size())) {
+				Frame next;
+				sequence.frame(i + 1, &next);
+				if (t4 > loop_start + std::chrono::microseconds(next.timestamp_us - first_us)) {
+					stats->late++;
+				}
+			}
+
+			if (on_frame) {
+				on_frame(out);
+			}
+		}
+	}
+
+	stats->wall_s = us_between(start, Clock::now()) / 1e6;
+	stats->frames = times[4].size();
+	stats->decode = summarize(times[0]);
+	stats->reduce = summarize(times[1]);
+	stats->encode = summarize(times[2]);
+	stats->apply = summarize(times[3]);
+	stats->total = summarize(times[4]);
+
+	return Status::Ok;
+}
+
+} // namespace hgdepth
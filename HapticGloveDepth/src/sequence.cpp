@@ -0,0 +1,435 @@
+/*
+ * sequence.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Depth sequence files, see sequence.h. The reader uses mmap, so POSIX
+// hosts only; the samples are handed out as they are in the file, which
+// takes a little endian host as well.
+
+// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hgdepth/sequence.h"
+
+namespace hgdepth {
+
+// Private functions
+namespace {
+
+void put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+void put_u32(uint8_t *p, uint32_t v)
+{
+	put_u16(p, (uint16_t)v);
+	put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+void put_u64(uint8_t *p, uint64_t v)
+{
+	put_u32(p, (uint32_t)v);
+	put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+void put_f32(uint8_t *p, float v)
+{
+	uint32_t raw;
+
+	std::memcpy(&raw, &v, sizeof(raw));
+	put_u32(p, raw);
+}
+
+uint16_t get_u16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t *p)
+{
+	return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+uint64_t get_u64(const uint8_t *p)
+{
+	return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+float get_f32(const uint8_t *p)
+{
+	uint32_t raw = get_u32(p);
+	float v;
+
+	std::memcpy(&v, &raw, sizeof(v));
+	return v;
+}
+
+bool little_endian()
+{
+	const uint16_t one = 1;
+
+	return *(const uint8_t *)&one == 1;
+}
+
+uint64_t frame_length(const SequenceInfo &info)
+{
+	return (uint64_t)info.width * info.height * sizeof(uint16_t);
+}
+
+bool write_all(std::FILE *file, const void *data, size_t length)
+{
+	return std::fwrite(data, 1, length, file) == length;
+}
+
+} // namespace
+
+// Exported functions
+
+SequenceReader::~SequenceReader()
+{
+	close();
+}
+
+Status SequenceReader::open(const char *path)
+{
+	struct stat st;
+	const uint8_t *h;
+	uint64_t frame_len, index_offset;
+	int fd;
+
+	close();
+
+	if (!little_endian()) {
+		return Status::InvalidFormat;
+	}
+
+	fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return Status::IoError;
+	}
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return Status::IoError;
+	}
+	if (st.st_size < (off_t)HGDEPTH_SEQ_HEADER_LEN) {
+		::close(fd);
+		return Status::InvalidFormat;
+	}
+
+	length_ = (size_t)st.st_size;
+	void *map = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		length_ = 0;
+		return Status::IoError;
+	}
+	map_ = (const uint8_t *)map;
+	h = map_;
+
+	info_.width = get_u32(h + 8);
+	info_.height = get_u32(h + 12);
+	info_.type = (SampleType)get_u16(h + 16);
+	info_.scale = get_f32(h + 20);
+	info_.offset = get_f32(h + 24);
+	info_.frames = get_u32(h + 28);
+	frame_len = get_u64(h + 32);
+	index_offset = get_u64(h + 40);
+
+	if ((std::memcmp(h, HGDEPTH_SEQ_MAGIC, 4) != 0) ||
+		(get_u16(h + 4) != HGDEPTH_SEQ_VERSION) || (get_u16(h + 6) != HGDEPTH_SEQ_HEADER_LEN) ||
+		(info_.width == 0) || (info_.height == 0) ||
+		((info_.type != SampleType::Float16) && (info_.type != SampleType::Uint16)) ||
+		(frame_len != frame_length(info_)) ||
+		(index_offset < HGDEPTH_SEQ_HEADER_LEN) || (index_offset > length_) ||
+		((length_ - index_offset) / HGDEPTH_SEQ_INDEX_ENTRY < info_.frames)) {
+		close();
+		return Status::InvalidFormat;
+	}
+
+	index_ = map_ + index_offset;
+
+	// Every frame aligned and before the index
+	for (uint32_t i = 0; i < info_.frames; i++) {
+		uint64_t offset = get_u64(index_ + ((size_t)i * HGDEPTH_SEQ_INDEX_ENTRY));
+		if ((offset % HGDEPTH_SEQ_ALIGN != 0) || (offset < HGDEPTH_SEQ_HEADER_LEN) ||
+			(offset > index_offset) || (index_offset - offset < frame_len)) {
+			close();
+			return Status::InvalidFormat;
+		}
+	}
+
+	madvise(map, length_, MADV_SEQUENTIAL);
+
+	return Status::Ok;
+}
+
+void SequenceReader::close()
+{
+	if (map_ != nullptr) {
+		munmap((void *)map_, length_);
+	}
+
+	map_ = nullptr;
+	index_ = nullptr;
+	length_ = 0;
+	info_ = SequenceInfo();
+}
+
+Status SequenceReader::frame(size_t i, Frame *out) const
+{
+	const uint8_t *entry;
+
+	if ((map_ == nullptr) || (i >= info_.frames) || (out == nullptr)) {
+		return Status::InvalidArgument;
+	}
+
+	entry = index_ + (i * HGDEPTH_SEQ_INDEX_ENTRY);
+	out->samples = (const uint16_t *)(map_ + get_u64(entry));
+	out->timestamp_us = get_u64(entry + 8);
+
+	return Status::Ok;
+}
+
+SequenceWriter::~SequenceWriter()
+{
+	close();
+}
+
+Status SequenceWriter::open(const char *path, const SequenceInfo &info)
+{
+	uint8_t header[HGDEPTH_SEQ_HEADER_LEN] = {0};
+
+	close();
+
+	if ((info.width == 0) || (info.height == 0) ||
+		((info.type != SampleType::Float16) && (info.type != SampleType::Uint16))) {
+		return Status::InvalidArgument;
+	}
+
+	file_ = std::fopen(path, "wb");
+	if (file_ == nullptr) {
+		return Status::IoError;
+	}
+
+	info_ = info;
+	info_.frames = 0;
+	index_.clear();
+
+	// Completed by close()
+	if (!write_all(file_, header, sizeof(header))) {
+		std::fclose(file_);
+		file_ = nullptr;
+		return Status::IoError;
+	}
+	position_ = sizeof(header);
+
+	return Status::Ok;
+}
+
+Status SequenceWriter::append(const uint16_t *samples, uint64_t timestamp_us)
+{
+	static const uint8_t padding[HGDEPTH_SEQ_ALIGN] = {0};
+	uint8_t entry[HGDEPTH_SEQ_INDEX_ENTRY];
+	size_t pad = (size_t)((HGDEPTH_SEQ_ALIGN - (position_ % HGDEPTH_SEQ_ALIGN)) % HGDEPTH_SEQ_ALIGN);
+	uint64_t length = frame_length(info_);
+
+	if ((file_ == nullptr) || (samples == nullptr)) {
+		return Status::InvalidArgument;
+	}
+
+	if (!write_all(file_, padding, pad)) {
+		return Status::IoError;
+	}
+	position_ += pad;
+
+	if (little_endian()) {
+		if (!write_all(file_, samples, (size_t)length)) {
+			return Status::IoError;
+		}
+	} else {
+		for (uint64_t k = 0; k < length / 2; k++) {
+			uint8_t b[2];
+			put_u16(b, samples[k]);
+			if (!write_all(file_, b, sizeof(b))) {
+				return Status::IoError;
+			}
+		}
+	}
+
+	put_u64(entry, position_);
+	put_u64(entry + 8, timestamp_us);
+	index_.insert(index_.end(), entry, entry + sizeof(entry));
+
+	position_ += length;
+	info_.frames++;
+
+	return Status::Ok;
+}
+
+Status SequenceWriter::close()
+{
+	uint8_t header[HGDEPTH_SEQ_HEADER_LEN] = {0};
+	bool ok;
+
+	if (file_ == nullptr) {
+		return Status::Ok;
+	}
+
+	std::memcpy(header, HGDEPTH_SEQ_MAGIC, 4);
+	put_u16(header + 4, HGDEPTH_SEQ_VERSION);
+	put_u16(header + 6, HGDEPTH_SEQ_HEADER_LEN);
+	put_u32(header + 8, info_.width);
+	put_u32(header + 12, info_.height);
+	put_u16(header + 16, (uint16_t)info_.type);
+	put_f32(header + 20, info_.scale);
+	put_f32(header + 24, info_.offset);
+	put_u32(header + 28, info_.frames);
+	put_u64(header + 32, frame_length(info_));
+	put_u64(header + 40, position_);
+
+	ok = write_all(file_, index_.data(), index_.size()) &&
+		 (std::fseek(file_, 0, SEEK_SET) == 0) &&
+		 write_all(file_, header, sizeof(header));
+	ok = (std::fclose(file_) == 0) && ok;
+
+	file_ = nullptr;
+	index_.clear();
+
+	return ok ? Status::Ok : Status::IoError;
+}
+
+uint16_t float_to_half(float value)
+{
+	uint32_t x, mant, half, rem, halfway, shift;
+	uint16_t sign;
+	int32_t exp;
+
+	std::memcpy(&x, &value, sizeof(x));
+	sign = (uint16_t)((x >> 16) & 0x8000U);
+	mant = x & 0x7FFFFFU;
+	exp = (int32_t)((x >> 23) & 0xFFU);
+
+	// Infinity and NaN
+	if (exp == 0xFF) {
+		return sign | 0x7C00U | ((mant != 0) ? (0x200U | (mant >> 13)) : 0U);
+	}
+
+	exp = exp - 127 + 15;
+	if (exp >= 31) {
+		return sign | 0x7C00U;
+	}
+
+	// Subnormal half, or zero
+	if (exp <= 0) {
+		if (exp < -10) {
+			return sign;
+		}
+		mant |= 0x800000U;
+		shift = (uint32_t)(14 - exp);
+		half = mant >> shift;
+		rem = mant & ((1U << shift) - 1U);
+		halfway = 1U << (shift - 1U);
+		if ((rem > halfway) || ((rem == halfway) && (half & 1U))) {
+			half++;
+		}
+		return sign | (uint16_t)half;
+	}
+
+	// Rounding to nearest even; a carry out of the mantissa goes into the exponent, up to infinity
+	half = ((uint32_t)exp << 10) | (mant >> 13);
+	rem = mant & 0x1FFFU;
+	if ((rem > 0x1000U) || ((rem == 0x1000U) && (half & 1U))) {
+		half++;
+	}
+
+	return sign | (uint16_t)half;
+}
+
+float half_to_float(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000U) << 16;
+	uint32_t exp = (half >> 10) & 0x1FU;
+	uint32_t mant = half & 0x3FFU;
+	uint32_t x;
+	float value;
+
+	if (exp == 0) {
+		// Zero or subnormal: mant x 2^-24, exact in a float
+		value = (float)mant * 5.9604644775390625e-8f;
+		return sign ? -value : value;
+	}
+
+	if (exp == 31) {
+		x = sign | 0x7F800000U | (mant << 13);
+	} else {
+		x = sign | ((exp + 112U) << 23) | (mant << 13);
+	}
+
+	std::memcpy(&value, &x, sizeof(value));
+	return value;
+}
+
+void decode_frame(const SequenceInfo &info, const uint16_t *samples, float *out,
+				  const Region *regions, size_t count)
+{
+	Region all;
+
+	if (regions == nullptr) {
+		all.width = info.width;
+		all.height = info.height;
+		regions = &all;
+		count = 1;
+	}
+
+	for (size_t r = 0; r < count; r++) {
+		const Region &region = regions[r];
+		uint32_t x_end = std::min(region.x + region.width, info.width);
+		uint32_t y_end = std::min(region.y + region.height, info.height);
+		uint32_t step_x = (region.step_x != 0) ? region.step_x : 1;
+		uint32_t step_y = (region.step_y != 0) ? region.step_y : 1;
+
+		for (uint32_t y = region.y; y < y_end; y += step_y) {
+			const uint16_t *in = samples + ((size_t)y * info.width);
+			float *row = out + ((size_t)y * info.width);
+
+			if (info.type == SampleType::Float16) {
+				for (uint32_t x = region.x; x < x_end; x += step_x) {
+					row[x] = (half_to_float(in[x]) * info.scale) + info.offset;
+				}
+			} else {
+				for (uint32_t x = region.x; x < x_end; x += step_x) {
+					row[x] = ((float)in[x] * info.scale) + info.offset;
+				}
+			}
+		}
+	}
+}
+
+void encode_frame(const SequenceInfo &info, const float *depth, uint16_t *out)
+{
+	size_t n = (size_t)info.width * info.height;
+	float scale = (info.scale != 0.0f) ? info.scale : 1.0f;
+
+	for (size_t k = 0; k < n; k++) {
+		float v = (depth[k] - info.offset) / scale;
+
+		if (info.type == SampleType::Float16) {
+			out[k] = float_to_half(v);
+		} else {
+			v = std::nearbyint(v);
+			out[k] = !(v > 0.0f) ? 0 : ((v >= 65535.0f) ? 65535 : (uint16_t)v);
+		}
+	}
+}
+
+} // namespace hgdepth
@@ -0,0 +1,106 @@
+/*
+ * thread_pool.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Includes
+#include "thread_pool.h"
+
+namespace hgdepth {
+namespace detail {
+
+// Exported functions
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+	for (unsigned i = 1; i < threads; i++) {
+		workers_.emplace_back(&ThreadPool::worker, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	start_.notify_all();
+
+	for (std::thread &t : workers_) {
+		t.join();
+	}
+}
+
+void ThreadPool::run(size_t count, const Job &job)
+{
+	size_t begin, end;
+
+	if (workers_.empty() || count < 2) {
+		job(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_ = &job;
+		count_ = count;
+		pending_ = (unsigned)workers_.size();
+		generation_++;
+	}
+	start_.notify_all();
+
+	range(0, count, &begin, &end);
+	job(begin, end);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return pending_ == 0; });
+	job_ = nullptr;
+}
+
+// Private functions
+
+void ThreadPool::worker(unsigned index)
+{
+	unsigned seen = 0;
+	size_t begin, end;
+
+	for (;;) {
+		const Job *job;
+		size_t count;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_.wait(lock, [this, seen] { return stop_ || (generation_ != seen); });
+			if (stop_) {
+				return;
+			}
+			seen = generation_;
+			job = job_;
+			count = count_;
+		}
+
+		range(index, count, &begin, &end);
+		if (begin < end) {
+			(*job)(begin, end);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			pending_--;
+		}
+		done_.notify_one();
+	}
+}
+
+void ThreadPool::range(unsigned index, size_t count, size_t *begin, size_t *end) const
+{
+	size_t n = workers_.size() + 1;
+
+	*begin = (count * index) / n;
+	*end = (count * (index + 1)) / n;
+}
+
+} // namespace detail
+} // namespace hgdepth
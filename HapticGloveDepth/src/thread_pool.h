@@ -0,0 +1,59 @@
+/*
+ * thread_pool.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_THREAD_POOL_H_
+#define HGDEPTH_THREAD_POOL_H_
+
+// Threads started once and kept for every frame. A job is split into as many
+// contiguous ranges as there are threads, the calling thread taking the first
+// one, so which thread runs which range never changes the result.
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hgdepth {
+namespace detail {
+
+class ThreadPool {
+public:
+	using Job = std::function<void(size_t begin, size_t end)>;
+
+	// threads counts the calling thread
+	explicit ThreadPool(unsigned threads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	unsigned threads() const { return (unsigned)workers_.size() + 1; }
+
+	// Runs job over [0, count) and returns once every range is done
+	void run(size_t count, const Job &job);
+
+private:
+	void worker(unsigned index);
+	void range(unsigned index, size_t count, size_t *begin, size_t *end) const;
+
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	const Job *job_ = nullptr;
+	size_t count_ = 0;
+	unsigned generation_ = 0;
+	unsigned pending_ = 0;
+	bool stop_ = false;
+};
+
+} // namespace detail
+} // namespace hgdepth
+
+#endif /* HGDEPTH_THREAD_POOL_H_ */
@@ -0,0 +1,29 @@
+/*
+ * check.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+#ifndef HGDEPTH_TESTS_CHECK_H_
+#define HGDEPTH_TESTS_CHECK_H_
+
+// The checks the tests share: a failed CHECK prints where it failed and is
+// counted, and main returns nonzero when any did. Each test is its own
+// executable, so each gets its own count.
+
+// Includes
+#include <cstdio>
+
+// Variables
+static int failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			std::printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+#endif /* HGDEPTH_TESTS_CHECK_H_ */
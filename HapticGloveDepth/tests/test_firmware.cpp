@@ -0,0 +1,506 @@
+/*
+ * test_firmware.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// The HAL free firmware, built for the host: grid decoding, the PWM mapping,
+// the temporal filter against a floating point one euro filter, the latency
+// prediction, the saliency stage and the depth tile written in parts the way
+// the phone splits it, against the host reduction.
+
+// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "hgdepth/reduce.h"
+#include "depth_tile.h"
+#include "haptic_filter.h"
+#include "haptic_predict.h"
+#include "haptic_render.h"
+#include "haptic_saliency.h"
+#include "check.h"
+
+// Variables
+static const Haptic_FilterParams_t filter_off = {HAPTIC_FILTER_OFF, 0, 0, 0, 0};
+
+// Private functions
+
+static void set_params(const Haptic_FilterParams_t &params)
+{
+	CHECK(Haptic_FilterSetParams(&params) == 1);
+	Haptic_FilterReset();
+}
+
+// Filtered value of cell 0 for a frame where all the cells are value
+static double filter(double value, uint32_t time_ms)
+{
+	int32_t cells[HAPTIC_CELL_NUM];
+
+	for (uint32_t i = 0; i < HAPTIC_CELL_NUM; i++) {
+		cells[i] = (int32_t)std::lround(value * HAPTIC_Q15_ONE);
+	}
+	Haptic_FilterApply(cells, time_ms);
+
+	return (double)cells[0] / HAPTIC_Q15_ONE;
+}
+
+// The one euro filter in double, as published
+struct OneEuro {
+	double min_cutoff, beta, d_cutoff;
+	double value = 0.0, raw = 0.0, speed = 0.0;
+	bool primed = false;
+
+	static double alpha(double cutoff, double dt)
+	{
+		double r = 2.0 * M_PI * cutoff * dt;
+		return r / (1.0 + r);
+	}
+
+	double operator()(double x, double dt)
+	{
+		if (!primed) {
+			primed = true;
+			value = raw = x;
+			return x;
+		}
+		speed += alpha(d_cutoff, dt) * (((x - raw) / dt) - speed);
+		raw = x;
+		value += alpha(min_cutoff + (beta * std::fabs(speed)), dt) * (x - value);
+		return value;
+	}
+};
+
+static void test_decode()
+{
+	const float grid[HAPTIC_CELL_NUM] = {0.25f, -1.0f, 1.5f, 0.5f};
+	uint8_t value[HAPTIC_GRID_LEN];
+	float out[HAPTIC_CELL_NUM];
+	uint16_t timestamp;
+
+	value[0] = 0x34;
+	value[1] = 0x12;
+	std::memcpy(value + 2, grid, sizeof(grid));
+
+	CHECK(Haptic_GridDecode(value, sizeof(value) - 1, &timestamp, out) == 0);
+	CHECK(Haptic_GridDecode(value, sizeof(value), &timestamp, out) == 1);
+	CHECK(timestamp == 0x1234);
+	CHECK(std::memcmp(out, grid, sizeof(grid)) == 0);
+}
+
+static void test_pulse()
+{
+	const float grid[HAPTIC_CELL_NUM] = {0.5f, -0.3f, NAN, 7.0f};
+	uint32_t pulse[HAPTIC_CELL_NUM];
+
+	set_params(filter_off);
+	Haptic_PredictEnable(0);
+	Haptic_SaliencyEnable(0);
+
+	Haptic_Render(grid, 0, pulse);
+	CHECK(pulse[0] == HAPTIC_PULSE_PER_UNIT / 2);
+	CHECK(pulse[1] == 0);
+	CHECK(pulse[2] == 0);
+	CHECK(pulse[3] == HAPTIC_PULSE_PER_UNIT);
+
+	// Same steps as roundf(value * HAPTIC_PULSE_PER_UNIT) away from the midpoints
+	for (int k = 0; k <= 1000; k++) {
+		float v = (float)k / 1000.0f;
+		float g[HAPTIC_CELL_NUM] = {v, v, v, v};
+		float want = v * HAPTIC_PULSE_PER_UNIT;
+		Haptic_Render(g, 0, pulse);
+		if (std::fabs(want - std::floor(want) - 0.5f) > 0.01f) {
+			CHECK(pulse[0] == (uint32_t)std::lround(want));
+		}
+	}
+
+	Haptic_PredictEnable(1);
+	Haptic_SaliencyEnable(1);
+}
+
+static void test_params()
+{
+	Haptic_FilterParams_t params, bad, got;
+	uint8_t value[HAPTIC_FILTER_PARAMS_LEN];
+
+	Haptic_FilterGetParams(&params);
+	CHECK(params.mode == HAPTIC_FILTER_ONE_EURO);
+
+	Haptic_FilterEncode(&params, value);
+	CHECK(Haptic_FilterDecode(value, sizeof(value), &got) == 1);
+	CHECK(std::memcmp(&got, &params, sizeof(got)) == 0);
+	CHECK(Haptic_FilterDecode(value, sizeof(value) - 1, &got) == 0);
+
+	bad = {HAPTIC_FILTER_NUM, 1, 1, 1, 1};
+	CHECK(Haptic_FilterSetParams(&bad) == 0);
+	bad = {HAPTIC_FILTER_EMA, 0, 0, 0, 0};
+	CHECK(Haptic_FilterSetParams(&bad) == 0);
+	bad = {HAPTIC_FILTER_EMA, HAPTIC_Q15_ONE + 1, 0, 0, 0};
+	CHECK(Haptic_FilterSetParams(&bad) == 0);
+	bad = {HAPTIC_FILTER_ONE_EURO, 0, 0, 256, 256};
+	CHECK(Haptic_FilterSetParams(&bad) == 0);
+
+	Haptic_FilterGetParams(&got);
+	CHECK(std::memcmp(&got, &params, sizeof(got)) == 0);
+}
+
+static void test_ema()
+{
+	set_params({HAPTIC_FILTER_EMA, HAPTIC_Q15_ONE / 2, 0, 0, 0});
+
+	CHECK(filter(0.0, 0) == 0.0);
+	CHECK(filter(1.0, 33) == 0.5);
+	CHECK(filter(1.0, 66) == 0.75);
+	CHECK(filter(1.0, 99) == 0.875);
+
+	// A gap in the frames: taken as it is
+	CHECK(filter(0.0, 99 + HAPTIC_FILTER_GAP_MS + 1) == 0.0);
+
+	// A change of mode starts over
+	CHECK(filter(1.0, 700) == 0.5);
+	set_params({HAPTIC_FILTER_ONE_EURO, 0, 256, 256, 256});
+	CHECK(filter(0.25, 733) == 0.25);
+}
+
+static void test_one_euro()
+{
+	std::mt19937 rng(30);
+	std::normal_distribution<double> noise(0.0, 0.03);
+	OneEuro reference{1.0, 1.0, 1.0};
+	double error = 0.0, in_var = 0.0, out_var = 0.0;
+	uint32_t time_ms = 1000;
+
+	set_params({HAPTIC_FILTER_ONE_EURO, 0, 256, 256, 256});
+
+	// Still then a step, at a jittery 30 frames per second
+	for (int i = 0; i < 300; i++) {
+		uint32_t dt = (i == 0) ? 0 : (uint32_t)(28 + (rng() % 11));
+		double x = ((i < 150) ? 0.3 : 0.8) + noise(rng);
+		x = std::fmin(std::fmax(x, 0.0), 1.0);
+		time_ms += dt;
+
+		double got = filter(x, time_ms);
+		double want = reference(x, dt / 1000.0);
+		error = std::fmax(error, std::fabs(got - want));
+
+		if ((i > 50) && (i < 150)) {
+			in_var += (x - 0.3) * (x - 0.3);
+			out_var += (got - 0.3) * (got - 0.3);
+		}
+		if (i == 160) {
+			CHECK(got > 0.7);		// Caught up with the step
+		}
+	}
+
+	CHECK(error < 0.002);
+	CHECK(out_var < in_var / 4.0);	// Noise of a still cell at least halved
+}
+
+static void test_saliency()
+{
+	uint32_t pulse[HAPTIC_CELL_NUM];
+	uint32_t time_ms = 0, focus_ms, on;
+
+	set_params(filter_off);
+	Haptic_PredictEnable(0);
+
+	// Still background: attenuated, nothing emphasized
+	Haptic_RenderReset();
+	for (int i = 0; i < 10; i++) {
+		float grid[HAPTIC_CELL_NUM] = {0.2f, 0.2f, 0.2f, 0.2f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+	}
+	CHECK(Haptic_SaliencyFocus() == -1);
+	CHECK(Haptic_IsAnimated() == 0);
+	CHECK(pulse[0] < (uint32_t)std::lround(0.2 * HAPTIC_PULSE_PER_UNIT));
+	CHECK(pulse[0] > 0);
+
+	// The nearest cell: boosted, pulsing between the frames
+	Haptic_RenderReset();
+	focus_ms = time_ms + 33;
+	for (int i = 0; i < 10; i++) {
+		float grid[HAPTIC_CELL_NUM] = {0.2f, 0.2f, 0.7f, 0.2f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+	}
+	CHECK(Haptic_SaliencyFocus() == 2);
+	CHECK(Haptic_IsAnimated() == 1);
+
+	// Start of the next period of the pulsing
+	on = focus_ms + ((((time_ms - focus_ms) / HAPTIC_SALIENCY_PULSE_MS) + 1) * HAPTIC_SALIENCY_PULSE_MS);
+	CHECK(Haptic_Refresh(on, pulse) == 1);
+	CHECK(pulse[2] > (uint32_t)std::lround(0.7 * HAPTIC_PULSE_PER_UNIT));
+	CHECK(pulse[0] < (uint32_t)std::lround(0.2 * HAPTIC_PULSE_PER_UNIT));
+	CHECK(Haptic_Refresh(on + (HAPTIC_SALIENCY_PULSE_MS / 2), pulse) == 1);
+	CHECK(pulse[2] < (uint32_t)std::lround(0.7 * HAPTIC_PULSE_PER_UNIT));
+
+	// No more frames: steady again, still boosted
+	CHECK(Haptic_Refresh(time_ms + HAPTIC_SALIENCY_HOLD_MS + 1, pulse) == 0);
+	CHECK(Haptic_IsAnimated() == 0);
+	CHECK(pulse[2] > (uint32_t)std::lround(0.7 * HAPTIC_PULSE_PER_UNIT));
+
+	// A farther cell coming closer fast takes over from a nearer still one
+	Haptic_RenderReset();
+	for (int i = 0; i < 6; i++) {
+		float grid[HAPTIC_CELL_NUM] = {0.6f, 0.2f + (0.03f * (float)i), 0.1f, 0.1f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+		if (i == 0) {
+			CHECK(Haptic_SaliencyFocus() == 0);
+		}
+	}
+	CHECK(Haptic_SaliencyFocus() == 1);
+
+	// A gap in the frames forgets the approach
+	{
+		float grid[HAPTIC_CELL_NUM] = {0.6f, 0.5f, 0.1f, 0.1f};
+		Haptic_Render(grid, time_ms += HAPTIC_FILTER_GAP_MS + 1, pulse);
+	}
+	CHECK(Haptic_SaliencyFocus() == 0);
+
+	// The emphasis stays while another cell is about as near, moves for a nearer one
+	Haptic_RenderReset();
+	for (int i = 0; i < 3; i++) {
+		float grid[HAPTIC_CELL_NUM] = {0.7f, 0.62f, 0.1f, 0.1f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+	}
+	{
+		float grid[HAPTIC_CELL_NUM] = {0.6f, 0.62f, 0.1f, 0.1f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+	}
+	CHECK(Haptic_SaliencyFocus() == 0);
+	{
+		float grid[HAPTIC_CELL_NUM] = {0.6f, 0.7f, 0.1f, 0.1f};
+		Haptic_Render(grid, time_ms += 33, pulse);
+	}
+	CHECK(Haptic_SaliencyFocus() == 1);
+
+	Haptic_PredictEnable(1);
+	Haptic_RenderReset();
+}
+
+// Predicted value of cell 0 for a frame where all the cells are value
+static double predict(double value, uint32_t time_ms)
+{
+	int32_t cells[HAPTIC_CELL_NUM];
+
+	for (uint32_t i = 0; i < HAPTIC_CELL_NUM; i++) {
+		cells[i] = (int32_t)std::lround(value * HAPTIC_Q15_ONE);
+	}
+	Haptic_PredictApply(cells, time_ms);
+
+	return (double)cells[0] / HAPTIC_Q15_ONE;
+}
+
+static void test_predict()
+{
+	uint32_t time_ms = 0, lead;
+	double got = 0.0, last;
+	int32_t confidence;
+
+	// The first measure is taken as it is, the next ones smoothed, all clamped
+	Haptic_PredictLatency(70);
+	lead = Haptic_PredictLead();
+	CHECK(lead == 70 + HAPTIC_PREDICT_RESPONSE_MS);
+
+	// A still cell stays where it is
+	Haptic_PredictReset();
+	for (int i = 0; i < 20; i++) {
+		CHECK(predict(0.375, time_ms += 33) == 0.375);
+	}
+	CHECK(Haptic_PredictConfidence(0) > (HAPTIC_Q15_ONE * 9) / 10);
+
+	// A ramp is caught up with: the output is where the input will be a lead later
+	Haptic_PredictReset();
+	for (int i = 0; i < 30; i++) {
+		double x = 0.2 + (0.5 * i * 0.033);
+		got = predict(x, time_ms += 33);
+		if (i == 0) {
+			CHECK(std::fabs(got - x) < 1.0 / HAPTIC_Q15_ONE);		// Nothing to extrapolate from yet
+		}
+	}
+	CHECK(std::fabs(got - (0.2 + (0.5 * 29 * 0.033) + (0.5 * lead / 1000.0))) < 0.01);
+
+	// Up to the top, and no further
+	for (int i = 0; i < 20; i++) {
+		got = predict(std::fmin(0.7 + (0.5 * i * 0.033), 1.0), time_ms += 33);
+		CHECK(got <= 1.0);
+	}
+
+	// A step: the tracker misses, the confidence drops, the move stays clamped
+	Haptic_PredictReset();
+	for (int i = 0; i < 20; i++) {
+		predict(0.2, time_ms += 33);
+	}
+	confidence = Haptic_PredictConfidence(0);
+	got = predict(0.8, time_ms += 33);
+	CHECK(got <= 0.8 + ((double)HAPTIC_PREDICT_MAX_STEP / HAPTIC_Q15_ONE));
+	CHECK(Haptic_PredictConfidence(0) < confidence);
+	for (int i = 0; i < 30; i++) {
+		last = got;
+		got = predict(0.8, time_ms += 33);
+	}
+	CHECK(std::fabs(got - 0.8) < 0.01);
+	CHECK(std::fabs(got - last) < 0.005);
+
+	// Frames far apart are extrapolated less, and not at all once stale, before the tracker starts over
+	last = 2.0;
+	for (uint32_t spacing : {50U, 150U, 300U, HAPTIC_PREDICT_STALE_MS, HAPTIC_FILTER_GAP_MS}) {
+		Haptic_PredictReset();
+		for (int i = 0; i < 20; i++) {
+			got = predict(0.2 + (0.05 * i * spacing / 1000.0), time_ms += spacing);
+		}
+		double share = (got - (0.2 + (0.05 * 19 * spacing / 1000.0))) / (0.05 * lead / 1000.0);
+		if (spacing < HAPTIC_PREDICT_STALE_MS) {
+			CHECK(share < last);
+			CHECK(std::fabs(share - (1.0 - ((double)spacing / HAPTIC_PREDICT_STALE_MS))) < 0.05);
+		} else {
+			CHECK(std::fabs(share) < 0.01);
+		}
+		last = share;
+	}
+
+	// Off, the cells go through
+	Haptic_PredictEnable(0);
+	CHECK(predict(0.25, time_ms += 33) == 0.25);
+	CHECK(predict(0.625, time_ms += 33) == 0.625);
+	Haptic_PredictEnable(1);
+
+	Haptic_PredictLatency(10000);
+	CHECK(Haptic_PredictLead() <= HAPTIC_PREDICT_MAX_LEAD_MS);
+}
+
+// Writes of a tile as BluetoothManager.writeTile makes them for a given maximum write length
+static std::vector<std::vector<uint8_t>> split_tile(const uint8_t *tile, uint16_t timestamp, uint32_t max_length)
+{
+	std::vector<std::vector<uint8_t>> writes;
+	uint32_t rows_per_write = std::max(1U, std::min(DEPTH_TILE_ROWS_MAX,
+													(max_length - DEPTH_TILE_HEADER_LEN) / DEPTH_TILE_SIZE));
+
+	for (uint32_t first = 0; first < DEPTH_TILE_SIZE; first += rows_per_write) {
+		uint32_t rows = std::min(rows_per_write, DEPTH_TILE_SIZE - first);
+		std::vector<uint8_t> data = {(uint8_t)(timestamp & 0xFF), (uint8_t)(timestamp >> 8),
+									 (uint8_t)first, (uint8_t)rows};
+
+		data.insert(data.end(), tile + (first * DEPTH_TILE_SIZE), tile + ((first + rows) * DEPTH_TILE_SIZE));
+		writes.push_back(data);
+	}
+
+	return writes;
+}
+
+static void test_depth_tile()
+{
+	std::mt19937 rng(45);
+	std::uniform_int_distribution<int> sample(0, 255);
+	uint8_t tile[DEPTH_TILE_SIZE * DEPTH_TILE_SIZE];
+	float grid[DEPTH_REGION_NUM];
+	float expected[DEPTH_REGION_NUM];
+	uint16_t timestamp = 0;
+
+	hgdepth::Reducer reducer;
+	CHECK(reducer.init(hgdepth::Options()) == hgdepth::Status::Ok);
+	std::vector<hgdepth::Region> layout = hgdepth::grid_layout(DEPTH_TILE_SIZE, DEPTH_TILE_SIZE, 2, 2);
+	CHECK(layout.size() == DEPTH_REGION_NUM);
+
+	// Default ATT MTU, a 185 byte one and the largest iOS allows
+	for (uint32_t max_length : {20U, 182U, 512U}) {
+		for (uint8_t &s : tile) {
+			s = (uint8_t)sample(rng);
+		}
+		hgdepth::Image<uint8_t> image{tile, DEPTH_TILE_SIZE, DEPTH_TILE_SIZE, DEPTH_TILE_SIZE};
+		CHECK(reducer.reduce(image, layout.data(), layout.size(), expected) == hgdepth::Status::Ok);
+
+		std::vector<std::vector<uint8_t>> writes = split_tile(tile, ++timestamp, max_length);
+		for (size_t w = 0; w < writes.size(); w++) {
+			CHECK(writes[w].size() <= DEPTH_TILE_CHAR_LEN);
+			CHECK(writes[w].size() <= max_length);
+
+			// The grid comes with the last part, not before
+			std::memset(grid, 0, sizeof(grid));
+			uint8_t done = Depth_TileWrite(writes[w].data(), (uint16_t)writes[w].size(), grid);
+			CHECK(done == ((w + 1) == writes.size()));
+		}
+
+		for (uint32_t r = 0; r < DEPTH_REGION_NUM; r++) {
+			CHECK(grid[r] == expected[r]);
+		}
+	}
+
+	// More rows than one event carries are refused
+	std::vector<uint8_t> big = {0, 0, 0, (uint8_t)(DEPTH_TILE_ROWS_MAX + 1)};
+	big.resize(DEPTH_TILE_HEADER_LEN + ((DEPTH_TILE_ROWS_MAX + 1) * DEPTH_TILE_SIZE));
+	CHECK(Depth_TileWrite(big.data(), (uint16_t)big.size(), grid) == 0);
+
+	// Rows past the tile, or shorter than announced
+	std::vector<uint8_t> past = {0, 0, DEPTH_TILE_SIZE - 2, 4};
+	past.resize(DEPTH_TILE_HEADER_LEN + (4 * DEPTH_TILE_SIZE));
+	CHECK(Depth_TileWrite(past.data(), (uint16_t)past.size(), grid) == 0);
+	std::vector<uint8_t> shorter = {0, 0, 0, 2};
+	shorter.resize(DEPTH_TILE_HEADER_LEN + DEPTH_TILE_SIZE);
+	CHECK(Depth_TileWrite(shorter.data(), (uint16_t)shorter.size(), grid) == 0);
+
+	// Layouts leaving the tile are refused
+	Depth_Region_t regions[DEPTH_REGION_NUM];
+	for (uint32_t r = 0; r < DEPTH_REGION_NUM; r++) {
+		regions[r] = {(uint8_t)layout[r].x, (uint8_t)layout[r].y, (uint8_t)layout[r].width,
+					  (uint8_t)layout[r].height, DEPTH_WEIGHT_ONE};
+	}
+	CHECK(Depth_SetLayout(regions) == 1);
+	regions[3].w = DEPTH_TILE_SIZE;
+	CHECK(Depth_SetLayout(regions) == 0);
+	regions[3].w = 0;
+	CHECK(Depth_SetLayout(regions) == 0);
+
+	// A layout written over its characteristic: round trip, then the tiles reduced with it
+	uint8_t value[DEPTH_LAYOUT_LEN];
+	Depth_Region_t decoded[DEPTH_REGION_NUM];
+	for (uint32_t r = 0; r < DEPTH_REGION_NUM; r++) {
+		layout[r].x = r * 2;
+		layout[r].y = 1 + r;
+		layout[r].width = 5 + r;
+		layout[r].height = 8 - r;
+		layout[r].weight = (r == 0) ? 0.5f : 1.0f;
+		regions[r] = {(uint8_t)layout[r].x, (uint8_t)layout[r].y, (uint8_t)layout[r].width,
+					  (uint8_t)layout[r].height, (uint16_t)(layout[r].weight * DEPTH_WEIGHT_ONE)};
+	}
+	Depth_LayoutEncode(regions, value);
+	CHECK(value[DEPTH_REGION_LEN * 3] == 6);
+	CHECK((value[4] | (value[5] << 8)) == DEPTH_WEIGHT_ONE / 2);
+	CHECK(Depth_LayoutDecode(value, DEPTH_LAYOUT_LEN - 1, decoded) == 0);
+	CHECK(Depth_LayoutDecode(value, DEPTH_LAYOUT_LEN, decoded) == 1);
+	CHECK(Depth_SetLayout(decoded) == 1);
+
+	Depth_GetLayout(decoded);
+	CHECK(std::memcmp(decoded, regions, sizeof(regions)) == 0);
+
+	for (uint8_t &s : tile) {
+		s = (uint8_t)sample(rng);
+	}
+	hgdepth::Image<uint8_t> image{tile, DEPTH_TILE_SIZE, DEPTH_TILE_SIZE, DEPTH_TILE_SIZE};
+	CHECK(reducer.reduce(image, layout.data(), layout.size(), expected) == hgdepth::Status::Ok);
+	for (const std::vector<uint8_t> &data : split_tile(tile, ++timestamp, 182U)) {
+		Depth_TileWrite(data.data(), (uint16_t)data.size(), grid);
+	}
+	for (uint32_t r = 0; r < DEPTH_REGION_NUM; r++) {
+		CHECK(std::fabs(grid[r] - expected[r]) < 1e-6f);
+	}
+}
+
+int main()
+{
+	test_params();
+	test_decode();
+	test_pulse();
+	test_ema();
+	test_one_euro();
+	test_saliency();
+	test_predict();
+	test_depth_tile();
+
+	std::printf("%s: %d failure(s)\n", failures ? "FAIL" : "ok", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,253 @@
+/*
+ * test_reduce.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Every kernel and thread count against the scalar kernel on one thread, to
+// the bit, over random maps and layouts. Then the library against the two
+// reductions it stands for: calculateRegionDepths of the app, within float
+// rounding, and Depth_Reduce of depth_tile.c, to the bit.
+
+// Includes
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "hgdepth/reduce.h"
+#include "check.h"
+
+using namespace hgdepth;
+
+// Variables
+static const Isa isas[] = {Isa::Sse2, Isa::Avx2, Isa::Neon};
+static const unsigned thread_counts[] = {1, 2, 3, 7};
+
+// Private functions
+
+template <typename T>
+static std::vector<Region> random_layout(std::mt19937 &rng, const Image<T> &image)
+{
+	std::vector<Region> regions(1 + (rng() % 9));
+
+	for (Region &r : regions) {
+		r.width = 1 + (rng() % image.width);
+		r.height = 1 + (rng() % image.height);
+		r.x = rng() % (image.width - r.width + 1);
+		r.y = rng() % (image.height - r.height + 1);
+		r.step_x = 1 + (rng() % 3);
+		r.step_y = 1 + (rng() % 3);
+		r.weight = 0.5f + (float)(rng() % 100) / 100.0f;
+	}
+
+	return regions;
+}
+
+template <typename T>
+static void check_kernels(std::mt19937 &rng, const Image<T> &image)
+{
+	std::vector<Region> regions = random_layout(rng, image);
+	size_t n = regions.size();
+	std::vector<float> want(n), got(n);
+	std::vector<RegionStats> want_stats(n), got_stats(n);
+	Reducer reference;
+
+	CHECK(reference.init({Isa::Scalar, 1}) == Status::Ok);
+	CHECK(reference.reduce(image, regions.data(), n, want.data(), want_stats.data()) == Status::Ok);
+
+	for (Isa isa : isas) {
+		if (!isa_supported(isa)) {
+			continue;
+		}
+		for (unsigned threads : thread_counts) {
+			Reducer reducer;
+			CHECK(reducer.init({isa, threads}) == Status::Ok);
+			CHECK(reducer.reduce(image, regions.data(), n, got.data(), got_stats.data()) == Status::Ok);
+			CHECK(std::memcmp(want.data(), got.data(), n * sizeof(float)) == 0);
+			CHECK(std::memcmp(want_stats.data(), got_stats.data(), n * sizeof(RegionStats)) == 0);
+		}
+	}
+}
+
+static void test_kernels()
+{
+	std::mt19937 rng(518);
+	std::normal_distribution<float> depth(2.0f, 1.5f);
+
+	for (int i = 0; i < 200; i++) {
+		// Sized exactly, so a kernel reading past a row at the end of the map gets caught by a sanitizer
+		uint32_t width = 1 + (rng() % 300);
+		uint32_t height = 1 + (rng() % 64);
+		size_t stride = width + (rng() % 5);
+		std::vector<float> f((stride * (height - 1)) + width);
+		std::vector<uint8_t> b(f.size());
+
+		for (size_t k = 0; k < f.size(); k++) {
+			f[k] = depth(rng);
+			b[k] = (uint8_t)rng();
+		}
+
+		check_kernels(rng, Image<float>{f.data(), width, height, stride});
+		check_kernels(rng, Image<uint8_t>{b.data(), width, height, stride});
+	}
+}
+
+// calculateRegionDepths of DataModel.swift, in float as there
+static void app_reduce(const Image<float> &image, float *out)
+{
+	int width = (int)image.width;
+	int height = (int)image.height;
+	int quad_w = width / 2;
+	int quad_h = height / 2;
+	int centre_w = quad_w / 4;
+	int centre_h = quad_h / 4;
+	float min = FLT_MAX;
+	float max = -FLT_MAX;
+
+	for (int r = 0; r < 4; r++) {
+		int sx = ((r % 2) * quad_w) + ((quad_w - centre_w) / 2);
+		int sy = ((r / 2) * quad_h) + ((quad_h - centre_h) / 2);
+		for (int y = sy; y < sy + centre_h; y += 2) {
+			for (int x = sx; x < sx + centre_w; x += 2) {
+				float d = image.data[(y * image.stride) + x];
+				min = std::fmin(min, d);
+				max = std::fmax(max, d);
+			}
+		}
+	}
+
+	float range = std::fmax(max - min, FLT_EPSILON);
+
+	for (int r = 0; r < 4; r++) {
+		int sx = ((r % 2) * quad_w) + ((quad_w - centre_w) / 2);
+		int sy = ((r / 2) * quad_h) + ((quad_h - centre_h) / 2);
+		float sum = 0.0f;
+		int count = 0;
+		for (int y = sy; y < sy + centre_h; y += 2) {
+			for (int x = sx; x < sx + centre_w; x += 2) {
+				sum += image.data[(y * image.stride) + x];
+				count++;
+			}
+		}
+		out[r] = ((sum / (float)count) - min) / range;
+	}
+}
+
+static void test_app()
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> depth(0.0f, 10.0f);
+	const uint32_t size = 518;
+	std::vector<float> map(size * size);
+	float want[4], got[4];
+
+	for (float &d : map) {
+		d = depth(rng);
+	}
+
+	Image<float> image{map.data(), size, size, size};
+	std::vector<Region> regions = quadrant_layout(size, size);
+	Reducer reducer;
+
+	app_reduce(image, want);
+	CHECK(reducer.reduce(image, regions.data(), regions.size(), got) == Status::Ok);
+	for (int r = 0; r < 4; r++) {
+		CHECK(std::fabs(want[r] - got[r]) < 1e-5f);
+	}
+}
+
+// Depth_Reduce of depth_tile.c over its default layout, weights in Q8
+static void glove_reduce(const uint8_t *tile, const uint16_t *weight, float *out)
+{
+	std::vector<Region> regions = grid_layout(16, 16, 2, 2);
+	uint32_t sum[4] = {0};
+	uint8_t min = UINT8_MAX;
+	uint8_t max = 0;
+
+	for (int r = 0; r < 4; r++) {
+		const Region &g = regions[r];
+		for (uint32_t y = g.y; y < g.y + g.height; y++) {
+			for (uint32_t x = g.x; x < g.x + g.width; x++) {
+				uint8_t v = tile[(y * 16) + x];
+				sum[r] += v;
+				min = (v < min) ? v : min;
+				max = (v > max) ? v : max;
+			}
+		}
+	}
+
+	float range = (max > min) ? (float)(max - min) : 1.0f;
+
+	for (int r = 0; r < 4; r++) {
+		float value = ((float)sum[r] / (float)(regions[r].width * regions[r].height)) - (float)min;
+		value = (value / range) * ((float)weight[r] / 256.0f);
+		out[r] = (value > 1.0f) ? 1.0f : value;
+	}
+}
+
+static void test_glove()
+{
+	std::mt19937 rng(16);
+	uint8_t tile[16 * 16];
+	uint16_t weight[4];
+	float want[4], got[4];
+
+	for (int i = 0; i < 100; i++) {
+		for (uint8_t &v : tile) {
+			v = (uint8_t)(rng() % ((i % 4 == 0) ? 2 : 256));
+		}
+
+		std::vector<Region> regions = grid_layout(16, 16, 2, 2);
+		for (int r = 0; r < 4; r++) {
+			weight[r] = (uint16_t)(rng() % 512);
+			regions[r].weight = (float)weight[r] / 256.0f;
+		}
+
+		Reducer reducer;
+		glove_reduce(tile, weight, want);
+		CHECK(reducer.reduce(Image<uint8_t>{tile, 16, 16, 16}, regions.data(), 4, got) == Status::Ok);
+		CHECK(std::memcmp(want, got, sizeof(want)) == 0);
+	}
+}
+
+static void test_arguments()
+{
+	float map[8 * 8] = {0};
+	float out[1];
+	Image<float> image{map, 8, 8, 8};
+	Region region;
+	Reducer reducer;
+
+	region.width = 4;
+	region.height = 4;
+	CHECK(reducer.reduce(image, &region, 1, out) == Status::Ok);
+
+	region.x = 5;
+	CHECK(reducer.reduce(image, &region, 1, out) == Status::InvalidArgument);
+
+	region.x = 0;
+	region.step_y = 0;
+	CHECK(reducer.reduce(image, &region, 1, out) == Status::InvalidArgument);
+
+	region.step_y = 1;
+	image.stride = 4;
+	CHECK(reducer.reduce(image, &region, 1, out) == Status::InvalidArgument);
+
+	for (Isa isa : isas) {
+		CHECK((reducer.init({isa, 1}) == Status::Ok) == isa_supported(isa));
+	}
+}
+
+int main()
+{
+	test_kernels();
+	test_app();
+	test_glove();
+	test_arguments();
+
+	std::printf("%s: %d failure(s), best kernels %s\n", failures ? "FAIL" : "ok", failures, isa_name(best_isa()));
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,269 @@
+/*
+ * test_sequence.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Depth sequence files written then read back, broken files refused, the
+// float16 conversions, and a replay through the host build of the firmware
+// against the same pipeline called by hand.
+
+// Includes
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "hgdepth/replay.h"
+#include "haptic_filter.h"
+#include "haptic_predict.h"
+#include "haptic_saliency.h"
+#include "haptic_render.h"
+#include "check.h"
+
+using namespace hgdepth;
+
+// Private functions
+
+static std::string temp_path(const char *name)
+{
+	return std::string(P_tmpdir) + "/hgdepth_" + std::to_string(getpid()) + "_" + name;
+}
+
+static std::vector<uint16_t> random_frame(std::mt19937 &rng, const SequenceInfo &info)
+{
+	std::uniform_real_distribution<float> depth(0.2f, 8.0f);
+	std::vector<float> map((size_t)info.width * info.height);
+	std::vector<uint16_t> samples(map.size());
+
+	for (float &d : map) {
+		d = depth(rng);
+	}
+	encode_frame(info, map.data(), samples.data());
+
+	return samples;
+}
+
+static void test_half()
+{
+	std::mt19937 rng(16);
+
+	// Every half that is a number back to itself
+	for (uint32_t h = 0; h < 0x10000U; h++) {
+		if (((h & 0x7C00U) == 0x7C00U) && ((h & 0x3FFU) != 0)) {
+			continue;
+		}
+		CHECK(float_to_half(half_to_float((uint16_t)h)) == h);
+	}
+
+	CHECK(float_to_half(1.0f) == 0x3C00U);
+	CHECK(float_to_half(65520.0f) == 0x7C00U);		// Rounds up to infinity
+	CHECK(float_to_half(65519.0f) == 0x7BFFU);
+	CHECK(float_to_half(2.98023224e-8f) == 0x0000U);	// Half of the smallest subnormal, to even
+	CHECK(float_to_half(2.98023259e-8f) == 0x0001U);
+
+#if defined(__FLT16_MAX__)
+	// Against the conversion of the compiler
+	for (int i = 0; i < 1000000; i++) {
+		uint32_t raw = rng();
+		float f;
+		std::memcpy(&f, &raw, sizeof(f));
+		if (std::isnan(f)) {
+			continue;
+		}
+		_Float16 h = (_Float16)f;
+		uint16_t want;
+		std::memcpy(&want, &h, sizeof(want));
+		CHECK(float_to_half(f) == want);
+	}
+#endif
+}
+
+static void test_round_trip(SampleType type)
+{
+	std::mt19937 rng(518);
+	std::string path = temp_path("round_trip.hgds");
+	std::vector<std::vector<uint16_t>> frames;
+	SequenceInfo info;
+	SequenceWriter writer;
+	SequenceReader reader;
+	Frame frame;
+
+	// Odd sizes: the frames need padding to stay aligned
+	info.width = 37;
+	info.height = 23;
+	info.type = type;
+	info.scale = (type == SampleType::Uint16) ? 0.001f : 1.0f;
+
+	CHECK(writer.open(path.c_str(), info) == Status::Ok);
+	for (int i = 0; i < 7; i++) {
+		frames.push_back(random_frame(rng, info));
+		CHECK(writer.append(frames.back().data(), 33333U * i) == Status::Ok);
+	}
+	CHECK(writer.close() == Status::Ok);
+
+	CHECK(reader.open(path.c_str()) == Status::Ok);
+	CHECK(reader.size() == frames.size());
+	CHECK(reader.info().width == info.width);
+	CHECK(reader.info().height == info.height);
+	CHECK(reader.info().type == type);
+	CHECK(reader.info().scale == info.scale);
+
+	for (size_t i = 0; i < frames.size(); i++) {
+		CHECK(reader.frame(i, &frame) == Status::Ok);
+		CHECK(((uintptr_t)frame.samples % HGDEPTH_SEQ_ALIGN) == 0);
+		CHECK(frame.timestamp_us == 33333U * i);
+		CHECK(std::memcmp(frame.samples, frames[i].data(), frames[i].size() * sizeof(uint16_t)) == 0);
+	}
+	CHECK(reader.frame(frames.size(), &frame) == Status::InvalidArgument);
+
+	// Depth back within the precision of the samples
+	std::vector<float> depth(frames[0].size());
+	std::vector<uint16_t> again(frames[0].size());
+	reader.frame(0, &frame);
+	decode_frame(reader.info(), frame.samples, depth.data());
+	encode_frame(reader.info(), depth.data(), again.data());
+	CHECK(std::memcmp(again.data(), frame.samples, again.size() * sizeof(uint16_t)) == 0);
+
+	reader.close();
+	std::remove(path.c_str());
+}
+
+static void test_broken()
+{
+	std::mt19937 rng(1);
+	std::string path = temp_path("broken.hgds");
+	SequenceInfo info;
+	SequenceWriter writer;
+	SequenceReader reader;
+	std::vector<uint8_t> bytes;
+
+	info.width = 16;
+	info.height = 16;
+
+	CHECK(reader.open(path.c_str()) == Status::IoError);
+
+	CHECK(writer.open(path.c_str(), info) == Status::Ok);
+	for (int i = 0; i < 3; i++) {
+		CHECK(writer.append(random_frame(rng, info).data(), i) == Status::Ok);
+	}
+	CHECK(writer.close() == Status::Ok);
+
+	std::FILE *f = std::fopen(path.c_str(), "rb");
+	bytes.resize(1 << 16);
+	bytes.resize(std::fread(bytes.data(), 1, bytes.size(), f));
+	std::fclose(f);
+
+	auto check = [&](const std::vector<uint8_t> &b, Status want) {
+		std::FILE *w = std::fopen(path.c_str(), "wb");
+		std::fwrite(b.data(), 1, b.size(), w);
+		std::fclose(w);
+		CHECK(reader.open(path.c_str()) == want);
+	};
+
+	check(bytes, Status::Ok);
+
+	// Index cut short
+	check(std::vector<uint8_t>(bytes.begin(), bytes.end() - 1), Status::InvalidFormat);
+
+	// Recording cut short: no header, no index
+	std::vector<uint8_t> b = bytes;
+	std::memset(b.data(), 0, HGDEPTH_SEQ_HEADER_LEN);
+	check(b, Status::InvalidFormat);
+
+	// Misaligned frame
+	b = bytes;
+	b[b.size() - HGDEPTH_SEQ_INDEX_ENTRY] += 2;
+	check(b, Status::InvalidFormat);
+
+	// Header only
+	check(std::vector<uint8_t>(bytes.begin(), bytes.begin() + 10), Status::InvalidFormat);
+
+	reader.close();
+	std::remove(path.c_str());
+}
+
+static void test_replay()
+{
+	std::mt19937 rng(7);
+	std::string path = temp_path("replay.hgds");
+	SequenceInfo info;
+	SequenceWriter writer;
+	SequenceReader reader;
+	ReplayOptions options;
+	ReplayStats stats;
+	size_t seen = 0;
+
+	info.width = 96;
+	info.height = 64;
+
+	CHECK(writer.open(path.c_str(), info) == Status::Ok);
+	for (int i = 0; i < 5; i++) {
+		CHECK(writer.append(random_frame(rng, info).data(), 1000U * i) == Status::Ok);
+	}
+	CHECK(writer.close() == Status::Ok);
+	CHECK(reader.open(path.c_str()) == Status::Ok);
+
+	std::vector<Region> layout = quadrant_layout(info.width, info.height);
+	std::vector<float> depth((size_t)info.width * info.height);
+	Reducer reducer;
+	Haptic_FilterParams_t params, off = {HAPTIC_FILTER_OFF, 0, 0, 0, 0};
+
+	// Without the filter, the prediction and the saliency the pulses only depend on the frame
+	Haptic_FilterGetParams(&params);
+	CHECK(Haptic_FilterSetParams(&off) == 1);
+	Haptic_PredictEnable(0);
+	Haptic_SaliencyEnable(0);
+
+	options.loops = 2;
+	CHECK(replay(reader, options, &stats, [&](const ReplayFrame &f) {
+		Frame frame;
+		float grid[HGDEPTH_GRID_CELLS];
+		uint32_t pulse[HGDEPTH_GRID_CELLS];
+
+		reader.frame(f.index, &frame);
+		decode_frame(reader.info(), frame.samples, depth.data());
+		reducer.reduce(Image<float>{depth.data(), info.width, info.height, info.width}, layout.data(), layout.size(), grid);
+		Haptic_Render(grid, 0, pulse);
+
+		CHECK(f.timestamp_us == frame.timestamp_us);
+		CHECK(std::memcmp(f.grid, grid, sizeof(grid)) == 0);
+		CHECK(std::memcmp(f.applied, grid, sizeof(grid)) == 0);
+		CHECK(std::memcmp(f.pulse, pulse, sizeof(pulse)) == 0);
+		seen++;
+	}) == Status::Ok);
+
+	CHECK(seen == 10);
+	CHECK(Haptic_FilterSetParams(&params) == 1);
+	Haptic_PredictEnable(1);
+	Haptic_SaliencyEnable(1);
+	CHECK(stats.frames == 10);
+	CHECK(stats.total.max >= stats.total.p50);
+
+	// At the recorded rate, 4 ms of frames take at least that long
+	options.loops = 1;
+	options.rate = ReplayRate::Recorded;
+	CHECK(replay(reader, options, &stats) == Status::Ok);
+	CHECK(stats.wall_s >= 0.004);
+
+	options.layout.resize(3);
+	CHECK(replay(reader, options, &stats) == Status::InvalidArgument);
+
+	reader.close();
+	std::remove(path.c_str());
+}
+
+int main()
+{
+	test_half();
+	test_round_trip(SampleType::Float16);
+	test_round_trip(SampleType::Uint16);
+	test_broken();
+	test_replay();
+
+	std::printf("%s: %d failure(s)\n", failures ? "FAIL" : "ok", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * hgdepth_pack.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Packs depth maps into a depth sequence file:
+//
+//	hgdepth_pack [-r fps] [-u scale] out.hgds width height map.f32...
+//	hgdepth_pack [-r fps] [-u scale] -s frames out.hgds width height
+//
+// The maps are raw 32 bit floats, row after row, as dumped from the depth
+// CVPixelBuffer, one file per frame, timed at fps. -u stores uint16 samples
+// of scale each instead of float16. -s makes a synthetic walk instead: a
+// floor, a wall, and an obstacle coming closer from the right to the left,
+// at the height of the upper cells.
+
+// Includes
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "hgdepth/sequence.h"
+
+using namespace hgdepth;
+
+// Private functions
+
+static void synthetic(uint32_t width, uint32_t height, uint32_t i, uint32_t frames, float *depth)
+{
+	float t = (float)i / (float)((frames > 1) ? (frames - 1) : 1);
+	float ox = 0.8f - (0.6f * t);
+	float oy = 0.3f;
+	float od = 4.0f - (3.2f * t);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			float u = (float)x / (float)width;
+			float v = (float)y / (float)height;
+			float d = 6.0f - (4.0f * v);
+			float r = ((u - ox) * (u - ox)) + ((v - oy) * (v - oy));
+			if (r < 0.02f) {
+				d = std::fmin(d, od + (5.0f * r));
+			}
+			depth[((size_t)y * width) + x] = d;
+		}
+	}
+}
+
+static bool load(const char *path, size_t n, float *depth)
+{
+	std::FILE *f = std::fopen(path, "rb");
+	size_t got;
+
+	if (f == nullptr) {
+		std::perror(path);
+		return false;
+	}
+
+	got = std::fread(depth, sizeof(float), n, f);
+	std::fclose(f);
+	if (got != n) {
+		std::fprintf(stderr, "%s: %zu samples, %zu expected\n", path, got, n);
+		return false;
+	}
+
+	return true;
+}
+
+static int usage(const char *name)
+{
+	std::fprintf(stderr, "usage: %s [-r fps] [-u scale] [-s frames] out.hgds width height [map.f32...]\n", name);
+	return 1;
+}
+
+// Exported functions
+
+int main(int argc, char **argv)
+{
+	SequenceInfo info;
+	SequenceWriter writer;
+	double fps = 30.0;
+	uint32_t frames = 0;
+	int i = 1;
+	Status status;
+
+	for (; (i < argc) && (argv[i][0] == '-'); i++) {
+		if ((std::strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+			fps = std::atof(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-u") == 0) && (i + 1 < argc)) {
+			info.type = SampleType::Uint16;
+			info.scale = (float)std::atof(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+			frames = (uint32_t)std::atoi(argv[++i]);
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if ((argc - i < 3) || !(fps > 0.0) || ((frames == 0) && (argc - i < 4)) || !(info.scale > 0.0f)) {
+		return usage(argv[0]);
+	}
+
+	const char *path = argv[i];
+	info.width = (uint32_t)std::atoi(argv[i + 1]);
+	info.height = (uint32_t)std::atoi(argv[i + 2]);
+	i += 3;
+	if (frames == 0) {
+		frames = (uint32_t)(argc - i);
+	}
+
+	size_t n = (size_t)info.width * info.height;
+	std::vector<float> depth(n);
+	std::vector<uint16_t> samples(n);
+
+	status = writer.open(path, info);
+	if (status != Status::Ok) {
+		std::fprintf(stderr, "%s: %s\n", path, status_name(status));
+		return 1;
+	}
+
+	for (uint32_t f = 0; f < frames; f++) {
+		if (i < argc) {
+			if (!load(argv[i + f], n, depth.data())) {
+				return 1;
+			}
+		} else {
+			synthetic(info.width, info.height, f, frames, depth.data());
+		}
+
+		encode_frame(info, depth.data(), samples.data());
+		status = writer.append(samples.data(), (uint64_t)std::llround((double)f * 1e6 / fps));
+		if (status != Status::Ok) {
+			std::fprintf(stderr, "%s: %s\n", path, status_name(status));
+			return 1;
+		}
+	}
+
+	status = writer.close();
+	if (status != Status::Ok) {
+		std::fprintf(stderr, "%s: %s\n", path, status_name(status));
+		return 1;
+	}
+
+	std::printf("%s: %u frames of %u x %u\n", path, frames, info.width, info.height);
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * hgdepth_replay.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Peter Alpajaro
+ */
+
+// Replays a depth sequence through the pipeline and prints the time of each
+// stage:
+//
+//	hgdepth_replay [-r] [-l loops] [-i isa] [-t threads] [-g cols rows] [-L latency_ms] [-o pulses.csv] seq.hgds
+//
+// -r plays at the recorded rate instead of as fast as possible. -g reduces
+// the centre of each cell of a grid instead of the layout of the app (cols x
+// rows must make 4 cells). -L gives the firmware predictor the latency from
+// the camera to the glove it would get from the phone. -o writes the grid and the compare values of
+// every frame.
+
+// Includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "hgdepth/replay.h"
+
+using namespace hgdepth;
+
+// Private functions
+
+static Isa parse_isa(const char *name)
+{
+	static const Isa isas[] = {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Neon, Isa::Best};
+
+	for (Isa isa : isas) {
+		if (std::strcmp(name, isa_name(isa)) == 0) {
+			return isa;
+		}
+	}
+
+	return Isa::Best;
+}
+
+static void print_stage(const char *name, const StageStats &s)
+{
+	std::printf("  %-7s mean %9.2f  p50 %9.2f  p99 %9.2f  max %9.2f us\n", name, s.mean, s.p50, s.p99, s.max);
+}
+
+static int usage(const char *name)
+{
+	std::fprintf(stderr, "usage: %s [-r] [-l loops] [-i isa] [-t threads] [-g cols rows] [-L latency_ms] [-o pulses.csv] seq.hgds\n", name);
+	return 1;
+}
+
+// Exported functions
+
+int main(int argc, char **argv)
+{
+	ReplayOptions options;
+	ReplayStats stats;
+	SequenceReader sequence;
+	uint32_t cols = 0, rows = 0;
+	const char *csv = nullptr;
+	std::FILE *out = nullptr;
+	Status status;
+	int i = 1;
+
+	for (; (i < argc) && (argv[i][0] == '-'); i++) {
+		if (std::strcmp(argv[i], "-r") == 0) {
+			options.rate = ReplayRate::Recorded;
+		} else if ((std::strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) {
+			options.loops = (unsigned)std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-i") == 0) && (i + 1 < argc)) {
+			options.reducer.isa = parse_isa(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) {
+			options.reducer.threads = (unsigned)std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-g") == 0) && (i + 2 < argc)) {
+			cols = (uint32_t)std::atoi(argv[++i]);
+			rows = (uint32_t)std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-L") == 0) && (i + 1 < argc)) {
+			options.latency_ms = std::atoi(argv[++i]);
+		} else if ((std::strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) {
+			csv = argv[++i];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (i + 1 != argc) {
+		return usage(argv[0]);
+	}
+
+	status = sequence.open(argv[i]);
+	if (status != Status::Ok) {
+		std::fprintf(stderr, "%s: %s\n", argv[i], status_name(status));
+		return 1;
+	}
+
+	if (cols != 0) {
+		options.layout = grid_layout(sequence.info().width, sequence.info().height, cols, rows);
+	}
+
+	if (csv != nullptr) {
+		out = std::fopen(csv, "w");
+		if (out == nullptr) {
+			std::perror(csv);
+			return 1;
+		}
+		std::fprintf(out, "frame,timestamp_us,grid0,grid1,grid2,grid3,pulse0,pulse1,pulse2,pulse3\n");
+	}
+
+	status = replay(sequence, options, &stats, [out](const ReplayFrame &f) {
+		if (out != nullptr) {
+			std::fprintf(out, "%zu,%llu,%f,%f,%f,%f,%u,%u,%u,%u\n", f.index, (unsigned long long)f.timestamp_us,
+						 f.grid[0], f.grid[1], f.grid[2], f.grid[3], f.pulse[0], f.pulse[1], f.pulse[2], f.pulse[3]);
+		}
+	});
+
+	if (out != nullptr) {
+		std::fclose(out);
+	}
+
+	if (status != Status::Ok) {
+		std::fprintf(stderr, "%s: %s\n", argv[i], status_name(status));
+		return 1;
+	}
+
+	std::printf("%s: %u x %u, %zu frames in %.3f s (%.1f frames/s), %s rate, %zu late\n",
+				argv[i], sequence.info().width, sequence.info().height, stats.frames, stats.wall_s,
+				(double)stats.frames / stats.wall_s,
+				(options.rate == ReplayRate::Recorded) ? "recorded" : "max", stats.late);
+	print_stage("decode", stats.decode);
+	print_stage("reduce", stats.reduce);
+	print_stage("encode", stats.encode);
+	print_stage("apply", stats.apply);
+	print_stage("total", stats.total);
+
+	return 0;
+}
@@ -24,6 +24,9 @@ class BluetoothManager: NSObject, ObservableObject {
     private var connectedPeripheral: CBPeripheral?
     public var readCharacteristic: CBCharacteristic?
     private var writeCharacteristic: CBCharacteristic?
+    private var tileCharacteristic: CBCharacteristic?
+    private var filterCharacteristic: CBCharacteristic?
+    private var layoutCharacteristic: CBCharacteristic?
     
     private var device_count = 0
     
@@ -40,6 +43,15 @@ class BluetoothManager: NSObject, ObservableObject {
     private let serviceUUID = CBUUID(string: "00000000-0002-11e1-9ab4-0002a5d5c51b")
     private let readCharacteristicUUID = CBUUID(string: "00000001-0001-11e1-ac36-0002a5d5c51b")
     private let writeCharacteristicUUID = CBUUID(string: "00000001-0001-11e1-ac36-0002a5d5c51b")
+    private let tileCharacteristicUUID = CBUUID(string: "00000003-0001-11e1-ac36-0002a5d5c51b")
+    private let filterCharacteristicUUID = CBUUID(string: "00000004-0001-11e1-ac36-0002a5d5c51b")
+    private let layoutCharacteristicUUID = CBUUID(string: "00000005-0001-11e1-ac36-0002a5d5c51b")
+    
+    // Depth tile reduced on the glove: side in samples, and the header of each write
+    static let tileSize = 16
+    private let tileHeaderLength = 4
+    // Rows the glove takes per write (DEPTH_TILE_ROWS_MAX): a longer write does not fit its HCI buffer
+    private let tileRowsPerWrite = 6
     
     // Callbacks
     var onDataReceived: ((String) -> Void)?
@@ -99,7 +111,9 @@ class BluetoothManager: NSObject, ObservableObject {
         print(paddedString)
     }
     
-    func writeData(timestamp: UInt16, float_grid: [[Float]]) {
+    // latencyMs, when given, is the time from the camera frame to this write; the glove
+    // extrapolates the grid over it, so it is appended after the cells.
+    func writeData(timestamp: UInt16, float_grid: [[Float]], latencyMs: UInt16? = nil) {
         guard let peripheral = connectedPeripheral,
               let characteristic = writeCharacteristic,
               float_grid.count == 2, float_grid[0].count == 2 else {
@@ -121,12 +135,125 @@ class BluetoothManager: NSObject, ObservableObject {
             
         }
         
+        if let latencyMs {
+            combinedData.append(UInt8(latencyMs & 0xFF))
+            combinedData.append(UInt8((latencyMs >> 8) & 0xFF))
+        }
+        
         peripheral.writeValue(combinedData, for: characteristic, type: .withResponse)
         
         print("Sending timestamp: \(timestamp), grid: \(float_grid)")
         print("Total data length: \(combinedData.count) bytes")
     }
     
+    // Sends a depth tile (tileSize x tileSize samples, row by row) to be reduced on the glove.
+    // The rows are split over as many writes as the MTU and the glove need: timestamp, first row, number of rows, then the rows.
+    // Without response, and dropped when the link is busy: the next frame replaces it anyway.
+    func writeTile(timestamp: UInt16, tile: [UInt8]) {
+        let tileSize = BluetoothManager.tileSize
+        guard let peripheral = connectedPeripheral,
+              let characteristic = tileCharacteristic,
+              tile.count == tileSize * tileSize else {
+            print("Could not write tile: peripheral not ready or invalid data")
+            return
+        }
+        
+        guard peripheral.canSendWriteWithoutResponse else {
+            return
+        }
+        
+        let maxLength = peripheral.maximumWriteValueLength(for: .withoutResponse)
+        let rowsPerWrite = max(1, min(tileRowsPerWrite, (maxLength - tileHeaderLength) / tileSize))
+        
+        for firstRow in stride(from: 0, to: tileSize, by: rowsPerWrite) {
+            let rows = min(rowsPerWrite, tileSize - firstRow)
+            
+            var data = Data(capacity: tileHeaderLength + rows * tileSize)
+            data.append(UInt8(timestamp & 0xFF))
+            data.append(UInt8((timestamp >> 8) & 0xFF))
+            data.append(UInt8(firstRow))
+            data.append(UInt8(rows))
+            data.append(contentsOf: tile[(firstRow * tileSize)..<((firstRow + rows) * tileSize)])
+            
+            peripheral.writeValue(data, for: characteristic, type: .withoutResponse)
+        }
+    }
+    
+    // Temporal filter the glove runs on each cell before the motors.
+    // Cutoffs in Hz, beta in Hz per unit of intensity per second.
+    enum HapticFilter {
+        case off
+        case ema(alpha: Float)
+        case oneEuro(minCutoff: Float, beta: Float, dCutoff: Float)
+    }
+    
+    // Sets the filter: mode, then EMA weight in Q15 and the one euro parameters in Q8, little endian
+    func writeFilter(_ filter: HapticFilter) {
+        guard let peripheral = connectedPeripheral,
+              let characteristic = filterCharacteristic else {
+            print("Could not write filter: peripheral not ready")
+            return
+        }
+        
+        func fixed(_ value: Float, _ one: Float) -> UInt16 {
+            return UInt16(max(0, min(Float(UInt16.max), (value * one).rounded())))
+        }
+        
+        var mode: UInt8 = 0
+        var fields: [UInt16] = [0, 0, 0, 0]
+        switch filter {
+        case .off:
+            break
+        case .ema(let alpha):
+            mode = 1
+            fields[0] = fixed(alpha, 32768)
+        case .oneEuro(let minCutoff, let beta, let dCutoff):
+            mode = 2
+            fields[1] = fixed(minCutoff, 256)
+            fields[2] = fixed(beta, 256)
+            fields[3] = fixed(dCutoff, 256)
+        }
+        
+        var data = Data([mode])
+        for field in fields {
+            data.append(UInt8(field & 0xFF))
+            data.append(UInt8(field >> 8))
+        }
+        
+        peripheral.writeValue(data, for: characteristic, type: .withResponse)
+    }
+    
+    // Area of the depth tile reduced into one motor, in samples, and its gain on the normalized depth
+    struct TileRegion {
+        var x: UInt8
+        var y: UInt8
+        var width: UInt8
+        var height: UInt8
+        var weight: Float = 1.0
+    }
+    
+    // Sets the layout the glove reduces the tiles with, one region per motor in the order of the grid:
+    // first column, first row, columns, rows, then the weight in Q8, little endian.
+    // The glove refuses a region that is empty or leaves the tile and keeps the layout it has
+    func writeLayout(_ regions: [TileRegion]) {
+        guard let peripheral = connectedPeripheral,
+              let characteristic = layoutCharacteristic,
+              regions.count == 4 else {
+            print("Could not write layout: peripheral not ready or invalid regions")
+            return
+        }
+        
+        var data = Data(capacity: regions.count * 6)
+        for region in regions {
+            let weight = UInt16(max(0, min(Float(UInt16.max), (region.weight * 256).rounded())))
+            data.append(contentsOf: [region.x, region.y, region.width, region.height])
+            data.append(UInt8(weight & 0xFF))
+            data.append(UInt8(weight >> 8))
+        }
+        
+        peripheral.writeValue(data, for: characteristic, type: .withResponse)
+    }
+    
     func readData() {
         guard let peripheral = connectedPeripheral,
               let characteristic = readCharacteristic else {
@@ -212,6 +339,9 @@ extension BluetoothManager: CBCentralManagerDelegate {
             connectedPeripheral = nil
             writeCharacteristic = nil
             readCharacteristic = nil
+            tileCharacteristic = nil
+            filterCharacteristic = nil
+            layoutCharacteristic = nil
             print("Disconnected from peripheral")
             startScanning() // Optionally restart scanning
     }
@@ -228,7 +358,7 @@ extension BluetoothManager: CBPeripheralDelegate {
         guard let services = peripheral.services else { return }
         for service in services {
             // TODO: add write functionality
-            peripheral.discoverCharacteristics([readCharacteristicUUID], for: service)
+            peripheral.discoverCharacteristics([readCharacteristicUUID, tileCharacteristicUUID, filterCharacteristicUUID, layoutCharacteristicUUID], for: service)
         }
     }
     
@@ -257,6 +387,21 @@ extension BluetoothManager: CBPeripheralDelegate {
                 
                 //peripheral.setNotifyValue(true, for: characteristic)
             }
+            
+            if characteristic.uuid == tileCharacteristicUUID {
+                tileCharacteristic = characteristic
+                print ("Depth tile characteristic found")
+            }
+            
+            if characteristic.uuid == filterCharacteristicUUID {
+                filterCharacteristic = characteristic
+                print ("Filter characteristic found")
+            }
+            
+            if characteristic.uuid == layoutCharacteristicUUID {
+                layoutCharacteristic = characteristic
+                print ("Depth layout characteristic found")
+            }
         }
         
         
@@ -29,6 +29,13 @@ final class DataModel: ObservableObject {
     // The resulting depthregions
     @Published var regionDepths: [Float] = [0, 0, 0, 0]
     
+    // When the camera frame behind depthData was taken, for the latency sent with the grid
+    private var depthCaptured = ContinuousClock.now
+    
+    // Depth tile sent in the glove reduction mode, and its frame number
+    private var depthTile = [UInt8](repeating: 0, count: BluetoothManager.tileSize * BluetoothManager.tileSize)
+    private var tileTimestamp: UInt16 = 0
+    
     init(viewM:    ViewManager) {
         // Create a reusable buffer to avoid allocating memory for every model invocation
         viewManager = viewM
@@ -121,7 +128,9 @@ final class DataModel: ObservableObject {
             newRegionDepths[region] = normalizedAverage
         }
         
-        self.viewManager?.bluetoothManager.writeData(timestamp: 1, float_grid: [[newRegionDepths[0], newRegionDepths[1]], [newRegionDepths[2], newRegionDepths[3]]])
+        let age = depthCaptured.duration(to: .now).components
+        let latencyMs = UInt16(clamping: age.seconds * 1000 + age.attoseconds / 1_000_000_000_000_000)
+        self.viewManager?.bluetoothManager.writeData(timestamp: 1, float_grid: [[newRegionDepths[0], newRegionDepths[1]], [newRegionDepths[2], newRegionDepths[3]]], latencyMs: latencyMs)
         
         DispatchQueue.main.async {
             self.regionDepths = newRegionDepths
@@ -130,6 +139,28 @@ final class DataModel: ObservableObject {
     }
 
     
+    // Glove reduction mode: downsamples the depth map to a tile of 8 bit samples, on the GPU,
+    // and leaves the min/max scan and the region averages to the glove.
+    func sendDepthTile() {
+        guard let depthBuffer = depthData else { return }
+        
+        let tileSize = BluetoothManager.tileSize
+        let tileImage = CIImage(cvPixelBuffer: depthBuffer)
+            .resized(to: CGSize(width: tileSize, height: tileSize))
+        
+        depthTile.withUnsafeMutableBytes { bytes in
+            context.render(tileImage,
+                           toBitmap: bytes.baseAddress!,
+                           rowBytes: tileSize,
+                           bounds: CGRect(x: 0, y: 0, width: tileSize, height: tileSize),
+                           format: .L8,
+                           colorSpace: nil)
+        }
+        
+        tileTimestamp &+= 1
+        viewManager?.bluetoothManager.writeTile(timestamp: tileTimestamp, tile: depthTile)
+    }
+    
     func handleCameraFeed() async {
         let imageStream = camera.previewStream
         for await image in imageStream {
@@ -146,8 +177,9 @@ final class DataModel: ObservableObject {
         while !Task.isCancelled {
             let image = lastImage.withLock({ $0 })
             if let pixelBuffer = image?.pixelBuffer {
+                let captured = clock.now
                 let duration = await clock.measure {
-                    try? await performInference(pixelBuffer)
+                    try? await performInference(pixelBuffer, captured: captured)
                 }
                 durations.append(duration)
             }
@@ -178,7 +210,7 @@ final class DataModel: ObservableObject {
         print("Model loaded (took \(duration.formatted(.units(allowed: [.seconds, .milliseconds]))))")
     }
 
-    func performInference(_ pixelBuffer: CVPixelBuffer) async throws {
+    func performInference(_ pixelBuffer: CVPixelBuffer, captured: ContinuousClock.Instant) async throws {
         guard let model else {
             return
         }
@@ -195,7 +227,12 @@ final class DataModel: ObservableObject {
         Task { @MainActor in
             depthImage = outputImage
             depthData = result.depth
-            calculateRegionDepths()
+            depthCaptured = captured
+            if viewManager?.reductionMode == .glove {
+                sendDepthTile()
+            } else {
+                calculateRegionDepths()
+            }
         }
     }
 }
@@ -9,12 +9,19 @@ import SwiftUI
 import CoreBluetooth
 import Combine
 
+// Where the depth map is reduced to the motor values
+enum ReductionMode {
+    case phone  // Region depths computed here, 4 floats sent
+    case glove  // Downsampled depth tile sent, reduced by the glove
+}
+
 // Manages variables between and through different classes / objects.
 class ViewManager: ObservableObject {
     @Published var bluetoothManager: BluetoothManager
     @Published var isConnected: Bool = false
     @Published var visibleDevices: [ListItem] = []
     @Published var temperature: Int = 10
+    @Published var reductionMode: ReductionMode = .phone
     
     private var cancellables = Set<AnyCancellable>()
 